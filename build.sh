@@ -24,3 +24,14 @@ code_path="$working_path/code"
 
 # build the executable
 $compiler $compiler_flags $code_path/$executable.cpp -o $build_path/$executable $linker_flags
+
+# build and run the tests
+if [ "$1" == "test" ]
+then
+  for test_path in $working_path/tests/*.cpp
+  do
+    test_executable="$build_path/$(basename $test_path .cpp)"
+    $compiler $compiler_flags $test_path -o $test_executable $linker_flags
+    $test_executable
+  done
+fi
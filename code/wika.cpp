@@ -3,7 +3,21 @@
 constexpr char help_message[] =
 	"USAGE: wika [options] path...\n"
 	"\n"
-	"OPTIONS:\n";
+	"OPTIONS:\n"
+	"  --lazy            only analyze what `_start` and the `#export`ed declarations use\n"
+	"  --emit-ir         print the intermediate representation of the procedures after optimizing them\n"
+	"  --emit-c          write the program as C, one translation unit next to each source, with `.c` for its\n"
+	"                    extension\n"
+	"  -o path           write a static x86-64 executable, which is entered at `_start`, to the path\n"
+	"  --object          with -o, write a relocatable object to link instead\n"
+	"  --reorder-fields  lay out the fields of structures from the most aligned to the least, which leaves the least\n"
+	"                    padding, rather than in the order they're declared\n"
+	"  --report-padding  print how many bytes of each structure and union are padding\n"
+	"  --error-limit n   stop compiling at the nth error, rather than reporting every error that can be found\n"
+	"  --instrument      with -o, count how many times each block of each procedure runs, and write the counts to\n"
+	"                    the output path with `.profile` appended when `_start` returns, or, in an object, when\n"
+	"                    `wika_write_profile` is called\n"
+	"  --profile path    optimize for what ran the most in a profile that an instrumented build wrote\n";
 
 void display_help(void)
 {
@@ -16,11 +30,38 @@ void terminate(void);
 
 struct
 {
+	bool lazy;
+	bool emit_ir;
+	bool emit_c;
+	bool object;
+	bool report_padding;
+	bool instrument;
+	Size errors_limit; // zero if there's none
+	const char *output_path;
+	const char *profile_path;
 }
 compilation_options;
 
 Size compilation_errors_count = 0;
 
+// set once the errors reach the limit. the workers stop taking more work, and the main thread stops once they have.
+static bool compilation_stopped = false;
+
+static bool check_compilation_stopped(void)
+{
+	return __atomic_load_n(&compilation_stopped, __ATOMIC_RELAXED);
+}
+
+// threads take the next unparsed source until there are none left.
+struct Parsing_Work
+{
+	Parser *parsers;
+	Size parsers_count;
+	Size next_parser_index;
+};
+
+static void *parse_sources(void *input);
+
 int main(int arguments_count, char **arguments)
 {
 	initialize();
@@ -31,7 +72,7 @@ int main(int arguments_count, char **arguments)
 	{
 		report_error("no source paths given.");
 		display_help();
-		return 0;
+		return 1;
 	}
 
 	static Arena sources;
@@ -55,10 +96,50 @@ int main(int arguments_count, char **arguments)
 					if (argument[1] == '-')
 					{
 						const char *option = &argument[2];
+						if (compare_string(option, "lazy") == 0)
+							compilation_options.lazy = true;
+						else if (compare_string(option, "emit-ir") == 0)
+							compilation_options.emit_ir = true;
+						else if (compare_string(option, "emit-c") == 0)
+							compilation_options.emit_c = true;
+						else if (compare_string(option, "object") == 0)
+							compilation_options.object = true;
+						else if (compare_string(option, "reorder-fields") == 0)
+							enable_field_reordering();
+						else if (compare_string(option, "report-padding") == 0)
+							compilation_options.report_padding = true;
+						else if (compare_string(option, "instrument") == 0)
+							compilation_options.instrument = true;
+						else if (compare_string(option, "profile") == 0)
+						{
+							if (i + 1 < (Size)arguments_count)
+								compilation_options.profile_path = arguments[++i];
+							else
+								report_error("missing the profile path after --profile.");
+						}
+						else if (compare_string(option, "error-limit") == 0)
+						{
+							char *ending = 0;
+							if (i + 1 < (Size)arguments_count)
+								compilation_options.errors_limit = strtoul(arguments[++i], &ending, 10);
+							if (!ending || ending == arguments[i] || *ending)
+								report_error("expected a number of errors after --error-limit.");
+						}
+						else
+							report_error("unknown option: %s.", argument);
 					}
 					else
 					{
 						const char option = argument[1];
+						if (option == 'o' && !argument[2])
+						{
+							if (i + 1 < (Size)arguments_count)
+								compilation_options.output_path = arguments[++i];
+							else
+								report_error("missing the output path after -o.");
+						}
+						else
+							report_error("unknown option: %s.", argument);
 					}
 				}
 				else
@@ -107,8 +188,8 @@ int main(int arguments_count, char **arguments)
 						continue;
 					}
 
-					char *path = (char *)reserve_from_arena(&source_paths, path_size);
-					copy_memory(path, path_buffer, path_size);
+					char *path = (char *)reserve_from_arena(&source_paths, path_size + 1);
+					copy_memory(path, path_buffer, path_size + 1);
 
 					Source *source = (Source *)reserve_from_arena(&sources, sizeof(Source), alignof(Source));
 					source->path_size = path_size;
@@ -118,87 +199,245 @@ int main(int arguments_count, char **arguments)
 			}
 		}
 
+		// the counters are written by the code that enters the program, which C doesn't get
+		if (compilation_options.instrument && (!compilation_options.output_path || compilation_options.emit_c))
+			report_error("--instrument needs -o, and can't be used with --emit-c.");
+
 		// load the sources
 		initialize_arena(&source_datas, sources_count * get_memory_page_size());
+		struct Loading_Input
+		{
+			File_Load *loads;
+			Source **sources;
+			Size count;
+		}
+		loading_input = {};
+		Scratch scratch;
+		loading_input.loads = (File_Load *)reserve_from_arena(scratch.arena, sources_count * sizeof(File_Load), alignof(File_Load));
+		loading_input.sources = (Source **)reserve_from_arena(scratch.arena, sources_count * sizeof(Source *), alignof(Source *));
 		iterate_over_arena(
 			&sources,
-			[](void *, void *pointer) -> bool
+			[](void *input_pointer, void *pointer) -> bool
 			{
+				Loading_Input *input = (Loading_Input *)input_pointer;
 				Source *source = (Source *)pointer;
-				Handle handle;
-				if (!open_file(&handle, source->path))
-				{
-					report_error("failed to open source file: %s.", source->path);
-					return true;
-				}
-
-				Size data_size;
-				if (!get_file_size(handle, &data_size))
-				{
-					close_file(handle);
-					report_error("failed to get source file size: %s.", source->path);
-					return true;
-				}
-
-				U8 *data = (U8 *)reserve_from_arena(&source_datas, data_size + 1);
-				Size read_size = data_size;
-				if (!read_file(handle, data, &read_size))
-				{
-					close_file(handle);
-					report_error("failed to read source file: %s.", source->path);
-					return true;
-				}
-				if (read_size != data_size)
-				{
-					close_file(handle);
-					report_error("failed to read entire file: %s.", source->path);
-					return true;
-				}
-				data[read_size] = 0;
-		
-				source->handle = handle;
-				source->data_size = data_size;
-				source->data = data;
+				input->loads[input->count] = {};
+				input->loads[input->count].path = source->path;
+				input->sources[input->count++] = source;
 				return true;
 			},
-			0,
+			&loading_input,
 			sizeof(Source),
 			alignof(Source));
+		load_files(
+			loading_input.loads,
+			loading_input.count,
+			[](void *, Size size) -> U8 *
+			{
+				return (U8 *)reserve_from_arena(&source_datas, size + SOURCE_DATA_PADDING_SIZE);
+			},
+			0);
+		for (Size i = 0; i < loading_input.count; ++i)
+		{
+			const File_Load *load = &loading_input.loads[i];
+			Source *source = loading_input.sources[i];
+			if (!load->data)
+			{
+				report_error("failed to %s source file: %s: %s.", load->failure, source->path, load->message);
+				continue;
+			}
+			set_memory(&load->data[load->size], SOURCE_DATA_PADDING_SIZE, 0);
+			source->data_size = load->size;
+			source->data = load->data;
+			if (!register_source(source))
+				report_error("the sources exceed the source address space: %s.", source->path);
+		}
+
+		// nothing is parsed unless every source is there
 		if (compilation_errors_count != 0)
+		{
 			terminate();
+			return 1;
+		}
 	}
 
-	iterate_over_arena(
-		&sources,
-		[](void *, void *pointer) -> bool
+	// parse the sources on all processors
+	static Parsing_Work parsing_work;
+	{
+		Size sources_count = get_sources_count();
+		parsing_work.parsers = (Parser *)allocate(sources_count * sizeof(Parser));
+		parsing_work.parsers_count = sources_count;
+		for (Size i = 0; i < sources_count; ++i)
+			initialize_parser(&parsing_work.parsers[i], get_source(i));
+
+		Size threads_count = min(get_processors_count(), sources_count);
+		Thread *threads = (Thread *)allocate(threads_count * sizeof(Thread));
+		Size created_threads_count = 0;
+		for (Size i = 1; i < threads_count; ++i)
 		{
-			Source *source = (Source *)pointer;
+			if (!create_thread(&threads[created_threads_count], parse_sources, &parsing_work))
+				break;
+			++created_threads_count;
+		}
+		parse_sources(&parsing_work);
+		for (Size i = 0; i < created_threads_count; ++i)
+			join_thread(threads[i]);
+		deallocate(threads);
+	}
 
-			print("compiling \e[1m%s\e[0m...\n", source->path);
+	// analyze the top-level artifacts in dependency order on all processors
+	if (compilation_errors_count == 0)
+		analyze(parsing_work.parsers, parsing_work.parsers_count, compilation_options.lazy);
+	if (compilation_errors_count == 0 && compilation_options.report_padding)
+		report_padding();
 
-			Parser parser;
-			initialize_parser(&parser, source);
+	// lower what was analyzed into SSA form and optimize it
+	static Program program;
+	if (compilation_errors_count == 0)
+		lower_program(&program, parsing_work.parsers, parsing_work.parsers_count);
+	if (compilation_errors_count == 0 && compilation_options.profile_path)
+		apply_profile(&program, compilation_options.profile_path);
+	if (compilation_errors_count == 0 && compilation_options.instrument)
+	{
+		// the profile goes next to the output, wherever the program runs from
+		static char profile_path[MAX_FILE_PATH_SIZE + 16];
+		const char *output_path = compilation_options.output_path;
+		Size size = 0;
+		if (output_path[0] != '/' && getcwd(profile_path, MAX_FILE_PATH_SIZE))
+		{
+			size = get_length_of_string(profile_path);
+			profile_path[size++] = '/';
+		}
+		format(&profile_path[size], sizeof(profile_path) - size, "%s.profile", output_path);
+		instrument_program(&program, profile_path);
+	}
+	if (compilation_errors_count == 0)
+	{
+		optimize_program(&program);
+		if (compilation_options.emit_ir)
+			print_program(&program);
+	}
 
-			Size errors_count = parse(&parser);
-			if (errors_count)
-				return false;
-			return true;
-		},
-		0,
-		sizeof(Source),
-		alignof(Source));
+	// generate machine code
+	if (compilation_errors_count == 0 && compilation_options.output_path)
+		generate_program(&program, compilation_options.output_path, compilation_options.object);
+	if (compilation_errors_count == 0 && compilation_options.emit_c)
+		generate_c_program(&program);
 
+	if (compilation_errors_count != 0)
+		exit_code = 1;
 	terminate();
 	return exit_code;
 }
 
-Size format_token(char *buffer, Size size, const Token *token)
+static void *parse_sources(void *input)
+{
+	Parsing_Work *work = (Parsing_Work *)input;
+	for (;;)
+	{
+		Size index = __atomic_fetch_add(&work->next_parser_index, 1, __ATOMIC_RELAXED);
+		if (index >= work->parsers_count || check_compilation_stopped())
+			break;
+
+		Parser *parser = &work->parsers[index];
+		print("compiling \e[1m%s\e[0m...\n", parser->source->path);
+		parse(parser);
+	}
+	return 0;
+}
+
+// sources are registered in order, so their bases are already sorted.
+static Buffer source_table;
+static U64 next_source_base = 0;
+
+bool register_source(Source *source)
+{
+	// one more for the null terminator, so the end of a source still maps back to it.
+	U64 base = next_source_base;
+	if (base + source->data_size + 1 > MAXIMUM_SOURCE_SPACE_SIZE)
+		return false;
+	next_source_base += source->data_size + 1;
+
+	source->base = (Location)base;
+	Source **entry = (Source **)reserve_from_buffer(&source_table, sizeof(Source *), alignof(Source *));
+	*entry = source;
+	return true;
+}
+
+const Source *find_source(Location location)
 {
-	char strbuf[16];
+	Source **sources = (Source **)source_table.pointer;
+	Size count = source_table.mass / sizeof(Source *);
+	assert(count);
+
+	// find the last source whose base is at or before the location
+	Size low = 0;
+	Size high = count;
+	while (high - low > 1)
+	{
+		Size middle = low + (high - low) / 2;
+		if (sources[middle]->base <= location)
+			low = middle;
+		else
+			high = middle;
+	}
+	return sources[low];
+}
+
+Size get_sources_count(void)
+{
+	return source_table.mass / sizeof(Source *);
+}
+
+Source *get_source(Size index)
+{
+	return ((Source **)source_table.pointer)[index];
+}
+
+// tokens of two characters, which are lexed as the first one unless the second follows
+static const struct
+{
+	char representation[3];
+	Token_Type type;
+}
+compound_tokens[] =
+{
+	{"==", Token_Type_EQUAL_EQUAL},
+	{"!=", Token_Type_EXCLAMATION_EQUAL},
+	{"<=", Token_Type_LESS_EQUAL},
+	{">=", Token_Type_GREATER_EQUAL},
+	{"<<", Token_Type_LESS_LESS},
+	{">>", Token_Type_GREATER_GREATER},
+	{"&&", Token_Type_AND},
+	{"||", Token_Type_OR},
+	{"->", Token_Type_ARROW},
+	{"|>", Token_Type_PIPE},
+	{"+=", Token_Type_PLUS_EQUAL},
+	{"-=", Token_Type_MINUS_EQUAL},
+	{"*=", Token_Type_ASTERISK_EQUAL},
+	{"/=", Token_Type_SLASH_EQUAL},
+};
+
+// `buffer` has to have space for 3 characters.
+static void format_operator(char *buffer, Token_Type type)
+{
+	buffer[0] = type;
+	buffer[1] = 0;
+	for (Size i = 0; i < sizeof(compound_tokens) / sizeof(compound_tokens[0]); ++i)
+	{
+		if (compound_tokens[i].type == type)
+			copy_string(buffer, compound_tokens[i].representation);
+	}
+}
+
+Size format_token(char *buffer, Size size, const Parser *parser, const Token *token)
+{
+	char strbuf[32];
 	set_memory(strbuf, sizeof(strbuf), 0);
 
-	const char *fmt = "type = %i, position = %lu, size = %lu, representation = \"%s\"";
-	char *representation = strbuf;
+	const char *fmt = "type = %i, position = %lu, size = %lu, representation = \"%.*s\"";
+	const char *representation = strbuf;
+	int representation_size = -1;
 
 	switch (token->type)
 	{
@@ -206,34 +445,87 @@ Size format_token(char *buffer, Size size, const Token *token)
 		copy_string(strbuf, "");
 		break;
 	case Token_Type_IDENTIFIER:
-		representation = token->representation;
+		{
+			String string = get_identifier_string(token->value);
+			representation = (const char *)string.pointer;
+			representation_size = string.size;
+		}
 		break;
 	case Token_Type_PROC:
 		copy_string(strbuf, "proc");
 		break;
+	case Token_Type_JUMP_TO:
+		copy_string(strbuf, "jump_to");
+		break;
+	case Token_Type_STRUCT:
+		copy_string(strbuf, "struct");
+		break;
+	case Token_Type_UNION:
+		copy_string(strbuf, "union");
+		break;
+	case Token_Type_ENUM:
+		copy_string(strbuf, "enum");
+		break;
+	case Token_Type_RETURN:
+		copy_string(strbuf, "return");
+		break;
+	case Token_Type_TRUE:
+		copy_string(strbuf, "true");
+		break;
+	case Token_Type_FALSE:
+		copy_string(strbuf, "false");
+		break;
+	case Token_Type_INTEGER:
+	case Token_Type_FLOAT:
+	case Token_Type_STRING:
+		{
+			const Literal *literal = &((const Literal *)parser->literals.pointer)[token->value];
+			if (literal->type == Literal_Type_INTEGER)
+				format(strbuf, sizeof(strbuf), "%lu", literal->integer);
+			else if (literal->type == Literal_Type_FLOAT)
+				format(strbuf, sizeof(strbuf), "%g", literal->floating);
+			else
+			{
+				representation = (const char *)literal->string.pointer;
+				representation_size = literal->string.size;
+			}
+		}
+		break;
 	default:
 		strbuf[0] = token->type;
+		for (Size i = 0; i < sizeof(compound_tokens) / sizeof(compound_tokens[0]); ++i)
+		{
+			if (compound_tokens[i].type == token->type)
+				copy_string(strbuf, compound_tokens[i].representation);
+		}
 		break;
 	}
-	return format(buffer, size, fmt, token->type, token->position, token->size, representation);
+	return format(buffer, size, fmt, token->type, token->span.beginning, token->span.size, representation_size, representation);
 }
 
 void initialize_parser(Parser *parser, const Source *source)
 {
 	set_memory(parser, sizeof(Parser), 0);
-	parser->location.source = source;
+	parser->source = source;
+	parser->location = source->base;
+	initialize_arena(&parser->strings, 0);
+	initialize_arena(&parser->artifacts, 64 * sizeof(Artifact));
+	initialize_arena(&parser->scopes, 16 * sizeof(Scope));
+	initialize_arena(&parser->labels, 0);
+	initialize_arena(&parser->references, 64 * sizeof(Reference));
+	initialize_arena(&parser->nodes, 256 * sizeof(Node));
 }
 
 static Size advance(Parser *parser, U32 *codepoint)
 {
-	U8 *pointer = &parser->location.source->data[parser->location.position];
+	const U8 *pointer = get_source_pointer(parser->source, parser->location);
 	Size size = decode_utf8(codepoint, pointer);
 	if (!size)
 	{
 		report_error("erroneous UTF-8 encoding.");
 		return 0;
 	}
-	parser->location.position += size;
+	parser->location += size;
 	return size;
 
 }
@@ -253,19 +545,326 @@ static bool check_number(U32 codepoint)
 	return iswdigit(codepoint);
 }
 
+static bool check_digit(U8 character)
+{
+	return (U8)(character - '0') < 10;
+}
+
+static Size add_literal(Parser *parser, const Literal *literal)
+{
+	Literal *result = (Literal *)reserve_from_buffer(&parser->literals, sizeof(Literal), alignof(Literal));
+	*result = *literal;
+	return result - (Literal *)parser->literals.pointer;
+}
+
+// checks whether all eight bytes of `chunk` are ASCII digits.
+static bool check_eight_digits(U64 chunk)
+{
+	return !(((chunk + 0x4646464646464646) | (chunk - 0x3030303030303030)) & 0x8080808080808080);
+}
+
+// converts eight ASCII digits (loaded little-endian) into their value with three multiplications.
+static U32 parse_eight_digits(U64 chunk)
+{
+	constexpr U64 mask        = 0x000000ff000000ff;
+	constexpr U64 multiplier1 = 100 + (1000000ull << 32);
+	constexpr U64 multiplier2 = 1 + (10000ull << 32);
+	chunk -= 0x3030303030303030;
+	chunk = chunk * 10 + (chunk >> 8);
+	chunk = ((chunk & mask) * multiplier1 + ((chunk >> 16) & mask) * multiplier2) >> 32;
+	return (U32)chunk;
+}
+
+// accumulates the decimal digits at `pointer` into `*value`, eight at a time while it can.
+// returns the number of digits read.
+static Size read_decimal_digits(const U8 *pointer, U64 *value, bool *overflowed)
+{
+	const U8 *beginning = pointer;
+	U64 result = *value;
+	bool overflow = false;
+	for (;;)
+	{
+		U64 chunk;
+		copy_memory(&chunk, pointer, sizeof(chunk));
+		if (!check_eight_digits(chunk))
+			break;
+		overflow |= __builtin_mul_overflow(result, 100000000, &result);
+		overflow |= __builtin_add_overflow(result, parse_eight_digits(chunk), &result);
+		pointer += 8;
+	}
+	while (check_digit(*pointer))
+	{
+		overflow |= __builtin_mul_overflow(result, 10, &result);
+		overflow |= __builtin_add_overflow(result, *pointer - '0', &result);
+		++pointer;
+	}
+	*value = result;
+	*overflowed |= overflow;
+	return pointer - beginning;
+}
+
+// returns the value of a hexadecimal digit, or something above 15 if it isn't one.
+static U32 get_digit_value(U8 character)
+{
+	if (check_digit(character))
+		return character - '0';
+	if ((U8)((character | 0x20) - 'a') < 6)
+		return (character | 0x20) - 'a' + 10;
+	return 0xff;
+}
+
+static Size read_radix_digits(const U8 *pointer, U32 shift, U64 *value, bool *overflowed)
+{
+	const U8 *beginning = pointer;
+	U32 radix = 1 << shift;
+	U64 result = 0;
+	for (U32 digit; (digit = get_digit_value(*pointer)) < radix; ++pointer)
+	{
+		if (result >> (64 - shift))
+			*overflowed = true;
+		result = result << shift | digit;
+	}
+	*value = result;
+	return pointer - beginning;
+}
+
+static void lex_number(Parser *parser, Token *token)
+{
+	const Source *source = parser->source;
+	const U8 *beginning = get_source_pointer(source, token->span.beginning);
+	const U8 *pointer = beginning;
+
+	Literal literal;
+	literal.type = Literal_Type_INTEGER;
+	U64 value = 0;
+	bool overflowed = false;
+
+	if (pointer[0] == '0' && ((pointer[1] | 0x20) == 'x' || (pointer[1] | 0x20) == 'b'))
+	{
+		U32 shift = (pointer[1] | 0x20) == 'x' ? 4 : 1;
+		pointer += 2;
+		Size digits_count = read_radix_digits(pointer, shift, &value, &overflowed);
+		pointer += digits_count;
+		if (!digits_count)
+		{
+			parser->location = get_source_location(source, pointer);
+			report_parsing_token_error(parser, "expected digits after the radix prefix.");
+		}
+	}
+	else
+	{
+		pointer += read_decimal_digits(pointer, &value, &overflowed);
+
+		int exponent = 0;
+		if (pointer[0] == '.' && check_digit(pointer[1]))
+		{
+			literal.type = Literal_Type_FLOAT;
+			++pointer;
+			Size fraction_size = read_decimal_digits(pointer, &value, &overflowed);
+			pointer += fraction_size;
+			exponent -= (int)fraction_size;
+		}
+		if ((pointer[0] | 0x20) == 'e')
+		{
+			const U8 *exponent_pointer = &pointer[1];
+			bool negative = *exponent_pointer == '-';
+			if (*exponent_pointer == '-' || *exponent_pointer == '+')
+				++exponent_pointer;
+			if (check_digit(*exponent_pointer))
+			{
+				literal.type = Literal_Type_FLOAT;
+				int explicit_exponent = 0;
+				for (; check_digit(*exponent_pointer); ++exponent_pointer)
+				{
+					// anything past this is an infinity or a zero anyway
+					if (explicit_exponent < 100000)
+						explicit_exponent = explicit_exponent * 10 + (*exponent_pointer - '0');
+				}
+				exponent += negative ? -explicit_exponent : explicit_exponent;
+				pointer = exponent_pointer;
+			}
+		}
+
+		if (literal.type == Literal_Type_FLOAT)
+		{
+			if (overflowed || !compute_float(value, exponent, &literal.floating))
+			{
+				// too many significant digits for the fast path; let the C library round it.
+				Size text_size = pointer - beginning;
+				Scratch scratch;
+				char *text = (char *)reserve_from_arena(scratch.arena, text_size + 1, 1);
+				copy_memory(text, beginning, text_size);
+				text[text_size] = 0;
+				literal.floating = strtod(text, 0);
+			}
+			overflowed = false;
+		}
+	}
+
+	token->span.size = pointer - beginning;
+	parser->location = token->span.beginning + token->span.size;
+
+	if (isalnum(*pointer) || *pointer == '_')
+		report_parsing_token_error(parser, "invalid suffix on a number literal: \"%c\".", *pointer);
+	if (overflowed)
+		report_parsing_token_error(parser, "integer literal is too large.");
+
+	if (literal.type == Literal_Type_INTEGER)
+	{
+		literal.integer = value;
+		token->type = Token_Type_INTEGER;
+	}
+	else
+		token->type = Token_Type_FLOAT;
+	token->value = add_literal(parser, &literal);
+}
+
+static bool decode_escape_sequence(const U8 **pointer, U8 *output)
+{
+	const U8 *escape = *pointer;
+	switch (escape[0])
+	{
+	case 'n':  *output = '\n'; break;
+	case 't':  *output = '\t'; break;
+	case 'r':  *output = '\r'; break;
+	case 'e':  *output = '\e'; break;
+	case '0':  *output = 0;    break;
+	case '\\': *output = '\\'; break;
+	case '"':  *output = '"';  break;
+	case '\'': *output = '\''; break;
+	case 'x':
+		{
+			U32 high = get_digit_value(escape[1]);
+			U32 low  = get_digit_value(escape[2]);
+			if (high >= 16 || low >= 16)
+				return false;
+			*output = (U8)(high << 4 | low);
+			*pointer += 2;
+		}
+		break;
+	default:
+		return false;
+	}
+	*pointer += 1;
+	return true;
+}
+
+static void lex_string(Parser *parser, Token *token)
+{
+	const Source *source = parser->source;
+	const U8 *beginning = get_source_pointer(source, token->span.beginning + 1);
+	const U8 *ending = &source->data[source->data_size];
+
+	// find the closing quote; a quote preceded by an odd number of backslashes is escaped.
+	const U8 *quote = beginning;
+	for (;;)
+	{
+		quote = (const U8 *)memchr(quote, '"', ending - quote);
+		if (!quote)
+		{
+			parser->location = get_source_location(source, ending);
+			token->type = Token_Type_NONE;
+			token->span.size = parser->location - token->span.beginning;
+			report_parsing_token_error(parser, "unterminated string literal.");
+			return;
+		}
+		const U8 *backslashes = quote;
+		while (backslashes > beginning && backslashes[-1] == '\\')
+			--backslashes;
+		if ((quote - backslashes) % 2 == 0)
+			break;
+		++quote;
+	}
+
+	token->type = Token_Type_STRING;
+	token->span.size = get_source_location(source, quote + 1) - token->span.beginning;
+	parser->location = token->span.beginning + token->span.size;
+
+	Literal literal;
+	literal.type = Literal_Type_STRING;
+	Size raw_size = quote - beginning;
+	const U8 *backslash = (const U8 *)memchr(beginning, '\\', raw_size);
+	if (!backslash)
+	{
+		// most strings have no escape sequences, so they're used straight from the source.
+		literal.string = intern_literal({beginning, raw_size});
+	}
+	else
+	{
+		Arena_Pointer decoding;
+		get_arena_pointer(&parser->strings, &decoding);
+		U8 *output = (U8 *)reserve_from_arena(&parser->strings, raw_size, 1);
+		U8 *cursor = output;
+		const U8 *input = beginning;
+		while (backslash)
+		{
+			Size segment_size = backslash - input;
+			copy_memory(cursor, input, segment_size);
+			cursor += segment_size;
+			input = backslash + 1;
+			if (!decode_escape_sequence(&input, cursor))
+				report_parsing_token_error(parser, "invalid escape sequence in string literal: \"\\%c\".", *input);
+			else
+				++cursor;
+			backslash = (const U8 *)memchr(input, '\\', quote - input);
+		}
+		Size segment_size = quote - input;
+		copy_memory(cursor, input, segment_size);
+		cursor += segment_size;
+		// the decoded bytes are given back if the literal was already pooled
+		literal.string = intern_literal({output, (Size)(cursor - output)});
+		if (literal.string.pointer != output)
+			set_arena(&decoding);
+	}
+	token->value = add_literal(parser, &literal);
+}
+
 static Token_Type lex(Parser *parser)
 {
 	Token *token = &parser->token;
-	const Source *source = parser->location.source;
+	const Source *source = parser->source;
 	U32 codepoint;
 	Size increment;
 
-	// skip whitespace
-	do
+	parser->previous_token_type = token->type;
+	parser->previous_token_ending = token->span.beginning + token->span.size;
+
+	// skip whitespace and comments
+	for (;;)
+	{
 		increment = advance(parser, &codepoint);
-	while (check_whitespace(codepoint));
+		if (check_whitespace(codepoint))
+			continue;
+		if (codepoint == '/')
+		{
+			const U8 *pointer = get_source_pointer(source, parser->location);
+			const U8 *ending = &source->data[source->data_size];
+			if (pointer[0] == '/')
+			{
+				const U8 *newline = (const U8 *)memchr(pointer, '\n', ending - pointer);
+				parser->location = get_source_location(source, newline ? newline : ending);
+				continue;
+			}
+			if (pointer[0] == '*')
+			{
+				Span span = {(Location)(parser->location - increment), 2};
+				const U8 *asterisk = pointer + 1;
+				while ((asterisk = (const U8 *)memchr(asterisk, '*', ending - asterisk)) && asterisk[1] != '/')
+					++asterisk;
+				if (!asterisk)
+				{
+					report_span_error(span, "unterminated comment.");
+					parser->location = get_source_location(source, ending);
+					continue;
+				}
+				parser->location = get_source_location(source, asterisk + 2);
+				continue;
+			}
+		}
+		break;
+	}
 
-	token->position = parser->location.position - increment;
+	token->span.beginning = parser->location - increment;
 
 	// get the type
 	switch (codepoint)
@@ -277,42 +876,72 @@ static Token_Type lex(Parser *parser)
 	case Token_Type_RIGHT_PARENTHESIS:
 	case Token_Type_LEFT_BRACE:
 	case Token_Type_RIGHT_BRACE:
+	case Token_Type_MINUS:
+	case Token_Type_EQUAL:
+	case Token_Type_COMMA:
+	case Token_Type_DOT:
+	case Token_Type_LEFT_BRACKET:
+	case Token_Type_RIGHT_BRACKET:
+	case Token_Type_QUESTION_MARK:
+	case Token_Type_AT:
+	case Token_Type_HASH:
+	case Token_Type_EXCLAMATION_MARK:
+	case Token_Type_LESS:
+	case Token_Type_GREATER:
+	case Token_Type_PLUS:
+	case Token_Type_ASTERISK:
+	case Token_Type_SLASH:
+	case Token_Type_PERCENT:
+	case Token_Type_AMPERSAND:
+	case Token_Type_BAR:
+	case Token_Type_CARET:
+	case Token_Type_TILDE:
+	case Token_Type_APOSTROPHE:
 		token->type = (Token_Type)codepoint;
-		token->size = 1;
+		token->span.size = 1;
+		for (Size i = 0; i < sizeof(compound_tokens) / sizeof(compound_tokens[0]); ++i)
+		{
+			const char *representation = compound_tokens[i].representation;
+			if (representation[0] == (char)codepoint && representation[1] == (char)*get_source_pointer(source, parser->location))
+			{
+				token->type = compound_tokens[i].type;
+				token->span.size = 2;
+				++parser->location;
+				break;
+			}
+		}
+		if (token->type == Token_Type_LEFT_BRACE)
+			++parser->braces_depth;
+		else if (token->type == Token_Type_RIGHT_BRACE && parser->braces_depth)
+			--parser->braces_depth;
+		break;
+	case '"':
+		lex_string(parser, token);
 		break;
 	default:
 		if (check_letter(codepoint) || codepoint == '_')
 		{
-			token->size = increment;
+			token->span.size = increment;
 			do
 			{
-				token->size += advance(parser, &codepoint);
+				token->span.size += advance(parser, &codepoint);
 				if (!codepoint)
 					break;
 			}
 			while (check_letter(codepoint) || codepoint == '_' || check_number(codepoint));
-			token->size -= increment;
-			parser->location.position -= increment;
-
-			// extract it as an identifier. (if it isn't an identifier, it'll be released later).
-			token->representation = (char *)reserve_from_buffer(&parser->identifiers, token->size + 1);
-			token->representation[token->size] = 0;
-			copy_memory(token->representation, &source->data[token->position], token->size);
+			token->span.size -= increment;
+			parser->location -= increment;
 
-			// check if it's a keyword
-			if (compare_string(token->representation, "proc") == 0)
-				token->type = Token_Type_PROC;
-			else
-				token->type = Token_Type_IDENTIFIER;
-
-			// release if it's an identifier
-			if (token->type != Token_Type_IDENTIFIER)
-				release_from_buffer(&parser->identifiers, token->size + 1);
+			// keywords are interned up front, so this also tells whether it's one.
+			token->value = intern_identifier(get_source_pointer(source, token->span.beginning), token->span.size);
+			token->type = get_identifier_keyword(token->value);
 		}
+		else if (check_number(codepoint))
+			lex_number(parser, token);
 		else
 		{
 			token->type = Token_Type_NONE;
-			token->size = 1;
+			token->span.size = increment;
 			report_parsing_token_error(parser, "unknown token: \"%c\".", codepoint);
 		}
 		break;
@@ -321,11 +950,11 @@ static Token_Type lex(Parser *parser)
 	// print the token
 #if defined ENABLE_DEBUGGING
 	{
-		Size size = format_token(0, 0, token);
+		Size size = format_token(0, 0, parser, token);
 		Array string;
 		initialize_array(&string, size + 1, 0);
 		((char *)string.pointer)[size] = 0;
-		format_token((char *)string.pointer, size + 1, token);
+		format_token((char *)string.pointer, size + 1, parser, token);
 		uninitialize_array(&string);
 	}
 #endif
@@ -333,85 +962,12543 @@ static Token_Type lex(Parser *parser)
 	return token->type;
 }
 
-Size parse(Parser *parser)
-{
-	Size errors_count = 0;
+// scopes
 
-	for (;;)
+struct Scope_Entry
+{
+	Identifier name;
+	bool declared; // declared in this scope, as opposed to a memoized resolution
+	union
 	{
-		Token_Type type = lex(parser);
-		if (type == Token_Type_NONE)
-			break;
+		Artifact *artifact;
+		Label *label;
+	};
+};
 
-		switch (type)
-		{
-		case Token_Type_IDENTIFIER:
-			{
-				Artifact *artifact = reserve_artifact(parser);
-			}
-			break;
-		default:
-			report_parsing_token_error(parser, "expected an identifier token.");
-			++errors_count;
-			break;
-		}
+static U32 get_scope_entry_index(Identifier name, U32 capacity)
+{
+	return (U32)(name * 0x9e3779b97f4a7c15 >> 32) & (capacity - 1);
+}
+
+static Scope_Entry *find_scope_entry(Scope_Table *table, Identifier name)
+{
+	if (!table->capacity)
+		return 0;
+	U32 mask = table->capacity - 1;
+	for (U32 index = get_scope_entry_index(name, table->capacity);; index = (index + 1) & mask)
+	{
+		Scope_Entry *entry = &table->entries[index];
+		if (!entry->name)
+			return 0;
+		if (entry->name == name)
+			return entry;
+	}
+}
 
-		if (errors_count)
+static Scope_Entry *add_scope_entry(Scope_Table *table, Identifier name)
+{
+	if ((table->count + 1) * 2 > table->capacity)
+	{
+		U32 capacity = table->capacity ? table->capacity * 2 : 8;
+		Scope_Entry *entries = (Scope_Entry *)allocate(capacity * sizeof(Scope_Entry));
+		set_memory(entries, capacity * sizeof(Scope_Entry), 0);
+		for (U32 i = 0; i < table->capacity; ++i)
 		{
-			do
-				type = lex(parser);
-			while (type != Token_Type_NONE);
-			break;
+			Scope_Entry *entry = &table->entries[i];
+			if (!entry->name)
+				continue;
+			U32 index = get_scope_entry_index(entry->name, capacity);
+			while (entries[index].name)
+				index = (index + 1) & (capacity - 1);
+			entries[index] = *entry;
 		}
+		deallocate(table->entries);
+		table->entries = entries;
+		table->capacity = capacity;
 	}
 
-	if (errors_count)
-		return errors_count;
+	U32 mask = table->capacity - 1;
+	U32 index = get_scope_entry_index(name, table->capacity);
+	while (table->entries[index].name)
+		index = (index + 1) & mask;
+	Scope_Entry *entry = &table->entries[index];
+	entry->name = name;
+	++table->count;
+	return entry;
+}
+
+// returns the artifact that is already declared with the same name in the scope, if any.
+static Artifact *insert_scope_artifact(Scope *scope, Artifact *artifact)
+{
+	if (Scope_Entry *entry = find_scope_entry(&scope->names, artifact->name))
+		return entry->artifact;
 
+	Scope_Entry *entry = add_scope_entry(&scope->names, artifact->name);
+	entry->declared = true;
+	entry->artifact = artifact;
+	add_to_list(&scope->artifacts, artifact);
 	return 0;
 }
 
-void v_report_parsing_error(Parser *parser, Size beginning, Size ending, const char *message, va_list args)
+Artifact *resolve_name(Scope *scope, Identifier name)
 {
-	++compilation_errors_count;
-	fprintf(stderr, "\e[1m%s:%lu: \e[31merror:\e[0m ", parser->location.source->path, parser->location.position);
-	vfprintf(stderr, message, args);
-	putc('\n', stderr);
+	if (!scope)
+		return find_global_artifact(name);
 
-	fprintf(stderr, "\t| ");
-	char *data = (char *)parser->location.source->data;
-	Size line_offset = beginning;
-	while (line_offset)
-	{
-		if (data[line_offset--] == '\n')
-			break;
+	if (Scope_Entry *entry = find_scope_entry(&scope->names, name))
+		return entry->artifact;
+
+	// the parent memoizes it as well, so the next lookup from any scope below it stops there.
+	Artifact *artifact = resolve_name(scope->parent, name);
+	add_scope_entry(&scope->names, name)->artifact = artifact;
+	return artifact;
+}
+
+Scope *get_ancestor(Scope *scope, Size levels)
+{
+	if (!scope || levels > scope->depth)
+		return 0;
+	return scope->ancestors[scope->depth - levels];
+}
+
+Artifact *resolve_backwards_name(Scope *scope, Size levels, Identifier name)
+{
+	Size depth = scope ? scope->depth + 1 : 0;
+	if (levels > depth)
+		return 0;
+	return resolve_name(get_ancestor(scope, levels), name);
+}
+
+Artifact *find_member(const Artifact *artifact, Identifier name)
+{
+	if (!artifact->body)
+		return 0;
+	Scope_Entry *entry = find_scope_entry(&artifact->body->names, name);
+	if (!entry || !entry->declared)
+		return 0;
+	return entry->artifact;
+}
+
+// reports whichever of the two declarations comes later.
+static void report_redeclaration(Identifier name, Span span, Span other_span)
+{
+	Span former = span;
+	Span latter = other_span;
+	if (latter.beginning < former.beginning)
+	{
+		former = other_span;
+		latter = span;
+	}
+
+	String string = get_identifier_string(name);
+	flockfile(stderr);
+	report_span_error(latter, "\"%.*s\" is already declared.", (int)string.size, string.pointer);
+	report_span_note(former, "previously declared here.");
+	funlockfile(stderr);
+}
+
+static Scope *open_scope(Parser *parser)
+{
+	Scope *parent = parser->current_scope;
+	Scope *scope = (Scope *)reserve_from_arena(&parser->scopes, sizeof(Scope), alignof(Scope));
+	set_memory(scope, sizeof(Scope), 0);
+	scope->parent = parent;
+	scope->depth = parent ? parent->depth + 1 : 0;
+	scope->ancestors = (Scope **)reserve_from_arena(&parser->scopes, (scope->depth + 1) * sizeof(Scope *), alignof(Scope *));
+	if (parent)
+	{
+		copy_memory(scope->ancestors, parent->ancestors, scope->depth * sizeof(Scope *));
+		scope->index = get_list_count(&parent->children);
+		add_to_list(&parent->children, scope);
+	}
+	scope->ancestors[scope->depth] = scope;
+	scope->top = parser->current_declaration;
+	if (!parent && parser->current_declaration)
+		add_to_list(&parser->current_declaration->scopes, scope);
+	return scope;
+}
+
+static Artifact *declare_artifact(Parser *parser, const Token *name)
+{
+	Artifact *artifact = reserve_artifact(parser);
+	artifact->name = name->value;
+	artifact->span = name->span;
+	artifact->scope = parser->current_scope;
+
+	Artifact *other;
+	if (parser->current_scope)
+		other = insert_scope_artifact(parser->current_scope, artifact);
+	else
+		other = insert_global_artifact(artifact);
+	if (other)
+		report_redeclaration(artifact->name, artifact->span, other->span);
+	return artifact;
+}
+
+// `levels` is the number of scopes that the search skips. a name right after `@` is weak, since what it
+// names doesn't have to be complete to take its address.
+static Reference *add_reference(Parser *parser, Span span, Identifier name, Size levels)
+{
+	Reference *reference = (Reference *)reserve_from_arena(&parser->references, sizeof(Reference), alignof(Reference));
+	reference->name = name;
+	reference->span = span;
+	reference->scope = parser->current_scope;
+	reference->levels = levels;
+	reference->weak = parser->procedure_bodies_depth || parser->previous_token_type == Token_Type_AT;
+	reference->artifact = 0;
+	reference->next = 0;
+	*parser->next_reference = reference;
+	parser->next_reference = &reference->next;
+	return reference;
+}
+
+// drops the references that were added since `tail` was the tail.
+static void drop_references(Parser *parser, Reference **tail)
+{
+	*tail = 0;
+	parser->next_reference = tail;
+}
+
+// returns null if it's a redeclaration.
+static Label *declare_label(Parser *parser, const Token *name)
+{
+	Scope *scope = parser->current_scope;
+	if (!scope)
+	{
+		report_span_error(name->span, "labels have to be inside a scope.");
+		return 0;
+	}
+
+	if (Scope_Entry *entry = find_scope_entry(&scope->labels, name->value))
+	{
+		report_redeclaration(name->value, name->span, entry->label->span);
+		return 0;
+	}
+
+	Label *label = (Label *)reserve_from_arena(&parser->labels, sizeof(Label), alignof(Label));
+	label->name = name->value;
+	label->span = name->span;
+	label->scope = scope;
+
+	Scope_Entry *entry = add_scope_entry(&scope->labels, name->value);
+	entry->declared = true;
+	entry->label = label;
+	return label;
+}
+
+// resolves the jumps that were waiting on the scope. the ones that this scope has no label for move on to
+// the parent, unless this is as far as the labels they can see go.
+static void close_scope(Scope *scope)
+{
+	Jump *jump = scope->pending_jumps;
+	scope->pending_jumps = 0;
+	while (jump)
+	{
+		Jump *next = jump->next;
+		if (Scope_Entry *entry = find_scope_entry(&scope->labels, jump->name))
+			jump->target = entry->label;
+		else if (scope->procedure || !scope->parent)
+		{
+			String name = get_identifier_string(jump->name);
+			report_span_error(jump->span, "there is no label \"%.*s\" to jump to.", (int)name.size, name.pointer);
+		}
+		else
+		{
+			jump->next = scope->parent->pending_jumps;
+			scope->parent->pending_jumps = jump;
+		}
+		jump = next;
+	}
+}
+
+Node *allocate_node(Parser *parser, Node_Type type)
+{
+	Node *node = (Node *)reserve_from_arena(&parser->nodes, sizeof(Node), alignof(Node));
+	set_memory(node, sizeof(Node), 0);
+	node->type = type;
+	node->span.beginning = parser->token.span.beginning;
+	return node;
+}
+
+static Node *allocate_node_at(Parser *parser, Node_Type type, Location beginning)
+{
+	Node *node = allocate_node(parser, type);
+	node->span.beginning = beginning;
+	return node;
+}
+
+// ends the node's span where the last token that it was parsed from ends.
+static Node *finish_node(Parser *parser, Node *node)
+{
+	node->span.size = parser->previous_token_ending - node->span.beginning;
+	return node;
+}
+
+// lists are parsed onto a stack first, since they can nest. artifacts go there too.
+static void push_node(Parser *parser, void *node)
+{
+	*(void **)reserve_from_buffer(&parser->node_stack, sizeof(void *), alignof(void *)) = node;
+}
+
+// moves whatever was pushed since `base` into the node's list.
+static void pop_nodes(Parser *parser, Node *node, Size base)
+{
+	Size size = parser->node_stack.mass - base;
+	node->count = size / sizeof(void *);
+	node->nodes = (Node **)reserve_from_arena(&parser->nodes, size, alignof(void *));
+	copy_memory(node->nodes, (U8 *)parser->node_stack.pointer + base, size);
+	parser->node_stack.mass = base;
+}
+
+static Size get_pushed_nodes_count(const Parser *parser, Size base)
+{
+	return (parser->node_stack.mass - base) / sizeof(void *);
+}
+
+static void **get_pushed_nodes(const Parser *parser, Size base)
+{
+	return (void **)((U8 *)parser->node_stack.pointer + base);
+}
+
+static bool check_identifier(Identifier identifier, const char *representation)
+{
+	String string = get_identifier_string(identifier);
+	return string.size == get_length_of_string(representation) && compare_memory(string.pointer, representation, string.size) == 0;
+}
+
+// whether the token can begin an argument of a call without parentheses
+static bool check_argument_beginning(Token_Type type)
+{
+	switch (type)
+	{
+	case Token_Type_IDENTIFIER:
+	case Token_Type_INTEGER:
+	case Token_Type_FLOAT:
+	case Token_Type_STRING:
+	case Token_Type_TRUE:
+	case Token_Type_FALSE:
+	case Token_Type_AT:
+	case Token_Type_APOSTROPHE:
+	case Token_Type_HASH:
+	case Token_Type_EXCLAMATION_MARK:
+	case Token_Type_TILDE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool check_assignment_operation(Token_Type type)
+{
+	switch (type)
+	{
+	case Token_Type_EQUAL:
+	case Token_Type_PLUS_EQUAL:
+	case Token_Type_MINUS_EQUAL:
+	case Token_Type_ASTERISK_EQUAL:
+	case Token_Type_SLASH_EQUAL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// zero if it isn't a binary operation
+static U32 get_binary_precedence(Token_Type type)
+{
+	switch (type)
+	{
+	case Token_Type_PIPE:
+		return 1;
+	case Token_Type_OR:
+		return 2;
+	case Token_Type_AND:
+		return 3;
+	case Token_Type_EQUAL_EQUAL:
+	case Token_Type_EXCLAMATION_EQUAL:
+	case Token_Type_LESS:
+	case Token_Type_GREATER:
+	case Token_Type_LESS_EQUAL:
+	case Token_Type_GREATER_EQUAL:
+		return 4;
+	case Token_Type_BAR:
+		return 5;
+	case Token_Type_CARET:
+		return 6;
+	case Token_Type_AMPERSAND:
+		return 7;
+	case Token_Type_LESS_LESS:
+	case Token_Type_GREATER_GREATER:
+		return 8;
+	case Token_Type_PLUS:
+	case Token_Type_MINUS:
+		return 9;
+	case Token_Type_ASTERISK:
+	case Token_Type_SLASH:
+	case Token_Type_PERCENT:
+		return 10;
+	default:
+		return 0;
+	}
+}
+
+static Node *parse_expression(Parser *parser);
+static Node *parse_unary(Parser *parser);
+static Node *parse_statement(Parser *parser);
+
+// a compound is only expected where the context has a type for it, so anywhere else a brace begins a block.
+static Node *parse_compound(Parser *parser);
+
+static Node *parse_value(Parser *parser, bool compound)
+{
+	if (compound && parser->token.type == Token_Type_LEFT_BRACE)
+		return parse_compound(parser);
+	return parse_expression(parser);
+}
+
+// a value, or a tuple of the values if there are several.
+static Node *parse_values(Parser *parser, bool compound)
+{
+	Node *value = parse_value(parser, compound);
+	if (!value || parser->token.type != Token_Type_COMMA)
+		return value;
+
+	Node *tuple = allocate_node_at(parser, Node_Type_TUPLE, value->span.beginning);
+	Size base = parser->node_stack.mass;
+	push_node(parser, value);
+	while (parser->token.type == Token_Type_COMMA)
+	{
+		lex(parser);
+		Node *element = parse_value(parser, compound);
+		if (!element)
+			return 0;
+		push_node(parser, element);
+	}
+	pop_nodes(parser, tuple, base);
+	return finish_node(parser, tuple);
+}
+
+// `{a, b}`, or `{name = a; name = b}`
+static Node *parse_compound(Parser *parser)
+{
+	Node *node = allocate_node(parser, Node_Type_COMPOUND);
+	Size base = parser->node_stack.mass;
+	lex(parser);
+	while (parser->token.type != Token_Type_RIGHT_BRACE)
+	{
+		Reference **references = parser->next_reference;
+		Node *element = parse_value(parser, true);
+		if (!element)
+			return 0;
+		bool named = element->type == Node_Type_ELEMENT || (element->type == Node_Type_NAME && !element->reference->levels);
+		if (named && parser->token.type == Token_Type_EQUAL)
+		{
+			// a member to set, rather than a name to resolve
+			if (element->type == Node_Type_NAME)
+			{
+				Identifier name = element->reference->name;
+				drop_references(parser, references);
+				element->name = name;
+			}
+			element->type = Node_Type_MEMBER;
+			lex(parser);
+			element->right = parse_value(parser, true);
+			if (!element->right)
+				return 0;
+			finish_node(parser, element);
+		}
+		push_node(parser, element);
+
+		if (parser->token.type == Token_Type_COMMA || parser->token.type == Token_Type_SEMICOLON)
+			lex(parser);
+		else if (parser->token.type != Token_Type_RIGHT_BRACE)
+		{
+			report_parsing_token_error(parser, "expected \",\" or \"}\" after the element.");
+			return 0;
+		}
+	}
+	lex(parser);
+	pop_nodes(parser, node, base);
+	return finish_node(parser, node);
+}
+
+// statements end with a semicolon, unless they end with a brace, are labels, or are the last in their block.
+static bool end_statement(Parser *parser, const Node *statement)
+{
+	Token_Type type = parser->token.type;
+	if (type == Token_Type_SEMICOLON)
+	{
+		lex(parser);
+		return true;
+	}
+	if (type == Token_Type_RIGHT_BRACE || statement->type == Node_Type_LABEL || parser->previous_token_type == Token_Type_RIGHT_BRACE)
+		return true;
+	report_parsing_token_error(parser, "expected \";\" after the statement.");
+	return false;
+}
+
+// `Token_Type_NONE` is also what unknown tokens are
+static bool check_source_ending(const Parser *parser)
+{
+	return parser->token.type == Token_Type_NONE && parser->token.span.beginning - parser->source->base >= parser->source->data_size;
+}
+
+// after a statement fails, the tokens are skipped up to the next semicolon in its block, or to the brace that closes
+// the block. returns false at the end of the source.
+static bool recover_statement(Parser *parser, Size depth)
+{
+	for (;;)
+	{
+		Token_Type type = parser->token.type;
+		if (check_source_ending(parser))
+			return false;
+		if (type == Token_Type_SEMICOLON && parser->braces_depth == depth)
+		{
+			lex(parser);
+			return true;
+		}
+		if (type == Token_Type_RIGHT_BRACE && parser->braces_depth < depth)
+			return true;
+		lex(parser);
+	}
+}
+
+// `{statements}`. a procedure's body is in the scope of the procedure; any other block opens its own. a statement that
+// fails is skipped, so the rest of the block is still parsed and its errors reported.
+static Node *parse_block(Parser *parser, Scope *scope)
+{
+	Node *node = allocate_node(parser, Node_Type_BLOCK);
+	Scope *outer_scope = parser->current_scope;
+	if (!scope)
+		scope = open_scope(parser);
+	node->scope = scope;
+	parser->current_scope = scope;
+
+	Size base = parser->node_stack.mass;
+	Size depth = parser->braces_depth;
+	Size procedure_bodies_depth = parser->procedure_bodies_depth;
+	bool braces_end_types = parser->braces_end_types;
+	parser->braces_end_types = false;
+	lex(parser);
+	while (parser->token.type != Token_Type_RIGHT_BRACE)
+	{
+		if (parser->token.type == Token_Type_NONE)
+		{
+			report_parsing_token_error(parser, "expected \"}\" before the end of the source.");
+			return 0;
+		}
+		Size mass = parser->node_stack.mass;
+		Node *statement = parse_statement(parser);
+		if (statement)
+			push_node(parser, statement);
+		if (statement && end_statement(parser, statement))
+			continue;
+
+		// what the statement left unfinished is dropped
+		++parser->skipped_statements_count;
+		parser->node_stack.mass = mass;
+		parser->current_scope = scope;
+		parser->procedure_bodies_depth = procedure_bodies_depth;
+		parser->braces_end_types = false;
+		if (check_compilation_stopped() || !recover_statement(parser, depth))
+			return 0;
+	}
+	parser->braces_end_types = braces_end_types;
+	close_scope(scope);
+	parser->current_scope = outer_scope;
+	lex(parser);
+	pop_nodes(parser, node, base);
+	return finish_node(parser, node);
+}
+
+// parses a declaration from the colon after its names, whose artifacts were pushed since `base`. values of
+// parameters and fields come one at a time, since commas separate those.
+static Node *parse_declaration(Parser *parser, Location beginning, Size base, bool values)
+{
+	Node *node = allocate_node_at(parser, Node_Type_DECLARATION, beginning);
+	pop_nodes(parser, node, base);
+	for (U32 i = 0; i < node->count; ++i)
+	{
+		node->artifacts[i]->node = node;
+		node->artifacts[i]->index = i;
+	}
+
+	Token_Type type = lex(parser);
+	if (type != Token_Type_COLON && type != Token_Type_EQUAL)
+	{
+		node->left = parse_expression(parser);
+		if (!node->left)
+			return 0;
+		type = parser->token.type;
+		if (type != Token_Type_COLON && type != Token_Type_EQUAL)
+			return finish_node(parser, node);
+	}
+	node->operation = type;
+	lex(parser);
+
+	bool compound = node->left != 0;
+	node->right = values ? parse_values(parser, compound) : parse_value(parser, compound);
+	if (!node->right)
+		return 0;
+
+	if (node->count == 1)
+	{
+		switch (node->right->type)
+		{
+		case Node_Type_PROCEDURE:
+		case Node_Type_STRUCT:
+		case Node_Type_UNION:
+		case Node_Type_ENUM:
+		case Node_Type_BLOCK:
+			if (Scope *scope = node->right->scope)
+			{
+				node->artifacts[0]->body = scope;
+				scope->owner = node->artifacts[0];
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return finish_node(parser, node);
+}
+
+// parses what begins with a list of values: a declaration if they are names followed by a colon, or else an
+// expression, a tuple, or an assignment to either.
+static Node *parse_declaration_or_expression(Parser *parser, bool values)
+{
+	Location beginning = parser->token.span.beginning;
+	Reference **references = parser->next_reference;
+	Size base = parser->node_stack.mass;
+	bool names = true;
+	for (;;)
+	{
+		Node *value = parse_value(parser, false);
+		if (!value)
+			return 0;
+		names = names && value->type == Node_Type_NAME && !value->reference->levels;
+		push_node(parser, value);
+		if (parser->token.type != Token_Type_COMMA)
+			break;
+		lex(parser);
+	}
+
+	Size count = get_pushed_nodes_count(parser, base);
+	void **pushed = get_pushed_nodes(parser, base);
+	if (names && parser->token.type == Token_Type_COLON)
+	{
+		// they are names to declare, rather than names to resolve
+		for (Size i = 0; i < count; ++i)
+		{
+			Reference *reference = ((Node *)pushed[i])->reference;
+			Token name = {Token_Type_IDENTIFIER, reference->span, reference->name};
+			pushed[i] = declare_artifact(parser, &name);
+		}
+		drop_references(parser, references);
+		return parse_declaration(parser, beginning, base, values);
+	}
+
+	Node *node = (Node *)pushed[0];
+	if (count > 1)
+	{
+		node = allocate_node_at(parser, Node_Type_TUPLE, beginning);
+		node->operation = Token_Type_COMMA;
+		pop_nodes(parser, node, base);
+		finish_node(parser, node);
+	}
+	else
+		parser->node_stack.mass = base;
+
+	if (!check_assignment_operation(parser->token.type))
+		return node;
+	Node *assignment = allocate_node_at(parser, Node_Type_ASSIGNMENT, beginning);
+	assignment->operation = parser->token.type;
+	assignment->left = node;
+	lex(parser);
+	assignment->right = values ? parse_values(parser, true) : parse_value(parser, true);
+	if (!assignment->right)
+		return 0;
+	return finish_node(parser, assignment);
+}
+
+// fields of structures and unions, or parameters and results of procedures, up to the closing token. each is a
+// declaration, or just a type. they are pushed.
+static bool parse_fields(Parser *parser, Token_Type separator, Token_Type closing)
+{
+	lex(parser);
+	while (parser->token.type != closing)
+	{
+		if (parser->token.type == Token_Type_NONE)
+		{
+			report_parsing_token_error(parser, "expected \"%c\" before the end of the source.", closing);
+			return false;
+		}
+
+		Node *node = parse_declaration_or_expression(parser, false);
+		if (!node)
+			return false;
+		if (node->type == Node_Type_DECLARATION)
+			push_node(parser, node);
+		else
+		{
+			// types without names
+			Size count = node->type == Node_Type_TUPLE && node->operation == Token_Type_COMMA ? node->count : 1;
+			for (Size i = 0; i < count; ++i)
+			{
+				Node *type = count == 1 ? node : node->nodes[i];
+				Node *field = allocate_node_at(parser, Node_Type_DECLARATION, type->span.beginning);
+				if (type->type == Node_Type_ASSIGNMENT && type->operation == Token_Type_EQUAL)
+				{
+					field->operation = Token_Type_EQUAL;
+					field->left = type->left;
+					field->right = type->right;
+				}
+				else
+					field->left = type;
+				field->span.size = type->span.size;
+				push_node(parser, field);
+			}
+		}
+
+		if (parser->token.type == separator)
+			lex(parser);
+		else if (parser->token.type != closing)
+		{
+			report_parsing_token_error(parser, "expected \"%c\" or \"%c\".", separator, closing);
+			return false;
+		}
+	}
+	return true;
+}
+
+// `proc(parameters) -> results {body}`, where each part is optional
+static Node *parse_procedure(Parser *parser)
+{
+	Node *node = allocate_node(parser, Node_Type_PROCEDURE);
+	Scope *outer_scope = parser->current_scope;
+	Scope *scope = open_scope(parser);
+	scope->procedure = true;
+	node->scope = scope;
+	parser->current_scope = scope;
+
+	Size base = parser->node_stack.mass;
+	if (lex(parser) == Token_Type_LEFT_PARENTHESIS)
+	{
+		if (!parse_fields(parser, Token_Type_COMMA, Token_Type_RIGHT_PARENTHESIS))
+			return 0;
+		lex(parser);
+	}
+	node->parameters_count = get_pushed_nodes_count(parser, base);
+
+	if (parser->token.type == Token_Type_ARROW)
+	{
+		if (lex(parser) == Token_Type_LEFT_PARENTHESIS)
+		{
+			if (!parse_fields(parser, Token_Type_COMMA, Token_Type_RIGHT_PARENTHESIS))
+				return 0;
+			lex(parser);
+		}
+		else
+		{
+			bool braces_end_types = parser->braces_end_types;
+			parser->braces_end_types = true;
+			Node *type = parse_expression(parser);
+			parser->braces_end_types = braces_end_types;
+			if (!type)
+				return 0;
+			Node *result = allocate_node_at(parser, Node_Type_DECLARATION, type->span.beginning);
+			result->left = type;
+			result->span.size = type->span.size;
+			push_node(parser, result);
+		}
+	}
+	parser->current_scope = outer_scope;
+
+	if (parser->token.type == Token_Type_LEFT_BRACE)
+	{
+		++parser->procedure_bodies_depth;
+		node->right = parse_block(parser, scope);
+		--parser->procedure_bodies_depth;
+		if (!node->right)
+			return 0;
+	}
+	pop_nodes(parser, node, base);
+	return finish_node(parser, node);
+}
+
+// `struct {fields}` or `union {fields}`
+static Node *parse_record(Parser *parser)
+{
+	Node *node = allocate_node(parser, parser->token.type == Token_Type_STRUCT ? Node_Type_STRUCT : Node_Type_UNION);
+	if (lex(parser) != Token_Type_LEFT_BRACE)
+		return finish_node(parser, node);
+
+	Scope *outer_scope = parser->current_scope;
+	node->scope = open_scope(parser);
+	parser->current_scope = node->scope;
+	Size base = parser->node_stack.mass;
+	if (!parse_fields(parser, Token_Type_SEMICOLON, Token_Type_RIGHT_BRACE))
+		return 0;
+	lex(parser);
+	parser->current_scope = outer_scope;
+	pop_nodes(parser, node, base);
+	return finish_node(parser, node);
+}
+
+// `enum -> type {NAME = value, NAME = value}`, where the type is optional
+static Node *parse_enumeration(Parser *parser)
+{
+	Node *node = allocate_node(parser, Node_Type_ENUM);
+	if (lex(parser) == Token_Type_ARROW)
+	{
+		lex(parser);
+		bool braces_end_types = parser->braces_end_types;
+		parser->braces_end_types = true;
+		node->left = parse_expression(parser);
+		parser->braces_end_types = braces_end_types;
+		if (!node->left)
+			return 0;
+	}
+	if (parser->token.type != Token_Type_LEFT_BRACE)
+		return finish_node(parser, node);
+
+	Scope *outer_scope = parser->current_scope;
+	node->scope = open_scope(parser);
+	parser->current_scope = node->scope;
+	Size base = parser->node_stack.mass;
+	lex(parser);
+	while (parser->token.type != Token_Type_RIGHT_BRACE)
+	{
+		if (parser->token.type != Token_Type_IDENTIFIER)
+		{
+			report_parsing_token_error(parser, "expected the name of an element.");
+			return 0;
+		}
+		Node *element = allocate_node(parser, Node_Type_DECLARATION);
+		Artifact *artifact = declare_artifact(parser, &parser->token);
+		artifact->node = element;
+		element->artifacts = (Artifact **)reserve_from_arena(&parser->nodes, sizeof(Artifact *), alignof(Artifact *));
+		element->artifacts[0] = artifact;
+		element->count = 1;
+		element->operation = Token_Type_COLON;
+		if (lex(parser) != Token_Type_EQUAL)
+		{
+			report_parsing_token_error(parser, "expected \"=\" and the value of the element.");
+			return 0;
+		}
+		lex(parser);
+		element->right = parse_value(parser, true);
+		if (!element->right)
+			return 0;
+		push_node(parser, finish_node(parser, element));
+
+		if (parser->token.type == Token_Type_COMMA || parser->token.type == Token_Type_SEMICOLON)
+			lex(parser);
+		else if (parser->token.type != Token_Type_RIGHT_BRACE)
+		{
+			report_parsing_token_error(parser, "expected \",\" or \"}\" after the element.");
+			return 0;
+		}
+	}
+	lex(parser);
+	parser->current_scope = outer_scope;
+	pop_nodes(parser, node, base);
+	return finish_node(parser, node);
+}
+
+// `(a, b)`, or just `a` in parentheses
+static Node *parse_parentheses(Parser *parser)
+{
+	Node *node = allocate_node(parser, Node_Type_TUPLE);
+	Size base = parser->node_stack.mass;
+	lex(parser);
+	while (parser->token.type != Token_Type_RIGHT_PARENTHESIS)
+	{
+		Node *element = parse_value(parser, true);
+		if (!element)
+			return 0;
+		push_node(parser, element);
+		if (parser->token.type == Token_Type_COMMA)
+			lex(parser);
+		else if (parser->token.type != Token_Type_RIGHT_PARENTHESIS)
+		{
+			report_parsing_token_error(parser, "expected \",\" or \")\" after the element.");
+			return 0;
+		}
+	}
+	lex(parser);
+	if (get_pushed_nodes_count(parser, base) == 1)
+	{
+		Node *element = (Node *)get_pushed_nodes(parser, base)[0];
+		parser->node_stack.mass = base;
+		return element;
+	}
+	pop_nodes(parser, node, base);
+	return finish_node(parser, node);
+}
+
+// parses the target of a `jump_to`. a jump whose label is already declared in the scope that the search starts
+// from is resolved right away; the others wait on that scope until it closes.
+static Node *parse_jump(Parser *parser)
+{
+	Node *node = allocate_node(parser, Node_Type_JUMP);
+	Token_Type type = lex(parser);
+	Location beginning = parser->token.span.beginning;
+	Size dots_count = 0;
+	for (; type == Token_Type_DOT; type = lex(parser))
+		++dots_count;
+	if (type != Token_Type_IDENTIFIER || dots_count == 1)
+	{
+		report_parsing_token_error(parser, "expected the name of a label, optionally preceded by \"..\".");
+		return 0;
+	}
+	Span span = {beginning, parser->location - beginning};
+	Identifier name = parser->token.value;
+	lex(parser);
+	finish_node(parser, node);
+
+	Scope *scope = parser->current_scope;
+	if (!scope)
+	{
+		report_span_error(span, "jumps have to be inside a scope.");
+		return node;
+	}
+
+	// the search can't leave the procedure
+	Size levels = dots_count ? dots_count - 1 : 0;
+	Scope *start = scope;
+	for (Size i = 0; i < levels; ++i)
+	{
+		if (start->procedure || !start->parent)
+		{
+			report_span_error(span, "there is no scope %lu levels up to jump into.", levels);
+			return node;
+		}
+		start = start->parent;
+	}
+
+	Jump *jump = (Jump *)reserve_from_arena(&parser->labels, sizeof(Jump), alignof(Jump));
+	jump->name = name;
+	jump->span = span;
+	jump->levels = levels;
+	jump->scope = scope;
+	jump->target = 0;
+	jump->next = 0;
+	if (Scope_Entry *entry = find_scope_entry(&start->labels, name))
+		jump->target = entry->label;
+	else
+	{
+		jump->next = start->pending_jumps;
+		start->pending_jumps = jump;
+	}
+	node->jump = jump;
+	return node;
+}
+
+static Node *parse_return(Parser *parser)
+{
+	Node *node = allocate_node(parser, Node_Type_RETURN);
+	switch (lex(parser))
+	{
+	case Token_Type_NONE:
+	case Token_Type_SEMICOLON:
+	case Token_Type_RIGHT_BRACE:
+	case Token_Type_COMMA:
+	case Token_Type_COLON:
+		break;
+	default:
+		node->left = parse_values(parser, true);
+		if (!node->left)
+			return 0;
+		break;
+	}
+	return finish_node(parser, node);
+}
+
+// the branches of conditionals and cases can also be statements.
+static Node *parse_branch(Parser *parser)
+{
+	switch (parser->token.type)
+	{
+	case Token_Type_JUMP_TO:
+		return parse_jump(parser);
+	case Token_Type_RETURN:
+		return parse_return(parser);
+	default:
+		break;
+	}
+
+	Node *node = parse_expression(parser);
+	if (!node || !check_assignment_operation(parser->token.type))
+		return node;
+	Node *assignment = allocate_node_at(parser, Node_Type_ASSIGNMENT, node->span.beginning);
+	assignment->operation = parser->token.type;
+	assignment->left = node;
+	lex(parser);
+	assignment->right = parse_value(parser, true);
+	if (!assignment->right)
+		return 0;
+	return finish_node(parser, assignment);
+}
+
+static Node *parse_primary(Parser *parser)
+{
+	Token *token = &parser->token;
+	switch (token->type)
+	{
+	case Token_Type_IDENTIFIER:
+		{
+			Node *node = allocate_node(parser, Node_Type_NAME);
+			node->reference = add_reference(parser, token->span, token->value, 0);
+			lex(parser);
+			return finish_node(parser, node);
+		}
+	case Token_Type_DOT:
+		{
+			// `.NAME` is an element; `..name`, `...name`, etc. are names from scopes further up
+			Node *node = allocate_node(parser, Node_Type_ELEMENT);
+			Size dots_count = 0;
+			for (; token->type == Token_Type_DOT; lex(parser))
+				++dots_count;
+			if (token->type != Token_Type_IDENTIFIER)
+			{
+				report_parsing_token_error(parser, "expected a name after \".\".");
+				return 0;
+			}
+			if (dots_count == 1)
+				node->name = token->value;
+			else
+			{
+				node->type = Node_Type_NAME;
+				Span span = {node->span.beginning, token->span.beginning + token->span.size - node->span.beginning};
+				node->reference = add_reference(parser, span, token->value, dots_count - 1);
+			}
+			lex(parser);
+			return finish_node(parser, node);
+		}
+	case Token_Type_APOSTROPHE:
+		{
+			Node *node = allocate_node(parser, Node_Type_ELEMENT);
+			if (lex(parser) != Token_Type_IDENTIFIER)
+			{
+				report_parsing_token_error(parser, "expected the name of an element after \"'\".");
+				return 0;
+			}
+			node->name = token->value;
+			lex(parser);
+			return finish_node(parser, node);
+		}
+	case Token_Type_INTEGER:
+	case Token_Type_FLOAT:
+	case Token_Type_STRING:
+		{
+			Node *node = allocate_node(parser, Node_Type_LITERAL);
+			node->literal = ((const Literal *)parser->literals.pointer)[token->value];
+			lex(parser);
+			return finish_node(parser, node);
+		}
+	case Token_Type_TRUE:
+	case Token_Type_FALSE:
+		{
+			Node *node = allocate_node(parser, Node_Type_BOOLEAN);
+			node->boolean = token->type == Token_Type_TRUE;
+			lex(parser);
+			return finish_node(parser, node);
+		}
+	case Token_Type_LEFT_PARENTHESIS:
+		return parse_parentheses(parser);
+	case Token_Type_LEFT_BRACE:
+		return parse_block(parser, 0);
+	case Token_Type_LEFT_BRACKET:
+		{
+			// `[]a` or `[b]a`
+			Node *node = allocate_node(parser, Node_Type_SLICE_TYPE);
+			if (lex(parser) != Token_Type_RIGHT_BRACKET)
+			{
+				node->type = Node_Type_ARRAY_TYPE;
+				node->right = parse_expression(parser);
+				if (!node->right)
+					return 0;
+				if (token->type != Token_Type_RIGHT_BRACKET)
+				{
+					report_parsing_token_error(parser, "expected \"]\" after the length of the array.");
+					return 0;
+				}
+			}
+			// a brace after the element type begins a compound of the array or slice type
+			lex(parser);
+			bool braces_end_types = parser->braces_end_types;
+			parser->braces_end_types = true;
+			node->left = parse_unary(parser);
+			parser->braces_end_types = braces_end_types;
+			if (!node->left)
+				return 0;
+			return finish_node(parser, node);
+		}
+	case Token_Type_PROC:
+		return parse_procedure(parser);
+	case Token_Type_STRUCT:
+	case Token_Type_UNION:
+		return parse_record(parser);
+	case Token_Type_ENUM:
+		return parse_enumeration(parser);
+	case Token_Type_HASH:
+		{
+			Node *node = allocate_node(parser, Node_Type_SIZE_OF);
+			if (lex(parser) != Token_Type_IDENTIFIER || !check_identifier(token->value, "size_of"))
+			{
+				report_parsing_token_error(parser, "expected the name of a directive that has a value.");
+				return 0;
+			}
+			lex(parser);
+			node->left = parse_unary(parser);
+			if (!node->left)
+				return 0;
+			return finish_node(parser, node);
+		}
+	default:
+		report_parsing_token_error(parser, "expected an expression.");
+		return 0;
+	}
+}
+
+// what a typed compound's type can be written as
+static bool check_compound_type_node(const Node *node)
+{
+	switch (node->type)
+	{
+	case Node_Type_NAME:
+	case Node_Type_MEMBER:
+	case Node_Type_SLICE_TYPE:
+	case Node_Type_ARRAY_TYPE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// member accesses, indexing and calls, including calls whose arguments aren't in parentheses
+static Node *parse_postfix(Parser *parser)
+{
+	Node *node = parse_primary(parser);
+	while (node)
+	{
+		Token_Type type = parser->token.type;
+		if (type == Token_Type_DOT)
+		{
+			Node *member = allocate_node_at(parser, Node_Type_MEMBER, node->span.beginning);
+			member->left = node;
+			if (lex(parser) != Token_Type_IDENTIFIER)
+			{
+				report_parsing_token_error(parser, "expected the name of a member after \".\".");
+				return 0;
+			}
+			member->name = parser->token.value;
+			lex(parser);
+			node = finish_node(parser, member);
+		}
+		else if (type == Token_Type_LEFT_BRACKET)
+		{
+			Node *index = allocate_node_at(parser, Node_Type_INDEX, node->span.beginning);
+			index->left = node;
+			lex(parser);
+			index->right = parse_expression(parser);
+			if (!index->right)
+				return 0;
+			if (parser->token.type != Token_Type_RIGHT_BRACKET)
+			{
+				report_parsing_token_error(parser, "expected \"]\" after the index.");
+				return 0;
+			}
+			lex(parser);
+			node = finish_node(parser, index);
+		}
+		else if (type == Token_Type_LEFT_PARENTHESIS)
+		{
+			Node *call = parse_parentheses(parser);
+			if (!call)
+				return 0;
+			Node *arguments = call;
+			call = allocate_node_at(parser, Node_Type_CALL, node->span.beginning);
+			call->left = node;
+			if (arguments->type == Node_Type_TUPLE)
+			{
+				call->nodes = arguments->nodes;
+				call->count = arguments->count;
+			}
+			else
+			{
+				call->nodes = (Node **)reserve_from_arena(&parser->nodes, sizeof(Node *), alignof(Node *));
+				call->nodes[0] = arguments;
+				call->count = 1;
+			}
+			node = finish_node(parser, call);
+		}
+		else if (type == Token_Type_LEFT_BRACE && !parser->braces_end_types && check_compound_type_node(node))
+		{
+			// `Type {elements}`
+			Node *compound = parse_compound(parser);
+			if (!compound)
+				return 0;
+			compound->left = node;
+			compound->span.size += compound->span.beginning - node->span.beginning;
+			compound->span.beginning = node->span.beginning;
+			node = compound;
+		}
+		else
+			break;
+	}
+
+	// nothing that ends with a brace is called this way, so a block can be followed by the next statement
+	if (node && check_argument_beginning(parser->token.type) && parser->previous_token_type != Token_Type_RIGHT_BRACE)
+	{
+		Node *call = allocate_node_at(parser, Node_Type_CALL, node->span.beginning);
+		call->left = node;
+		Size base = parser->node_stack.mass;
+		for (;;)
+		{
+			Node *argument = parse_value(parser, true);
+			if (!argument)
+				return 0;
+			push_node(parser, argument);
+			if (parser->token.type != Token_Type_COMMA)
+				break;
+			lex(parser);
+		}
+		pop_nodes(parser, call, base);
+		node = finish_node(parser, call);
+	}
+	return node;
+}
+
+static Node *parse_unary(Parser *parser)
+{
+	switch (parser->token.type)
+	{
+	case Token_Type_MINUS:
+	case Token_Type_EXCLAMATION_MARK:
+	case Token_Type_TILDE:
+	case Token_Type_AT:
+		{
+			Node *node = allocate_node(parser, Node_Type_UNARY);
+			node->operation = parser->token.type;
+			lex(parser);
+			node->left = parse_unary(parser);
+			if (!node->left)
+				return 0;
+			return finish_node(parser, node);
+		}
+	default:
+		return parse_postfix(parser);
+	}
+}
+
+// `a == {values ? b, values ? b} : c`, from the brace
+static Node *parse_switch(Parser *parser, Node *node)
+{
+	node->type = Node_Type_SWITCH;
+	node->operation = Token_Type_NONE;
+	Size base = parser->node_stack.mass;
+	lex(parser);
+	while (parser->token.type != Token_Type_RIGHT_BRACE)
+	{
+		Node *case_node = allocate_node(parser, Node_Type_CASE);
+		Size values_base = parser->node_stack.mass;
+		for (;;)
+		{
+			Node *value = parse_expression(parser);
+			if (!value)
+				return 0;
+			if (value->type == Node_Type_CONDITIONAL && !value->other)
+			{
+				// the last value, and the result
+				push_node(parser, value->left);
+				case_node->left = value->right;
+				break;
+			}
+			push_node(parser, value);
+			if (parser->token.type != Token_Type_COMMA)
+			{
+				report_parsing_token_error(parser, "expected \"?\" after the values of the case.");
+				return 0;
+			}
+			lex(parser);
+		}
+		pop_nodes(parser, case_node, values_base);
+		push_node(parser, finish_node(parser, case_node));
+
+		if (parser->token.type == Token_Type_COMMA || parser->token.type == Token_Type_SEMICOLON)
+			lex(parser);
+		else if (parser->token.type != Token_Type_RIGHT_BRACE)
+		{
+			report_parsing_token_error(parser, "expected \",\" or \"}\" after the case.");
+			return 0;
+		}
+	}
+	lex(parser);
+	pop_nodes(parser, node, base);
+
+	if (parser->token.type == Token_Type_COLON)
+	{
+		lex(parser);
+		node->other = parse_branch(parser);
+		if (!node->other)
+			return 0;
+	}
+	return node;
+}
+
+static Node *parse_binary(Parser *parser, U32 precedence)
+{
+	Node *left = parse_unary(parser);
+	while (left)
+	{
+		Token_Type operation = parser->token.type;
+		U32 operation_precedence = get_binary_precedence(operation);
+		if (operation_precedence <= precedence)
+			break;
+
+		Node *node = allocate_node_at(parser, Node_Type_BINARY, left->span.beginning);
+		node->operation = operation;
+		node->left = left;
+		if (lex(parser) == Token_Type_LEFT_BRACE && operation == Token_Type_EQUAL_EQUAL)
+		{
+			if (!parse_switch(parser, node))
+				return 0;
+		}
+		else
+		{
+			node->right = parse_binary(parser, operation_precedence);
+			if (!node->right)
+				return 0;
+		}
+		left = finish_node(parser, node);
+	}
+	return left;
+}
+
+// also `a ? b : c`
+static Node *parse_expression(Parser *parser)
+{
+	Node *node = parse_binary(parser, 0);
+	if (!node || parser->token.type != Token_Type_QUESTION_MARK)
+		return node;
+
+	Node *conditional = allocate_node_at(parser, Node_Type_CONDITIONAL, node->span.beginning);
+	conditional->left = node;
+	lex(parser);
+	conditional->right = parse_branch(parser);
+	if (!conditional->right)
+		return 0;
+	if (parser->token.type == Token_Type_COLON)
+	{
+		lex(parser);
+		conditional->other = parse_branch(parser);
+		if (!conditional->other)
+			return 0;
+	}
+	return finish_node(parser, conditional);
+}
+
+static Node *parse_statement(Parser *parser)
+{
+	switch (parser->token.type)
+	{
+	case Token_Type_LEFT_BRACKET:
+		{
+			Node *node = allocate_node(parser, Node_Type_LABEL);
+			if (lex(parser) != Token_Type_IDENTIFIER)
+			{
+				report_parsing_token_error(parser, "expected the name of a label.");
+				return 0;
+			}
+			Token name = parser->token;
+			if (lex(parser) != Token_Type_RIGHT_BRACKET)
+			{
+				report_parsing_token_error(parser, "expected \"]\" after the name of the label.");
+				return 0;
+			}
+			lex(parser);
+			node->label = declare_label(parser, &name);
+			return finish_node(parser, node);
+		}
+	case Token_Type_LEFT_BRACE:
+		// a block ends its statement, so what follows it is the next statement, even if it's a label
+		return parse_block(parser, 0);
+	case Token_Type_JUMP_TO:
+		return parse_jump(parser);
+	case Token_Type_RETURN:
+		return parse_return(parser);
+	case Token_Type_HASH:
+		{
+			Location beginning = parser->token.span.beginning;
+			if (lex(parser) != Token_Type_IDENTIFIER || !check_identifier(parser->token.value, "static"))
+			{
+				report_parsing_token_error(parser, "expected \"static\"; no other directive begins a statement.");
+				return 0;
+			}
+			lex(parser);
+			Node *node = parse_declaration_or_expression(parser, true);
+			if (!node)
+				return 0;
+			if (node->type != Node_Type_DECLARATION)
+			{
+				report_span_error(node->span, "expected a declaration after \"#static\".");
+				return 0;
+			}
+			node->is_static = true;
+			node->span.size += node->span.beginning - beginning;
+			node->span.beginning = beginning;
+			return node;
+		}
+	default:
+		return parse_declaration_or_expression(parser, true);
+	}
+}
+
+static bool parse_top_level_declaration(Parser *parser, Location beginning)
+{
+	Token_Type type = parser->token.type;
+	bool exported = false;
+	if (type == Token_Type_HASH)
+	{
+		if (lex(parser) != Token_Type_IDENTIFIER || !check_identifier(parser->token.value, "export"))
+		{
+			report_parsing_token_error(parser, "expected \"export\"; no other directive begins a declaration.");
+			return false;
+		}
+		exported = true;
+		type = lex(parser);
+	}
+	if (type != Token_Type_IDENTIFIER)
+	{
+		// unknown tokens were reported when they were lexed, but null characters weren't
+		if (type != Token_Type_NONE || !*get_source_pointer(parser->source, parser->token.span.beginning))
+			report_parsing_token_error(parser, "expected a declaration.");
+		return false;
+	}
+	Token name = parser->token;
+
+	if (lex(parser) != Token_Type_COLON)
+	{
+		report_parsing_token_error(parser, "expected \":\" after the name of the declaration.");
+		return false;
+	}
+
+	Artifact *artifact = declare_artifact(parser, &name);
+	artifact->exported = exported;
+	add_to_list(&parser->declarations, artifact);
+	parser->current_declaration = artifact;
+	parser->next_reference = &artifact->references;
+	parser->node_stack.mass = 0;
+	push_node(parser, artifact);
+	Node *node = parse_declaration(parser, beginning, 0, true);
+	return node && end_statement(parser, node);
+}
+
+// the tokens are skipped up to the end of a top-level statement, or to a line that begins at the top level with what
+// may begin a declaration, but not the one that failed
+static void recover(Parser *parser, Location beginning)
+{
+	parser->current_scope = 0;
+	parser->procedure_bodies_depth = 0;
+	for (;;)
+	{
+		Token_Type type = parser->token.type;
+		if (check_source_ending(parser))
+			return;
+		if (!parser->braces_depth)
+		{
+			if (type == Token_Type_SEMICOLON)
+			{
+				lex(parser);
+				return;
+			}
+			if (type == Token_Type_RIGHT_BRACE)
+			{
+				if (lex(parser) == Token_Type_SEMICOLON)
+					lex(parser);
+				return;
+			}
+			if ((type == Token_Type_IDENTIFIER || type == Token_Type_HASH) && parser->token.span.beginning != beginning)
+			{
+				const U8 *pointer = get_source_pointer(parser->source, parser->token.span.beginning);
+				if (pointer == parser->source->data || pointer[-1] == '\n')
+					return;
+			}
+		}
+		lex(parser);
+	}
+}
+
+Size parse(Parser *parser)
+{
+	Size errors_count = 0;
+
+	lex(parser);
+	while (!check_source_ending(parser) && !check_compilation_stopped())
+	{
+		Location beginning = parser->token.span.beginning;
+		Size skipped_statements_count = parser->skipped_statements_count;
+		bool parsed = parse_top_level_declaration(parser, beginning);
+		if (!parsed)
+			recover(parser, beginning);
+		if (!parsed || parser->skipped_statements_count != skipped_statements_count)
+			++errors_count;
+	}
+
+	return errors_count;
+}
+
+Artifact *reserve_artifact(Parser *parser)
+{
+	Artifact *artifact = (Artifact *)reserve_from_arena(&parser->artifacts, sizeof(Artifact), alignof(Artifact));
+	set_memory(artifact, sizeof(Artifact), 0);
+	return artifact;
+}
+
+// identifiers
+
+// the entries of a shard are never moved, so an identifier can be looked up without taking the shard's lock.
+struct Identifier_Entry
+{
+	const Utf8 *pointer;
+	U32 size;
+	Token_Type keyword;
+};
+
+struct Identifier_Slot
+{
+	U32 hash;
+	Identifier identifier;
+};
+
+struct alignas(64) Identifier_Shard
+{
+	Mutex mutex;
+	Size count;
+	Size slots_capacity;
+	Identifier_Slot *slots;
+	Identifier_Entry *entries; // the first one is unused, so no identifier is zero
+	Arena strings;
+};
+
+static Identifier_Shard identifier_shards[IDENTIFIER_SHARDS_COUNT];
+
+U64 hash_memory(const void *pointer, Size size)
+{
+	const U8 *bytes = (const U8 *)pointer;
+	U64 hash = 0x9e3779b97f4a7c15 ^ size;
+	for (; size >= 8; size -= 8, bytes += 8)
+	{
+		U64 word;
+		copy_memory(&word, bytes, sizeof(word));
+		hash = (hash ^ word) * 0xff51afd7ed558ccd;
+		hash ^= hash >> 32;
+	}
+	U64 word = 0;
+	if (size)
+		copy_memory(&word, bytes, size);
+	hash = (hash ^ word) * 0xc4ceb9fe1a85ec53;
+	hash ^= hash >> 29;
+	return hash;
+}
+
+static void grow_identifier_shard(Identifier_Shard *shard)
+{
+	Size capacity = shard->slots_capacity * 2;
+	Identifier_Slot *slots = (Identifier_Slot *)allocate(capacity * sizeof(Identifier_Slot));
+	set_memory(slots, capacity * sizeof(Identifier_Slot), 0);
+	for (Size i = 0; i < shard->slots_capacity; ++i)
+	{
+		Identifier_Slot *slot = &shard->slots[i];
+		if (!slot->identifier)
+			continue;
+		Size index = slot->hash & (capacity - 1);
+		while (slots[index].identifier)
+			index = (index + 1) & (capacity - 1);
+		slots[index] = *slot;
+	}
+	deallocate(shard->slots);
+	shard->slots = slots;
+	shard->slots_capacity = capacity;
+}
+
+void initialize_identifiers(void)
+{
+	for (Size i = 0; i < IDENTIFIER_SHARDS_COUNT; ++i)
+	{
+		Identifier_Shard *shard = &identifier_shards[i];
+		initialize_mutex(&shard->mutex);
+		shard->count = 0;
+		shard->slots_capacity = 256;
+		shard->slots = (Identifier_Slot *)allocate(shard->slots_capacity * sizeof(Identifier_Slot));
+		set_memory(shard->slots, shard->slots_capacity * sizeof(Identifier_Slot), 0);
+		shard->entries = (Identifier_Entry *)allocate_virtual_memory(0, MAXIMUM_IDENTIFIERS_COUNT_PER_SHARD * sizeof(Identifier_Entry));
+		initialize_arena(&shard->strings, 0);
+	}
+
+	struct
+	{
+		const char *representation;
+		Token_Type type;
+	}
+	keywords[] =
+	{
+		{"proc",    Token_Type_PROC},
+		{"jump_to", Token_Type_JUMP_TO},
+		{"struct",  Token_Type_STRUCT},
+		{"union",   Token_Type_UNION},
+		{"enum",    Token_Type_ENUM},
+		{"return",  Token_Type_RETURN},
+		{"true",    Token_Type_TRUE},
+		{"false",   Token_Type_FALSE},
+	};
+	for (Size i = 0; i < sizeof(keywords) / sizeof(keywords[0]); ++i)
+	{
+		Identifier identifier = intern_identifier((const Utf8 *)keywords[i].representation, get_length_of_string(keywords[i].representation));
+		identifier_shards[identifier & (IDENTIFIER_SHARDS_COUNT - 1)].entries[identifier >> IDENTIFIER_SHARDS_COUNT_LOG2].keyword = keywords[i].type;
+	}
+}
+
+Identifier intern_identifier(const Utf8 *pointer, Size size)
+{
+	U64 hash = hash_memory(pointer, size);
+	Size shard_index = hash & (IDENTIFIER_SHARDS_COUNT - 1);
+	Identifier_Shard *shard = &identifier_shards[shard_index];
+	U32 slot_hash = (U32)(hash >> 32);
+
+	lock_mutex(&shard->mutex);
+
+	if ((shard->count + 1) * 2 > shard->slots_capacity)
+		grow_identifier_shard(shard);
+
+	Size mask = shard->slots_capacity - 1;
+	Size index = slot_hash & mask;
+	for (;; index = (index + 1) & mask)
+	{
+		Identifier_Slot *slot = &shard->slots[index];
+		if (!slot->identifier)
+			break;
+		if (slot->hash != slot_hash)
+			continue;
+		Identifier_Entry *entry = &shard->entries[slot->identifier >> IDENTIFIER_SHARDS_COUNT_LOG2];
+		if (entry->size == size && compare_memory(entry->pointer, pointer, size) == 0)
+		{
+			Identifier identifier = slot->identifier;
+			unlock_mutex(&shard->mutex);
+			return identifier;
+		}
+	}
+
+	if (shard->count + 1 >= MAXIMUM_IDENTIFIERS_COUNT_PER_SHARD)
+	{
+		unlock_mutex(&shard->mutex);
+		report_error("too many distinct identifiers.");
+		return 0;
+	}
+
+	Size entry_index = ++shard->count;
+	Utf8 *string = (Utf8 *)reserve_from_arena(&shard->strings, size + 1, 1);
+	copy_memory(string, pointer, size);
+	string[size] = 0;
+
+	Identifier_Entry *entry = &shard->entries[entry_index];
+	entry->pointer = string;
+	entry->size = (U32)size;
+	entry->keyword = Token_Type_IDENTIFIER;
+
+	Identifier identifier = (Identifier)(entry_index << IDENTIFIER_SHARDS_COUNT_LOG2 | shard_index);
+	shard->slots[index] = {slot_hash, identifier};
+
+	unlock_mutex(&shard->mutex);
+	return identifier;
+}
+
+static Identifier_Entry *get_identifier_entry(Identifier identifier)
+{
+	Identifier_Shard *shard = &identifier_shards[identifier & (IDENTIFIER_SHARDS_COUNT - 1)];
+	return &shard->entries[identifier >> IDENTIFIER_SHARDS_COUNT_LOG2];
+}
+
+String get_identifier_string(Identifier identifier)
+{
+	Identifier_Entry *entry = get_identifier_entry(identifier);
+	return {entry->pointer, entry->size};
+}
+
+Token_Type get_identifier_keyword(Identifier identifier)
+{
+	return get_identifier_entry(identifier)->keyword;
+}
+
+// string literals
+
+constexpr Size LITERAL_SHARDS_COUNT = IDENTIFIER_SHARDS_COUNT;
+
+struct Literal_Slot
+{
+	U64 hash;
+	String string; // the pointer is null if the slot is empty
+};
+
+struct alignas(64) Literal_Shard
+{
+	Mutex mutex;
+	Size count;
+	Size slots_capacity;
+	Literal_Slot *slots;
+};
+
+static Literal_Shard literal_shards[LITERAL_SHARDS_COUNT];
+
+static void grow_literal_shard(Literal_Shard *shard)
+{
+	Size capacity = shard->slots_capacity * 2;
+	Literal_Slot *slots = (Literal_Slot *)allocate(capacity * sizeof(Literal_Slot));
+	set_memory(slots, capacity * sizeof(Literal_Slot), 0);
+	for (Size i = 0; i < shard->slots_capacity; ++i)
+	{
+		Literal_Slot *slot = &shard->slots[i];
+		if (!slot->string.pointer)
+			continue;
+		Size index = slot->hash & (capacity - 1);
+		while (slots[index].string.pointer)
+			index = (index + 1) & (capacity - 1);
+		slots[index] = *slot;
+	}
+	deallocate(shard->slots);
+	shard->slots = slots;
+	shard->slots_capacity = capacity;
+}
+
+void initialize_literals(void)
+{
+	for (Size i = 0; i < LITERAL_SHARDS_COUNT; ++i)
+	{
+		Literal_Shard *shard = &literal_shards[i];
+		initialize_mutex(&shard->mutex);
+		shard->count = 0;
+		shard->slots_capacity = 64;
+		shard->slots = (Literal_Slot *)allocate(shard->slots_capacity * sizeof(Literal_Slot));
+		set_memory(shard->slots, shard->slots_capacity * sizeof(Literal_Slot), 0);
+	}
+}
+
+String intern_literal(String string)
+{
+	U64 hash = hash_memory(string.pointer, string.size);
+	Literal_Shard *shard = &literal_shards[hash & (LITERAL_SHARDS_COUNT - 1)];
+	U64 slot_hash = hash >> IDENTIFIER_SHARDS_COUNT_LOG2;
+
+	lock_mutex(&shard->mutex);
+
+	if ((shard->count + 1) * 2 > shard->slots_capacity)
+		grow_literal_shard(shard);
+
+	Size mask = shard->slots_capacity - 1;
+	Size index = slot_hash & mask;
+	for (;; index = (index + 1) & mask)
+	{
+		Literal_Slot *slot = &shard->slots[index];
+		if (!slot->string.pointer)
+			break;
+		if (slot->hash == slot_hash && slot->string.size == string.size &&
+		    compare_memory(slot->string.pointer, string.pointer, string.size) == 0)
+		{
+			String pooled = slot->string;
+			unlock_mutex(&shard->mutex);
+			return pooled;
+		}
+	}
+
+	++shard->count;
+	shard->slots[index] = {slot_hash, string};
+
+	unlock_mutex(&shard->mutex);
+	return string;
+}
+
+// symbol table
+
+constexpr Size SYMBOL_TABLE_SHARDS_COUNT = IDENTIFIER_SHARDS_COUNT;
+
+struct Symbol_Slot
+{
+	Identifier name;
+	Artifact *artifact;
+};
+
+struct alignas(64) Symbol_Shard
+{
+	Mutex mutex;
+	Size count;
+	Size slots_capacity;
+	Symbol_Slot *slots;
+};
+
+static Symbol_Shard symbol_shards[SYMBOL_TABLE_SHARDS_COUNT];
+
+// an identifier's low bits already come from its hash, so they pick the shard; the rest picks the slot.
+static Size get_symbol_slot_index(Identifier name, Size capacity)
+{
+	return ((name >> IDENTIFIER_SHARDS_COUNT_LOG2) * 0x9e3779b97f4a7c15 >> 32) & (capacity - 1);
+}
+
+static void grow_symbol_shard(Symbol_Shard *shard)
+{
+	Size capacity = shard->slots_capacity * 2;
+	Symbol_Slot *slots = (Symbol_Slot *)allocate(capacity * sizeof(Symbol_Slot));
+	set_memory(slots, capacity * sizeof(Symbol_Slot), 0);
+	for (Size i = 0; i < shard->slots_capacity; ++i)
+	{
+		Symbol_Slot *slot = &shard->slots[i];
+		if (!slot->name)
+			continue;
+		Size index = get_symbol_slot_index(slot->name, capacity);
+		while (slots[index].name)
+			index = (index + 1) & (capacity - 1);
+		slots[index] = *slot;
+	}
+	deallocate(shard->slots);
+	shard->slots = slots;
+	shard->slots_capacity = capacity;
+}
+
+void initialize_symbol_table(void)
+{
+	for (Size i = 0; i < SYMBOL_TABLE_SHARDS_COUNT; ++i)
+	{
+		Symbol_Shard *shard = &symbol_shards[i];
+		initialize_mutex(&shard->mutex);
+		shard->count = 0;
+		shard->slots_capacity = 64;
+		shard->slots = (Symbol_Slot *)allocate(shard->slots_capacity * sizeof(Symbol_Slot));
+		set_memory(shard->slots, shard->slots_capacity * sizeof(Symbol_Slot), 0);
+	}
+}
+
+Artifact *insert_global_artifact(Artifact *artifact)
+{
+	Symbol_Shard *shard = &symbol_shards[artifact->name & (SYMBOL_TABLE_SHARDS_COUNT - 1)];
+	lock_mutex(&shard->mutex);
+
+	if ((shard->count + 1) * 2 > shard->slots_capacity)
+		grow_symbol_shard(shard);
+
+	Artifact *other = 0;
+	Size mask = shard->slots_capacity - 1;
+	for (Size index = get_symbol_slot_index(artifact->name, shard->slots_capacity);; index = (index + 1) & mask)
+	{
+		Symbol_Slot *slot = &shard->slots[index];
+		if (!slot->name)
+		{
+			*slot = {artifact->name, artifact};
+			++shard->count;
+			break;
+		}
+		if (slot->name == artifact->name)
+		{
+			other = slot->artifact;
+			if (artifact->span.beginning < other->span.beginning)
+				slot->artifact = artifact;
+			break;
+		}
+	}
+
+	unlock_mutex(&shard->mutex);
+	return other;
+}
+
+Artifact *find_global_artifact(Identifier name)
+{
+	Symbol_Shard *shard = &symbol_shards[name & (SYMBOL_TABLE_SHARDS_COUNT - 1)];
+	lock_mutex(&shard->mutex);
+
+	Artifact *artifact = 0;
+	Size mask = shard->slots_capacity - 1;
+	for (Size index = get_symbol_slot_index(name, shard->slots_capacity);; index = (index + 1) & mask)
+	{
+		Symbol_Slot *slot = &shard->slots[index];
+		if (!slot->name)
+			break;
+		if (slot->name == name)
+		{
+			artifact = slot->artifact;
+			break;
+		}
+	}
+
+	unlock_mutex(&shard->mutex);
+	return artifact;
+}
+
+// types
+
+constexpr Size TYPE_SHARDS_COUNT = 16;
+
+struct Type_Slot
+{
+	U32 hash;
+	Type_Id type;
+};
+
+struct alignas(64) Type_Shard
+{
+	Mutex mutex;
+	Size count;
+	Size slots_capacity;
+	Type_Slot *slots;
+	Arena elements; // of the types in this shard
+};
+
+static Type_Shard type_shards[TYPE_SHARDS_COUNT];
+
+// IDs are handed out in order from one counter, so a type is always at `types[id]` and never moves.
+static Type *types;
+static Type_Id types_count;
+
+static struct
+{
+	const char *representation;
+	Type_Id type;
+	Identifier name;
+}
+builtin_types[] =
+{
+	{"Void",   Type_Id_VOID, 0},
+	{"Bool",   Type_Id_BOOL, 0},
+	{"U8",     Type_Id_U8, 0},
+	{"U16",    Type_Id_U16, 0},
+	{"U32",    Type_Id_U32, 0},
+	{"U64",    Type_Id_U64, 0},
+	{"S8",     Type_Id_S8, 0},
+	{"S16",    Type_Id_S16, 0},
+	{"S32",    Type_Id_S32, 0},
+	{"S64",    Type_Id_S64, 0},
+	{"F32",    Type_Id_F32, 0},
+	{"F64",    Type_Id_F64, 0},
+	{"Size",   Type_Id_SIZE, 0},
+	{"String", Type_Id_STRING, 0},
+	{"Type",   Type_Id_TYPE, 0},
+};
+
+static U64 hash_type(const Type *type)
+{
+	if (type->declaration)
+	{
+		U64 words[] = {type->kind, (U64)(Address)type->declaration};
+		return hash_memory(words, sizeof(words));
+	}
+
+	U64 words[] =
+	{
+		type->kind | (U64)type->is_signed << 8 | (U64)type->size << 32,
+		type->base | (U64)type->elements_count << 32,
+		type->count,
+		(U64)(Address)type->declaration,
+	};
+	U64 hash = hash_memory(words, sizeof(words));
+	if (type->elements_count)
+	{
+		hash = (hash ^ hash_memory(type->elements, type->elements_count * sizeof(Type_Id))) * 0x9e3779b97f4a7c15;
+		if (type->names)
+			hash = (hash ^ hash_memory(type->names, type->elements_count * sizeof(Identifier))) * 0x9e3779b97f4a7c15;
+	}
+	return hash;
+}
+
+static bool check_types_equality(const Type *a, const Type *b)
+{
+	if (a->declaration || b->declaration)
+		return a->kind == b->kind && a->declaration == b->declaration;
+	// the size of anything but a scalar is laid out from its components, so it isn't part of the key
+	bool scalar = a->kind <= Type_Kind_FLOAT || a->kind == Type_Kind_TYPE;
+	if (a->kind != b->kind || a->is_signed != b->is_signed || (scalar && a->size != b->size) || a->base != b->base ||
+	    a->count != b->count || a->declaration != b->declaration || a->elements_count != b->elements_count ||
+	    !a->names != !b->names)
+		return false;
+	// types without elements may have null ones, which can't be compared even if nothing is
+	if (!a->elements_count)
+		return true;
+	if (compare_memory(a->elements, b->elements, a->elements_count * sizeof(Type_Id)) != 0)
+		return false;
+	if (a->names && compare_memory(a->names, b->names, a->elements_count * sizeof(Identifier)) != 0)
+		return false;
+	return true;
+}
+
+static void grow_type_shard(Type_Shard *shard)
+{
+	Size capacity = shard->slots_capacity * 2;
+	Type_Slot *slots = (Type_Slot *)allocate(capacity * sizeof(Type_Slot));
+	set_memory(slots, capacity * sizeof(Type_Slot), 0);
+	for (Size i = 0; i < shard->slots_capacity; ++i)
+	{
+		Type_Slot *slot = &shard->slots[i];
+		if (!slot->type)
+			continue;
+		Size index = slot->hash & (capacity - 1);
+		while (slots[index].type)
+			index = (index + 1) & (capacity - 1);
+		slots[index] = *slot;
+	}
+	deallocate(shard->slots);
+	shard->slots = slots;
+	shard->slots_capacity = capacity;
+}
+
+// copies the elements (and names) into the shard, whose lock has to be held.
+static void copy_type_elements(Type_Shard *shard, Type *type, const Type_Id *elements, const Identifier *names, U32 count)
+{
+	type->elements_count = count;
+	type->elements = 0;
+	type->names = 0;
+	if (!count)
+		return;
+
+	Type_Id *elements_copy = (Type_Id *)reserve_from_arena(&shard->elements, count * sizeof(Type_Id), alignof(Type_Id));
+	copy_memory(elements_copy, elements, count * sizeof(Type_Id));
+	type->elements = elements_copy;
+	if (names)
+	{
+		Identifier *names_copy = (Identifier *)reserve_from_arena(&shard->elements, count * sizeof(Identifier), alignof(Identifier));
+		copy_memory(names_copy, names, count * sizeof(Identifier));
+		type->names = names_copy;
+	}
+}
+
+// structures lay their fields out in the order they're declared, unless their fields are reordered: then they go
+// from the most aligned to the least, so there's only padding at the end.
+static bool reordering_fields = false;
+
+void enable_field_reordering(void)
+{
+	reordering_fields = true;
+}
+
+// the order from the most aligned field to the least, which keeps the declared order of fields that are aligned alike
+static void sort_fields_by_alignment(const Type *type, U32 *order)
+{
+	for (U32 i = 1; i < type->elements_count; ++i)
+	{
+		U32 key = order[i];
+		U32 alignment = types[type->elements[key]].alignment;
+		U32 j = i;
+		for (; j && types[type->elements[order[j - 1]]].alignment < alignment; --j)
+			order[j] = order[j - 1];
+		order[j] = key;
+	}
+}
+
+// lays the fields out one after another in the order, returning where the last one ends
+static U32 place_fields(const Type *type, const U32 *order, U32 *offsets)
+{
+	U32 size = 0;
+	for (U32 i = 0; i < type->elements_count; ++i)
+	{
+		const Type *element = &types[type->elements[order[i]]];
+		size += get_alignment_addition(size, element->alignment);
+		offsets[order[i]] = size;
+		size += element->size;
+	}
+	return size;
+}
+
+// sets the size and alignment of the type, and the offsets of its elements. its components have to be complete.
+// the shard's lock has to be held.
+static void lay_out_type(Type_Shard *shard, Type *type)
+{
+	type->offsets = 0;
+	switch (type->kind)
+	{
+	case Type_Kind_VOID:
+		type->size = 0;
+		type->alignment = 1;
+		break;
+	case Type_Kind_BOOL:
+	case Type_Kind_INTEGER:
+	case Type_Kind_FLOAT:
+	case Type_Kind_TYPE:
+		type->alignment = type->size;
+		break;
+	case Type_Kind_POINTER:
+	case Type_Kind_PROCEDURE:
+		type->size = 8;
+		type->alignment = 8;
+		break;
+	case Type_Kind_SLICE:
+		type->size = 16;
+		type->alignment = 8;
+		break;
+	case Type_Kind_ARRAY:
+		{
+			const Type *element = &types[type->base];
+			type->size = element->size * type->count;
+			type->alignment = element->alignment;
+		}
+		break;
+	case Type_Kind_ENUM:
+		type->size = types[type->base].size;
+		type->alignment = types[type->base].alignment;
+		break;
+	case Type_Kind_TUPLE:
+	case Type_Kind_STRUCT:
+	case Type_Kind_UNION:
+		{
+			U32 *offsets = (U32 *)reserve_from_arena(&shard->elements, type->elements_count * sizeof(U32), alignof(U32));
+			U32 size = 0;
+			U32 alignment = 1;
+			for (U32 i = 0; i < type->elements_count; ++i)
+			{
+				const Type *element = &types[type->elements[i]];
+				alignment = max(alignment, element->alignment);
+				if (type->kind == Type_Kind_UNION)
+				{
+					offsets[i] = 0;
+					size = max(size, element->size);
+				}
+			}
+			if (type->kind != Type_Kind_UNION)
+			{
+				Scratch scratch;
+				U32 *order = (U32 *)reserve_from_arena(scratch.arena, type->elements_count * sizeof(U32), alignof(U32));
+				for (U32 i = 0; i < type->elements_count; ++i)
+					order[i] = i;
+				if (type->kind == Type_Kind_STRUCT && reordering_fields)
+					sort_fields_by_alignment(type, order);
+				size = place_fields(type, order, offsets);
+			}
+			type->size = size + get_alignment_addition(size, alignment);
+			type->alignment = alignment;
+			type->offsets = offsets;
+		}
+		break;
+	}
+}
+
+// returns the ID of the type that is equal to `key`, making it first if there isn't one yet.
+static Type_Id intern_type(const Type *key)
+{
+	U64 hash = hash_type(key);
+	Type_Shard *shard = &type_shards[hash & (TYPE_SHARDS_COUNT - 1)];
+	U32 slot_hash = (U32)(hash >> 32);
+
+	lock_mutex(&shard->mutex);
+
+	if ((shard->count + 1) * 2 > shard->slots_capacity)
+		grow_type_shard(shard);
+
+	Size mask = shard->slots_capacity - 1;
+	Size index = slot_hash & mask;
+	for (;; index = (index + 1) & mask)
+	{
+		Type_Slot *slot = &shard->slots[index];
+		if (!slot->type)
+			break;
+		if (slot->hash == slot_hash && check_types_equality(&types[slot->type], key))
+		{
+			Type_Id type = slot->type;
+			unlock_mutex(&shard->mutex);
+			return type;
+		}
+	}
+
+	Type_Id id = __atomic_fetch_add(&types_count, 1, __ATOMIC_RELAXED);
+	if (id >= MAXIMUM_TYPES_COUNT)
+	{
+		unlock_mutex(&shard->mutex);
+		report_error("too many distinct types.");
+		return Type_Id_NONE;
+	}
+
+	Type *type = &types[id];
+	*type = *key;
+	type->hash = hash;
+	copy_type_elements(shard, type, key->elements, key->names, key->elements_count);
+	type->complete = !key->declaration;
+	if (type->complete)
+		lay_out_type(shard, type);
+
+	shard->slots[index] = {slot_hash, id};
+	++shard->count;
+
+	unlock_mutex(&shard->mutex);
+	return id;
+}
+
+static Type_Id get_scalar_type(Type_Kind kind, U32 size, bool is_signed)
+{
+	Type key = {};
+	key.kind = kind;
+	key.size = size;
+	key.is_signed = is_signed;
+	return intern_type(&key);
+}
+
+void initialize_types(void)
+{
+	types = (Type *)allocate_virtual_memory(0, MAXIMUM_TYPES_COUNT * sizeof(Type));
+	types_count = 1; // `Type_Id_NONE`
+	for (Size i = 0; i < TYPE_SHARDS_COUNT; ++i)
+	{
+		Type_Shard *shard = &type_shards[i];
+		initialize_mutex(&shard->mutex);
+		shard->count = 0;
+		shard->slots_capacity = 256;
+		shard->slots = (Type_Slot *)allocate(shard->slots_capacity * sizeof(Type_Slot));
+		set_memory(shard->slots, shard->slots_capacity * sizeof(Type_Slot), 0);
+		initialize_arena(&shard->elements, 0);
+	}
+
+	Type_Id builtins[] =
+	{
+		get_scalar_type(Type_Kind_VOID, 0, false),
+		get_scalar_type(Type_Kind_BOOL, 1, false),
+		get_scalar_type(Type_Kind_INTEGER, 1, false),
+		get_scalar_type(Type_Kind_INTEGER, 2, false),
+		get_scalar_type(Type_Kind_INTEGER, 4, false),
+		get_scalar_type(Type_Kind_INTEGER, 8, false),
+		get_scalar_type(Type_Kind_INTEGER, 1, true),
+		get_scalar_type(Type_Kind_INTEGER, 2, true),
+		get_scalar_type(Type_Kind_INTEGER, 4, true),
+		get_scalar_type(Type_Kind_INTEGER, 8, true),
+		get_scalar_type(Type_Kind_FLOAT, 4, true),
+		get_scalar_type(Type_Kind_FLOAT, 8, true),
+		get_tuple_type(0, 0),
+		get_slice_type(Type_Id_U8),
+		get_scalar_type(Type_Kind_TYPE, sizeof(Type_Id), false),
+	};
+	for (Size i = 0; i < sizeof(builtins) / sizeof(builtins[0]); ++i)
+		assert(builtins[i] == Type_Id_VOID + i);
+
+	for (Size i = 0; i < sizeof(builtin_types) / sizeof(builtin_types[0]); ++i)
+	{
+		const char *representation = builtin_types[i].representation;
+		builtin_types[i].name = intern_identifier((const Utf8 *)representation, get_length_of_string(representation));
+	}
+}
+
+const Type *get_type(Type_Id type)
+{
+	return &types[type];
+}
+
+U64 get_type_hash(Type_Id type)
+{
+	return types[type].hash;
+}
+
+Type_Id find_builtin_type(Identifier name)
+{
+	for (Size i = 0; i < sizeof(builtin_types) / sizeof(builtin_types[0]); ++i)
+	{
+		if (builtin_types[i].name == name)
+			return builtin_types[i].type;
+	}
+	return Type_Id_NONE;
+}
+
+Type_Id get_pointer_type(Type_Id base)
+{
+	Type key = {};
+	key.kind = Type_Kind_POINTER;
+	key.size = 8;
+	key.base = base;
+	return intern_type(&key);
+}
+
+Type_Id get_slice_type(Type_Id element)
+{
+	Type key = {};
+	key.kind = Type_Kind_SLICE;
+	key.base = element;
+	return intern_type(&key);
+}
+
+Type_Id get_array_type(Type_Id element, U64 count)
+{
+	Type key = {};
+	key.kind = Type_Kind_ARRAY;
+	key.base = element;
+	key.count = count;
+	return intern_type(&key);
+}
+
+Type_Id get_tuple_type(const Type_Id *elements, U32 count)
+{
+	Type key = {};
+	key.kind = Type_Kind_TUPLE;
+	key.elements = elements;
+	key.elements_count = count;
+	return intern_type(&key);
+}
+
+Type_Id get_record_type(Type_Kind kind, const Type_Id *fields, const Identifier *names, U32 count)
+{
+	assert(kind == Type_Kind_STRUCT || kind == Type_Kind_UNION);
+	Type key = {};
+	key.kind = kind;
+	key.elements = fields;
+	key.names = names;
+	key.elements_count = count;
+	return intern_type(&key);
+}
+
+Type_Id get_nominal_type(Type_Kind kind, const Artifact *declaration)
+{
+	assert(declaration && (kind == Type_Kind_STRUCT || kind == Type_Kind_UNION || kind == Type_Kind_ENUM));
+	Type key = {};
+	key.kind = kind;
+	key.declaration = declaration;
+	return intern_type(&key);
+}
+
+void complete_record_type(Type_Id id, const Type_Id *fields, const Identifier *names, U32 count)
+{
+	Type *type = &types[id];
+	assert(!type->complete && (type->kind == Type_Kind_STRUCT || type->kind == Type_Kind_UNION));
+	Type_Shard *shard = &type_shards[type->hash & (TYPE_SHARDS_COUNT - 1)];
+	lock_mutex(&shard->mutex);
+	copy_type_elements(shard, type, fields, names, count);
+	lay_out_type(shard, type);
+	unlock_mutex(&shard->mutex);
+	__atomic_store_n(&type->complete, true, __ATOMIC_RELEASE);
+}
+
+void complete_enum_type(Type_Id id, Type_Id base)
+{
+	Type *type = &types[id];
+	assert(!type->complete && type->kind == Type_Kind_ENUM);
+	type->base = base;
+	lay_out_type(0, type);
+	__atomic_store_n(&type->complete, true, __ATOMIC_RELEASE);
+}
+
+bool check_type_completeness(Type_Id type)
+{
+	return __atomic_load_n(&types[type].complete, __ATOMIC_ACQUIRE);
+}
+
+Type_Id get_procedure_type(const Type_Id *parameters, U32 count, Type_Id results)
+{
+	Type key = {};
+	key.kind = Type_Kind_PROCEDURE;
+	key.elements = parameters;
+	key.elements_count = count;
+	key.base = results;
+	return intern_type(&key);
+}
+
+bool check_assignability(Type_Id destination, Type_Id source)
+{
+	if (destination == source)
+		return true;
+
+	const Type *destination_type = get_type(destination);
+	const Type *source_type = get_type(source);
+	switch (destination_type->kind)
+	{
+	case Type_Kind_INTEGER:
+		// widening, without changing signedness
+		return source_type->kind == Type_Kind_INTEGER && source_type->is_signed == destination_type->is_signed &&
+		       source_type->size <= destination_type->size;
+	case Type_Kind_FLOAT:
+		return source_type->kind == Type_Kind_FLOAT && source_type->size <= destination_type->size;
+	case Type_Kind_POINTER:
+		// any pointer goes into `@Void`
+		return source_type->kind == Type_Kind_POINTER && destination_type->base == Type_Id_VOID;
+	case Type_Kind_SLICE:
+		return source_type->kind == Type_Kind_ARRAY && source_type->base == destination_type->base;
+	case Type_Kind_TUPLE:
+		if (source_type->kind != Type_Kind_TUPLE || source_type->elements_count != destination_type->elements_count)
+			return false;
+		for (U32 i = 0; i < destination_type->elements_count; ++i)
+		{
+			if (!check_assignability(destination_type->elements[i], source_type->elements[i]))
+				return false;
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+// appends to the buffer at `offset` like `format` does, returning the new offset.
+[[gnu::format(printf, 4, 5)]]
+static Size append_format(char *buffer, Size size, Size offset, const char *message, ...)
+{
+	va_list args;
+	va_start(args, message);
+	bool fits = buffer && offset < size;
+	offset += vsnprintf(fits ? &buffer[offset] : 0, fits ? size - offset : 0, message, args);
+	va_end(args);
+	return offset;
+}
+
+static Size format_type_at(char *buffer, Size size, Size offset, Type_Id id)
+{
+	const Type *type = get_type(id);
+	if (type->declaration)
+	{
+		String name = get_identifier_string(type->declaration->name);
+		return append_format(buffer, size, offset, "%.*s", (int)name.size, name.pointer);
+	}
+
+	switch (type->kind)
+	{
+	case Type_Kind_VOID:
+		return append_format(buffer, size, offset, "Void");
+	case Type_Kind_BOOL:
+		return append_format(buffer, size, offset, "Bool");
+	case Type_Kind_TYPE:
+		return append_format(buffer, size, offset, "Type");
+	case Type_Kind_INTEGER:
+		return append_format(buffer, size, offset, "%c%u", type->is_signed ? 'S' : 'U', type->size * 8);
+	case Type_Kind_FLOAT:
+		return append_format(buffer, size, offset, "F%u", type->size * 8);
+	case Type_Kind_POINTER:
+		offset = append_format(buffer, size, offset, "@");
+		return format_type_at(buffer, size, offset, type->base);
+	case Type_Kind_SLICE:
+		offset = append_format(buffer, size, offset, "[]");
+		return format_type_at(buffer, size, offset, type->base);
+	case Type_Kind_ARRAY:
+		offset = append_format(buffer, size, offset, "[%lu]", type->count);
+		return format_type_at(buffer, size, offset, type->base);
+	case Type_Kind_TUPLE:
+	case Type_Kind_PROCEDURE:
+		if (type->kind == Type_Kind_PROCEDURE)
+			offset = append_format(buffer, size, offset, "proc");
+		offset = append_format(buffer, size, offset, "(");
+		for (U32 i = 0; i < type->elements_count; ++i)
+		{
+			if (i)
+				offset = append_format(buffer, size, offset, ", ");
+			offset = format_type_at(buffer, size, offset, type->elements[i]);
+		}
+		offset = append_format(buffer, size, offset, ")");
+		if (type->kind == Type_Kind_PROCEDURE && type->base != Type_Id_EMPTY_TUPLE)
+		{
+			offset = append_format(buffer, size, offset, " -> ");
+			offset = format_type_at(buffer, size, offset, type->base);
+		}
+		return offset;
+	case Type_Kind_STRUCT:
+	case Type_Kind_UNION:
+		offset = append_format(buffer, size, offset, type->kind == Type_Kind_STRUCT ? "struct {" : "union {");
+		for (U32 i = 0; i < type->elements_count; ++i)
+		{
+			if (i)
+				offset = append_format(buffer, size, offset, "; ");
+			if (type->names && type->names[i])
+			{
+				String name = get_identifier_string(type->names[i]);
+				offset = append_format(buffer, size, offset, "%.*s: ", (int)name.size, name.pointer);
+			}
+			offset = format_type_at(buffer, size, offset, type->elements[i]);
+		}
+		return append_format(buffer, size, offset, "}");
+	case Type_Kind_ENUM:
+		offset = append_format(buffer, size, offset, "enum -> ");
+		return format_type_at(buffer, size, offset, type->base);
+	}
+	return offset;
+}
+
+Size format_type(char *buffer, Size size, Type_Id type)
+{
+	return format_type_at(buffer, size, 0, type);
+}
+
+U32 get_padding_size(Type_Id id)
+{
+	const Type *type = &types[id];
+	if (type->kind != Type_Kind_TUPLE && type->kind != Type_Kind_STRUCT && type->kind != Type_Kind_UNION)
+		return 0;
+	U32 used = 0;
+	for (U32 i = 0; i < type->elements_count; ++i)
+	{
+		U32 size = types[type->elements[i]].size;
+		used = type->kind == Type_Kind_UNION ? max(used, size) : used + size;
+	}
+	return type->size - used;
+}
+
+void report_padding(void)
+{
+	U32 count = __atomic_load_n(&types_count, __ATOMIC_ACQUIRE);
+	for (Type_Id id = 1; id < count; ++id)
+	{
+		const Type *type = &types[id];
+		if ((type->kind != Type_Kind_STRUCT && type->kind != Type_Kind_UNION) || !check_type_completeness(id))
+			continue;
+		U32 padding = get_padding_size(id);
+		if (!padding)
+			continue;
+
+		char name[128];
+		format_type(name, sizeof(name), id);
+		print("\e[1m%s\e[0m takes %u bytes, and %u of them %s padding", name, type->size, padding, padding == 1 ? "is" : "are");
+		if (type->kind == Type_Kind_STRUCT && !reordering_fields)
+		{
+			// what it would take with its fields reordered
+			Scratch scratch;
+			U32 *order = (U32 *)reserve_from_arena(scratch.arena, type->elements_count * 2 * sizeof(U32), alignof(U32));
+			U32 *offsets = order + type->elements_count;
+			for (U32 i = 0; i < type->elements_count; ++i)
+				order[i] = i;
+			sort_fields_by_alignment(type, order);
+			U32 size = place_fields(type, order, offsets);
+			size += get_alignment_addition(size, type->alignment);
+			if (size < type->size)
+				print(" (%u bytes with its fields reordered)", size);
+		}
+		print(".\n");
+	}
+}
+
+// evaluation
+
+// for error messages; long types are cut short.
+struct Type_Name
+{
+	char string[128];
+};
+
+static Type_Name name_type(Type_Id type)
+{
+	Type_Name name;
+	format_type(name.string, sizeof(name.string), type);
+	return name;
+}
+
+bool check_image(Type_Id type)
+{
+	const Type *information = get_type(type);
+	switch (information->kind)
+	{
+	case Type_Kind_SLICE:
+	case Type_Kind_ARRAY:
+	case Type_Kind_TUPLE:
+	case Type_Kind_STRUCT:
+	case Type_Kind_UNION:
+		return true;
+	case Type_Kind_ENUM:
+		return check_image(information->base);
+	default:
+		return false;
+	}
+}
+
+static bool check_constant(const Artifact *artifact)
+{
+	return artifact->node && artifact->node->operation == Token_Type_COLON;
+}
+
+static Artifact *get_top_level_artifact(Artifact *artifact)
+{
+	return artifact->scope ? artifact->scope->top : artifact;
+}
+
+// the kind of type that the declaration's value declares, if it's the value of a nominal type
+static Type_Kind get_nominal_kind(const Artifact *artifact)
+{
+	const Node *declaration = artifact->node;
+	if (!declaration || declaration->count != 1 || declaration->operation != Token_Type_COLON || !declaration->right)
+		return Type_Kind_VOID;
+	switch (declaration->right->type)
+	{
+	case Node_Type_STRUCT:
+		return Type_Kind_STRUCT;
+	case Node_Type_UNION:
+		return Type_Kind_UNION;
+	case Node_Type_ENUM:
+		return Type_Kind_ENUM;
+	default:
+		return Type_Kind_VOID;
+	}
+}
+
+// whether it's a field of a structure or union, or a variable of a procedure that isn't static
+static bool check_local(const Artifact *artifact)
+{
+	if (artifact->node && artifact->node->is_static)
+		return false;
+	for (const Scope *scope = artifact->scope; scope; scope = scope->parent)
+	{
+		if (scope->procedure)
+			return true;
+		if (scope->owner && get_nominal_kind(scope->owner) != Type_Kind_VOID)
+			return true;
+	}
+	return false;
+}
+
+// evaluates the artifact, unless it's in the tree of a task that isn't done yet. then the evaluation stops, so
+// the task can park on that one.
+static bool use_artifact(Evaluation *evaluation, Artifact *artifact, Span span)
+{
+	Artifact *top = get_top_level_artifact(artifact);
+	if (evaluation->task && top != evaluation->task->artifact &&
+	    __atomic_load_n(&top->task->state, __ATOMIC_ACQUIRE) != Task_State_DONE)
+	{
+		evaluation->blocker = top->task;
+		evaluation->blocking_span = span;
+		return false;
+	}
+	return evaluate_artifact(evaluation, artifact);
+}
+
+// nominal types are completed by evaluating their declarations.
+static bool require_complete_type(Evaluation *evaluation, Type_Id type, Span span)
+{
+	if (check_type_completeness(type))
+		return true;
+	return use_artifact(evaluation, (Artifact *)get_type(type)->declaration, span);
+}
+
+static bool evaluate_type(Evaluation *evaluation, Node *node, Type_Id *type)
+{
+	Value value;
+	if (!evaluate(evaluation, node, Type_Id_TYPE, &value))
+		return false;
+	if (value.type != Type_Id_TYPE)
+	{
+		report_span_error(node->span, "expected a type, but this is a value of type \"%s\".", name_type(value.type).string);
+		return false;
+	}
+	*type = value.type_value;
+	return true;
+}
+
+static U8 *make_image(Evaluation *evaluation, Type_Id type)
+{
+	Size size = get_type(type)->size;
+	U8 *image = (U8 *)reserve_from_arena(evaluation->arena, size, 8);
+	set_memory(image, size, 0);
+	return image;
+}
+
+static void add_relocation(Evaluation *evaluation, Relocation **relocations, const Relocation *relocation, U32 offset)
+{
+	Relocation *copy = (Relocation *)reserve_from_arena(evaluation->arena, sizeof(Relocation), alignof(Relocation));
+	*copy = *relocation;
+	copy->offset += offset;
+	copy->next = *relocations;
+	*relocations = copy;
+}
+
+// integers are kept truncated to their size, and sign-extended if they are signed.
+static U64 normalize_integer(Type_Id type, U64 integer)
+{
+	const Type *information = get_type(type);
+	if (information->kind == Type_Kind_ENUM)
+		information = get_type(information->base);
+	if (information->kind == Type_Kind_BOOL)
+		return integer != 0;
+	if (information->size >= 8)
+		return integer;
+	U32 bits = information->size * 8;
+	integer &= ((U64)1 << bits) - 1;
+	if (information->is_signed && (integer >> (bits - 1)) & 1)
+		integer |= ~(U64)0 << bits;
+	return integer;
+}
+
+// reads a value of the type from the image at `offset`.
+static Value load_value(Evaluation *evaluation, Type_Id type, const U8 *image, U32 offset, const Relocation *relocations)
+{
+	Value value = {};
+	value.type = type;
+	const Type *information = get_type(type);
+	U32 size = information->size;
+	for (const Relocation *relocation = relocations; relocation; relocation = relocation->next)
+	{
+		if (relocation->offset >= offset && relocation->offset < offset + size)
+			add_relocation(evaluation, &value.relocations, relocation, 0), value.relocations->offset -= offset;
+	}
+
+	if (check_image(type))
+	{
+		value.image = image ? image + offset : make_image(evaluation, type);
+		return value;
+	}
+	if (!image)
+		return value;
+	switch (information->kind)
+	{
+	case Type_Kind_FLOAT:
+		if (size == 4)
+		{
+			float floating;
+			copy_memory(&floating, image + offset, 4);
+			value.floating = floating;
+		}
+		else
+			copy_memory(&value.floating, image + offset, 8);
+		break;
+	case Type_Kind_TYPE:
+		copy_memory(&value.type_value, image + offset, sizeof(Type_Id));
+		break;
+	case Type_Kind_PROCEDURE:
+		value.procedure = value.relocations ? value.relocations->procedure : 0;
+		break;
+	default:
+		copy_memory(&value.integer, image + offset, size);
+		value.integer = normalize_integer(type, value.integer);
+		break;
+	}
+	return value;
+}
+
+// writes the value into the image at `offset`, adding its relocations to the image's.
+static void store_value(Evaluation *evaluation, U8 *image, U32 offset, const Value *value, Relocation **relocations)
+{
+	const Type *information = get_type(value->type);
+	U32 size = information->size;
+	for (const Relocation *relocation = value->relocations; relocation; relocation = relocation->next)
+		add_relocation(evaluation, relocations, relocation, offset);
+
+	if (check_image(value->type))
+	{
+		if (value->image)
+			copy_memory(image + offset, value->image, size);
+		return;
+	}
+	switch (information->kind)
+	{
+	case Type_Kind_FLOAT:
+		if (size == 4)
+		{
+			float floating = (float)value->floating;
+			copy_memory(image + offset, &floating, 4);
+		}
+		else
+			copy_memory(image + offset, &value->floating, 8);
+		break;
+	case Type_Kind_TYPE:
+		copy_memory(image + offset, &value->type_value, sizeof(Type_Id));
+		break;
+	case Type_Kind_PROCEDURE:
+		if (value->procedure)
+		{
+			Relocation relocation = {};
+			relocation.procedure = value->procedure;
+			add_relocation(evaluation, relocations, &relocation, offset);
+		}
+		break;
+	default:
+		copy_memory(image + offset, &value->integer, size);
+		break;
+	}
+}
+
+static bool check_relocations_equality(const Relocation *a, const Relocation *b)
+{
+	for (; a && b; a = a->next, b = b->next)
+	{
+		if (a->offset != b->offset || a->artifact != b->artifact || a->procedure != b->procedure ||
+		    a->data.size != b->data.size || compare_memory(a->data.pointer, b->data.pointer, a->data.size) != 0 ||
+		    !check_relocations_equality(a->relocations, b->relocations))
+			return false;
+	}
+	return !a && !b;
+}
+
+// values of the same type
+static bool check_values_equality(const Value *a, const Value *b)
+{
+	if (!check_relocations_equality(a->relocations, b->relocations))
+		return false;
+	if (check_image(a->type))
+	{
+		Size size = get_type(a->type)->size;
+		if (!a->image || !b->image)
+		{
+			const U8 *image = a->image ? a->image : b->image;
+			for (Size i = 0; image && i < size; ++i)
+			{
+				if (image[i])
+					return false;
+			}
+			return true;
+		}
+		return compare_memory(a->image, b->image, size) == 0;
+	}
+	switch (get_type(a->type)->kind)
+	{
+	case Type_Kind_FLOAT:
+		return a->floating == b->floating;
+	case Type_Kind_TYPE:
+		return a->type_value == b->type_value;
+	case Type_Kind_PROCEDURE:
+		return a->procedure == b->procedure;
+	default:
+		return a->integer == b->integer;
+	}
+}
+
+// converts the value to the type, which it has to be assignable to.
+static void convert_value(Evaluation *evaluation, Value *value, Type_Id type)
+{
+	if (value->type == type)
+		return;
+	const Type *source = get_type(value->type);
+	const Type *destination = get_type(type);
+	if (destination->kind == Type_Kind_SLICE)
+	{
+		// the slice points to a copy of the array
+		U8 *image = make_image(evaluation, type);
+		Relocation relocation = {};
+		relocation.data = {value->image, source->size};
+		relocation.alignment = source->alignment;
+		relocation.relocations = value->relocations;
+		Value slice = {};
+		slice.type = type;
+		slice.image = image;
+		add_relocation(evaluation, &slice.relocations, &relocation, 0);
+		copy_memory(image + 8, &source->count, 8);
+		*value = slice;
+		return;
+	}
+	if (destination->kind == Type_Kind_TUPLE)
+	{
+		// the elements may have to be converted as well, which may move them
+		Value tuple = {};
+		tuple.type = type;
+		U8 *image = make_image(evaluation, type);
+		tuple.image = image;
+		for (U32 i = 0; i < destination->elements_count; ++i)
+		{
+			Value element = load_value(evaluation, source->elements[i], value->image, source->offsets[i], value->relocations);
+			convert_value(evaluation, &element, destination->elements[i]);
+			store_value(evaluation, image, destination->offsets[i], &element, &tuple.relocations);
+		}
+		*value = tuple;
+		return;
+	}
+	value->type = type;
+}
+
+// converts the value to the type if it's assignable, or reports that it isn't.
+static bool assign_value(Evaluation *evaluation, Value *value, Type_Id type, Span span)
+{
+	if (!check_assignability(type, value->type))
+	{
+		report_span_error(span, "expected a value of type \"%s\", but this is of type \"%s\".", name_type(type).string,
+		                  name_type(value->type).string);
+		return false;
+	}
+	convert_value(evaluation, value, type);
+	return true;
+}
+
+static bool evaluate_integer_literal(U64 integer, bool negative, Type_Id expected, Value *value, Span span)
+{
+	Type_Id type = expected;
+	const Type *information = get_type(expected);
+	if (information->kind == Type_Kind_FLOAT)
+	{
+		value->type = expected;
+		value->floating = negative ? -(F64)integer : (F64)integer;
+		return true;
+	}
+	if (information->kind != Type_Kind_INTEGER)
+		type = negative || integer <= (U64)INT64_MAX ? Type_Id_S64 : Type_Id_U64;
+	information = get_type(type);
+
+	U32 bits = information->size * 8;
+	U64 maximum = information->is_signed ? ((U64)1 << (bits - 1)) - !negative : bits == 64 ? ~(U64)0 : ((U64)1 << bits) - 1;
+	if ((negative && !information->is_signed && integer) || integer > maximum)
+	{
+		report_span_error(span, "%s%lu doesn't fit in \"%s\".", negative ? "-" : "", integer, name_type(type).string);
+		return false;
+	}
+	value->type = type;
+	value->integer = normalize_integer(type, negative ? -integer : integer);
+	return true;
+}
+
+// a literal, or the negation of one, takes whatever type the context expects.
+static bool check_untyped(const Node *node)
+{
+	if (node->type == Node_Type_UNARY && node->operation == Token_Type_MINUS)
+		node = node->left;
+	return node->type == Node_Type_LITERAL && node->literal.type != Literal_Type_STRING;
+}
+
+static bool evaluate_literal(Evaluation *evaluation, Node *node, Type_Id expected, Value *value, bool negative)
+{
+	const Literal *literal = &node->literal;
+	switch (literal->type)
+	{
+	case Literal_Type_INTEGER:
+		return evaluate_integer_literal(literal->integer, negative, expected, value, node->span);
+	case Literal_Type_FLOAT:
+		value->type = get_type(expected)->kind == Type_Kind_FLOAT ? expected : Type_Id_F64;
+		value->floating = negative ? -literal->floating : literal->floating;
+		return true;
+	case Literal_Type_STRING:
+		{
+			value->type = Type_Id_STRING;
+			U8 *image = make_image(evaluation, Type_Id_STRING);
+			value->image = image;
+			Relocation relocation = {};
+			relocation.data = literal->string;
+			relocation.alignment = 1;
+			add_relocation(evaluation, &value->relocations, &relocation, 0);
+			copy_memory(image + 8, &literal->string.size, 8);
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool evaluate_name(Evaluation *evaluation, Node *node, Value *value)
+{
+	Reference *reference = node->reference;
+	Artifact *artifact = reference->artifact;
+	if (!artifact)
+	{
+		// undeclared names were reported when they were resolved
+		value->type = Type_Id_TYPE;
+		value->type_value = find_builtin_type(reference->name);
+		return value->type_value != Type_Id_NONE;
+	}
+	if (!check_constant(artifact))
+	{
+		String name = get_identifier_string(artifact->name);
+		report_span_error(node->span, "\"%.*s\" isn't a constant, so its value isn't known at compile time.",
+		                  (int)name.size, name.pointer);
+		return false;
+	}
+
+	// the type's identity is all that's needed, so it doesn't have to be complete
+	if (Type_Kind kind = get_nominal_kind(artifact))
+	{
+		value->type = Type_Id_TYPE;
+		value->type_value = get_nominal_type(kind, artifact);
+		return value->type_value != Type_Id_NONE;
+	}
+	if (!use_artifact(evaluation, artifact, node->span))
+		return false;
+	*value = artifact->value;
+	return true;
+}
+
+// a constant that's declared in the body of the artifact, which has to be a named scope or a type
+static bool evaluate_artifact_member(Evaluation *evaluation, Node *node, Artifact *owner, Value *value)
+{
+	if (!use_artifact(evaluation, owner, node->span))
+		return false;
+	Artifact *member = find_member(owner, node->name);
+	String owner_name = get_identifier_string(owner->name);
+	String name = get_identifier_string(node->name);
+	if (!member)
+	{
+		report_span_error(node->span, "\"%.*s\" has no member \"%.*s\".", (int)owner_name.size, owner_name.pointer,
+		                  (int)name.size, name.pointer);
+		return false;
+	}
+	if (!check_constant(member))
+	{
+		report_span_error(node->span, "\"%.*s.%.*s\" isn't a constant.", (int)owner_name.size, owner_name.pointer,
+		                  (int)name.size, name.pointer);
+		return false;
+	}
+	if (!use_artifact(evaluation, member, node->span))
+		return false;
+	*value = member->value;
+	return true;
+}
+
+static bool evaluate_member(Evaluation *evaluation, Node *node, Value *value)
+{
+	if (!node->left)
+	{
+		report_span_error(node->span, "members can only be set like this in a compound.");
+		return false;
+	}
+
+	// members of named scopes
+	if (node->left->type == Node_Type_NAME)
+	{
+		Artifact *artifact = node->left->reference->artifact;
+		if (artifact && check_constant(artifact) && artifact->body && artifact->node->right->type == Node_Type_BLOCK)
+			return evaluate_artifact_member(evaluation, node, artifact, value);
+	}
+
+	Value left;
+	if (!evaluate(evaluation, node->left, Type_Id_NONE, &left))
+		return false;
+	String name = get_identifier_string(node->name);
+	if (left.type == Type_Id_TYPE)
+	{
+		// elements of enumerations, and constants in structures and unions
+		if (Artifact *declaration = (Artifact *)get_type(left.type_value)->declaration)
+			return evaluate_artifact_member(evaluation, node, declaration, value);
+	}
+	else
+	{
+		const Type *type = get_type(left.type);
+		switch (type->kind)
+		{
+		case Type_Kind_STRUCT:
+		case Type_Kind_UNION:
+			for (U32 i = 0; i < type->elements_count; ++i)
+			{
+				if (type->names[i] == node->name)
+				{
+					*value = load_value(evaluation, type->elements[i], left.image, type->offsets[i], left.relocations);
+					return true;
+				}
+			}
+			break;
+		case Type_Kind_SLICE:
+			if (check_identifier(node->name, "size"))
+			{
+				*value = load_value(evaluation, Type_Id_SIZE, left.image, 8, left.relocations);
+				return true;
+			}
+			if (check_identifier(node->name, "data"))
+			{
+				*value = load_value(evaluation, get_pointer_type(type->base), left.image, 0, left.relocations);
+				return true;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	Type_Id type = left.type == Type_Id_TYPE ? left.type_value : left.type;
+	report_span_error(node->span, "\"%s\" has no member \"%.*s\".", name_type(type).string, (int)name.size, name.pointer);
+	return false;
+}
+
+static bool evaluate_element(Evaluation *evaluation, Node *node, Type_Id expected, Value *value)
+{
+	String name = get_identifier_string(node->name);
+	if (get_type(expected)->kind != Type_Kind_ENUM)
+	{
+		report_span_error(node->span, "the enumeration that \"%.*s\" is an element of isn't known here.",
+		                  (int)name.size, name.pointer);
+		return false;
+	}
+	Artifact *declaration = (Artifact *)get_type(expected)->declaration;
+	if (!use_artifact(evaluation, declaration, node->span))
+		return false;
+	Artifact *element = find_member(declaration, node->name);
+	if (!element)
+	{
+		report_span_error(node->span, "\"%s\" has no element \"%.*s\".", name_type(expected).string, (int)name.size, name.pointer);
+		return false;
+	}
+	*value = element->value;
+	return true;
+}
+
+static bool evaluate_unary(Evaluation *evaluation, Node *node, Type_Id expected, Value *value)
+{
+	Node *operand = node->left;
+	if (node->operation == Token_Type_AT)
+	{
+		// the address of a global variable, or a pointer type
+		if (operand->type == Node_Type_NAME && operand->reference->artifact && !check_constant(operand->reference->artifact))
+		{
+			Artifact *artifact = operand->reference->artifact;
+			if (check_local(artifact))
+			{
+				report_span_error(node->span, "only the addresses of global variables are known at compile time.");
+				return false;
+			}
+			if (!use_artifact(evaluation, artifact, operand->span))
+				return false;
+			*value = {};
+			value->type = get_pointer_type(artifact->type);
+			Relocation relocation = {};
+			relocation.artifact = artifact;
+			add_relocation(evaluation, &value->relocations, &relocation, 0);
+			return value->type != Type_Id_NONE;
+		}
+		Value pointee;
+		if (!evaluate(evaluation, operand, Type_Id_TYPE, &pointee))
+			return false;
+		if (pointee.type != Type_Id_TYPE)
+		{
+			report_span_error(node->span, "only the addresses of global variables are known at compile time.");
+			return false;
+		}
+		value->type = Type_Id_TYPE;
+		value->type_value = get_pointer_type(pointee.type_value);
+		return value->type_value != Type_Id_NONE;
+	}
+
+	if (node->operation == Token_Type_MINUS && operand->type == Node_Type_LITERAL)
+		return evaluate_literal(evaluation, operand, expected, value, true);
+	if (!evaluate(evaluation, operand, node->operation == Token_Type_EXCLAMATION_MARK ? Type_Id_BOOL : expected, value))
+		return false;
+	const Type *type = get_type(value->type);
+	switch (node->operation)
+	{
+	case Token_Type_MINUS:
+		if (type->kind == Type_Kind_FLOAT)
+		{
+			value->floating = -value->floating;
+			return true;
+		}
+		if (type->kind == Type_Kind_INTEGER && type->is_signed)
+		{
+			value->integer = normalize_integer(value->type, -value->integer);
+			return true;
+		}
+		break;
+	case Token_Type_EXCLAMATION_MARK:
+		if (type->kind == Type_Kind_BOOL || type->kind == Type_Kind_INTEGER || type->kind == Type_Kind_POINTER)
+		{
+			value->integer = !value->integer && !value->relocations;
+			value->type = Type_Id_BOOL;
+			value->relocations = 0;
+			return true;
+		}
+		break;
+	case Token_Type_TILDE:
+		if (type->kind == Type_Kind_INTEGER)
+		{
+			value->integer = normalize_integer(value->type, ~value->integer);
+			return true;
+		}
+		break;
+	default:
+		break;
+	}
+	char operation[3];
+	format_operator(operation, node->operation);
+	report_span_error(node->span, "\"%s\" doesn't apply to \"%s\".", operation, name_type(value->type).string);
+	return false;
+}
+
+static bool evaluate_call(Evaluation *evaluation, Node *node, Node *callee, Node **arguments, U32 count, Value *value);
+
+static bool evaluate_binary(Evaluation *evaluation, Node *node, Type_Id expected, Value *value)
+{
+	Token_Type operation = node->operation;
+	if (operation == Token_Type_PIPE)
+		return evaluate_call(evaluation, node, node->right, &node->left, 1, value);
+
+	if (operation == Token_Type_AND || operation == Token_Type_OR)
+	{
+		Node *operands[] = {node->left, node->right};
+		for (Node *operand : operands)
+		{
+			if (!evaluate(evaluation, operand, Type_Id_BOOL, value))
+				return false;
+			if (value->type != Type_Id_BOOL)
+			{
+				report_span_error(operand->span, "expected a \"Bool\", but this is of type \"%s\".", name_type(value->type).string);
+				return false;
+			}
+			if (value->integer == (operation == Token_Type_OR))
+				break;
+		}
+		return true;
+	}
+
+	bool comparison = get_binary_precedence(operation) == get_binary_precedence(Token_Type_EQUAL_EQUAL);
+	bool shift = operation == Token_Type_LESS_LESS || operation == Token_Type_GREATER_GREATER;
+	Type_Id operand_expected = comparison ? Type_Id_NONE : expected;
+
+	// an untyped literal takes the type of the other operand, so that one goes first
+	Value left, right;
+	if (!shift && !get_type(operand_expected)->size && check_untyped(node->left) && !check_untyped(node->right))
+	{
+		if (!evaluate(evaluation, node->right, operand_expected, &right) || !evaluate(evaluation, node->left, right.type, &left))
+			return false;
+	}
+	else if (!evaluate(evaluation, node->left, operand_expected, &left) ||
+	         !evaluate(evaluation, node->right, shift ? Type_Id_NONE : left.type, &right))
+		return false;
+
+	const Type *type = get_type(left.type);
+	if (shift ? get_type(right.type)->kind != Type_Kind_INTEGER : left.type != right.type)
+	{
+		report_span_error(node->span, "the operands are of different types: \"%s\" and \"%s\".", name_type(left.type).string,
+		                  name_type(right.type).string);
+		return false;
+	}
+
+	if (operation == Token_Type_EQUAL_EQUAL || operation == Token_Type_EXCLAMATION_EQUAL)
+	{
+		value->type = Type_Id_BOOL;
+		value->integer = check_values_equality(&left, &right) == (operation == Token_Type_EQUAL_EQUAL);
+		value->relocations = 0;
+		return true;
+	}
+
+	*value = left;
+	if (type->kind == Type_Kind_FLOAT)
+	{
+		F64 a = left.floating;
+		F64 b = right.floating;
+		switch (operation)
+		{
+		case Token_Type_LESS:          value->integer = a < b; break;
+		case Token_Type_GREATER:       value->integer = a > b; break;
+		case Token_Type_LESS_EQUAL:    value->integer = a <= b; break;
+		case Token_Type_GREATER_EQUAL: value->integer = a >= b; break;
+		case Token_Type_PLUS:          value->floating = a + b; return true;
+		case Token_Type_MINUS:         value->floating = a - b; return true;
+		case Token_Type_ASTERISK:      value->floating = a * b; return true;
+		case Token_Type_SLASH:         value->floating = a / b; return true;
+		default:
+			goto invalid;
+		}
+		value->type = Type_Id_BOOL;
+		return true;
+	}
+
+	if (type->kind == Type_Kind_INTEGER || (type->kind == Type_Kind_BOOL && !comparison && !shift &&
+	    (operation == Token_Type_AMPERSAND || operation == Token_Type_BAR || operation == Token_Type_CARET)))
+	{
+		U64 a = left.integer;
+		U64 b = right.integer;
+		bool is_signed = type->is_signed;
+		if (comparison)
+		{
+			bool less = is_signed ? (S64)a < (S64)b : a < b;
+			bool greater = is_signed ? (S64)a > (S64)b : a > b;
+			switch (operation)
+			{
+			case Token_Type_LESS:          value->integer = less; break;
+			case Token_Type_GREATER:       value->integer = greater; break;
+			case Token_Type_LESS_EQUAL:    value->integer = !greater; break;
+			case Token_Type_GREATER_EQUAL: value->integer = !less; break;
+			default:
+				goto invalid;
+			}
+			value->type = Type_Id_BOOL;
+			return true;
+		}
+
+		if ((operation == Token_Type_SLASH || operation == Token_Type_PERCENT) && !b)
+		{
+			report_span_error(node->right->span, "this is zero, which can't be divided by.");
+			return false;
+		}
+		if (shift && b >= (U64)type->size * 8)
+		{
+			report_span_error(node->right->span, "shifting by %lu is more than \"%s\" has bits.", b, name_type(left.type).string);
+			return false;
+		}
+		switch (operation)
+		{
+		case Token_Type_PLUS:            a += b; break;
+		case Token_Type_MINUS:           a -= b; break;
+		case Token_Type_ASTERISK:        a *= b; break;
+		case Token_Type_SLASH:           a = is_signed ? (U64)((S64)a / (S64)b) : a / b; break;
+		case Token_Type_PERCENT:         a = is_signed ? (U64)((S64)a % (S64)b) : a % b; break;
+		case Token_Type_AMPERSAND:       a &= b; break;
+		case Token_Type_BAR:             a |= b; break;
+		case Token_Type_CARET:           a ^= b; break;
+		case Token_Type_LESS_LESS:       a <<= b; break;
+		case Token_Type_GREATER_GREATER: a = is_signed ? (U64)((S64)a >> b) : a >> b; break;
+		default:
+			goto invalid;
+		}
+		value->integer = normalize_integer(left.type, a);
+		return true;
+	}
+
+invalid:
+	char representation[3];
+	format_operator(representation, operation);
+	report_span_error(node->span, "\"%s\" doesn't apply to \"%s\".", representation, name_type(left.type).string);
+	return false;
+}
+
+// calling a type converts to it. procedures can't be called at compile time.
+static bool evaluate_call(Evaluation *evaluation, Node *node, Node *callee, Node **arguments, U32 count, Value *value)
+{
+	Value function;
+	if (!evaluate(evaluation, callee, Type_Id_NONE, &function))
+		return false;
+	if (function.type != Type_Id_TYPE)
+	{
+		if (get_type(function.type)->kind == Type_Kind_PROCEDURE)
+			report_span_error(node->span, "procedures can't be called at compile time.");
+		else
+			report_span_error(callee->span, "a value of type \"%s\" can't be called.", name_type(function.type).string);
+		return false;
+	}
+	Type_Id type = function.type_value;
+	if (count != 1)
+	{
+		report_span_error(node->span, "converting to \"%s\" takes one value.", name_type(type).string);
+		return false;
+	}
+	// a literal is converted rather than checked against the type
+	if (!evaluate(evaluation, arguments[0], check_untyped(arguments[0]) ? Type_Id_NONE : type, value))
+		return false;
+	if (check_assignability(type, value->type))
+	{
+		convert_value(evaluation, value, type);
+		return true;
+	}
+
+	const Type *destination = get_type(type);
+	const Type *source = get_type(value->type);
+	Type_Kind destination_kind = destination->kind == Type_Kind_ENUM ? get_type(destination->base)->kind : destination->kind;
+	Type_Kind source_kind = source->kind == Type_Kind_ENUM ? get_type(source->base)->kind : source->kind;
+	bool source_integral = source_kind == Type_Kind_INTEGER || source_kind == Type_Kind_BOOL;
+	if (destination_kind == Type_Kind_INTEGER && source_integral)
+		value->integer = normalize_integer(type, value->integer);
+	else if (destination_kind == Type_Kind_INTEGER && source_kind == Type_Kind_FLOAT)
+		value->integer = normalize_integer(type, destination->is_signed ? (U64)(S64)value->floating : (U64)value->floating);
+	else if (destination_kind == Type_Kind_FLOAT && source_integral)
+		value->floating = source->is_signed ? (F64)(S64)value->integer : (F64)value->integer;
+	else if (destination_kind == Type_Kind_FLOAT && source_kind == Type_Kind_FLOAT)
+		value->floating = destination->size == 4 ? (F64)(float)value->floating : value->floating;
+	else if (destination_kind == Type_Kind_BOOL && source_integral)
+		value->integer = value->integer != 0;
+	else if (!(destination_kind == Type_Kind_POINTER && source_kind == Type_Kind_POINTER))
+	{
+		report_span_error(node->span, "\"%s\" can't be converted to \"%s\".", name_type(value->type).string, name_type(type).string);
+		return false;
+	}
+	value->type = type;
+	return true;
+}
+
+static bool evaluate_index(Evaluation *evaluation, Node *node, Value *value)
+{
+	Value container, index;
+	if (!evaluate(evaluation, node->left, Type_Id_NONE, &container) || !evaluate(evaluation, node->right, Type_Id_SIZE, &index))
+		return false;
+	if (get_type(index.type)->kind != Type_Kind_INTEGER)
+	{
+		report_span_error(node->right->span, "expected an integer, but this is of type \"%s\".", name_type(index.type).string);
+		return false;
+	}
+
+	const Type *type = get_type(container.type);
+	Type_Id element;
+	U64 count;
+	const U8 *image = container.image;
+	const Relocation *relocations = container.relocations;
+	U32 offset;
+	switch (type->kind)
+	{
+	case Type_Kind_ARRAY:
+		element = type->base;
+		count = type->count;
+		offset = index.integer * get_type(element)->size;
+		break;
+	case Type_Kind_TUPLE:
+		count = type->elements_count;
+		element = index.integer < count ? type->elements[index.integer] : Type_Id_NONE;
+		offset = index.integer < count ? type->offsets[index.integer] : 0;
+		break;
+	case Type_Kind_SLICE:
+		{
+			element = type->base;
+			copy_memory(&count, image + 8, 8);
+			offset = index.integer * get_type(element)->size;
+
+			// the data is what the slice points to
+			const Relocation *data = 0;
+			for (const Relocation *relocation = relocations; relocation; relocation = relocation->next)
+			{
+				if (relocation->offset == 0)
+					data = relocation;
+			}
+			if (!data || data->artifact || data->procedure)
+			{
+				report_span_error(node->left->span, "what the slice points to isn't known at compile time.");
+				return false;
+			}
+			image = data->data.pointer;
+			relocations = data->relocations;
+		}
+		break;
+	default:
+		report_span_error(node->left->span, "a value of type \"%s\" can't be indexed.", name_type(container.type).string);
+		return false;
+	}
+	if (index.integer >= count)
+	{
+		report_span_error(node->right->span, "%lu is out of the bounds of \"%s\", which has %lu elements.", index.integer,
+		                  name_type(container.type).string, count);
+		return false;
+	}
+	*value = load_value(evaluation, element, image, offset, relocations);
+	return true;
+}
+
+// calls `procedure` for every field of the structure or union, with the field's declaration and artifact (null if
+// it has no name).
+template<typename F>
+static bool iterate_over_fields(Node *record, F procedure)
+{
+	for (U32 i = 0; i < record->count; ++i)
+	{
+		Node *declaration = record->nodes[i];
+		if (!declaration->count)
+		{
+			if (!procedure(declaration, (Artifact *)0))
+				return false;
+			continue;
+		}
+		for (U32 j = 0; j < declaration->count; ++j)
+		{
+			if (!procedure(declaration, declaration->artifacts[j]))
+				return false;
+		}
+	}
+	return true;
+}
+
+// fills in the image with the elements of the compound or tuple, which has to be of a type that has an image.
+static bool evaluate_elements(Evaluation *evaluation, Node *node, Type_Id expected, Value *value)
+{
+	if (!require_complete_type(evaluation, expected, node->span))
+		return false;
+	const Type *type = get_type(expected);
+	bool slice = type->kind == Type_Kind_SLICE;
+	Type_Id image_type = slice ? get_array_type(type->base, node->count) : expected;
+	if (!image_type)
+		return false;
+	const Type *image_information = get_type(image_type);
+	U8 *image = make_image(evaluation, image_type);
+	Relocation *relocations = 0;
+
+	// fields that aren't given get their default values
+	if (type->declaration && type->kind != Type_Kind_ENUM)
+	{
+		U32 index = 0;
+		bool done = iterate_over_fields(type->declaration->node->right, [&](Node *declaration, Artifact *artifact) -> bool
+		{
+			U32 field = index++;
+			if (!declaration->right)
+				return true;
+			Value field_value;
+			if (artifact)
+			{
+				if (!use_artifact(evaluation, artifact, node->span))
+					return false;
+				field_value = artifact->value;
+			}
+			else if (!evaluate(evaluation, declaration->right, type->elements[field], &field_value) ||
+			         !assign_value(evaluation, &field_value, type->elements[field], declaration->right->span))
+				return false;
+			store_value(evaluation, image, type->offsets[field], &field_value, &relocations);
+			return true;
+		});
+		if (!done)
+			return false;
+	}
+
+	U32 position = 0;
+	for (U32 i = 0; i < node->count; ++i)
+	{
+		Node *element = node->nodes[i];
+		Node *element_value = element;
+		U32 index = position;
+		if (element->type == Node_Type_MEMBER && !element->left)
+		{
+			String name = get_identifier_string(element->name);
+			if (type->kind != Type_Kind_STRUCT && type->kind != Type_Kind_UNION)
+			{
+				report_span_error(element->span, "\"%s\" has no members to set by name.", name_type(expected).string);
+				return false;
+			}
+			for (index = 0; index < type->elements_count && type->names[index] != element->name; ++index)
+			{
+			}
+			if (index == type->elements_count)
+			{
+				report_span_error(element->span, "\"%s\" has no field \"%.*s\".", name_type(expected).string, (int)name.size, name.pointer);
+				return false;
+			}
+			element_value = element->right;
+		}
+
+		U64 count = image_information->kind == Type_Kind_ARRAY ? image_information->count : image_information->elements_count;
+		if (index >= count)
+		{
+			report_span_error(element->span, "\"%s\" has only %lu elements.", name_type(expected).string, count);
+			return false;
+		}
+		position = index + 1;
+
+		bool array = image_information->kind == Type_Kind_ARRAY;
+		Type_Id element_type = array ? image_information->base : image_information->elements[index];
+		U32 offset = array ? index * get_type(element_type)->size : image_information->offsets[index];
+		Value result;
+		if (!evaluate(evaluation, element_value, element_type, &result) ||
+		    !assign_value(evaluation, &result, element_type, element_value->span))
+			return false;
+		store_value(evaluation, image, offset, &result, &relocations);
+	}
+
+	*value = {};
+	value->type = image_type;
+	value->image = image;
+	value->relocations = relocations;
+	if (slice)
+		convert_value(evaluation, value, expected);
+	return true;
+}
+
+static bool evaluate_tuple(Evaluation *evaluation, Node *node, Type_Id expected, Value *value)
+{
+	switch (get_type(expected)->kind)
+	{
+	case Type_Kind_SLICE:
+	case Type_Kind_ARRAY:
+	case Type_Kind_TUPLE:
+	case Type_Kind_STRUCT:
+		return evaluate_elements(evaluation, node, expected, value);
+	default:
+		break;
+	}
+
+	// either a tuple of types, which is a type, or a tuple of values
+	Value *elements = (Value *)reserve_from_arena(evaluation->arena, node->count * sizeof(Value), alignof(Value));
+	Type_Id *types = (Type_Id *)reserve_from_arena(evaluation->arena, node->count * sizeof(Type_Id), alignof(Type_Id));
+	U32 types_count = 0;
+	for (U32 i = 0; i < node->count; ++i)
+	{
+		if (!evaluate(evaluation, node->nodes[i], Type_Id_NONE, &elements[i]))
+			return false;
+		if (elements[i].type == Type_Id_TYPE)
+		{
+			if (!require_complete_type(evaluation, elements[i].type_value, node->nodes[i]->span))
+				return false;
+			types[i] = elements[i].type_value;
+			++types_count;
+		}
+		else
+			types[i] = elements[i].type;
+	}
+	if (types_count && types_count != node->count)
+	{
+		report_span_error(node->span, "a tuple has either types or values, not both.");
+		return false;
+	}
+
+	Type_Id type = get_tuple_type(types, node->count);
+	if (!type)
+		return false;
+	*value = {};
+	if (types_count || !node->count)
+	{
+		value->type = Type_Id_TYPE;
+		value->type_value = type;
+		return true;
+	}
+	value->type = type;
+	U8 *image = make_image(evaluation, type);
+	value->image = image;
+	for (U32 i = 0; i < node->count; ++i)
+		store_value(evaluation, image, get_type(type)->offsets[i], &elements[i], &value->relocations);
+	return true;
+}
+
+// the types of the fields of a structure or union, or of the parameters or results of a procedure. the fields
+// have to be complete.
+static bool evaluate_field_types(Evaluation *evaluation, Node **declarations, U32 count, bool complete, Type_Id **types,
+                                 Identifier **names, U32 *types_count)
+{
+	U32 capacity = 0;
+	for (U32 i = 0; i < count; ++i)
+		capacity += max(declarations[i]->count, 1);
+	*types = (Type_Id *)reserve_from_arena(evaluation->arena, capacity * sizeof(Type_Id), alignof(Type_Id));
+	*names = (Identifier *)reserve_from_arena(evaluation->arena, capacity * sizeof(Identifier), alignof(Identifier));
+	*types_count = 0;
+
+	for (U32 i = 0; i < count; ++i)
+	{
+		Node *declaration = declarations[i];
+		if (!declaration->count)
+		{
+			Type_Id type;
+			if (!evaluate_type(evaluation, declaration->left, &type))
+				return false;
+			if (declaration->right)
+			{
+				Value value;
+				if (!evaluate(evaluation, declaration->right, type, &value) ||
+				    !assign_value(evaluation, &value, type, declaration->right->span))
+					return false;
+			}
+			if (complete && !require_complete_type(evaluation, type, declaration->left->span))
+				return false;
+			(*names)[*types_count] = 0;
+			(*types)[(*types_count)++] = type;
+			continue;
+		}
+		for (U32 j = 0; j < declaration->count; ++j)
+		{
+			Artifact *artifact = declaration->artifacts[j];
+			if (!evaluate_artifact(evaluation, artifact))
+				return false;
+			if (complete && !require_complete_type(evaluation, artifact->type, artifact->span))
+				return false;
+			(*names)[*types_count] = artifact->name;
+			(*types)[(*types_count)++] = artifact->type;
+		}
+	}
+	return true;
+}
+
+static bool evaluate_procedure(Evaluation *evaluation, Node *node, Value *value)
+{
+	Type_Id *parameters, *results;
+	Identifier *parameter_names, *result_names;
+	U32 parameters_count, results_count;
+	if (!evaluate_field_types(evaluation, node->nodes, node->parameters_count, false, &parameters, &parameter_names, &parameters_count) ||
+	    !evaluate_field_types(evaluation, node->nodes + node->parameters_count, node->count - node->parameters_count, false,
+	                          &results, &result_names, &results_count))
+		return false;
+
+	// the results have to be complete to lay out their tuple
+	for (U32 i = 0; i < results_count; ++i)
+	{
+		if (!require_complete_type(evaluation, results[i], node->span))
+			return false;
+	}
+	*value = {};
+	value->type = get_procedure_type(parameters, parameters_count, get_tuple_type(results, results_count));
+	value->procedure = node;
+	return value->type != Type_Id_NONE;
+}
+
+// anonymous structures and unions are structural.
+static bool evaluate_record(Evaluation *evaluation, Node *node, Type_Id id)
+{
+	Type_Id *fields;
+	Identifier *names;
+	U32 count;
+	if (!evaluate_field_types(evaluation, node->nodes, node->count, true, &fields, &names, &count))
+		return false;
+	complete_record_type(id, fields, names, count);
+	return true;
+}
+
+static bool evaluate_enumeration(Evaluation *evaluation, Node *node, Type_Id id)
+{
+	if (!check_type_completeness(id))
+	{
+		Type_Id base = Type_Id_SIZE;
+		if (node->left && (!evaluate_type(evaluation, node->left, &base) || !require_complete_type(evaluation, base, node->left->span)))
+			return false;
+		complete_enum_type(id, base);
+	}
+
+	// an element that was already evaluated (before the evaluation stopped) is kept
+	Type_Id base = get_type(id)->base;
+	for (U32 i = 0; i < node->count; ++i)
+	{
+		Node *element = node->nodes[i];
+		Artifact *artifact = element->artifacts[0];
+		if (artifact->evaluation == Evaluation_State_DONE)
+			continue;
+		if (artifact->evaluation == Evaluation_State_FAILED)
+			return false;
+
+		artifact->evaluation = Evaluation_State_RUNNING;
+		Value value;
+		if (!evaluate(evaluation, element->right, base, &value) || !assign_value(evaluation, &value, base, element->right->span))
+		{
+			artifact->evaluation = evaluation->blocker ? Evaluation_State_NONE : Evaluation_State_FAILED;
+			return false;
+		}
+		for (U32 j = 0; j < i; ++j)
+		{
+			Artifact *other = node->nodes[j]->artifacts[0];
+			Value other_value = other->value;
+			other_value.type = base;
+			if (check_values_equality(&other_value, &value))
+			{
+				String name = get_identifier_string(artifact->name);
+				String other_name = get_identifier_string(other->name);
+				flockfile(stderr);
+				report_span_error(element->right->span, "\"%.*s\" has the same value as \"%.*s\".", (int)name.size,
+				                  name.pointer, (int)other_name.size, other_name.pointer);
+				report_span_note(other->span, "\"%.*s\" is declared here.", (int)other_name.size, other_name.pointer);
+				funlockfile(stderr);
+				artifact->evaluation = Evaluation_State_FAILED;
+				return false;
+			}
+		}
+		value.type = id;
+		artifact->type = id;
+		artifact->value = value;
+		artifact->evaluation = Evaluation_State_DONE;
+	}
+	return true;
+}
+
+bool evaluate(Evaluation *evaluation, Node *node, Type_Id expected, Value *value)
+{
+	*value = {};
+	switch (node->type)
+	{
+	case Node_Type_NAME:
+		return evaluate_name(evaluation, node, value);
+	case Node_Type_LITERAL:
+		return evaluate_literal(evaluation, node, expected, value, false);
+	case Node_Type_BOOLEAN:
+		value->type = Type_Id_BOOL;
+		value->integer = node->boolean;
+		return true;
+	case Node_Type_ELEMENT:
+		return evaluate_element(evaluation, node, expected, value);
+	case Node_Type_UNARY:
+		return evaluate_unary(evaluation, node, expected, value);
+	case Node_Type_BINARY:
+		return evaluate_binary(evaluation, node, expected, value);
+	case Node_Type_CONDITIONAL:
+		{
+			Value condition;
+			if (!evaluate(evaluation, node->left, Type_Id_BOOL, &condition))
+				return false;
+			if (condition.type != Type_Id_BOOL)
+			{
+				report_span_error(node->left->span, "expected a \"Bool\", but this is of type \"%s\".", name_type(condition.type).string);
+				return false;
+			}
+			Node *branch = condition.integer ? node->right : node->other;
+			if (!branch)
+			{
+				report_span_error(node->span, "the condition is false, and there's no value for that case.");
+				return false;
+			}
+			return evaluate(evaluation, branch, expected, value);
+		}
+	case Node_Type_SWITCH:
+		{
+			Value subject;
+			if (!evaluate(evaluation, node->left, Type_Id_NONE, &subject))
+				return false;
+			for (U32 i = 0; i < node->count; ++i)
+			{
+				Node *case_node = node->nodes[i];
+				for (U32 j = 0; j < case_node->count; ++j)
+				{
+					Value case_value;
+					if (!evaluate(evaluation, case_node->nodes[j], subject.type, &case_value) ||
+					    !assign_value(evaluation, &case_value, subject.type, case_node->nodes[j]->span))
+						return false;
+					if (check_values_equality(&subject, &case_value))
+						return evaluate(evaluation, case_node->left, expected, value);
+				}
+			}
+			if (!node->other)
+			{
+				report_span_error(node->span, "no case matches, and there's no value for that.");
+				return false;
+			}
+			return evaluate(evaluation, node->other, expected, value);
+		}
+	case Node_Type_CALL:
+		return evaluate_call(evaluation, node, node->left, node->nodes, node->count, value);
+	case Node_Type_MEMBER:
+		return evaluate_member(evaluation, node, value);
+	case Node_Type_INDEX:
+		return evaluate_index(evaluation, node, value);
+	case Node_Type_COMPOUND:
+		{
+			Type_Id type = expected;
+			if (node->left && !evaluate_type(evaluation, node->left, &type))
+				return false;
+			if (node->left && !check_image(type))
+			{
+				report_span_error(node->left->span, "a compound can't be of type \"%s\".", name_type(type).string);
+				return false;
+			}
+			if (!type || !check_image(type))
+			{
+				report_span_error(node->span, "the type of the compound isn't known here.");
+				return false;
+			}
+			return evaluate_elements(evaluation, node, type, value);
+		}
+	case Node_Type_TUPLE:
+		return evaluate_tuple(evaluation, node, expected, value);
+	case Node_Type_SIZE_OF:
+		{
+			Node *operand = node->left;
+			Type_Id type;
+			Artifact *artifact = operand->type == Node_Type_NAME ? operand->reference->artifact : 0;
+			if (artifact && !check_constant(artifact))
+			{
+				if (!use_artifact(evaluation, artifact, operand->span))
+					return false;
+				type = artifact->type;
+			}
+			else
+			{
+				Value operand_value;
+				if (!evaluate(evaluation, operand, Type_Id_NONE, &operand_value))
+					return false;
+				type = operand_value.type == Type_Id_TYPE ? operand_value.type_value : operand_value.type;
+			}
+			if (!require_complete_type(evaluation, type, operand->span))
+				return false;
+			value->type = Type_Id_SIZE;
+			value->integer = get_type(type)->size;
+			return true;
+		}
+	case Node_Type_SLICE_TYPE:
+	case Node_Type_ARRAY_TYPE:
+		{
+			Type_Id element;
+			if (!evaluate_type(evaluation, node->left, &element))
+				return false;
+			value->type = Type_Id_TYPE;
+			if (node->type == Node_Type_SLICE_TYPE)
+			{
+				value->type_value = get_slice_type(element);
+				return value->type_value != Type_Id_NONE;
+			}
+
+			Value count;
+			if (!evaluate(evaluation, node->right, Type_Id_SIZE, &count) || !require_complete_type(evaluation, element, node->left->span))
+				return false;
+			if (get_type(count.type)->kind != Type_Kind_INTEGER || (get_type(count.type)->is_signed && (S64)count.integer < 0))
+			{
+				report_span_error(node->right->span, "the length of an array has to be an integer that isn't negative.");
+				return false;
+			}
+			value->type_value = get_array_type(element, count.integer);
+			return value->type_value != Type_Id_NONE;
+		}
+	case Node_Type_PROCEDURE:
+		return evaluate_procedure(evaluation, node, value);
+	case Node_Type_STRUCT:
+	case Node_Type_UNION:
+		{
+			Type_Id *fields;
+			Identifier *names;
+			U32 count;
+			if (!evaluate_field_types(evaluation, node->nodes, node->count, true, &fields, &names, &count))
+				return false;
+			value->type = Type_Id_TYPE;
+			value->type_value = get_record_type(node->type == Node_Type_STRUCT ? Type_Kind_STRUCT : Type_Kind_UNION, fields, names, count);
+			return value->type_value != Type_Id_NONE;
+		}
+	case Node_Type_ENUM:
+		report_span_error(node->span, "enumerations have to be declared as constants with a name.");
+		return false;
+	default:
+		report_span_error(node->span, "this can't be evaluated at compile time.");
+		return false;
+	}
+}
+
+static bool evaluate_declaration(Evaluation *evaluation, Artifact *artifact)
+{
+	Node *declaration = artifact->node;
+	Type_Id type = Type_Id_NONE;
+	if (declaration->left && !evaluate_type(evaluation, declaration->left, &type))
+		return false;
+
+	Node *node = declaration->right;
+	if (!node)
+	{
+		// a variable without an initial value is all zeros
+		artifact->type = type;
+		artifact->value = {};
+		artifact->value.type = type;
+		return true;
+	}
+	if (declaration->count > 1)
+	{
+		if (node->type != Node_Type_TUPLE || node->count != declaration->count)
+		{
+			report_span_error(node->span, "expected %u values, one for each name.", declaration->count);
+			return false;
+		}
+		node = node->nodes[artifact->index];
+	}
+
+	if (Type_Kind kind = get_nominal_kind(artifact))
+	{
+		Type_Id id = get_nominal_type(kind, artifact);
+		if (!id)
+			return false;
+		artifact->type = Type_Id_TYPE;
+		artifact->value = {};
+		artifact->value.type = Type_Id_TYPE;
+		artifact->value.type_value = id;
+		return kind == Type_Kind_ENUM ? evaluate_enumeration(evaluation, node, id) : evaluate_record(evaluation, node, id);
+	}
+	if (node->type == Node_Type_BLOCK && declaration->operation == Token_Type_COLON)
+	{
+		// a named scope
+		artifact->type = Type_Id_VOID;
+		artifact->value = {};
+		artifact->value.type = Type_Id_VOID;
+		return true;
+	}
+
+	Value value;
+	if (!evaluate(evaluation, node, type, &value) || (type && !assign_value(evaluation, &value, type, node->span)))
+		return false;
+	artifact->type = value.type;
+	artifact->value = value;
+	return true;
+}
+
+bool evaluate_artifact(Evaluation *evaluation, Artifact *artifact)
+{
+	switch (artifact->evaluation)
+	{
+	case Evaluation_State_DONE:
+		return true;
+	case Evaluation_State_FAILED:
+		return false;
+	case Evaluation_State_RUNNING:
+		{
+			String name = get_identifier_string(artifact->name);
+			report_span_error(artifact->span, "\"%.*s\" depends on itself.", (int)name.size, name.pointer);
+			return false;
+		}
+	default:
+		break;
+	}
+
+	// elements are evaluated with their enumeration
+	Artifact *owner = artifact->scope ? artifact->scope->owner : 0;
+	if (owner && get_nominal_kind(owner) == Type_Kind_ENUM)
+		return evaluate_artifact(evaluation, owner) && artifact->evaluation == Evaluation_State_DONE;
+
+	artifact->evaluation = Evaluation_State_RUNNING;
+	bool done = evaluate_declaration(evaluation, artifact);
+	if (done)
+		artifact->evaluation = Evaluation_State_DONE;
+	else
+		artifact->evaluation = evaluation->blocker ? Evaluation_State_NONE : Evaluation_State_FAILED;
+	return done;
+}
+
+// evaluates what's declared in the scope and the ones inside it, except in procedures. with `procedures`, it's
+// the constants and static variables everywhere instead.
+static bool evaluate_scope(Evaluation *evaluation, Scope *scope, bool procedures)
+{
+	if (scope->procedure && !procedures)
+		return true;
+
+	// everything else outside of procedures is done by then
+	for (Size i = 0; i < get_list_count(&scope->artifacts); ++i)
+	{
+		Artifact *artifact = get_list_item(&scope->artifacts, i);
+		if (procedures && !check_constant(artifact) && !artifact->node->is_static)
+			continue;
+		if (!evaluate_artifact(evaluation, artifact) && evaluation->blocker)
+			return false;
+	}
+	for (Size i = 0; i < get_list_count(&scope->children); ++i)
+	{
+		if (!evaluate_scope(evaluation, get_list_item(&scope->children, i), procedures))
+			return false;
+	}
+	return true;
+}
+
+// everything in the top-level artifact's tree outside of procedures, or with `procedures`, what's left inside them.
+static bool evaluate_tree(Evaluation *evaluation, Artifact *artifact, bool procedures)
+{
+	if (!evaluate_artifact(evaluation, artifact) && evaluation->blocker)
+		return false;
+	for (Size i = 0; i < get_list_count(&artifact->scopes); ++i)
+	{
+		if (!evaluate_scope(evaluation, get_list_item(&artifact->scopes, i), procedures))
+			return false;
+	}
+	return true;
+}
+
+// analysis
+
+// tasks that are ready to run are on a stack. the workers sleep while it's empty and some task is still running,
+// since that one may wake others up; once it's empty and none is running, every task is either done or stuck.
+static struct
+{
+	Mutex mutex;
+	Condition condition;
+	List<Task> ready;
+	Size running_count;
+}
+scheduler;
+
+// states only change under the scheduler's lock, but `use_artifact` reads them without it
+static void set_task_state(Task *task, Task_State state)
+{
+	__atomic_store_n(&task->state, state, __ATOMIC_RELEASE);
+}
+
+static void push_ready_task(Task *task)
+{
+	set_task_state(task, Task_State_QUEUED);
+	add_to_list(&scheduler.ready, task);
+}
+
+static Task *pop_ready_task(void)
+{
+	Size count = get_list_count(&scheduler.ready);
+	if (!count)
+		return 0;
+	Task *task = get_list_item(&scheduler.ready, count - 1);
+	release_from_buffer(&scheduler.ready.items, sizeof(Task *), alignof(Task *));
+	return task;
+}
+
+// returns the task that it has to wait for, or null once it's done. only one thread runs a task at a time, and
+// it only resolves names from the scopes of its own artifact, so the memoization of the scopes needs no lock.
+// the names are all resolved before anything is evaluated, so what the evaluation needs from other tasks'
+// artifacts is only read once those are done.
+static Task *run_task(Task *task, Arena *arena)
+{
+	for (Reference *reference; (reference = task->next_reference); task->next_reference = reference->next)
+	{
+		Artifact *artifact = resolve_backwards_name(reference->scope, reference->levels, reference->name);
+		reference->artifact = artifact;
+		if (!artifact)
+		{
+			if (reference->levels || !find_builtin_type(reference->name))
+			{
+				String name = get_identifier_string(reference->name);
+				report_span_error(reference->span, "\"%.*s\" is not declared.", (int)name.size, name.pointer);
+			}
+			continue;
+		}
+		if (!artifact->scope && artifact != task->artifact)
+			add_to_list(&task->dependencies, artifact);
+	}
+
+	Evaluation evaluation = {task, arena, 0, {}};
+	if (evaluate_tree(&evaluation, task->artifact, false))
+		return 0;
+	task->blocking_span = evaluation.blocking_span;
+	return evaluation.blocker;
+}
+
+// `input` is the worker's arena, for the values it evaluates.
+static void *run_tasks(void *input)
+{
+	lock_mutex(&scheduler.mutex);
+	for (;;)
+	{
+		// once compiling stops, the workers only wait for the tasks that are running
+		Task *task = check_compilation_stopped() ? 0 : pop_ready_task();
+		if (!task)
+		{
+			if (!scheduler.running_count)
+				break;
+			wait_condition(&scheduler.condition, &scheduler.mutex);
+			continue;
+		}
+		set_task_state(task, Task_State_RUNNING);
+		++scheduler.running_count;
+		unlock_mutex(&scheduler.mutex);
+
+		Task *blocker = run_task(task, (Arena *)input);
+
+		lock_mutex(&scheduler.mutex);
+		--scheduler.running_count;
+
+		// whatever a task refers to is reached as well, along with whatever it waits for
+		for (; task->reached_count < get_list_count(&task->dependencies); ++task->reached_count)
+		{
+			Task *dependency = get_list_item(&task->dependencies, task->reached_count)->task;
+			if (dependency->state == Task_State_IDLE)
+				push_ready_task(dependency);
+		}
+		if (blocker && blocker->state == Task_State_IDLE)
+			push_ready_task(blocker);
+
+		if (!blocker)
+		{
+			set_task_state(task, Task_State_DONE);
+			for (Task *waiter = task->waiters; waiter; waiter = waiter->next_waiter)
+			{
+				waiter->blocker = 0;
+				push_ready_task(waiter);
+			}
+			task->waiters = 0;
+		}
+		else if (blocker->state == Task_State_DONE)
+			push_ready_task(task); // it finished in the meantime
+		else
+		{
+			set_task_state(task, Task_State_PARKED);
+			task->blocker = blocker;
+			task->next_waiter = blocker->waiters;
+			blocker->waiters = task;
+		}
+		if (get_list_count(&scheduler.ready) || !scheduler.running_count)
+			broadcast_condition(&scheduler.condition);
+	}
+	unlock_mutex(&scheduler.mutex);
+	return 0;
+}
+
+// a parked task waits on exactly one other, so following the blockers from a stuck task always ends in a cycle.
+// each cycle is reported once, from the first of its tasks that a walk reaches. returns whether there were any.
+static bool report_cycles(Task *tasks, Size tasks_count)
+{
+	bool stuck = false;
+	for (Size i = 0; i < tasks_count; ++i)
+	{
+		Size mark = i + 1;
+		Task *task = &tasks[i];
+		while (task && task->state == Task_State_PARKED && !task->mark)
+		{
+			task->mark = mark;
+			task = task->blocker;
+		}
+		if (!task || task->mark != mark)
+			continue;
+		stuck = true;
+
+		String name = get_identifier_string(task->artifact->name);
+		flockfile(stderr);
+		report_span_error(task->artifact->span, "\"%.*s\" depends on itself.", (int)name.size, name.pointer);
+		Task *cycle = task;
+		do
+		{
+			String dependent = get_identifier_string(task->artifact->name);
+			String dependency = get_identifier_string(task->blocker->artifact->name);
+			report_span_note(task->blocking_span, "\"%.*s\" needs \"%.*s\" here.",
+			                 (int)dependent.size, dependent.pointer, (int)dependency.size, dependency.pointer);
+			task = task->blocker;
+		}
+		while (task != cycle);
+		funlockfile(stderr);
+	}
+	return stuck;
+}
+
+void analyze(Parser *parsers, Size parsers_count, bool lazy)
+{
+	Size tasks_count = 0;
+	for (Size i = 0; i < parsers_count; ++i)
+		tasks_count += get_list_count(&parsers[i].declarations);
+	if (!tasks_count)
+		return;
+
+	Task *tasks = (Task *)allocate(tasks_count * sizeof(Task));
+	set_memory(tasks, tasks_count * sizeof(Task), 0);
+	initialize_mutex(&scheduler.mutex);
+	initialize_condition(&scheduler.condition);
+
+	// pushed backwards, so they start in the order they're declared
+	Artifact *start = lazy ? find_global_artifact(intern_identifier((const Utf8 *)"_start", 6)) : 0;
+	Size roots_count = 0;
+	Size index = tasks_count;
+	for (Size i = parsers_count; i--;)
+	{
+		const List<Artifact> *declarations = &parsers[i].declarations;
+		for (Size j = get_list_count(declarations); j--;)
+		{
+			Task *task = &tasks[--index];
+			task->artifact = get_list_item(declarations, j);
+			task->artifact->task = task;
+			task->next_reference = task->artifact->references;
+			if (!lazy || task->artifact == start || task->artifact->exported)
+			{
+				push_ready_task(task);
+				++roots_count;
+			}
+		}
+	}
+	if (!roots_count)
+	{
+		report_error("there's nothing to start the analysis from: \"_start\" isn't declared, and nothing is exported.");
+		return;
+	}
+
+	// the values outlive the analysis, so the arenas are kept
+	Size threads_count = min(get_processors_count(), tasks_count);
+	Thread *threads = (Thread *)allocate(threads_count * sizeof(Thread));
+	Arena *arenas = (Arena *)allocate(threads_count * sizeof(Arena));
+	for (Size i = 0; i < threads_count; ++i)
+		initialize_arena(&arenas[i], 0);
+	Size created_threads_count = 0;
+	for (Size i = 1; i < threads_count; ++i)
+	{
+		if (!create_thread(&threads[created_threads_count], run_tasks, &arenas[i]))
+			break;
+		++created_threads_count;
+	}
+	run_tasks(&arenas[0]);
+	for (Size i = 0; i < created_threads_count; ++i)
+		join_thread(threads[i]);
+	deallocate(threads);
+
+	if (check_compilation_stopped() || report_cycles(tasks, tasks_count))
+		return;
+
+	// what's left is in procedures. every task is done, so nothing can stop the evaluation anymore.
+	Evaluation evaluation = {0, &arenas[0], 0, {}};
+	for (Size i = 0; i < tasks_count && !check_compilation_stopped(); ++i)
+	{
+		if (tasks[i].state == Task_State_DONE)
+			evaluate_tree(&evaluation, tasks[i].artifact, true);
+	}
+}
+
+// intermediate representation
+
+Instruction *get_instruction(const Procedure *procedure, Instruction_Id id)
+{
+	return &((Instruction *)procedure->instructions.pointer)[id];
+}
+
+U32 get_instructions_count(const Procedure *procedure)
+{
+	return (U32)(procedure->instructions.mass / sizeof(Instruction));
+}
+
+Block *get_block(const Procedure *procedure, Block_Id id)
+{
+	return &((Block *)procedure->blocks.pointer)[id];
+}
+
+U32 get_blocks_count(const Procedure *procedure)
+{
+	return (U32)(procedure->blocks.mass / sizeof(Block));
+}
+
+static U32 get_block_instructions_count(const Block *block)
+{
+	return (U32)(block->instructions.mass / sizeof(Instruction_Id));
+}
+
+static Instruction_Id *get_block_instructions(const Block *block)
+{
+	return (Instruction_Id *)block->instructions.pointer;
+}
+
+static U32 get_predecessors_count(const Block *block)
+{
+	return (U32)(block->predecessors.mass / sizeof(Block_Id));
+}
+
+static Block_Id *get_predecessors(const Block *block)
+{
+	return (Block_Id *)block->predecessors.pointer;
+}
+
+// the terminator, or null if the block has none (yet)
+static Instruction *get_terminator(const Procedure *procedure, Block_Id id)
+{
+	const Block *block = get_block(procedure, id);
+	U32 count = get_block_instructions_count(block);
+	if (!count)
+		return 0;
+	Instruction *instruction = get_instruction(procedure, get_block_instructions(block)[count - 1]);
+	return instruction->operation >= Operation_JUMP ? instruction : 0;
+}
+
+static U32 get_successors_count(const Instruction *terminator)
+{
+	if (!terminator)
+		return 0;
+	switch (terminator->operation)
+	{
+	case Operation_JUMP:   return 1;
+	case Operation_BRANCH: return 2;
+	case Operation_SWITCH: return terminator->table.targets_count;
+	default:               return 0;
+	}
+}
+
+static Block_Id *get_successors(const Instruction *terminator)
+{
+	return terminator->operation == Operation_SWITCH ? terminator->table.targets : (Block_Id *)terminator->targets;
+}
+
+static U32 get_map_slot(const Index_Map *map, U64 key)
+{
+	return (U32)((key * 0x9E3779B97F4A7C15) >> 32) & (map->capacity - 1);
+}
+
+static U64 *find_in_map(const Index_Map *map, U64 key)
+{
+	if (!map->capacity)
+		return 0;
+	for (U32 i = get_map_slot(map, key);; i = (i + 1) & (map->capacity - 1))
+	{
+		if (map->keys[i] == key)
+			return &map->values[i];
+		if (!map->keys[i])
+			return 0;
+	}
+}
+
+// returns where the key's value is, which is zero if the key is new.
+static U64 *insert_into_map(Index_Map *map, U64 key)
+{
+	if ((map->count + 1) * 2 > map->capacity)
+	{
+		Index_Map old = *map;
+		map->capacity = old.capacity ? old.capacity * 2 : 16;
+		map->count = 0;
+		map->keys = (U64 *)allocate(map->capacity * sizeof(U64));
+		map->values = (U64 *)allocate(map->capacity * sizeof(U64));
+		set_memory(map->keys, map->capacity * sizeof(U64), 0);
+		for (U32 i = 0; i < old.capacity; ++i)
+		{
+			if (old.keys[i])
+				*insert_into_map(map, old.keys[i]) = old.values[i];
+		}
+		deallocate(old.keys);
+		deallocate(old.values);
+	}
+	for (U32 i = get_map_slot(map, key);; i = (i + 1) & (map->capacity - 1))
+	{
+		if (map->keys[i] == key)
+			return &map->values[i];
+		if (!map->keys[i])
+		{
+			map->keys[i] = key;
+			map->values[i] = 0;
+			++map->count;
+			return &map->values[i];
+		}
+	}
+}
+
+static void uninitialize_map(Index_Map *map)
+{
+	deallocate(map->keys);
+	deallocate(map->values);
+	*map = {};
+}
+
+static Block_Id add_block(Procedure *procedure)
+{
+	Block_Id id = get_blocks_count(procedure);
+	Block *block = (Block *)reserve_from_buffer(&procedure->blocks, sizeof(Block), alignof(Block));
+	*block = {};
+	return id;
+}
+
+static void add_predecessor(Procedure *procedure, Block_Id block, Block_Id predecessor)
+{
+	Block_Id *slot = (Block_Id *)reserve_from_buffer(&get_block(procedure, block)->predecessors, sizeof(Block_Id), alignof(Block_Id));
+	*slot = predecessor;
+}
+
+// `position` is where it goes among the instructions of the block; past the end, it's appended.
+static Instruction_Id insert_instruction(Procedure *procedure, Block_Id block, U32 position, Operation operation, Type_Id type,
+                                         U32 operands_count)
+{
+	Instruction_Id id = get_instructions_count(procedure);
+	Instruction *instruction = (Instruction *)reserve_from_buffer(&procedure->instructions, sizeof(Instruction), alignof(Instruction));
+	*instruction = {};
+	instruction->operation = operation;
+	instruction->type = type;
+	instruction->block = block;
+	instruction->operands_count = operands_count;
+	if (operands_count)
+	{
+		Size size = operands_count * sizeof(Instruction_Id);
+		instruction->operands = (Instruction_Id *)reserve_from_arena(&procedure->operands, size, alignof(Instruction_Id));
+		set_memory(instruction->operands, size, 0);
+	}
+
+	Buffer *instructions = &get_block(procedure, block)->instructions;
+	U32 count = (U32)(instructions->mass / sizeof(Instruction_Id));
+	reserve_from_buffer(instructions, sizeof(Instruction_Id), alignof(Instruction_Id));
+	Instruction_Id *ids = (Instruction_Id *)instructions->pointer;
+	if (position < count)
+		move_memory(&ids[position + 1], &ids[position], (count - position) * sizeof(Instruction_Id));
+	else
+		position = count;
+	ids[position] = id;
+	return id;
+}
+
+static void initialize_procedure_body(Procedure *procedure)
+{
+	initialize_arena(&procedure->operands, 0);
+
+	// so that zero names no instruction
+	Instruction *none = (Instruction *)reserve_from_buffer(&procedure->instructions, sizeof(Instruction), alignof(Instruction));
+	*none = {};
+	none->type = Type_Id_VOID;
+}
+
+static Procedure *get_procedure(Program *program, Node *node)
+{
+	U64 *slot = insert_into_map(&program->procedures_by_node, (U64)(Address)node);
+	if (*slot)
+		return (Procedure *)(Address)*slot;
+	Procedure *procedure = (Procedure *)reserve_from_arena(&program->arena, sizeof(Procedure), alignof(Procedure));
+	*procedure = {};
+	procedure->node = node;
+	procedure->artifact = node->scope->owner;
+	procedure->index = get_list_count(&program->procedures);
+	procedure->external = !node->right;
+	add_to_list(&program->procedures, procedure);
+	*slot = (U64)(Address)procedure;
+	return procedure;
+}
+
+// a few results that are all scalars are returned in registers, much like C returns small structures. the others
+// are returned through an address.
+constexpr U32 MAXIMUM_REGISTER_RESULTS_COUNT = 2;
+
+static bool check_register_results(Type_Id results)
+{
+	const Type *type = get_type(results);
+	if (type->elements_count > MAXIMUM_REGISTER_RESULTS_COUNT)
+		return false;
+	for (U32 i = 0; i < type->elements_count; ++i)
+	{
+		if (check_image(type->elements[i]))
+			return false;
+	}
+	return true;
+}
+
+// enumerations are folded like their base types, and pointers like addresses.
+static const Type *get_underlying_type(Type_Id type)
+{
+	const Type *information = get_type(type);
+	if (information->kind == Type_Kind_ENUM)
+		information = get_type(information->base);
+	return information;
+}
+
+static F64 load_float(const Type *type, U64 bits)
+{
+	if (type->size == 4)
+	{
+		float floating;
+		copy_memory(&floating, &bits, 4);
+		return floating;
+	}
+	F64 floating;
+	copy_memory(&floating, &bits, 8);
+	return floating;
+}
+
+static U64 store_float(const Type *type, F64 floating)
+{
+	U64 bits = 0;
+	if (type->size == 4)
+	{
+		float narrow = (float)floating;
+		copy_memory(&bits, &narrow, 4);
+	}
+	else
+		copy_memory(&bits, &floating, 8);
+	return bits;
+}
+
+// lowering
+
+struct Variable
+{
+	Type_Id type;
+	Instruction_Id address; // of its stack slot, if it's in memory; otherwise, it's an SSA value
+};
+
+// a read of a variable in a block that may still get predecessors
+struct Pending_Phi
+{
+	Block_Id block;
+	U32 variable;
+	Instruction_Id phi;
+};
+
+struct Label_Block
+{
+	Label *label;
+	Block_Id block;
+};
+
+struct Lowering
+{
+	Program *program;
+	Procedure *procedure;
+	Evaluation evaluation;
+	Index_Map *reached; // the global artifacts whose values were searched for procedures
+
+	Block_Id block; // where the instructions go
+	Buffer sealed;  // of `bool`, for each block: whether it has all its predecessors
+
+	Buffer variables;           // of `Variable`
+	Index_Map variable_indices; // from the artifacts to their variables, plus one
+	Index_Map definitions;      // from (block, variable) to the value it has at the end of the block
+	Buffer pending_phis;        // of `Pending_Phi`
+	Index_Map addressed;        // the artifacts whose addresses are taken
+	Buffer labels;              // of `Label_Block`
+
+	Instruction_Id results_address; // where the results go, unless they're returned in registers
+	bool named_results;             // whether every result has a name, so `return` needs no values
+	Buffer results;                 // of the variables of the named results
+};
+
+// what an expression is lowered into
+struct Operand
+{
+	Type_Id type;
+	Instruction_Id value;   // of scalars that aren't in memory
+	Instruction_Id address; // of anything in memory
+	U32 variable;           // plus one, if it's a variable that's an SSA value
+	Type_Id type_value;     // types, which only exist at compile time
+	const Instruction_Id *elements; // of tuples whose elements are SSA values instead, like results in registers
+};
+
+static Block_Id add_lowering_block(Lowering *lowering)
+{
+	*(bool *)reserve_from_buffer(&lowering->sealed, sizeof(bool), alignof(bool)) = false;
+	return add_block(lowering->procedure);
+}
+
+static Instruction_Id emit(Lowering *lowering, Operation operation, Type_Id type, U32 operands_count)
+{
+	return insert_instruction(lowering->procedure, lowering->block, ~(U32)0, operation, type, operands_count);
+}
+
+// `b` is zero if there's one operand.
+static Instruction_Id emit_operation(Lowering *lowering, Operation operation, Type_Id type, Instruction_Id a, Instruction_Id b)
+{
+	Instruction_Id id = emit(lowering, operation, type, b ? 2 : 1);
+	Instruction *instruction = get_instruction(lowering->procedure, id);
+	instruction->operands[0] = a;
+	if (b)
+		instruction->operands[1] = b;
+	return id;
+}
+
+static Instruction_Id emit_constant(Lowering *lowering, Type_Id type, U64 constant)
+{
+	Instruction_Id id = emit(lowering, Operation_CONSTANT, type, 0);
+	get_instruction(lowering->procedure, id)->constant = constant;
+	return id;
+}
+
+// stack slots are all made in the entry, so that one in a loop is still made once.
+static Instruction_Id emit_local(Lowering *lowering, Type_Id type)
+{
+	const Type *information = get_type(type);
+	Instruction_Id id = insert_instruction(lowering->procedure, 0, 0, Operation_LOCAL, get_pointer_type(type), 0);
+	Instruction *instruction = get_instruction(lowering->procedure, id);
+	instruction->slot.size = information->size;
+	instruction->slot.alignment = information->alignment;
+	return id;
+}
+
+// the address of something of type `type` at `offset` bytes from `address`
+static Instruction_Id emit_offset(Lowering *lowering, Instruction_Id address, U32 offset, Type_Id type)
+{
+	if (!offset)
+		return address;
+	Instruction_Id constant = emit_constant(lowering, Type_Id_SIZE, offset);
+	return emit_operation(lowering, Operation_ADD, get_pointer_type(type), address, constant);
+}
+
+static void emit_memory_operation(Lowering *lowering, Operation operation, Instruction_Id destination, Instruction_Id source, Type_Id type)
+{
+	Instruction_Id id = source ? emit_operation(lowering, operation, Type_Id_VOID, destination, source) :
+	                             emit_operation(lowering, operation, Type_Id_VOID, destination, 0);
+	Instruction *instruction = get_instruction(lowering->procedure, id);
+	instruction->slot.size = get_type(type)->size;
+	instruction->slot.alignment = get_type(type)->alignment;
+}
+
+static void emit_jump(Lowering *lowering, Block_Id target)
+{
+	Instruction_Id id = emit(lowering, Operation_JUMP, Type_Id_VOID, 0);
+	get_instruction(lowering->procedure, id)->targets[0] = target;
+	add_predecessor(lowering->procedure, target, lowering->block);
+}
+
+static void emit_branch(Lowering *lowering, Instruction_Id condition, Block_Id then_block, Block_Id else_block)
+{
+	Instruction_Id id = emit_operation(lowering, Operation_BRANCH, Type_Id_VOID, condition, 0);
+	Instruction *instruction = get_instruction(lowering->procedure, id);
+	instruction->targets[0] = then_block;
+	instruction->targets[1] = else_block;
+	add_predecessor(lowering->procedure, then_block, lowering->block);
+	add_predecessor(lowering->procedure, else_block, lowering->block);
+}
+
+// what follows a jump or a return is unreachable, unless a label begins a block for it.
+static void start_unreachable_block(Lowering *lowering)
+{
+	lowering->block = add_lowering_block(lowering);
+	((bool *)lowering->sealed.pointer)[lowering->block] = true;
+}
+
+// SSA construction (as in Braun et al., "Simple and Efficient Construction of Static Single Assignment Form"):
+// a variable's value is looked up from the block that reads it backwards through its predecessors, and a block
+// that may still get predecessors gets a phi that's only filled in once it's sealed.
+
+static U64 get_definition_key(Block_Id block, U32 variable)
+{
+	return (U64)block << 32 | (variable + 1);
+}
+
+static void write_variable(Lowering *lowering, U32 variable, Block_Id block, Instruction_Id value)
+{
+	*insert_into_map(&lowering->definitions, get_definition_key(block, variable)) = value;
+}
+
+static Instruction_Id read_variable(Lowering *lowering, U32 variable, Block_Id block);
+
+static void add_phi_operands(Lowering *lowering, U32 variable, Instruction_Id phi)
+{
+	Procedure *procedure = lowering->procedure;
+	Block_Id block = get_instruction(procedure, phi)->block;
+	U32 count = get_predecessors_count(get_block(procedure, block));
+	Instruction_Id *operands = (Instruction_Id *)reserve_from_arena(&procedure->operands, count * sizeof(Instruction_Id), alignof(Instruction_Id));
+	for (U32 i = 0; i < count; ++i)
+		operands[i] = read_variable(lowering, variable, get_predecessors(get_block(procedure, block))[i]);
+	Instruction *instruction = get_instruction(procedure, phi);
+	instruction->operands = operands;
+	instruction->operands_count = count;
+}
+
+static Instruction_Id read_variable(Lowering *lowering, U32 variable, Block_Id block)
+{
+	if (U64 *value = find_in_map(&lowering->definitions, get_definition_key(block, variable)))
+		return (Instruction_Id)*value;
+
+	Procedure *procedure = lowering->procedure;
+	Type_Id type = ((Variable *)lowering->variables.pointer)[variable].type;
+	const Block *information = get_block(procedure, block);
+	U32 count = get_predecessors_count(information);
+	Instruction_Id value;
+	if (!((bool *)lowering->sealed.pointer)[block])
+	{
+		value = insert_instruction(procedure, block, 0, Operation_PHI, type, 0);
+		Pending_Phi *pending = (Pending_Phi *)reserve_from_buffer(&lowering->pending_phis, sizeof(Pending_Phi), alignof(Pending_Phi));
+		*pending = {block, variable, value};
+	}
+	else if (count == 1)
+		value = read_variable(lowering, variable, get_predecessors(information)[0]);
+	else if (!count)
+	{
+		// only unreachable code reads a variable before it's written
+		value = insert_instruction(procedure, block, 0, Operation_CONSTANT, type, 0);
+	}
+	else
+	{
+		// the phi breaks cycles through loops
+		value = insert_instruction(procedure, block, 0, Operation_PHI, type, 0);
+		write_variable(lowering, variable, block, value);
+		add_phi_operands(lowering, variable, value);
+	}
+	write_variable(lowering, variable, block, value);
+	return value;
+}
+
+static void seal_block(Lowering *lowering, Block_Id block)
+{
+	for (Size i = 0; i < lowering->pending_phis.mass / sizeof(Pending_Phi); ++i)
+	{
+		Pending_Phi pending = ((Pending_Phi *)lowering->pending_phis.pointer)[i];
+		if (pending.block == block && pending.phi)
+		{
+			((Pending_Phi *)lowering->pending_phis.pointer)[i].phi = 0;
+			add_phi_operands(lowering, pending.variable, pending.phi);
+		}
+	}
+	((bool *)lowering->sealed.pointer)[block] = true;
+}
+
+// `address` is where the variable is if it's in memory already; otherwise, it's only put in memory if it has to be.
+static U32 declare_variable(Lowering *lowering, Artifact *artifact, Type_Id type, Instruction_Id address)
+{
+	if (!address && (check_image(type) || find_in_map(&lowering->addressed, (U64)(Address)artifact)))
+		address = emit_local(lowering, type);
+	U32 index = (U32)(lowering->variables.mass / sizeof(Variable));
+	Variable *variable = (Variable *)reserve_from_buffer(&lowering->variables, sizeof(Variable), alignof(Variable));
+	variable->type = type;
+	variable->address = address;
+	*insert_into_map(&lowering->variable_indices, (U64)(Address)artifact) = index + 1;
+	artifact->type = type;
+	return index;
+}
+
+// finds the variables whose addresses are taken, which have to be in memory.
+static void find_addressed_variables(Lowering *lowering, Node *node)
+{
+	if (!node)
+		return;
+	switch (node->type)
+	{
+	case Node_Type_NAME:
+	case Node_Type_LITERAL:
+	case Node_Type_BOOLEAN:
+	case Node_Type_ELEMENT:
+	case Node_Type_JUMP:
+	case Node_Type_LABEL:
+	case Node_Type_PROCEDURE:
+	case Node_Type_STRUCT:
+	case Node_Type_UNION:
+	case Node_Type_ENUM:
+		return;
+	case Node_Type_DECLARATION:
+		find_addressed_variables(lowering, node->left);
+		find_addressed_variables(lowering, node->right);
+		return;
+	case Node_Type_UNARY:
+		if (node->operation == Token_Type_AT && node->left->type == Node_Type_NAME && node->left->reference->artifact)
+			insert_into_map(&lowering->addressed, (U64)(Address)node->left->reference->artifact);
+		break;
+	default:
+		break;
+	}
+	find_addressed_variables(lowering, node->left);
+	find_addressed_variables(lowering, node->right);
+	find_addressed_variables(lowering, node->other);
+	for (U32 i = 0; i < node->count; ++i)
+		find_addressed_variables(lowering, node->nodes[i]);
+}
+
+// the procedures that a global artifact's value points to have to be lowered as well, and so do the ones that
+// the artifacts it points to point to.
+static void reach_relocations(Lowering *lowering, const Relocation *relocations)
+{
+	for (const Relocation *relocation = relocations; relocation; relocation = relocation->next)
+	{
+		if (relocation->procedure)
+			get_procedure(lowering->program, relocation->procedure);
+		if (Artifact *artifact = relocation->artifact)
+		{
+			U64 *reached = insert_into_map(lowering->reached, (U64)(Address)artifact);
+			if (!*reached)
+			{
+				*reached = 1;
+				reach_relocations(lowering, artifact->value.relocations);
+			}
+		}
+		reach_relocations(lowering, relocation->relocations);
+	}
+}
+
+// whether the expression is known at compile time, so the evaluator can take it
+static bool check_constant_node(const Node *node)
+{
+	switch (node->type)
+	{
+	case Node_Type_NAME:
+		if (Artifact *artifact = node->reference->artifact)
+			return check_constant(artifact);
+		return find_builtin_type(node->reference->name) != Type_Id_NONE;
+	case Node_Type_LITERAL:
+	case Node_Type_BOOLEAN:
+	case Node_Type_ELEMENT:
+	case Node_Type_SLICE_TYPE:
+	case Node_Type_ARRAY_TYPE:
+	case Node_Type_PROCEDURE:
+	case Node_Type_STRUCT:
+	case Node_Type_UNION:
+		return true;
+	case Node_Type_SIZE_OF:
+		// the types of global variables are known, but not the ones of local variables yet
+		if (node->left->type == Node_Type_NAME && node->left->reference->artifact)
+			return !check_local(node->left->reference->artifact);
+		return check_constant_node(node->left);
+	case Node_Type_UNARY:
+		if (node->operation == Token_Type_AT && node->left->type == Node_Type_NAME && node->left->reference->artifact &&
+		    !check_constant(node->left->reference->artifact))
+			return !check_local(node->left->reference->artifact);
+		return check_constant_node(node->left);
+	case Node_Type_BINARY:
+		return node->operation != Token_Type_PIPE && check_constant_node(node->left) && check_constant_node(node->right);
+	case Node_Type_CONDITIONAL:
+		return check_constant_node(node->left) && check_constant_node(node->right) && (!node->other || check_constant_node(node->other));
+	case Node_Type_MEMBER:
+		return node->left && check_constant_node(node->left);
+	case Node_Type_INDEX:
+		return check_constant_node(node->left) && check_constant_node(node->right);
+	case Node_Type_COMPOUND:
+		if (node->left && !check_constant_node(node->left))
+			return false;
+		// fallthrough
+	case Node_Type_TUPLE:
+		for (U32 i = 0; i < node->count; ++i)
+		{
+			const Node *element = node->nodes[i];
+			if (element->type == Node_Type_MEMBER && !element->left)
+				element = element->right;
+			if (!check_constant_node(element))
+				return false;
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+static Instruction_Id get_value(Lowering *lowering, const Operand *operand)
+{
+	if (operand->value)
+		return operand->value;
+	if (operand->variable)
+		return read_variable(lowering, operand->variable - 1, lowering->block);
+	if (operand->address && !check_image(operand->type))
+		return emit_operation(lowering, Operation_LOAD, operand->type, operand->address, 0);
+	return operand->address;
+}
+
+// types only exist at compile time, and so do named scopes.
+static bool require_value(const Operand *operand, Span span)
+{
+	if (operand->type == Type_Id_TYPE)
+	{
+		report_span_error(span, "expected a value, but this is the type \"%s\".", name_type(operand->type_value).string);
+		return false;
+	}
+	if (get_type(operand->type)->kind == Type_Kind_VOID)
+	{
+		report_span_error(span, "expected a value, but this has none.");
+		return false;
+	}
+	return true;
+}
+
+static bool lower_value(Lowering *lowering, const Value *value, Operand *operand)
+{
+	*operand = {};
+	operand->type = value->type;
+	if (value->type == Type_Id_TYPE)
+	{
+		operand->type_value = value->type_value;
+		return true;
+	}
+	const Type *type = get_type(value->type);
+	if (type->kind == Type_Kind_VOID)
+		return true;
+	reach_relocations(lowering, value->relocations);
+
+	if (check_image(value->type))
+	{
+		// it's read from data that's emitted with the program
+		Relocation *data = (Relocation *)reserve_from_arena(&lowering->program->arena, sizeof(Relocation), alignof(Relocation));
+		*data = {};
+		const U8 *image = value->image;
+		if (!image)
+		{
+			U8 *zeros = (U8 *)reserve_from_arena(&lowering->program->arena, type->size, 8);
+			set_memory(zeros, type->size, 0);
+			image = zeros;
+		}
+		data->data = {image, type->size};
+		data->alignment = type->alignment;
+		data->relocations = value->relocations;
+		operand->address = emit(lowering, Operation_ADDRESS, get_pointer_type(value->type), 0);
+		get_instruction(lowering->procedure, operand->address)->address.data = data;
+		return true;
+	}
+
+	switch (type->kind)
+	{
+	case Type_Kind_PROCEDURE:
+		if (value->procedure)
+		{
+			operand->value = emit(lowering, Operation_ADDRESS, value->type, 0);
+			get_instruction(lowering->procedure, operand->value)->address.procedure = get_procedure(lowering->program, value->procedure);
+			return true;
+		}
+		break;
+	case Type_Kind_POINTER:
+		if (const Relocation *relocation = value->relocations)
+		{
+			operand->value = emit(lowering, Operation_ADDRESS, value->type, 0);
+			Instruction *instruction = get_instruction(lowering->procedure, operand->value);
+			if (relocation->artifact)
+				instruction->address.artifact = relocation->artifact;
+			else
+				instruction->address.data = relocation;
+			return true;
+		}
+		break;
+	case Type_Kind_FLOAT:
+		{
+			U64 bits = 0;
+			if (type->size == 4)
+			{
+				float floating = (float)value->floating;
+				copy_memory(&bits, &floating, 4);
+			}
+			else
+				copy_memory(&bits, &value->floating, 8);
+			operand->value = emit_constant(lowering, value->type, bits);
+			return true;
+		}
+	default:
+		break;
+	}
+	operand->value = emit_constant(lowering, value->type, value->integer);
+	return true;
+}
+
+static bool lower_expression(Lowering *lowering, Node *node, Type_Id expected, Operand *operand);
+
+static void lower_statement(Lowering *lowering, Node *node);
+
+// writes the value to the address.
+static void store_operand(Lowering *lowering, Instruction_Id address, const Operand *value)
+{
+	if (check_image(value->type))
+		emit_memory_operation(lowering, Operation_COPY_MEMORY, address, value->address, value->type);
+	else
+		emit_operation(lowering, Operation_STORE, Type_Id_VOID, address, get_value(lowering, value));
+}
+
+static void write_operand(Lowering *lowering, const Operand *target, const Operand *value)
+{
+	if (target->variable)
+		write_variable(lowering, target->variable - 1, lowering->block, get_value(lowering, value));
+	else
+		store_operand(lowering, target->address, value);
+}
+
+// the zero of the type, which is what variables start as
+static void write_zero(Lowering *lowering, const Operand *target)
+{
+	if (target->variable)
+		write_variable(lowering, target->variable - 1, lowering->block, emit_constant(lowering, target->type, 0));
+	else if (check_image(target->type))
+		emit_memory_operation(lowering, Operation_ZERO_MEMORY, target->address, 0, target->type);
+	else
+		emit_operation(lowering, Operation_STORE, Type_Id_VOID, target->address, emit_constant(lowering, target->type, 0));
+}
+
+static Operand get_variable_operand(Lowering *lowering, U32 index)
+{
+	const Variable *variable = &((Variable *)lowering->variables.pointer)[index];
+	Operand operand = {};
+	operand.type = variable->type;
+	if (variable->address)
+		operand.address = variable->address;
+	else
+		operand.variable = index + 1;
+	return operand;
+}
+
+// converts the operand to the type, which it has to be assignable to.
+static void convert_operand(Lowering *lowering, Operand *operand, Type_Id type)
+{
+	if (operand->type == type)
+		return;
+	const Type *source = get_type(operand->type);
+	const Type *destination = get_type(type);
+	if (destination->kind == Type_Kind_SLICE)
+	{
+		// the slice points to the array
+		Instruction_Id slot = emit_local(lowering, type);
+		emit_operation(lowering, Operation_STORE, Type_Id_VOID, slot, operand->address);
+		Instruction_Id count = emit_constant(lowering, Type_Id_SIZE, source->count);
+		emit_operation(lowering, Operation_STORE, Type_Id_VOID, emit_offset(lowering, slot, 8, Type_Id_SIZE), count);
+		*operand = {};
+		operand->type = type;
+		operand->address = slot;
+		return;
+	}
+	if (destination->kind == Type_Kind_TUPLE && operand->elements)
+	{
+		Instruction_Id *elements = (Instruction_Id *)reserve_from_arena(&lowering->program->arena, destination->elements_count * sizeof(Instruction_Id), alignof(Instruction_Id));
+		for (U32 i = 0; i < destination->elements_count; ++i)
+		{
+			Operand element = {};
+			element.type = source->elements[i];
+			element.value = operand->elements[i];
+			convert_operand(lowering, &element, destination->elements[i]);
+			elements[i] = get_value(lowering, &element);
+		}
+		*operand = {};
+		operand->type = type;
+		operand->elements = elements;
+		return;
+	}
+	if (destination->kind == Type_Kind_TUPLE)
+	{
+		Instruction_Id slot = emit_local(lowering, type);
+		for (U32 i = 0; i < destination->elements_count; ++i)
+		{
+			Operand element = {};
+			element.type = source->elements[i];
+			element.address = emit_offset(lowering, operand->address, source->offsets[i], element.type);
+			convert_operand(lowering, &element, destination->elements[i]);
+			store_operand(lowering, emit_offset(lowering, slot, destination->offsets[i], destination->elements[i]), &element);
+		}
+		*operand = {};
+		operand->type = type;
+		operand->address = slot;
+		return;
+	}
+	Instruction_Id value = get_value(lowering, operand);
+	*operand = {};
+	operand->type = type;
+	operand->value = emit_operation(lowering, Operation_CONVERT, type, value, 0);
+}
+
+// converts the operand to the type if it's assignable, or reports that it isn't.
+static bool assign_operand(Lowering *lowering, Operand *operand, Type_Id type, Span span)
+{
+	if (!require_value(operand, span))
+		return false;
+	if (!check_assignability(type, operand->type))
+	{
+		report_span_error(span, "expected a value of type \"%s\", but this is of type \"%s\".", name_type(type).string,
+		                  name_type(operand->type).string);
+		return false;
+	}
+	convert_operand(lowering, operand, type);
+	return true;
+}
+
+// copies what's in memory, so that later writes don't change it.
+static Operand copy_operand(Lowering *lowering, const Operand *operand)
+{
+	Operand copy = {};
+	copy.type = operand->type;
+	if (check_image(operand->type))
+	{
+		copy.address = emit_local(lowering, operand->type);
+		store_operand(lowering, copy.address, operand);
+	}
+	else
+		copy.value = get_value(lowering, operand);
+	return copy;
+}
+
+// the `index`th element of a tuple, which is read where it is
+static Operand get_tuple_element(Lowering *lowering, const Operand *tuple, U32 index)
+{
+	const Type *type = get_type(tuple->type);
+	Operand element = {};
+	element.type = type->elements[index];
+	if (tuple->elements)
+		element.value = tuple->elements[index];
+	else
+		element.address = emit_offset(lowering, tuple->address, type->offsets[index], element.type);
+	return element;
+}
+
+static bool lower_name(Lowering *lowering, Node *node, Operand *operand)
+{
+	Artifact *artifact = node->reference->artifact;
+	if (!artifact)
+		return false;
+	if (check_local(artifact))
+	{
+		U64 *index = find_in_map(&lowering->variable_indices, (U64)(Address)artifact);
+		if (!index || !*index)
+		{
+			if (index)
+				return false;
+			String name = get_identifier_string(artifact->name);
+			report_span_error(node->span, "\"%.*s\" can't be used here: it's either declared later, or a variable of another procedure.",
+			                  (int)name.size, name.pointer);
+			return false;
+		}
+		*operand = get_variable_operand(lowering, (U32)*index - 1);
+		return true;
+	}
+
+	// global and static variables
+	if (!evaluate_artifact(&lowering->evaluation, artifact))
+		return false;
+	U64 *reached = insert_into_map(lowering->reached, (U64)(Address)artifact);
+	if (!*reached)
+	{
+		*reached = 1;
+		reach_relocations(lowering, artifact->value.relocations);
+	}
+	operand->type = artifact->type;
+	operand->address = emit(lowering, Operation_ADDRESS, get_pointer_type(artifact->type), 0);
+	get_instruction(lowering->procedure, operand->address)->address.artifact = artifact;
+	return true;
+}
+
+static bool lower_unary(Lowering *lowering, Node *node, Type_Id expected, Operand *operand)
+{
+	Node *operand_node = node->left;
+	if (node->operation == Token_Type_AT)
+	{
+		Operand target;
+		if (!lower_expression(lowering, operand_node, Type_Id_NONE, &target) || !require_value(&target, operand_node->span))
+			return false;
+		if (!target.address)
+		{
+			report_span_error(node->span, "this has no address.");
+			return false;
+		}
+		operand->type = get_pointer_type(target.type);
+		operand->value = target.address;
+		return operand->type != Type_Id_NONE;
+	}
+
+	Operand value;
+	if (!lower_expression(lowering, operand_node, node->operation == Token_Type_EXCLAMATION_MARK ? Type_Id_BOOL : expected, &value) ||
+	    !require_value(&value, operand_node->span))
+		return false;
+	const Type *type = get_type(value.type);
+	switch (node->operation)
+	{
+	case Token_Type_MINUS:
+		if (type->kind == Type_Kind_FLOAT || (type->kind == Type_Kind_INTEGER && type->is_signed))
+		{
+			operand->type = value.type;
+			operand->value = emit_operation(lowering, Operation_NEGATE, value.type, get_value(lowering, &value), 0);
+			return true;
+		}
+		break;
+	case Token_Type_EXCLAMATION_MARK:
+		operand->type = Type_Id_BOOL;
+		if (type->kind == Type_Kind_BOOL)
+		{
+			operand->value = emit_operation(lowering, Operation_NOT, Type_Id_BOOL, get_value(lowering, &value), 0);
+			return true;
+		}
+		if (type->kind == Type_Kind_INTEGER || type->kind == Type_Kind_POINTER)
+		{
+			Instruction_Id a = get_value(lowering, &value);
+			operand->value = emit_operation(lowering, Operation_EQUAL, Type_Id_BOOL, a, emit_constant(lowering, value.type, 0));
+			return true;
+		}
+		break;
+	case Token_Type_TILDE:
+		if (type->kind == Type_Kind_INTEGER)
+		{
+			operand->type = value.type;
+			operand->value = emit_operation(lowering, Operation_COMPLEMENT, value.type, get_value(lowering, &value), 0);
+			return true;
+		}
+		break;
+	default:
+		break;
+	}
+	char representation[3];
+	format_operator(representation, node->operation);
+	report_span_error(node->span, "\"%s\" doesn't apply to \"%s\".", representation, name_type(value.type).string);
+	return false;
+}
+
+// a binary operation on scalars of the same type, except for shifts, whose amount can be of any integer type.
+static bool lower_operation(Lowering *lowering, Node *node, Token_Type operation, Operand *left, Operand *right, Operand *operand)
+{
+	if (!require_value(left, node->span) || !require_value(right, node->span))
+		return false;
+	bool comparison = get_binary_precedence(operation) == get_binary_precedence(Token_Type_EQUAL_EQUAL);
+	bool shift = operation == Token_Type_LESS_LESS || operation == Token_Type_GREATER_GREATER;
+	if (shift ? get_type(right->type)->kind != Type_Kind_INTEGER : left->type != right->type)
+	{
+		report_span_error(node->span, "the operands are of different types: \"%s\" and \"%s\".", name_type(left->type).string,
+		                  name_type(right->type).string);
+		return false;
+	}
+
+	const Type *type = get_type(left->type);
+	Type_Kind kind = type->kind;
+	Operation result = Operation_NONE;
+	if ((operation == Token_Type_EQUAL_EQUAL || operation == Token_Type_EXCLAMATION_EQUAL) && !check_image(left->type))
+		result = operation == Token_Type_EQUAL_EQUAL ? Operation_EQUAL : Operation_NOT_EQUAL;
+	else if (comparison && (kind == Type_Kind_INTEGER || kind == Type_Kind_FLOAT))
+	{
+		switch (operation)
+		{
+		case Token_Type_LESS:          result = Operation_LESS; break;
+		case Token_Type_GREATER:       result = Operation_GREATER; break;
+		case Token_Type_LESS_EQUAL:    result = Operation_LESS_EQUAL; break;
+		case Token_Type_GREATER_EQUAL: result = Operation_GREATER_EQUAL; break;
+		default: break;
+		}
+	}
+	else if (kind == Type_Kind_INTEGER || kind == Type_Kind_FLOAT)
+	{
+		switch (operation)
+		{
+		case Token_Type_PLUS:     result = Operation_ADD; break;
+		case Token_Type_MINUS:    result = Operation_SUBTRACT; break;
+		case Token_Type_ASTERISK: result = Operation_MULTIPLY; break;
+		case Token_Type_SLASH:    result = Operation_DIVIDE; break;
+		default: break;
+		}
+		if (kind == Type_Kind_INTEGER)
+		{
+			switch (operation)
+			{
+			case Token_Type_PERCENT:         result = Operation_MODULO; break;
+			case Token_Type_AMPERSAND:       result = Operation_AND; break;
+			case Token_Type_BAR:             result = Operation_OR; break;
+			case Token_Type_CARET:           result = Operation_XOR; break;
+			case Token_Type_LESS_LESS:       result = Operation_SHIFT_LEFT; break;
+			case Token_Type_GREATER_GREATER: result = Operation_SHIFT_RIGHT; break;
+			default: break;
+			}
+		}
+	}
+	else if (kind == Type_Kind_BOOL)
+	{
+		switch (operation)
+		{
+		case Token_Type_AMPERSAND: result = Operation_AND; break;
+		case Token_Type_BAR:       result = Operation_OR; break;
+		case Token_Type_CARET:     result = Operation_XOR; break;
+		default: break;
+		}
+	}
+	if (!result)
+	{
+		char representation[3];
+		format_operator(representation, operation);
+		report_span_error(node->span, "\"%s\" doesn't apply to \"%s\".", representation, name_type(left->type).string);
+		return false;
+	}
+
+	Instruction_Id a = get_value(lowering, left);
+	Instruction_Id b = get_value(lowering, right);
+	const Instruction *divisor = get_instruction(lowering->procedure, b);
+	if ((result == Operation_DIVIDE || result == Operation_MODULO) && kind == Type_Kind_INTEGER &&
+	    divisor->operation == Operation_CONSTANT && !divisor->constant)
+	{
+		report_span_error(node->span, "the divisor is zero, which can't be divided by.");
+		return false;
+	}
+	if (shift && right->type != left->type)
+		b = emit_operation(lowering, Operation_CONVERT, left->type, b, 0);
+	operand->type = comparison ? Type_Id_BOOL : left->type;
+	operand->value = emit_operation(lowering, result, operand->type, a, b);
+	return true;
+}
+
+static bool lower_call(Lowering *lowering, Node *node, Node *callee, Node **arguments, U32 count, bool elements, Operand *operand);
+
+// `&&` and `||` only evaluate their right operand if the left one doesn't decide the result.
+static bool lower_logical_operation(Lowering *lowering, Node *node, Operand *operand)
+{
+	bool conjunction = node->operation == Token_Type_AND;
+	Operand left;
+	if (!lower_expression(lowering, node->left, Type_Id_BOOL, &left))
+		return false;
+	if (left.type != Type_Id_BOOL)
+	{
+		report_span_error(node->left->span, "expected a \"Bool\", but this is of type \"%s\".", name_type(left.type).string);
+		return false;
+	}
+	Instruction_Id a = get_value(lowering, &left);
+	Block_Id right_block = add_lowering_block(lowering);
+	Block_Id end = add_lowering_block(lowering);
+	emit_branch(lowering, a, conjunction ? right_block : end, conjunction ? end : right_block);
+	seal_block(lowering, right_block);
+	lowering->block = right_block;
+
+	Operand right;
+	if (!lower_expression(lowering, node->right, Type_Id_BOOL, &right))
+		return false;
+	if (right.type != Type_Id_BOOL)
+	{
+		report_span_error(node->right->span, "expected a \"Bool\", but this is of type \"%s\".", name_type(right.type).string);
+		return false;
+	}
+	Instruction_Id b = get_value(lowering, &right);
+	emit_jump(lowering, end);
+	seal_block(lowering, end);
+	lowering->block = end;
+
+	// the left operand is the result if it's what decided it
+	Instruction_Id phi = insert_instruction(lowering->procedure, end, 0, Operation_PHI, Type_Id_BOOL, 2);
+	Instruction *instruction = get_instruction(lowering->procedure, phi);
+	instruction->operands[0] = a;
+	instruction->operands[1] = b;
+	operand->type = Type_Id_BOOL;
+	operand->value = phi;
+	return true;
+}
+
+static bool lower_binary(Lowering *lowering, Node *node, Type_Id expected, Operand *operand)
+{
+	Token_Type operation = node->operation;
+	if (operation == Token_Type_PIPE)
+		return lower_call(lowering, node, node->right, &node->left, 1, false, operand);
+	if (operation == Token_Type_AND || operation == Token_Type_OR)
+		return lower_logical_operation(lowering, node, operand);
+
+	bool comparison = get_binary_precedence(operation) == get_binary_precedence(Token_Type_EQUAL_EQUAL);
+	bool shift = operation == Token_Type_LESS_LESS || operation == Token_Type_GREATER_GREATER;
+	Type_Id operand_expected = comparison ? Type_Id_NONE : expected;
+
+	// an untyped literal takes the type of the other operand, so that one goes first
+	Operand left, right;
+	if (!shift && !get_type(operand_expected)->size && check_untyped(node->left) && !check_untyped(node->right))
+	{
+		if (!lower_expression(lowering, node->right, operand_expected, &right) ||
+		    !lower_expression(lowering, node->left, right.type, &left))
+			return false;
+	}
+	else if (!lower_expression(lowering, node->left, operand_expected, &left) ||
+	         !lower_expression(lowering, node->right, shift ? Type_Id_NONE : left.type, &right))
+		return false;
+	return lower_operation(lowering, node, operation, &left, &right, operand);
+}
+
+// the values of the branches of a conditional or a switch, which meet where they end
+struct Join
+{
+	Type_Id type;
+	Instruction_Id slot; // where values in memory go
+	Buffer values;       // of `Instruction_Id`, in the order that the branches reach the end
+};
+
+// adds the value that the branch ends with, before it jumps to the end.
+static bool add_to_join(Lowering *lowering, Join *join, Operand *value, Span span)
+{
+	if (!join->type)
+	{
+		if (!require_value(value, span))
+			return false;
+		join->type = value->type;
+		if (check_image(value->type))
+			join->slot = emit_local(lowering, value->type);
+	}
+	else if (!assign_operand(lowering, value, join->type, span))
+		return false;
+	if (join->slot)
+		store_operand(lowering, join->slot, value);
+	else
+		*(Instruction_Id *)reserve_from_buffer(&join->values, sizeof(Instruction_Id), alignof(Instruction_Id)) = get_value(lowering, value);
+	return true;
+}
+
+// in the block where the branches end
+static void finish_join(Lowering *lowering, Join *join, Operand *operand)
+{
+	operand->type = join->type;
+	if (join->slot)
+		operand->address = join->slot;
+	else
+	{
+		U32 count = (U32)(join->values.mass / sizeof(Instruction_Id));
+		operand->value = insert_instruction(lowering->procedure, lowering->block, 0, Operation_PHI, join->type, count);
+		copy_memory(get_instruction(lowering->procedure, operand->value)->operands, join->values.pointer, count * sizeof(Instruction_Id));
+	}
+	uninitialize_buffer(&join->values);
+}
+
+// a branch of a conditional or a switch. without a join, its value isn't used.
+static bool lower_branch(Lowering *lowering, Node *node, Type_Id expected, Join *join, Block_Id end)
+{
+	bool lowered = true;
+	if (join)
+	{
+		Operand value;
+		lowered = lower_expression(lowering, node, expected ? expected : join->type, &value) && add_to_join(lowering, join, &value, node->span);
+	}
+	else
+		lower_statement(lowering, node);
+	emit_jump(lowering, end);
+	return lowered;
+}
+
+// `operand` is null if the value isn't used.
+static bool lower_conditional(Lowering *lowering, Node *node, Type_Id expected, Operand *operand)
+{
+	if (operand && !node->other)
+	{
+		report_span_error(node->span, "this has no value for when the condition is false.");
+		return false;
+	}
+	Operand condition;
+	if (!lower_expression(lowering, node->left, Type_Id_BOOL, &condition))
+		return false;
+	if (condition.type != Type_Id_BOOL)
+	{
+		report_span_error(node->left->span, "expected a \"Bool\", but this is of type \"%s\".", name_type(condition.type).string);
+		return false;
+	}
+
+	Block_Id then_block = add_lowering_block(lowering);
+	Block_Id else_block = node->other ? add_lowering_block(lowering) : 0;
+	Block_Id end = add_lowering_block(lowering);
+	emit_branch(lowering, get_value(lowering, &condition), then_block, node->other ? else_block : end);
+
+	Join join = {};
+	Join *values = operand ? &join : 0;
+	seal_block(lowering, then_block);
+	lowering->block = then_block;
+	bool lowered = lower_branch(lowering, node->right, expected, values, end);
+	if (node->other)
+	{
+		seal_block(lowering, else_block);
+		lowering->block = else_block;
+		lowered = lower_branch(lowering, node->other, expected, values, end) && lowered;
+	}
+	seal_block(lowering, end);
+	lowering->block = end;
+	if (operand && lowered)
+		finish_join(lowering, &join, operand);
+	return lowered;
+}
+
+// switches whose values are dense enough go through a table: their values take up at least a third of the range
+// between the smallest and the largest.
+constexpr U32 MINIMUM_TABLE_CASES_COUNT = 4;
+constexpr U64 MAXIMUM_TABLE_SPARSENESS = 3;
+constexpr U64 MAXIMUM_TABLE_RANGE = 4096;
+
+static bool check_case_order(U64 a, U64 b, bool is_signed)
+{
+	return is_signed ? (S64)a < (S64)b : a < b;
+}
+
+// the cases are sorted by value, and those whose value an earlier one has are dropped. returns how many are left.
+static U32 sort_cases(Switch_Case *cases, U32 count, bool is_signed)
+{
+	for (U32 i = 1; i < count; ++i)
+	{
+		Switch_Case key = cases[i];
+		U32 j = i;
+		for (; j && check_case_order(key.value, cases[j - 1].value, is_signed); --j)
+			cases[j] = cases[j - 1];
+		cases[j] = key;
+	}
+	U32 kept = 0;
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (!kept || cases[kept - 1].value != cases[i].value)
+			cases[kept++] = cases[i];
+	}
+	return kept;
+}
+
+// the number of values from the first case's to the last's, or zero if it doesn't fit
+static U64 get_cases_range(const Switch_Case *cases, U32 count)
+{
+	return cases[count - 1].value - cases[0].value + 1;
+}
+
+static bool check_table_density(const Switch_Case *cases, U32 count)
+{
+	if (count < MINIMUM_TABLE_CASES_COUNT)
+		return false;
+	U64 range = get_cases_range(cases, count);
+	return range && range <= MAXIMUM_TABLE_RANGE && range <= count * MAXIMUM_TABLE_SPARSENESS;
+}
+
+// whether the values of every case are known at compile time
+static bool check_constant_cases(const Node *node)
+{
+	for (U32 i = 0; i < node->count; ++i)
+	{
+		for (U32 j = 0; j < node->nodes[i]->count; ++j)
+		{
+			if (!check_constant_node(node->nodes[i]->nodes[j]))
+				return false;
+		}
+	}
+	return true;
+}
+
+// when every case has a constant for its value, as does the default, the value is read from a table of them, which
+// has the default's where no case is. returns false, without reporting anything, if they aren't alike enough, and
+// otherwise sets `lowered`.
+static bool lower_switch_lookup(Lowering *lowering, Node *node, Type_Id expected, Instruction_Id subject, const Switch_Case *cases,
+                                U32 cases_count, Operand *operand, bool *lowered)
+{
+	if (!node->other || !check_constant_node(node->other))
+		return false;
+	for (U32 i = 0; i < node->count; ++i)
+	{
+		if (!check_constant_node(node->nodes[i]->left))
+			return false;
+	}
+
+	// the value of each case, and then the default's
+	Scratch scratch;
+	Value *values = (Value *)reserve_from_arena(scratch.arena, (node->count + 1) * sizeof(Value), alignof(Value));
+	bool alike = true;
+	Type_Id type = expected;
+	for (U32 i = 0; i <= node->count && alike; ++i)
+	{
+		Node *value_node = i < node->count ? node->nodes[i]->left : node->other;
+		if (!evaluate(&lowering->evaluation, value_node, type, &values[i]))
+		{
+			*lowered = false;
+			return true;
+		}
+		if (!type)
+			type = values[i].type;
+		const Type *information = get_underlying_type(values[i].type);
+		alike = values[i].type == type && (check_image(type) || information->kind == Type_Kind_INTEGER ||
+		                                   information->kind == Type_Kind_BOOL || information->kind == Type_Kind_FLOAT);
+	}
+	if (!alike)
+		return false;
+
+	const Type *information = get_type(type);
+	U64 range = get_cases_range(cases, cases_count);
+	U8 *table = (U8 *)reserve_from_arena(&lowering->program->arena, range * information->size, 8);
+	Relocation *relocations = 0;
+	for (U64 slot = 0, k = 0; slot < range; ++slot)
+	{
+		const Value *value = &values[node->count];
+		if (k < cases_count && cases[k].value == cases[0].value + slot)
+			value = &values[cases[k++].target - 1];
+		U8 *element = table + slot * information->size;
+		if (!check_image(type))
+		{
+			U64 bits = get_underlying_type(type)->kind == Type_Kind_FLOAT ? store_float(get_underlying_type(type), value->floating) : value->integer;
+			copy_memory(element, &bits, information->size);
+		}
+		else if (value->image)
+			copy_memory(element, value->image, information->size);
+		else
+			set_memory(element, information->size, 0);
+		for (const Relocation *relocation = value->relocations; relocation; relocation = relocation->next)
+		{
+			Relocation *copy = (Relocation *)reserve_from_arena(&lowering->program->arena, sizeof(Relocation), alignof(Relocation));
+			*copy = *relocation;
+			copy->offset += (U32)(slot * information->size);
+			copy->next = relocations;
+			relocations = copy;
+		}
+	}
+
+	Value table_value = {};
+	table_value.type = get_array_type(type, range);
+	table_value.image = table;
+	table_value.relocations = relocations;
+	Operand table_operand;
+	lower_value(lowering, &table_value, &table_operand);
+
+	Instruction_Id index = emit_operation(lowering, Operation_CONVERT, Type_Id_SIZE, subject, 0);
+	index = emit_operation(lowering, Operation_SUBTRACT, Type_Id_SIZE, index, emit_constant(lowering, Type_Id_SIZE, cases[0].value));
+	Instruction_Id inside = emit_operation(lowering, Operation_LESS, Type_Id_BOOL, index, emit_constant(lowering, Type_Id_SIZE, range));
+	Block_Id table_block = add_lowering_block(lowering);
+	Block_Id default_block = add_lowering_block(lowering);
+	Block_Id end = add_lowering_block(lowering);
+	emit_branch(lowering, inside, table_block, default_block);
+
+	Join join = {};
+	seal_block(lowering, table_block);
+	lowering->block = table_block;
+	Instruction_Id offset = emit_operation(lowering, Operation_MULTIPLY, Type_Id_SIZE, index, emit_constant(lowering, Type_Id_SIZE, information->size));
+	Operand element = {};
+	element.type = type;
+	element.address = emit_operation(lowering, Operation_ADD, get_pointer_type(type), table_operand.address, offset);
+	add_to_join(lowering, &join, &element, node->span);
+	emit_jump(lowering, end);
+
+	seal_block(lowering, default_block);
+	lowering->block = default_block;
+	*lowered = lower_branch(lowering, node->other, type, &join, end);
+	seal_block(lowering, end);
+	lowering->block = end;
+	if (*lowered)
+		finish_join(lowering, &join, operand);
+	return true;
+}
+
+// each value of each case is compared in turn, unless the values are all known. then the switch dispatches at once,
+// and if it's for a value of constants, that's read from a table.
+static bool lower_switch(Lowering *lowering, Node *node, Type_Id expected, Operand *operand)
+{
+	if (operand && !node->other)
+	{
+		report_span_error(node->span, "this has no value for when no case matches.");
+		return false;
+	}
+	Operand subject;
+	if (!lower_expression(lowering, node->left, Type_Id_NONE, &subject) || !require_value(&subject, node->left->span))
+		return false;
+	if (check_image(subject.type))
+	{
+		report_span_error(node->left->span, "only scalars can be switched on, but this is of type \"%s\".", name_type(subject.type).string);
+		return false;
+	}
+	Instruction_Id subject_value = get_value(lowering, &subject);
+
+	// the values of the cases are lowered first if they're constants
+	const Type *subject_type = get_underlying_type(subject.type);
+	bool constant_cases = (subject_type->kind == Type_Kind_INTEGER || subject_type->kind == Type_Kind_BOOL) && check_constant_cases(node);
+	U32 values_count = 0;
+	for (U32 i = 0; i < node->count; ++i)
+		values_count += node->nodes[i]->count;
+	Scratch scratch;
+	Instruction_Id *case_values = 0;
+	if (constant_cases)
+	{
+		case_values = (Instruction_Id *)reserve_from_arena(scratch.arena, values_count * sizeof(Instruction_Id), alignof(Instruction_Id));
+		for (U32 i = 0, k = 0; i < node->count; ++i)
+		{
+			Node *case_node = node->nodes[i];
+			for (U32 j = 0; j < case_node->count; ++j, ++k)
+			{
+				Operand value;
+				if (!lower_expression(lowering, case_node->nodes[j], subject.type, &value) ||
+				    !assign_operand(lowering, &value, subject.type, case_node->nodes[j]->span))
+					return false;
+				case_values[k] = get_value(lowering, &value);
+				constant_cases = constant_cases && get_instruction(lowering->procedure, case_values[k])->operation == Operation_CONSTANT;
+			}
+		}
+	}
+	Block_Id *targets = 0;
+	if (constant_cases)
+	{
+		Switch_Case *cases = (Switch_Case *)reserve_from_arena(&lowering->procedure->operands, values_count * sizeof(Switch_Case), alignof(Switch_Case));
+		for (U32 i = 0, k = 0; i < node->count; ++i)
+		{
+			for (U32 j = 0; j < node->nodes[i]->count; ++j, ++k)
+			{
+				cases[k].value = get_instruction(lowering->procedure, case_values[k])->constant;
+				cases[k].target = i + 1;
+			}
+		}
+		U32 cases_count = sort_cases(cases, values_count, subject_type->is_signed);
+		bool lowered;
+		if (operand && cases_count && check_table_density(cases, cases_count) &&
+		    lower_switch_lookup(lowering, node, expected, subject_value, cases, cases_count, operand, &lowered))
+			return lowered;
+
+		Instruction_Id id = emit_operation(lowering, Operation_SWITCH, Type_Id_VOID, subject_value, 0);
+		targets = (Block_Id *)reserve_from_arena(&lowering->procedure->operands, (node->count + 1) * sizeof(Block_Id), alignof(Block_Id));
+		Instruction *instruction = get_instruction(lowering->procedure, id);
+		instruction->table.targets = targets;
+		instruction->table.cases = cases;
+		instruction->table.targets_count = node->count + 1;
+		instruction->table.cases_count = cases_count;
+		Block_Id dispatch = lowering->block;
+		for (U32 i = 0; i <= node->count; ++i)
+		{
+			targets[i] = add_lowering_block(lowering);
+			add_predecessor(lowering->procedure, targets[i], dispatch);
+		}
+	}
+
+	Join join = {};
+	Join *values = operand ? &join : 0;
+	Block_Id end = add_lowering_block(lowering);
+	bool lowered = true;
+	for (U32 i = 0, k = 0; i < node->count; ++i)
+	{
+		Node *case_node = node->nodes[i];
+		Block_Id case_block = targets ? targets[i + 1] : add_lowering_block(lowering);
+		for (U32 j = 0; j < case_node->count && !targets; ++j, ++k)
+		{
+			Operand value = {};
+			if (case_values)
+			{
+				value.type = subject.type;
+				value.value = case_values[k];
+			}
+			else if (!lower_expression(lowering, case_node->nodes[j], subject.type, &value) ||
+			         !assign_operand(lowering, &value, subject.type, case_node->nodes[j]->span))
+				return false;
+			Instruction_Id equal = emit_operation(lowering, Operation_EQUAL, Type_Id_BOOL, subject_value, get_value(lowering, &value));
+			Block_Id next = add_lowering_block(lowering);
+			emit_branch(lowering, equal, case_block, next);
+			seal_block(lowering, next);
+			lowering->block = next;
+		}
+		Block_Id next = lowering->block;
+		seal_block(lowering, case_block);
+		lowering->block = case_block;
+		lowered = lower_branch(lowering, case_node->left, expected, values, end) && lowered;
+		lowering->block = next;
+	}
+	if (targets)
+	{
+		seal_block(lowering, targets[0]);
+		lowering->block = targets[0];
+	}
+	if (node->other)
+		lowered = lower_branch(lowering, node->other, expected, values, end) && lowered;
+	else
+		emit_jump(lowering, end);
+	seal_block(lowering, end);
+	lowering->block = end;
+	if (operand && lowered)
+		finish_join(lowering, &join, operand);
+	return lowered;
+}
+
+// calling a type converts to it.
+static bool lower_conversion(Lowering *lowering, Node *node, Type_Id type, Node **arguments, U32 count, Operand *operand)
+{
+	if (count != 1)
+	{
+		report_span_error(node->span, "converting to \"%s\" takes one value.", name_type(type).string);
+		return false;
+	}
+	if (check_constant_node(arguments[0]))
+	{
+		Value value;
+		return evaluate(&lowering->evaluation, node, Type_Id_NONE, &value) && lower_value(lowering, &value, operand);
+	}
+
+	// a literal is converted rather than checked against the type
+	Operand value;
+	if (!lower_expression(lowering, arguments[0], check_untyped(arguments[0]) ? Type_Id_NONE : type, &value) ||
+	    !require_value(&value, arguments[0]->span))
+		return false;
+	if (check_assignability(type, value.type))
+	{
+		convert_operand(lowering, &value, type);
+		*operand = value;
+		return true;
+	}
+
+	const Type *destination = get_type(type);
+	const Type *source = get_type(value.type);
+	Type_Kind destination_kind = destination->kind == Type_Kind_ENUM ? get_type(destination->base)->kind : destination->kind;
+	Type_Kind source_kind = source->kind == Type_Kind_ENUM ? get_type(source->base)->kind : source->kind;
+	bool source_integral = source_kind == Type_Kind_INTEGER || source_kind == Type_Kind_BOOL;
+	bool destination_numeric = destination_kind == Type_Kind_INTEGER || destination_kind == Type_Kind_FLOAT;
+	operand->type = type;
+	if (destination_kind == Type_Kind_BOOL && source_integral)
+	{
+		Instruction_Id a = get_value(lowering, &value);
+		operand->value = emit_operation(lowering, Operation_NOT_EQUAL, Type_Id_BOOL, a, emit_constant(lowering, value.type, 0));
+		return true;
+	}
+	if ((destination_numeric && (source_integral || source_kind == Type_Kind_FLOAT)) ||
+	    (destination_kind == Type_Kind_POINTER && source_kind == Type_Kind_POINTER))
+	{
+		operand->value = emit_operation(lowering, Operation_CONVERT, type, get_value(lowering, &value), 0);
+		return true;
+	}
+	report_span_error(node->span, "\"%s\" can't be converted to \"%s\".", name_type(value.type).string, name_type(type).string);
+	return false;
+}
+
+// results that are returned in registers stay SSA values if `elements` is set; otherwise, they're stored in a stack
+// slot like the others, so the tuple can be used like any other.
+static bool lower_call(Lowering *lowering, Node *node, Node *callee, Node **arguments, U32 count, bool elements, Operand *operand)
+{
+	Operand function;
+	if (check_constant_node(callee))
+	{
+		Value value;
+		if (!evaluate(&lowering->evaluation, callee, Type_Id_NONE, &value))
+			return false;
+		if (value.type == Type_Id_TYPE)
+			return lower_conversion(lowering, node, value.type_value, arguments, count, operand);
+		if (!lower_value(lowering, &value, &function))
+			return false;
+	}
+	else if (!lower_expression(lowering, callee, Type_Id_NONE, &function))
+		return false;
+	const Type *type = get_type(function.type);
+	if (type->kind != Type_Kind_PROCEDURE)
+	{
+		report_span_error(callee->span, "a value of type \"%s\" can't be called.", name_type(function.type).string);
+		return false;
+	}
+	if (count != type->elements_count)
+	{
+		report_span_error(node->span, "\"%s\" takes %u arguments, but this gives it %u.", name_type(function.type).string,
+		                  type->elements_count, count);
+		return false;
+	}
+	Instruction_Id callee_value = get_value(lowering, &function);
+
+	// what's in memory is passed by the address of a copy, which the callee may change
+	Instruction_Id *values = (Instruction_Id *)reserve_from_arena(&lowering->program->arena, (count + 1) * sizeof(Instruction_Id), alignof(Instruction_Id));
+	for (U32 i = 0; i < count; ++i)
+	{
+		Operand argument;
+		if (!lower_expression(lowering, arguments[i], type->elements[i], &argument) ||
+		    !assign_operand(lowering, &argument, type->elements[i], arguments[i]->span))
+			return false;
+		Operand copy = copy_operand(lowering, &argument);
+		values[i] = get_value(lowering, &copy);
+	}
+
+	Type_Id results = type->base;
+	const Type *results_type = get_type(results);
+	U32 results_count = results_type->elements_count;
+	bool registers = check_register_results(results);
+	Instruction_Id slot = registers ? 0 : emit_local(lowering, results);
+	Type_Id result_type = registers && results_count ? results_type->elements[0] : Type_Id_VOID;
+	Instruction_Id call = emit(lowering, Operation_CALL, result_type, 1 + count + !registers);
+	Instruction *instruction = get_instruction(lowering->procedure, call);
+	instruction->operands[0] = callee_value;
+	copy_memory(&instruction->operands[1], values, count * sizeof(Instruction_Id));
+	if (slot)
+		instruction->operands[1 + count] = slot;
+
+	*operand = {};
+	if (!registers)
+	{
+		operand->type = results_count == 1 ? results_type->elements[0] : results;
+		operand->address = slot;
+		return true;
+	}
+	if (results_count <= 1)
+	{
+		operand->type = result_type;
+		operand->value = result_type == Type_Id_VOID ? 0 : call;
+		return true;
+	}
+
+	// the other results come right after the call
+	Instruction_Id *results_values = (Instruction_Id *)reserve_from_arena(&lowering->program->arena, results_count * sizeof(Instruction_Id), alignof(Instruction_Id));
+	results_values[0] = call;
+	for (U32 i = 1; i < results_count; ++i)
+	{
+		results_values[i] = emit_operation(lowering, Operation_RESULT, results_type->elements[i], call, 0);
+		get_instruction(lowering->procedure, results_values[i])->index = i;
+	}
+	operand->type = results;
+	if (elements)
+	{
+		operand->elements = results_values;
+		return true;
+	}
+	operand->address = emit_local(lowering, results);
+	for (U32 i = 0; i < results_count; ++i)
+	{
+		Instruction_Id address = emit_offset(lowering, operand->address, results_type->offsets[i], results_type->elements[i]);
+		emit_operation(lowering, Operation_STORE, Type_Id_VOID, address, results_values[i]);
+	}
+	return true;
+}
+
+// lowers a tuple whose elements are taken apart, so the results of a call can stay in registers
+static bool lower_destructured(Lowering *lowering, Node *node, Type_Id expected, Operand *tuple)
+{
+	if (node->type == Node_Type_CALL)
+		return lower_call(lowering, node, node->left, node->nodes, node->count, true, tuple);
+	if (node->type == Node_Type_BINARY && node->operation == Token_Type_PIPE)
+		return lower_call(lowering, node, node->right, &node->left, 1, true, tuple);
+	return lower_expression(lowering, node, expected, tuple);
+}
+
+static bool lower_member(Lowering *lowering, Node *node, Operand *operand)
+{
+	if (!node->left)
+	{
+		report_span_error(node->span, "members can only be set like this in a compound.");
+		return false;
+	}
+	Operand left;
+	if (!lower_expression(lowering, node->left, Type_Id_NONE, &left) || !require_value(&left, node->left->span))
+		return false;
+
+	// pointers to what has members are followed
+	Type_Id type_id = left.type;
+	const Type *type = get_type(type_id);
+	Instruction_Id address = left.address;
+	if (type->kind == Type_Kind_POINTER && check_image(type->base))
+	{
+		address = get_value(lowering, &left);
+		type_id = type->base;
+		type = get_type(type_id);
+	}
+
+	String name = get_identifier_string(node->name);
+	switch (type->kind)
+	{
+	case Type_Kind_STRUCT:
+	case Type_Kind_UNION:
+		for (U32 i = 0; i < type->elements_count; ++i)
+		{
+			if (type->names[i] == node->name)
+			{
+				operand->type = type->elements[i];
+				operand->address = emit_offset(lowering, address, type->offsets[i], operand->type);
+				return true;
+			}
+		}
+		break;
+	case Type_Kind_SLICE:
+		if (check_identifier(node->name, "size"))
+		{
+			operand->type = Type_Id_SIZE;
+			operand->address = emit_offset(lowering, address, 8, Type_Id_SIZE);
+			return true;
+		}
+		if (check_identifier(node->name, "data"))
+		{
+			operand->type = get_pointer_type(type->base);
+			operand->address = address;
+			return true;
+		}
+		break;
+	default:
+		break;
+	}
+	report_span_error(node->span, "\"%s\" has no member \"%.*s\".", name_type(type_id).string, (int)name.size, name.pointer);
+	return false;
+}
+
+static bool lower_index(Lowering *lowering, Node *node, Operand *operand)
+{
+	Operand container;
+	if (!lower_expression(lowering, node->left, Type_Id_NONE, &container) || !require_value(&container, node->left->span))
+		return false;
+	const Type *type = get_type(container.type);
+	if (type->kind == Type_Kind_TUPLE)
+	{
+		// the elements are of different types, so which one has to be known
+		Value index;
+		if (!evaluate(&lowering->evaluation, node->right, Type_Id_SIZE, &index))
+			return false;
+		if (get_type(index.type)->kind != Type_Kind_INTEGER || index.integer >= type->elements_count)
+		{
+			report_span_error(node->right->span, "expected an index of an element of \"%s\".", name_type(container.type).string);
+			return false;
+		}
+		operand->type = type->elements[index.integer];
+		operand->address = emit_offset(lowering, container.address, type->offsets[index.integer], operand->type);
+		return true;
+	}
+
+	Operand index;
+	if (!lower_expression(lowering, node->right, Type_Id_SIZE, &index) || !require_value(&index, node->right->span))
+		return false;
+	if (get_type(index.type)->kind != Type_Kind_INTEGER)
+	{
+		report_span_error(node->right->span, "expected an integer, but this is of type \"%s\".", name_type(index.type).string);
+		return false;
+	}
+
+	Instruction_Id base;
+	switch (type->kind)
+	{
+	case Type_Kind_ARRAY:
+		{
+			const Instruction *constant = get_instruction(lowering->procedure, get_value(lowering, &index));
+			if (constant->operation == Operation_CONSTANT && constant->constant >= type->count)
+			{
+				report_span_error(node->right->span, "%lu is out of the bounds of \"%s\", which has %lu elements.",
+				                  constant->constant, name_type(container.type).string, type->count);
+				return false;
+			}
+			base = container.address;
+		}
+		break;
+	case Type_Kind_SLICE:
+		base = emit_operation(lowering, Operation_LOAD, get_pointer_type(type->base), container.address, 0);
+		break;
+	case Type_Kind_POINTER:
+		base = get_value(lowering, &container);
+		break;
+	default:
+		report_span_error(node->left->span, "a value of type \"%s\" can't be indexed.", name_type(container.type).string);
+		return false;
+	}
+
+	Type_Id element = type->base;
+	Instruction_Id offset = get_value(lowering, &index);
+	if (get_type(index.type)->size != 8)
+		offset = emit_operation(lowering, Operation_CONVERT, Type_Id_SIZE, offset, 0);
+	U32 size = get_type(element)->size;
+	if (size != 1)
+		offset = emit_operation(lowering, Operation_MULTIPLY, Type_Id_SIZE, offset, emit_constant(lowering, Type_Id_SIZE, size));
+	operand->type = element;
+	operand->address = emit_operation(lowering, Operation_ADD, get_pointer_type(element), base, offset);
+	return true;
+}
+
+// the elements of a compound or tuple that isn't known at compile time, in a stack slot
+static bool lower_elements(Lowering *lowering, Node *node, Type_Id expected, Operand *operand)
+{
+	const Type *type = get_type(expected);
+	bool slice = type->kind == Type_Kind_SLICE;
+	Type_Id slot_type = slice ? get_array_type(type->base, node->count) : expected;
+	if (!slot_type)
+		return false;
+	const Type *slot_information = get_type(slot_type);
+	Instruction_Id slot = emit_local(lowering, slot_type);
+	emit_memory_operation(lowering, Operation_ZERO_MEMORY, slot, 0, slot_type);
+
+	// fields that aren't given get their default values
+	if (type->declaration && type->kind != Type_Kind_ENUM)
+	{
+		U32 index = 0;
+		bool done = iterate_over_fields(type->declaration->node->right, [&](Node *declaration, Artifact *artifact) -> bool
+		{
+			U32 field = index++;
+			if (!declaration->right)
+				return true;
+			Value field_value;
+			if (artifact)
+			{
+				if (!evaluate_artifact(&lowering->evaluation, artifact))
+					return false;
+				field_value = artifact->value;
+			}
+			else if (!evaluate(&lowering->evaluation, declaration->right, type->elements[field], &field_value) ||
+			         !assign_value(&lowering->evaluation, &field_value, type->elements[field], declaration->right->span))
+				return false;
+			Operand default_value;
+			if (!lower_value(lowering, &field_value, &default_value))
+				return false;
+			store_operand(lowering, emit_offset(lowering, slot, type->offsets[field], type->elements[field]), &default_value);
+			return true;
+		});
+		if (!done)
+			return false;
+	}
+
+	U32 position = 0;
+	for (U32 i = 0; i < node->count; ++i)
+	{
+		Node *element = node->nodes[i];
+		Node *element_value = element;
+		U32 index = position;
+		if (element->type == Node_Type_MEMBER && !element->left)
+		{
+			String name = get_identifier_string(element->name);
+			if (type->kind != Type_Kind_STRUCT && type->kind != Type_Kind_UNION)
+			{
+				report_span_error(element->span, "\"%s\" has no members to set by name.", name_type(expected).string);
+				return false;
+			}
+			for (index = 0; index < type->elements_count && type->names[index] != element->name; ++index)
+			{
+			}
+			if (index == type->elements_count)
+			{
+				report_span_error(element->span, "\"%s\" has no field \"%.*s\".", name_type(expected).string, (int)name.size, name.pointer);
+				return false;
+			}
+			element_value = element->right;
+		}
+
+		bool array = slot_information->kind == Type_Kind_ARRAY;
+		U64 count = array ? slot_information->count : slot_information->elements_count;
+		if (index >= count)
+		{
+			report_span_error(element->span, "\"%s\" has only %lu elements.", name_type(expected).string, count);
+			return false;
+		}
+		position = index + 1;
+
+		Type_Id element_type = array ? slot_information->base : slot_information->elements[index];
+		U32 offset = array ? index * get_type(element_type)->size : slot_information->offsets[index];
+		Operand result;
+		if (!lower_expression(lowering, element_value, element_type, &result) ||
+		    !assign_operand(lowering, &result, element_type, element_value->span))
+			return false;
+		store_operand(lowering, emit_offset(lowering, slot, offset, element_type), &result);
+	}
+
+	*operand = {};
+	operand->type = slot_type;
+	operand->address = slot;
+	if (slice)
+		convert_operand(lowering, operand, expected);
+	return true;
+}
+
+static bool lower_tuple(Lowering *lowering, Node *node, Type_Id expected, Operand *operand)
+{
+	switch (get_type(expected)->kind)
+	{
+	case Type_Kind_SLICE:
+	case Type_Kind_ARRAY:
+	case Type_Kind_TUPLE:
+	case Type_Kind_STRUCT:
+		return lower_elements(lowering, node, expected, operand);
+	default:
+		break;
+	}
+
+	Operand *elements = (Operand *)reserve_from_arena(&lowering->program->arena, node->count * sizeof(Operand), alignof(Operand));
+	Type_Id *types = (Type_Id *)reserve_from_arena(&lowering->program->arena, node->count * sizeof(Type_Id), alignof(Type_Id));
+	for (U32 i = 0; i < node->count; ++i)
+	{
+		if (!lower_expression(lowering, node->nodes[i], Type_Id_NONE, &elements[i]) || !require_value(&elements[i], node->nodes[i]->span))
+			return false;
+		types[i] = elements[i].type;
+	}
+	Type_Id type = get_tuple_type(types, node->count);
+	if (!type)
+		return false;
+	Instruction_Id slot = emit_local(lowering, type);
+	for (U32 i = 0; i < node->count; ++i)
+		store_operand(lowering, emit_offset(lowering, slot, get_type(type)->offsets[i], types[i]), &elements[i]);
+	operand->type = type;
+	operand->address = slot;
+	return true;
+}
+
+bool lower_expression(Lowering *lowering, Node *node, Type_Id expected, Operand *operand)
+{
+	*operand = {};
+	if (check_constant_node(node))
+	{
+		Value value;
+		return evaluate(&lowering->evaluation, node, expected, &value) && lower_value(lowering, &value, operand);
+	}
+	switch (node->type)
+	{
+	case Node_Type_NAME:
+		return lower_name(lowering, node, operand);
+	case Node_Type_UNARY:
+		return lower_unary(lowering, node, expected, operand);
+	case Node_Type_BINARY:
+		return lower_binary(lowering, node, expected, operand);
+	case Node_Type_CONDITIONAL:
+		return lower_conditional(lowering, node, expected, operand);
+	case Node_Type_SWITCH:
+		return lower_switch(lowering, node, expected, operand);
+	case Node_Type_CALL:
+		return lower_call(lowering, node, node->left, node->nodes, node->count, false, operand);
+	case Node_Type_MEMBER:
+		return lower_member(lowering, node, operand);
+	case Node_Type_INDEX:
+		return lower_index(lowering, node, operand);
+	case Node_Type_COMPOUND:
+		{
+			Type_Id type = expected;
+			if (node->left && !evaluate_type(&lowering->evaluation, node->left, &type))
+				return false;
+			if (node->left && !check_image(type))
+			{
+				report_span_error(node->left->span, "a compound can't be of type \"%s\".", name_type(type).string);
+				return false;
+			}
+			if (!type || !check_image(type))
+			{
+				report_span_error(node->span, "the type of the compound isn't known here.");
+				return false;
+			}
+			return lower_elements(lowering, node, type, operand);
+		}
+	case Node_Type_TUPLE:
+		return lower_tuple(lowering, node, expected, operand);
+	case Node_Type_SIZE_OF:
+		{
+			Operand operand_value;
+			if (!lower_expression(lowering, node->left, Type_Id_NONE, &operand_value))
+				return false;
+			Type_Id type = operand_value.type == Type_Id_TYPE ? operand_value.type_value : operand_value.type;
+			operand->type = Type_Id_SIZE;
+			operand->value = emit_constant(lowering, Type_Id_SIZE, get_type(type)->size);
+			return true;
+		}
+	case Node_Type_BLOCK:
+	case Node_Type_ASSIGNMENT:
+	case Node_Type_RETURN:
+	case Node_Type_JUMP:
+		// branches that are statements
+		lower_statement(lowering, node);
+		operand->type = Type_Id_VOID;
+		return true;
+	default:
+		report_span_error(node->span, "this can't be evaluated at run time.");
+		return false;
+	}
+}
+
+// the values of a declaration with several names come from a tuple, or from a value that is one.
+static bool lower_declaration_values(Lowering *lowering, Node *node, Type_Id type, Operand *values)
+{
+	Node *right = node->right;
+	U32 count = node->count;
+	if (count == 1)
+		return lower_expression(lowering, right, type, &values[0]);
+	if (right->type == Node_Type_TUPLE && right->count == count)
+	{
+		for (U32 i = 0; i < count; ++i)
+		{
+			if (!lower_expression(lowering, right->nodes[i], type, &values[i]))
+				return false;
+		}
+		return true;
+	}
+	Operand tuple;
+	if (!lower_destructured(lowering, right, Type_Id_NONE, &tuple))
+		return false;
+	const Type *tuple_type = get_type(tuple.type);
+	if (tuple_type->kind != Type_Kind_TUPLE || tuple_type->elements_count != count)
+	{
+		report_span_error(right->span, "expected %u values, one for each name.", count);
+		return false;
+	}
+	for (U32 i = 0; i < count; ++i)
+		values[i] = get_tuple_element(lowering, &tuple, i);
+	return true;
+}
+
+static void lower_declaration(Lowering *lowering, Node *node)
+{
+	// constants and static variables are global
+	if (node->operation == Token_Type_COLON || node->is_static)
+		return;
+
+	// the values are all lowered before any of the variables is declared
+	U32 count = node->count;
+	Operand *values = (Operand *)reserve_from_arena(&lowering->program->arena, count * sizeof(Operand), alignof(Operand));
+	Type_Id type = Type_Id_NONE;
+	bool lowered = (!node->left || evaluate_type(&lowering->evaluation, node->left, &type)) &&
+	               (!node->right || lower_declaration_values(lowering, node, type, values));
+
+	for (U32 i = 0; i < count; ++i)
+	{
+		Artifact *artifact = node->artifacts[i];
+		Span span = node->right ? node->right->span : artifact->span;
+		bool assigned = lowered && (!node->right || (type ? assign_operand(lowering, &values[i], type, span) : require_value(&values[i], span)));
+		Type_Id variable_type = type ? type : values[i].type;
+		if (assigned && (variable_type == Type_Id_TYPE || get_type(variable_type)->kind == Type_Kind_VOID))
+		{
+			report_span_error(artifact->span, "a variable can't be of type \"%s\".", name_type(variable_type).string);
+			assigned = false;
+		}
+		if (!assigned)
+		{
+			// its uses fail without reporting it again
+			insert_into_map(&lowering->variable_indices, (U64)(Address)artifact);
+			continue;
+		}
+		Operand target = get_variable_operand(lowering, declare_variable(lowering, artifact, variable_type, 0));
+		if (node->right)
+			write_operand(lowering, &target, &values[i]);
+		else
+			write_zero(lowering, &target);
+	}
+}
+
+static Token_Type get_assignment_operation(Token_Type type)
+{
+	switch (type)
+	{
+	case Token_Type_PLUS_EQUAL:     return Token_Type_PLUS;
+	case Token_Type_MINUS_EQUAL:    return Token_Type_MINUS;
+	case Token_Type_ASTERISK_EQUAL: return Token_Type_ASTERISK;
+	case Token_Type_SLASH_EQUAL:    return Token_Type_SLASH;
+	default:                        return Token_Type_NONE;
+	}
+}
+
+static bool lower_target(Lowering *lowering, Node *node, Operand *target)
+{
+	if (check_constant_node(node))
+	{
+		report_span_error(node->span, "constants can't be assigned to.");
+		return false;
+	}
+	if (!lower_expression(lowering, node, Type_Id_NONE, target) || !require_value(target, node->span))
+		return false;
+	if (!target->variable && !target->address)
+	{
+		report_span_error(node->span, "this can't be assigned to.");
+		return false;
+	}
+	return true;
+}
+
+static void lower_assignment(Lowering *lowering, Node *node)
+{
+	Node *left = node->left;
+	Node *right = node->right;
+	if (left->type == Node_Type_TUPLE && left->operation == Token_Type_COMMA)
+	{
+		// every value is taken before any target is written
+		if (node->operation != Token_Type_EQUAL)
+		{
+			report_span_error(node->span, "only \"=\" can assign to several targets at once.");
+			return;
+		}
+		U32 count = left->count;
+		Operand *targets = (Operand *)reserve_from_arena(&lowering->program->arena, 2 * count * sizeof(Operand), alignof(Operand));
+		Operand *values = targets + count;
+		for (U32 i = 0; i < count; ++i)
+		{
+			if (!lower_target(lowering, left->nodes[i], &targets[i]))
+				return;
+		}
+		if (right->type == Node_Type_TUPLE && right->count == count)
+		{
+			for (U32 i = 0; i < count; ++i)
+			{
+				if (!lower_expression(lowering, right->nodes[i], targets[i].type, &values[i]) ||
+				    !assign_operand(lowering, &values[i], targets[i].type, right->nodes[i]->span))
+					return;
+				values[i] = copy_operand(lowering, &values[i]);
+			}
+		}
+		else
+		{
+			Operand tuple;
+			if (!lower_destructured(lowering, right, Type_Id_NONE, &tuple))
+				return;
+			const Type *tuple_type = get_type(tuple.type);
+			if (tuple_type->kind != Type_Kind_TUPLE || tuple_type->elements_count != count)
+			{
+				report_span_error(right->span, "expected %u values, one for each target.", count);
+				return;
+			}
+			for (U32 i = 0; i < count; ++i)
+			{
+				values[i] = get_tuple_element(lowering, &tuple, i);
+				if (!assign_operand(lowering, &values[i], targets[i].type, right->span))
+					return;
+				values[i] = copy_operand(lowering, &values[i]);
+			}
+		}
+		for (U32 i = 0; i < count; ++i)
+			write_operand(lowering, &targets[i], &values[i]);
+		return;
+	}
+
+	Operand target, value;
+	if (!lower_target(lowering, left, &target) || !lower_expression(lowering, right, target.type, &value))
+		return;
+	if (Token_Type operation = get_assignment_operation(node->operation))
+	{
+		Operand result;
+		if (!lower_operation(lowering, node, operation, &target, &value, &result))
+			return;
+		value = result;
+	}
+	if (assign_operand(lowering, &value, target.type, right->span))
+		write_operand(lowering, &target, &value);
+}
+
+// `values` are null to return the named results as they are.
+static void finish_return(Lowering *lowering, Operand *values, Span span)
+{
+	const Type *results = get_type(get_type(lowering->procedure->type)->base);
+	U32 count = results->elements_count;
+	if (!values)
+	{
+		if (count && !lowering->named_results)
+		{
+			report_span_error(span, "this has to return %u values.", count);
+			start_unreachable_block(lowering);
+			return;
+		}
+	}
+	else if (lowering->results_address)
+	{
+		for (U32 i = 0; i < count; ++i)
+			store_operand(lowering, emit_offset(lowering, lowering->results_address, results->offsets[i], results->elements[i]), &values[i]);
+	}
+
+	if (lowering->results_address || !count)
+		emit(lowering, Operation_RETURN, Type_Id_VOID, 0);
+	else
+	{
+		Instruction_Id returned[MAXIMUM_REGISTER_RESULTS_COUNT];
+		for (U32 i = 0; i < count; ++i)
+		{
+			Operand named;
+			if (!values)
+				named = get_variable_operand(lowering, ((U32 *)lowering->results.pointer)[i]);
+			returned[i] = get_value(lowering, values ? &values[i] : &named);
+		}
+		Instruction_Id id = emit(lowering, Operation_RETURN, Type_Id_VOID, count);
+		copy_memory(get_instruction(lowering->procedure, id)->operands, returned, count * sizeof(Instruction_Id));
+	}
+	start_unreachable_block(lowering);
+}
+
+static bool lower_results(Lowering *lowering, Node *node, Operand *values)
+{
+	Type_Id results_type = get_type(lowering->procedure->type)->base;
+	const Type *results = get_type(results_type);
+	U32 count = results->elements_count;
+	if (!count)
+	{
+		report_span_error(node->span, "the procedure returns nothing.");
+		return false;
+	}
+	if (count > 1 && node->type == Node_Type_TUPLE && node->count == count)
+	{
+		for (U32 i = 0; i < count; ++i)
+		{
+			if (!lower_expression(lowering, node->nodes[i], results->elements[i], &values[i]) ||
+			    !assign_operand(lowering, &values[i], results->elements[i], node->nodes[i]->span))
+				return false;
+		}
+		return true;
+	}
+	if (count == 1)
+	{
+		return lower_expression(lowering, node, results->elements[0], &values[0]) &&
+		       assign_operand(lowering, &values[0], results->elements[0], node->span);
+	}
+	Operand tuple;
+	if (!lower_destructured(lowering, node, results_type, &tuple) || !assign_operand(lowering, &tuple, results_type, node->span))
+		return false;
+	for (U32 i = 0; i < count; ++i)
+		values[i] = get_tuple_element(lowering, &tuple, i);
+	return true;
+}
+
+static void lower_return(Lowering *lowering, Node *node)
+{
+	if (!node->left)
+	{
+		finish_return(lowering, 0, node->span);
+		return;
+	}
+	U32 count = get_type(get_type(lowering->procedure->type)->base)->elements_count;
+	Operand *values = (Operand *)reserve_from_arena(&lowering->program->arena, max(count, 1) * sizeof(Operand), alignof(Operand));
+	if (lower_results(lowering, node->left, values))
+		finish_return(lowering, values, node->span);
+	else
+	{
+		// it still doesn't fall through
+		start_unreachable_block(lowering);
+	}
+}
+
+static Block_Id get_label_block(Lowering *lowering, Label *label)
+{
+	Label_Block *labels = (Label_Block *)lowering->labels.pointer;
+	for (Size i = 0; i < lowering->labels.mass / sizeof(Label_Block); ++i)
+	{
+		if (labels[i].label == label)
+			return labels[i].block;
+	}
+	Label_Block *entry = (Label_Block *)reserve_from_buffer(&lowering->labels, sizeof(Label_Block), alignof(Label_Block));
+	entry->label = label;
+	entry->block = add_lowering_block(lowering);
+	return entry->block;
+}
+
+// a label's block gets all its predecessors by the end of the scope it's in, since jumps can't come from outside.
+static void lower_block(Lowering *lowering, Node *node)
+{
+	for (U32 i = 0; i < node->count; ++i)
+		lower_statement(lowering, node->nodes[i]);
+	Label_Block *labels = (Label_Block *)lowering->labels.pointer;
+	for (Size i = 0; i < lowering->labels.mass / sizeof(Label_Block); ++i)
+	{
+		if (labels[i].label->scope == node->scope && !((bool *)lowering->sealed.pointer)[labels[i].block])
+			seal_block(lowering, labels[i].block);
+	}
+}
+
+void lower_statement(Lowering *lowering, Node *node)
+{
+	switch (node->type)
+	{
+	case Node_Type_DECLARATION:
+		lower_declaration(lowering, node);
+		return;
+	case Node_Type_ASSIGNMENT:
+		lower_assignment(lowering, node);
+		return;
+	case Node_Type_RETURN:
+		lower_return(lowering, node);
+		return;
+	case Node_Type_JUMP:
+		if (node->jump && node->jump->target)
+		{
+			emit_jump(lowering, get_label_block(lowering, node->jump->target));
+			start_unreachable_block(lowering);
+		}
+		return;
+	case Node_Type_LABEL:
+		if (node->label)
+		{
+			Block_Id block = get_label_block(lowering, node->label);
+			emit_jump(lowering, block);
+			lowering->block = block;
+		}
+		return;
+	case Node_Type_BLOCK:
+		lower_block(lowering, node);
+		return;
+	case Node_Type_CONDITIONAL:
+		lower_conditional(lowering, node, Type_Id_NONE, 0);
+		return;
+	case Node_Type_SWITCH:
+		lower_switch(lowering, node, Type_Id_NONE, 0);
+		return;
+	default:
+		{
+			Operand operand;
+			lower_expression(lowering, node, Type_Id_NONE, &operand);
+		}
+		return;
+	}
+}
+
+static void lower_procedure(Lowering *lowering)
+{
+	Procedure *procedure = lowering->procedure;
+	Node *node = procedure->node;
+	Value value;
+	if (!evaluate(&lowering->evaluation, node, Type_Id_NONE, &value))
+		return;
+	procedure->type = value.type;
+	const Type *type = get_type(value.type);
+	Type_Id results = type->base;
+	bool register_results = check_register_results(results);
+	procedure->parameters_count = type->elements_count + !register_results;
+	if (procedure->external)
+		return;
+
+	initialize_procedure_body(procedure);
+	lowering->block = add_lowering_block(lowering);
+	seal_block(lowering, lowering->block);
+	find_addressed_variables(lowering, node->right);
+
+	// what's in memory is passed by its address
+	U32 index = 0;
+	for (U32 i = 0; i < node->parameters_count; ++i)
+	{
+		Node *declaration = node->nodes[i];
+		for (U32 j = 0; j < max(declaration->count, 1); ++j, ++index)
+		{
+			Type_Id parameter_type = type->elements[index];
+			bool memory = check_image(parameter_type);
+			Instruction_Id parameter = emit(lowering, Operation_PARAMETER, memory ? get_pointer_type(parameter_type) : parameter_type, 0);
+			get_instruction(procedure, parameter)->index = index;
+			if (!declaration->count)
+				continue;
+			U32 variable = declare_variable(lowering, declaration->artifacts[j], parameter_type, memory ? parameter : 0);
+			if (!memory)
+			{
+				Operand target = get_variable_operand(lowering, variable);
+				Operand argument = {};
+				argument.type = parameter_type;
+				argument.value = parameter;
+				write_operand(lowering, &target, &argument);
+			}
+		}
+	}
+
+	// named results start as zeros, where they're returned from
+	if (!register_results)
+	{
+		lowering->results_address = emit(lowering, Operation_PARAMETER, get_pointer_type(results), 0);
+		get_instruction(procedure, lowering->results_address)->index = index;
+	}
+	const Type *results_type = get_type(results);
+	lowering->named_results = results_type->elements_count != 0;
+	index = 0;
+	for (U32 i = node->parameters_count; i < node->count; ++i)
+	{
+		Node *declaration = node->nodes[i];
+		if (!declaration->count)
+		{
+			lowering->named_results = false;
+			++index;
+			continue;
+		}
+		for (U32 j = 0; j < declaration->count; ++j, ++index)
+		{
+			Type_Id result_type = results_type->elements[index];
+			Instruction_Id address = 0;
+			if (lowering->results_address)
+				address = emit_offset(lowering, lowering->results_address, results_type->offsets[index], result_type);
+			U32 variable = declare_variable(lowering, declaration->artifacts[j], result_type, address);
+			*(U32 *)reserve_from_buffer(&lowering->results, sizeof(U32), alignof(U32)) = variable;
+			Operand target = get_variable_operand(lowering, variable);
+			write_zero(lowering, &target);
+		}
+	}
+
+	lower_block(lowering, node->right);
+
+	// falling off the end returns, but only the named results can be returned like that
+	Block_Id end = lowering->block;
+	if (end == 0 || get_predecessors_count(get_block(procedure, end)) || lowering->named_results || !results_type->elements_count)
+		finish_return(lowering, 0, node->right->span);
+	else if (lowering->results_address)
+		emit(lowering, Operation_RETURN, Type_Id_VOID, 0);
+	else
+	{
+		Instruction_Id zeros[MAXIMUM_REGISTER_RESULTS_COUNT];
+		for (U32 i = 0; i < results_type->elements_count; ++i)
+			zeros[i] = emit_constant(lowering, results_type->elements[i], 0);
+		Instruction_Id id = emit(lowering, Operation_RETURN, Type_Id_VOID, results_type->elements_count);
+		copy_memory(get_instruction(procedure, id)->operands, zeros, results_type->elements_count * sizeof(Instruction_Id));
+	}
+
+	// the unreachable block that a return leaves is dropped
+	if (!get_block_instructions_count(get_block(procedure, lowering->block)))
+		release_from_buffer(&procedure->blocks, sizeof(Block), alignof(Block));
+}
+
+void lower_program(Program *program, const Parser *parsers, Size parsers_count)
+{
+	initialize_arena(&program->arena, 0);
+	Index_Map reached = {};
+	Lowering lowering = {};
+	lowering.program = program;
+	lowering.evaluation.arena = &program->arena;
+	lowering.reached = &reached;
+
+	// everything that was analyzed is a root
+	for (Size i = 0; i < parsers_count; ++i)
+	{
+		const List<Artifact> *declarations = &parsers[i].declarations;
+		for (Size j = 0; j < get_list_count(declarations); ++j)
+		{
+			Artifact *artifact = get_list_item(declarations, j);
+			if (!artifact->task || artifact->task->state != Task_State_DONE || artifact->evaluation != Evaluation_State_DONE)
+				continue;
+			if (get_type(artifact->type)->kind == Type_Kind_PROCEDURE && artifact->value.procedure)
+				get_procedure(program, artifact->value.procedure);
+			*insert_into_map(&reached, (U64)(Address)artifact) = 1;
+			reach_relocations(&lowering, artifact->value.relocations);
+		}
+	}
+
+	// lowering a procedure may reach more of them
+	for (Size i = 0; i < get_list_count(&program->procedures); ++i)
+	{
+		lowering.procedure = get_list_item(&program->procedures, i);
+		lower_procedure(&lowering);
+
+		uninitialize_buffer(&lowering.sealed);
+		uninitialize_buffer(&lowering.variables);
+		uninitialize_map(&lowering.variable_indices);
+		uninitialize_map(&lowering.definitions);
+		uninitialize_buffer(&lowering.pending_phis);
+		uninitialize_map(&lowering.addressed);
+		uninitialize_buffer(&lowering.labels);
+		uninitialize_buffer(&lowering.results);
+		lowering.results_address = 0;
+		lowering.named_results = false;
+	}
+	uninitialize_map(&reached);
+}
+
+// passes
+
+// removes the predecessor from the block, along with what its phis take from it.
+static void remove_predecessor(Procedure *procedure, Block_Id block, Block_Id predecessor)
+{
+	Block *information = get_block(procedure, block);
+	U32 count = get_predecessors_count(information);
+	Block_Id *predecessors = get_predecessors(information);
+	U32 index = 0;
+	while (index < count && predecessors[index] != predecessor)
+		++index;
+	if (index == count)
+		return;
+	move_memory(&predecessors[index], &predecessors[index + 1], (count - index - 1) * sizeof(Block_Id));
+	information->predecessors.mass -= sizeof(Block_Id);
+
+	Instruction_Id *instructions = get_block_instructions(information);
+	for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+	{
+		Instruction *phi = get_instruction(procedure, instructions[i]);
+		if (phi->operation != Operation_PHI || index >= phi->operands_count)
+			continue;
+		move_memory(&phi->operands[index], &phi->operands[index + 1], (phi->operands_count - index - 1) * sizeof(Instruction_Id));
+		--phi->operands_count;
+	}
+}
+
+static void replace_predecessor(Procedure *procedure, Block_Id block, Block_Id old_predecessor, Block_Id new_predecessor)
+{
+	Block *information = get_block(procedure, block);
+	Block_Id *predecessors = get_predecessors(information);
+	for (U32 i = 0; i < get_predecessors_count(information); ++i)
+	{
+		if (predecessors[i] == old_predecessor)
+			predecessors[i] = new_predecessor;
+	}
+}
+
+// an emptied block is removed: nothing jumps to it, and it's skipped.
+static void clear_block(Procedure *procedure, Block_Id block)
+{
+	Block *information = get_block(procedure, block);
+	Instruction_Id *instructions = get_block_instructions(information);
+	for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+		get_instruction(procedure, instructions[i])->operation = Operation_NONE;
+	information->instructions.mass = 0;
+	information->predecessors.mass = 0;
+}
+
+static void make_copy(Instruction *instruction, Instruction_Id value)
+{
+	instruction->operation = Operation_COPY;
+	instruction->operands_count = 1;
+	instruction->operands[0] = value;
+}
+
+static void make_constant(Instruction *instruction, U64 constant)
+{
+	instruction->operation = Operation_CONSTANT;
+	instruction->operands_count = 0;
+	instruction->constant = constant;
+}
+
+// false if it can't be folded without changing what happens at run time, like dividing by zero. `amount_type` is
+// the type of the second operand, which only matters to shifts.
+static bool fold_operation(Operation operation, Type_Id result_type, Type_Id operand_type_id, Type_Id amount_type_id, U64 x, U64 y,
+                           U64 *result)
+{
+	const Type *operand_type = get_underlying_type(operand_type_id);
+	const Type *type = get_underlying_type(result_type);
+
+	if (operation == Operation_CONVERT)
+	{
+		bool from_float = operand_type->kind == Type_Kind_FLOAT;
+		if (type->kind == Type_Kind_FLOAT)
+		{
+			F64 floating = from_float ? load_float(operand_type, x) : operand_type->is_signed ? (F64)(S64)x : (F64)x;
+			*result = store_float(type, floating);
+			return true;
+		}
+		if (from_float)
+		{
+			F64 floating = load_float(operand_type, x);
+			if (!(floating > -9223372036854775808.0 && floating < 9223372036854775808.0))
+				return false;
+			x = (U64)(S64)floating;
+		}
+		*result = normalize_integer(result_type, x);
+		return true;
+	}
+
+	if (operand_type->kind == Type_Kind_FLOAT)
+	{
+		F64 f = load_float(operand_type, x);
+		F64 g = load_float(operand_type, y);
+		switch (operation)
+		{
+		case Operation_NEGATE:        *result = store_float(type, -f); return true;
+		case Operation_ADD:           *result = store_float(type, f + g); return true;
+		case Operation_SUBTRACT:      *result = store_float(type, f - g); return true;
+		case Operation_MULTIPLY:      *result = store_float(type, f * g); return true;
+		case Operation_DIVIDE:        *result = store_float(type, f / g); return true;
+		case Operation_EQUAL:         *result = f == g; return true;
+		case Operation_NOT_EQUAL:     *result = f != g; return true;
+		case Operation_LESS:          *result = f < g; return true;
+		case Operation_LESS_EQUAL:    *result = f <= g; return true;
+		case Operation_GREATER:       *result = f > g; return true;
+		case Operation_GREATER_EQUAL: *result = f >= g; return true;
+		default:                      return false;
+		}
+	}
+
+	bool is_signed = operand_type->is_signed;
+	U32 bits = operand_type->size * 8;
+	U64 value;
+	switch (operation)
+	{
+	case Operation_NEGATE:     value = -x; break;
+	case Operation_NOT:        value = !x; break;
+	case Operation_COMPLEMENT: value = ~x; break;
+	case Operation_ADD:        value = x + y; break;
+	case Operation_SUBTRACT:   value = x - y; break;
+	case Operation_MULTIPLY:   value = x * y; break;
+	case Operation_DIVIDE:
+	case Operation_MODULO:
+		if (!y || (is_signed && (S64)y == -1 && (S64)x == INT64_MIN))
+			return false;
+		if (operation == Operation_DIVIDE)
+			value = is_signed ? (U64)((S64)x / (S64)y) : x / y;
+		else
+			value = is_signed ? (U64)((S64)x % (S64)y) : x % y;
+		break;
+	case Operation_AND: value = x & y; break;
+	case Operation_OR:  value = x | y; break;
+	case Operation_XOR: value = x ^ y; break;
+	case Operation_SHIFT_LEFT:
+	case Operation_SHIFT_RIGHT:
+		{
+			// the amount is of its own type
+			const Type *amount_type = get_underlying_type(amount_type_id);
+			if ((amount_type->is_signed && (S64)y < 0) || y >= bits)
+				return false;
+			if (operation == Operation_SHIFT_LEFT)
+				value = x << y;
+			else
+				value = is_signed ? (U64)((S64)x >> y) : x >> y;
+		}
+		break;
+	case Operation_EQUAL:         value = x == y; break;
+	case Operation_NOT_EQUAL:     value = x != y; break;
+	case Operation_LESS:          value = is_signed ? (S64)x < (S64)y : x < y; break;
+	case Operation_LESS_EQUAL:    value = is_signed ? (S64)x <= (S64)y : x <= y; break;
+	case Operation_GREATER:       value = is_signed ? (S64)x > (S64)y : x > y; break;
+	case Operation_GREATER_EQUAL: value = is_signed ? (S64)x >= (S64)y : x >= y; break;
+	default:                      return false;
+	}
+	*result = normalize_integer(result_type, value);
+	return true;
+}
+
+static bool fold_instruction(const Procedure *procedure, const Instruction *instruction, U64 *result)
+{
+	const Instruction *a = get_instruction(procedure, instruction->operands[0]);
+	const Instruction *b = instruction->operands_count > 1 ? get_instruction(procedure, instruction->operands[1]) : 0;
+	return fold_operation(instruction->operation, instruction->type, a->type, b ? b->type : Type_Id_NONE, a->constant,
+	                      b ? b->constant : 0, result);
+}
+
+static bool check_constant_instruction(const Procedure *procedure, Instruction_Id id, U64 constant)
+{
+	const Instruction *instruction = get_instruction(procedure, id);
+	return instruction->operation == Operation_CONSTANT && instruction->constant == constant;
+}
+
+// operations with an operand that makes it trivial, like adding zero. floats are left alone: `x + 0` isn't `x`
+// if `x` is `-0`, and `x * 0` isn't zero if `x` is a NaN.
+static bool simplify_instruction(Procedure *procedure, Instruction *instruction)
+{
+	if (instruction->operands_count != 2 || get_underlying_type(instruction->type)->kind == Type_Kind_FLOAT)
+		return false;
+	Instruction_Id a = instruction->operands[0];
+	Instruction_Id b = instruction->operands[1];
+	switch (instruction->operation)
+	{
+	case Operation_ADD:
+	case Operation_OR:
+	case Operation_XOR:
+		if (check_constant_instruction(procedure, a, 0) && instruction->operation != Operation_ADD)
+		{
+			make_copy(instruction, b);
+			return true;
+		}
+		// fallthrough
+	case Operation_SUBTRACT:
+	case Operation_SHIFT_LEFT:
+	case Operation_SHIFT_RIGHT:
+		if (check_constant_instruction(procedure, b, 0) && get_instruction(procedure, a)->type == instruction->type)
+		{
+			make_copy(instruction, a);
+			return true;
+		}
+		if (instruction->operation == Operation_ADD && check_constant_instruction(procedure, a, 0) &&
+		    get_instruction(procedure, b)->type == instruction->type)
+		{
+			make_copy(instruction, b);
+			return true;
+		}
+		return false;
+	case Operation_MULTIPLY:
+		if (check_constant_instruction(procedure, b, 1))
+		{
+			make_copy(instruction, a);
+			return true;
+		}
+		if (check_constant_instruction(procedure, a, 1))
+		{
+			make_copy(instruction, b);
+			return true;
+		}
+		// fallthrough
+	case Operation_AND:
+		if (check_constant_instruction(procedure, a, 0) || check_constant_instruction(procedure, b, 0))
+		{
+			make_constant(instruction, 0);
+			return true;
+		}
+		return false;
+	default:
+		return false;
+	}
+}
+
+struct Optimization
+{
+	Program *program;
+	Procedure *procedure;
+	const U8 *optimized; // for each procedure of the program: whether it won't change anymore
+};
+
+// operations whose operands are all constants are done at compile time, and branches on constants become jumps.
+static bool propagate_constants(Optimization *optimization)
+{
+	Procedure *procedure = optimization->procedure;
+	bool changed = false;
+	for (Block_Id block = 0; block < get_blocks_count(procedure); ++block)
+	{
+		Block *information = get_block(procedure, block);
+		for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+		{
+			Instruction *instruction = get_instruction(procedure, get_block_instructions(information)[i]);
+			Operation operation = instruction->operation;
+			if (operation == Operation_BRANCH)
+			{
+				const Instruction *condition = get_instruction(procedure, instruction->operands[0]);
+				if (condition->operation != Operation_CONSTANT)
+					continue;
+				Block_Id target = instruction->targets[condition->constant ? 0 : 1];
+				Block_Id other = instruction->targets[condition->constant ? 1 : 0];
+				instruction->operation = Operation_JUMP;
+				instruction->operands_count = 0;
+				instruction->targets[0] = target;
+				remove_predecessor(procedure, other, block);
+				changed = true;
+				continue;
+			}
+			if (operation == Operation_SWITCH)
+			{
+				const Instruction *value = get_instruction(procedure, instruction->operands[0]);
+				if (value->operation != Operation_CONSTANT)
+					continue;
+				U32 chosen = 0;
+				for (U32 j = 0; j < instruction->table.cases_count; ++j)
+				{
+					if (instruction->table.cases[j].value == value->constant)
+						chosen = instruction->table.cases[j].target;
+				}
+				for (U32 j = 0; j < instruction->table.targets_count; ++j)
+				{
+					if (j != chosen)
+						remove_predecessor(procedure, instruction->table.targets[j], block);
+				}
+				Block_Id target = instruction->table.targets[chosen];
+				instruction->operation = Operation_JUMP;
+				instruction->operands_count = 0;
+				instruction->targets[0] = target;
+				changed = true;
+				continue;
+			}
+			if (operation < Operation_NEGATE || operation > Operation_GREATER_EQUAL || operation == Operation_LOAD)
+				continue;
+
+			bool constant = true;
+			for (U32 j = 0; j < instruction->operands_count; ++j)
+				constant = constant && get_instruction(procedure, instruction->operands[j])->operation == Operation_CONSTANT;
+			U64 result;
+			if (constant && get_underlying_type(instruction->type)->kind != Type_Kind_POINTER && fold_instruction(procedure, instruction, &result))
+			{
+				make_constant(instruction, result);
+				changed = true;
+			}
+			else if (simplify_instruction(procedure, instruction))
+				changed = true;
+		}
+	}
+	return changed;
+}
+
+// uses of copies use what they copy instead, and phis whose operands are all the same become copies.
+static bool propagate_copies(Optimization *optimization)
+{
+	Procedure *procedure = optimization->procedure;
+	bool changed = false;
+	for (Instruction_Id id = 1; id < get_instructions_count(procedure); ++id)
+	{
+		Instruction *instruction = get_instruction(procedure, id);
+		if (instruction->operation == Operation_NONE)
+			continue;
+		for (U32 i = 0; i < instruction->operands_count; ++i)
+		{
+			Instruction_Id operand = instruction->operands[i];
+			while (operand != id && get_instruction(procedure, operand)->operation == Operation_COPY)
+				operand = get_instruction(procedure, operand)->operands[0];
+			if (operand != instruction->operands[i])
+			{
+				instruction->operands[i] = operand;
+				changed = true;
+			}
+		}
+		if (instruction->operation != Operation_PHI || !instruction->operands_count)
+			continue;
+
+		// a phi that only takes itself and one other value is that value
+		Instruction_Id value = 0;
+		bool trivial = true;
+		for (U32 i = 0; i < instruction->operands_count && trivial; ++i)
+		{
+			Instruction_Id operand = instruction->operands[i];
+			if (operand == id || operand == value)
+				continue;
+			trivial = !value;
+			value = operand;
+		}
+		if (trivial && value)
+		{
+			make_copy(instruction, value);
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+static bool check_side_effects(Operation operation)
+{
+	switch (operation)
+	{
+	case Operation_STORE:
+	case Operation_COPY_MEMORY:
+	case Operation_ZERO_MEMORY:
+	case Operation_CALL:
+	case Operation_JUMP:
+	case Operation_BRANCH:
+	case Operation_SWITCH:
+	case Operation_RETURN:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// the blocks that can't be reached from the entry are removed, and so are the instructions whose values aren't used
+// by anything with side effects.
+static bool eliminate_dead_code(Optimization *optimization)
+{
+	Procedure *procedure = optimization->procedure;
+	U32 blocks_count = get_blocks_count(procedure);
+	U32 instructions_count = get_instructions_count(procedure);
+	Scratch scratch;
+	U8 *marks = (U8 *)reserve_from_arena(scratch.arena, blocks_count + instructions_count, 1);
+	U8 *reached = marks;
+	U8 *live = marks + blocks_count;
+	set_memory(marks, blocks_count + instructions_count, 0);
+	// each block and each instruction is pushed at most once
+	U32 *stack = (U32 *)reserve_from_arena(scratch.arena, max(blocks_count, instructions_count) * sizeof(U32), alignof(U32));
+	U32 stack_count = 0;
+	bool changed = false;
+
+	reached[0] = true;
+	stack[stack_count++] = 0;
+	while (stack_count)
+	{
+		Block_Id block = stack[--stack_count];
+		const Instruction *terminator = get_terminator(procedure, block);
+		for (U32 i = 0; i < get_successors_count(terminator); ++i)
+		{
+			Block_Id successor = get_successors(terminator)[i];
+			if (!reached[successor])
+			{
+				reached[successor] = true;
+				stack[stack_count++] = successor;
+			}
+		}
+	}
+	for (Block_Id block = 1; block < blocks_count; ++block)
+	{
+		Block *information = get_block(procedure, block);
+		if (reached[block] || (!get_block_instructions_count(information) && !get_predecessors_count(information)))
+			continue;
+		const Instruction *terminator = get_terminator(procedure, block);
+		for (U32 i = 0; i < get_successors_count(terminator); ++i)
+			remove_predecessor(procedure, get_successors(terminator)[i], block);
+		clear_block(procedure, block);
+		changed = true;
+	}
+
+	for (Block_Id block = 0; block < blocks_count; ++block)
+	{
+		Block *information = get_block(procedure, block);
+		for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+		{
+			Instruction_Id id = get_block_instructions(information)[i];
+			if (check_side_effects(get_instruction(procedure, id)->operation))
+			{
+				live[id] = true;
+				stack[stack_count++] = id;
+			}
+		}
+	}
+	while (stack_count)
+	{
+		const Instruction *instruction = get_instruction(procedure, stack[--stack_count]);
+		for (U32 i = 0; i < instruction->operands_count; ++i)
+		{
+			Instruction_Id operand = instruction->operands[i];
+			if (!live[operand])
+			{
+				live[operand] = true;
+				stack[stack_count++] = operand;
+			}
+		}
+	}
+	for (Block_Id block = 0; block < blocks_count; ++block)
+	{
+		Block *information = get_block(procedure, block);
+		Instruction_Id *instructions = get_block_instructions(information);
+		U32 count = get_block_instructions_count(information);
+		U32 kept = 0;
+		for (U32 i = 0; i < count; ++i)
+		{
+			if (live[instructions[i]])
+				instructions[kept++] = instructions[i];
+			else
+				get_instruction(procedure, instructions[i])->operation = Operation_NONE;
+		}
+		changed = changed || kept != count;
+		information->instructions.mass = kept * sizeof(Instruction_Id);
+	}
+
+	return changed;
+}
+
+static bool check_phis(const Procedure *procedure, Block_Id block)
+{
+	const Block *information = get_block(procedure, block);
+	for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+	{
+		if (get_instruction(procedure, get_block_instructions(information)[i])->operation == Operation_PHI)
+			return true;
+	}
+	return false;
+}
+
+static void retarget(Procedure *procedure, Block_Id block, Block_Id old_target, Block_Id new_target)
+{
+	Instruction *terminator = get_terminator(procedure, block);
+	for (U32 i = 0; i < get_successors_count(terminator); ++i)
+	{
+		if (get_successors(terminator)[i] == old_target)
+			get_successors(terminator)[i] = new_target;
+	}
+}
+
+// a switch that's copied gets its own targets, which are changed apart from the original's
+static void copy_switch_targets(Procedure *procedure, Instruction *instruction)
+{
+	Size size = instruction->table.targets_count * sizeof(Block_Id);
+	Block_Id *targets = (Block_Id *)reserve_from_arena(&procedure->operands, size, alignof(Block_Id));
+	copy_memory(targets, instruction->table.targets, size);
+	instruction->table.targets = targets;
+}
+
+// branches whose targets are the same and switches with one target become jumps, jumps to blocks that only jump on
+// go straight on, and a block that's the only successor of its only predecessor is merged into it.
+static bool simplify_control_flow(Optimization *optimization)
+{
+	Procedure *procedure = optimization->procedure;
+	bool changed = false;
+	for (Block_Id block = 0; block < get_blocks_count(procedure); ++block)
+	{
+		Instruction *terminator = get_terminator(procedure, block);
+		if (!terminator)
+			continue;
+		if (terminator->operation == Operation_BRANCH && terminator->targets[0] == terminator->targets[1])
+		{
+			terminator->operation = Operation_JUMP;
+			terminator->operands_count = 0;
+			remove_predecessor(procedure, terminator->targets[0], block);
+			changed = true;
+		}
+		else if (terminator->operation == Operation_SWITCH && terminator->table.targets_count == 1)
+		{
+			Block_Id target = terminator->table.targets[0];
+			terminator->operation = Operation_JUMP;
+			terminator->operands_count = 0;
+			terminator->targets[0] = target;
+			changed = true;
+		}
+
+		// the phis of the target would need to tell the predecessors apart
+		Block *information = get_block(procedure, block);
+		Block_Id target = terminator->targets[0];
+		if (block && terminator->operation == Operation_JUMP && target != block && get_block_instructions_count(information) == 1)
+		{
+			if (check_phis(procedure, target))
+				continue;
+			remove_predecessor(procedure, target, block);
+			for (U32 i = 0; i < get_predecessors_count(get_block(procedure, block)); ++i)
+			{
+				Block_Id predecessor = get_predecessors(get_block(procedure, block))[i];
+				retarget(procedure, predecessor, block, target);
+				add_predecessor(procedure, target, predecessor);
+			}
+			clear_block(procedure, block);
+			changed = true;
+		}
+	}
+
+	for (Block_Id block = 0; block < get_blocks_count(procedure); ++block)
+	{
+		Instruction *terminator = get_terminator(procedure, block);
+		if (!terminator || terminator->operation != Operation_JUMP)
+			continue;
+		Block_Id successor = terminator->targets[0];
+		Block *successor_information = get_block(procedure, successor);
+		if (!successor || successor == block || get_predecessors_count(successor_information) != 1)
+			continue;
+
+		// the phis have one operand each, so they're copies
+		terminator->operation = Operation_NONE;
+		Block *information = get_block(procedure, block);
+		information->instructions.mass -= sizeof(Instruction_Id);
+		U32 count = get_block_instructions_count(successor_information);
+		for (U32 i = 0; i < count; ++i)
+		{
+			Instruction_Id id = get_block_instructions(get_block(procedure, successor))[i];
+			Instruction *instruction = get_instruction(procedure, id);
+			if (instruction->operation == Operation_PHI)
+				make_copy(instruction, instruction->operands[0]);
+			instruction->block = block;
+			*(Instruction_Id *)reserve_from_buffer(&get_block(procedure, block)->instructions, sizeof(Instruction_Id), alignof(Instruction_Id)) = id;
+		}
+		const Instruction *successor_terminator = get_terminator(procedure, block);
+		for (U32 i = 0; i < get_successors_count(successor_terminator); ++i)
+			replace_predecessor(procedure, get_successors(successor_terminator)[i], successor, block);
+		Block *emptied = get_block(procedure, successor);
+		emptied->instructions.mass = 0;
+		emptied->predecessors.mass = 0;
+		changed = true;
+
+		// the merged block may end with another jump to merge
+		--block;
+	}
+	return changed;
+}
+
+constexpr U32 MAXIMUM_INLINED_INSTRUCTIONS_COUNT = 40;
+
+// calls that a profile says are hot may inline more
+constexpr U32 MAXIMUM_HOT_INLINED_INSTRUCTIONS_COUNT = 160;
+
+// so that inlining into each other doesn't make procedures huge
+constexpr U32 MAXIMUM_INLINING_INSTRUCTIONS_COUNT = 4000;
+
+static U32 count_live_instructions(const Procedure *procedure)
+{
+	U32 count = 0;
+	for (Block_Id block = 0; block < get_blocks_count(procedure); ++block)
+		count += get_block_instructions_count(get_block(procedure, block));
+	return count;
+}
+
+// with a profile, a block that never ran is cold, and one that ran at least as many times as its procedure was entered
+// is hot
+static bool check_cold_block(const Procedure *procedure, Block_Id block)
+{
+	return get_block(procedure, block)->frequency == 1;
+}
+
+static bool check_hot_block(const Procedure *procedure, Block_Id block)
+{
+	U64 frequency = get_block(procedure, block)->frequency;
+	return frequency > 1 && frequency >= get_block(procedure, 0)->frequency;
+}
+
+// the frequency of a block of a callee once it's inlined at a call that ran `call` times
+static U64 scale_frequency(U64 frequency, U64 call, U64 entry)
+{
+	if (!frequency || !call || entry <= 1)
+		return 0;
+	return (U64)((F64)(frequency - 1) * (F64)(call - 1) / (F64)(entry - 1)) + 1;
+}
+
+// the result becomes the phi of its results that the callee's returns return
+static void make_result_phi(Procedure *procedure, const Procedure *callee, Instruction_Id id, U32 index, const Instruction_Id *returns,
+                            U32 returns_count, const Instruction_Id *map)
+{
+	Instruction_Id *operands = (Instruction_Id *)reserve_from_arena(&procedure->operands, returns_count * sizeof(Instruction_Id), alignof(Instruction_Id));
+	for (U32 i = 0; i < returns_count; ++i)
+		operands[i] = map[get_instruction(callee, returns[i])->operands[index]];
+	Instruction *instruction = get_instruction(procedure, id);
+	instruction->operation = Operation_PHI;
+	instruction->operands = operands;
+	instruction->operands_count = returns_count;
+}
+
+// the callee's blocks are copied in place of the call, which splits its block in two.
+static void inline_call(Procedure *procedure, Block_Id block, U32 position, const Procedure *callee)
+{
+	Instruction_Id call = get_block_instructions(get_block(procedure, block))[position];
+
+	// what follows the call goes in a new block
+	Block_Id after = add_block(procedure);
+	get_block(procedure, after)->frequency = get_block(procedure, block)->frequency;
+	{
+		Block *information = get_block(procedure, block);
+		U32 count = get_block_instructions_count(information);
+		for (U32 i = position + 1; i < count; ++i)
+		{
+			Instruction_Id id = get_block_instructions(get_block(procedure, block))[i];
+			get_instruction(procedure, id)->block = after;
+			*(Instruction_Id *)reserve_from_buffer(&get_block(procedure, after)->instructions, sizeof(Instruction_Id), alignof(Instruction_Id)) = id;
+		}
+		get_block(procedure, block)->instructions.mass = position * sizeof(Instruction_Id);
+		const Instruction *terminator = get_terminator(procedure, after);
+		for (U32 i = 0; i < get_successors_count(terminator); ++i)
+			replace_predecessor(procedure, get_successors(terminator)[i], block, after);
+	}
+
+	// the callee's blocks are appended in order, so its entry is the first of them
+	Block_Id first = get_blocks_count(procedure);
+	U32 callee_blocks_count = get_blocks_count(callee);
+	for (Block_Id i = 0; i < callee_blocks_count; ++i)
+	{
+		add_block(procedure);
+		get_block(procedure, first + i)->frequency = scale_frequency(get_block(callee, i)->frequency, get_block(procedure, block)->frequency,
+		                                                             get_block(callee, 0)->frequency);
+	}
+	Scratch scratch;
+	Instruction_Id *map = (Instruction_Id *)reserve_from_arena(scratch.arena, get_instructions_count(callee) * sizeof(Instruction_Id), alignof(Instruction_Id));
+	set_memory(map, get_instructions_count(callee) * sizeof(Instruction_Id), 0);
+	// of the callee's returns, in the order of the predecessors of `after`. each block has one at most.
+	Instruction_Id *return_ids = (Instruction_Id *)reserve_from_arena(scratch.arena, callee_blocks_count * sizeof(Instruction_Id), alignof(Instruction_Id));
+	U32 returns_count = 0;
+	for (Block_Id i = 0; i < callee_blocks_count; ++i)
+	{
+		const Block *information = get_block(callee, i);
+		for (U32 j = 0; j < get_predecessors_count(information); ++j)
+			add_predecessor(procedure, first + i, first + get_predecessors(information)[j]);
+		for (U32 j = 0; j < get_block_instructions_count(information); ++j)
+		{
+			Instruction_Id id = get_block_instructions(information)[j];
+			const Instruction *original = get_instruction(callee, id);
+			Operation operation = original->operation;
+			U32 operands_count = original->operands_count;
+			if (operation == Operation_PARAMETER)
+			{
+				operation = Operation_COPY;
+				operands_count = 1;
+			}
+			else if (operation == Operation_RETURN)
+			{
+				operation = Operation_JUMP;
+				operands_count = 0;
+			}
+
+			// stack slots stay in the entry
+			Instruction_Id clone = operation == Operation_LOCAL ?
+				insert_instruction(procedure, 0, 0, operation, original->type, 0) :
+				insert_instruction(procedure, first + i, ~(U32)0, operation, original->type, operands_count);
+			Instruction *instruction = get_instruction(procedure, clone);
+			original = get_instruction(callee, id);
+			Instruction_Id *operands = instruction->operands;
+			copy_memory(instruction, original, sizeof(Instruction));
+			instruction->operation = operation;
+			instruction->block = operation == Operation_LOCAL ? 0 : first + i;
+			instruction->operands = operands;
+			instruction->operands_count = operands_count;
+			map[id] = clone;
+
+			if (original->operation == Operation_PARAMETER)
+				operands[0] = get_instruction(procedure, call)->operands[1 + original->index];
+			else if (original->operation == Operation_RETURN)
+			{
+				instruction->targets[0] = after;
+				add_predecessor(procedure, after, first + i);
+				return_ids[returns_count++] = id;
+			}
+			else if (operation == Operation_JUMP || operation == Operation_BRANCH || operation == Operation_SWITCH)
+			{
+				if (operation == Operation_SWITCH)
+					copy_switch_targets(procedure, instruction);
+				for (U32 k = 0; k < get_successors_count(instruction); ++k)
+					get_successors(instruction)[k] += first;
+			}
+		}
+	}
+
+	// the operands are mapped once every value has its clone, since phis can use later ones
+	for (Block_Id i = 0; i < callee_blocks_count; ++i)
+	{
+		const Block *information = get_block(callee, i);
+		for (U32 j = 0; j < get_block_instructions_count(information); ++j)
+		{
+			Instruction_Id id = get_block_instructions(information)[j];
+			const Instruction *original = get_instruction(callee, id);
+			if (original->operation == Operation_PARAMETER || original->operation == Operation_RETURN)
+				continue;
+			Instruction *instruction = get_instruction(procedure, map[id]);
+			for (U32 k = 0; k < original->operands_count; ++k)
+				instruction->operands[k] = map[original->operands[k]];
+		}
+	}
+	Instruction_Id jump = insert_instruction(procedure, block, ~(U32)0, Operation_JUMP, Type_Id_VOID, 0);
+	get_instruction(procedure, jump)->targets[0] = first;
+	add_predecessor(procedure, first, block);
+
+	// the call becomes the phi of what the callee returns, and so do its other results, which are already first
+	for (U32 i = 0; i < get_block_instructions_count(get_block(procedure, after)); ++i)
+	{
+		Instruction_Id id = get_block_instructions(get_block(procedure, after))[i];
+		const Instruction *result = get_instruction(procedure, id);
+		if (result->operation != Operation_RESULT || result->operands[0] != call)
+			break;
+		make_result_phi(procedure, callee, id, result->index, return_ids, returns_count, map);
+	}
+	Instruction *instruction = get_instruction(procedure, call);
+	instruction->block = after;
+	if (instruction->type == Type_Id_VOID)
+		instruction->operation = Operation_NONE;
+	else
+	{
+		make_result_phi(procedure, callee, call, 0, return_ids, returns_count, map);
+		Buffer *instructions = &get_block(procedure, after)->instructions;
+		reserve_from_buffer(instructions, sizeof(Instruction_Id), alignof(Instruction_Id));
+		Instruction_Id *ids = (Instruction_Id *)instructions->pointer;
+		move_memory(&ids[1], &ids[0], instructions->mass - sizeof(Instruction_Id));
+		ids[0] = call;
+	}
+}
+
+// direct calls to small procedures that are already optimized are replaced by their bodies, unless a profile says the
+// calls never ran.
+static bool inline_calls(Optimization *optimization)
+{
+	Procedure *procedure = optimization->procedure;
+	bool changed = false;
+	for (Block_Id block = 0; block < get_blocks_count(procedure); ++block)
+	{
+		for (U32 i = 0; i < get_block_instructions_count(get_block(procedure, block)); ++i)
+		{
+			const Instruction *instruction = get_instruction(procedure, get_block_instructions(get_block(procedure, block))[i]);
+			if (instruction->operation != Operation_CALL)
+				continue;
+			const Instruction *callee_address = get_instruction(procedure, instruction->operands[0]);
+			if (callee_address->operation != Operation_ADDRESS || get_type(callee_address->type)->kind != Type_Kind_PROCEDURE)
+				continue;
+			const Procedure *callee = callee_address->address.procedure;
+			U32 limit = check_hot_block(procedure, block) ? MAXIMUM_HOT_INLINED_INSTRUCTIONS_COUNT : MAXIMUM_INLINED_INSTRUCTIONS_COUNT;
+			if (callee == procedure || callee->external || !optimization->optimized[callee->index] || check_cold_block(procedure, block) ||
+			    count_live_instructions(callee) > limit ||
+			    count_live_instructions(procedure) > MAXIMUM_INLINING_INSTRUCTIONS_COUNT)
+				continue;
+			inline_call(procedure, block, i, callee);
+			changed = true;
+
+			// the rest of the block moved to a new one, which comes later
+			break;
+		}
+	}
+	return changed;
+}
+
+// loops
+
+// wika has no loop statements: every loop is a cycle of `jump_to`s, so loops are found in the control flow
+// rather than in the syntax. a natural loop is what reaches a back edge (a jump to a block that dominates the
+// jumping one) without going through the block jumped to, which is the loop's header.
+
+struct Dominators
+{
+	Block_Id *order;   // the reachable blocks, in reverse postorder
+	U32 *indices;      // in `order`, of each block; ~0 for unreachable ones
+	Block_Id *parents; // the immediate dominator of each reachable block
+	U32 count;         // of reachable blocks
+};
+
+// as in Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm". they're reserved from the arena.
+static void find_dominators(const Procedure *procedure, Dominators *dominators, Arena *arena)
+{
+	U32 blocks_count = get_blocks_count(procedure);
+	dominators->order = (Block_Id *)reserve_from_arena(arena, blocks_count * sizeof(Block_Id), alignof(Block_Id));
+	dominators->indices = (U32 *)reserve_from_arena(arena, blocks_count * sizeof(U32), alignof(U32));
+	dominators->parents = (Block_Id *)reserve_from_arena(arena, blocks_count * sizeof(Block_Id), alignof(Block_Id));
+	set_memory(dominators->indices, blocks_count * sizeof(U32), 0xff);
+	Scratch scratch(arena);
+
+	// postorder, by an iterative depth-first search that keeps the next successor to visit of each block
+	struct Visit
+	{
+		Block_Id block;
+		U32 next;
+	};
+	Visit *stack = (Visit *)reserve_from_arena(scratch.arena, blocks_count * sizeof(Visit), alignof(Visit));
+	U8 *visited = (U8 *)reserve_from_arena(scratch.arena, blocks_count, 1);
+	set_memory(visited, blocks_count, 0);
+	U32 depth = 0;
+	U32 count = 0;
+	stack[depth++] = {0, 0};
+	visited[0] = true;
+	while (depth)
+	{
+		Visit *visit = &stack[depth - 1];
+		const Instruction *terminator = get_terminator(procedure, visit->block);
+		if (visit->next < get_successors_count(terminator))
+		{
+			Block_Id successor = get_successors(terminator)[visit->next++];
+			if (!visited[successor])
+			{
+				visited[successor] = true;
+				stack[depth++] = {successor, 0};
+			}
+			continue;
+		}
+		dominators->order[count++] = visit->block;
+		--depth;
+	}
+	for (U32 i = 0; i < count / 2; ++i)
+	{
+		Block_Id block = dominators->order[i];
+		dominators->order[i] = dominators->order[count - 1 - i];
+		dominators->order[count - 1 - i] = block;
+	}
+	for (U32 i = 0; i < count; ++i)
+		dominators->indices[dominators->order[i]] = i;
+	dominators->count = count;
+
+	Block_Id *parents = dominators->parents;
+	const U32 *indices = dominators->indices;
+	set_memory(parents, blocks_count * sizeof(Block_Id), 0xff);
+	parents[0] = 0;
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (U32 i = 1; i < count; ++i)
+		{
+			Block_Id block = dominators->order[i];
+			const Block *information = get_block(procedure, block);
+			Block_Id parent = ~(Block_Id)0;
+			for (U32 j = 0; j < get_predecessors_count(information); ++j)
+			{
+				Block_Id predecessor = get_predecessors(information)[j];
+				if (parents[predecessor] == ~(Block_Id)0)
+					continue;
+				if (parent == ~(Block_Id)0)
+				{
+					parent = predecessor;
+					continue;
+				}
+				Block_Id a = predecessor;
+				Block_Id b = parent;
+				while (a != b)
+				{
+					while (indices[a] > indices[b])
+						a = parents[a];
+					while (indices[b] > indices[a])
+						b = parents[b];
+				}
+				parent = a;
+			}
+			if (parents[block] != parent)
+			{
+				parents[block] = parent;
+				changed = true;
+			}
+		}
+	}
+}
+
+static bool check_dominance(const Dominators *dominators, Block_Id dominator, Block_Id block)
+{
+	if (dominators->indices[block] == ~(U32)0)
+		return false;
+	for (;;)
+	{
+		if (block == dominator)
+			return true;
+		if (!block)
+			return false;
+		block = dominators->parents[block];
+	}
+}
+
+struct Loop
+{
+	Block_Id header;
+	Block_Id preheader; // the only block outside of the loop that jumps to the header, if there's one
+	U8 *body;           // for each block: whether it's in the loop
+	Block_Id *blocks;   // in reverse postorder, so the header is first
+	U32 blocks_count;
+	U32 latches_count;  // blocks in the loop that jump back to the header
+	Block_Id latch;     // the last of them
+};
+
+// the loops whose headers are the same are one loop. inner loops come before the loops around them. they're reserved
+// from the arena, and so is what they point to.
+static Loop *find_loops(const Procedure *procedure, const Dominators *dominators, Arena *arena, U32 *loops_count)
+{
+	U32 blocks_count = get_blocks_count(procedure);
+	// each header has one loop at most
+	Loop *items = (Loop *)reserve_from_arena(arena, dominators->count * sizeof(Loop), alignof(Loop));
+	U32 count = 0;
+	Scratch scratch(arena);
+	Block_Id *work = (Block_Id *)reserve_from_arena(scratch.arena, blocks_count * sizeof(Block_Id), alignof(Block_Id));
+	for (U32 i = 0; i < dominators->count; ++i)
+	{
+		Block_Id header = dominators->order[i];
+		const Block *information = get_block(procedure, header);
+		Loop *loop = 0;
+		for (U32 j = 0; j < get_predecessors_count(information); ++j)
+		{
+			Block_Id latch = get_predecessors(get_block(procedure, header))[j];
+			if (!check_dominance(dominators, header, latch))
+				continue;
+			if (!loop)
+			{
+				loop = &items[count++];
+				*loop = {};
+				loop->header = header;
+				loop->preheader = ~(Block_Id)0;
+				loop->body = (U8 *)reserve_from_arena(arena, blocks_count, 1);
+				set_memory(loop->body, blocks_count, 0);
+				loop->body[header] = true;
+			}
+			++loop->latches_count;
+			loop->latch = latch;
+
+			// the blocks that reach the latch without going through the header
+			U32 work_count = 0;
+			if (!loop->body[latch])
+			{
+				loop->body[latch] = true;
+				work[work_count++] = latch;
+			}
+			while (work_count)
+			{
+				const Block *block = get_block(procedure, work[--work_count]);
+				for (U32 k = 0; k < get_predecessors_count(block); ++k)
+				{
+					Block_Id predecessor = get_predecessors(block)[k];
+					if (!loop->body[predecessor] && dominators->indices[predecessor] != ~(U32)0)
+					{
+						loop->body[predecessor] = true;
+						work[work_count++] = predecessor;
+					}
+				}
+			}
+		}
+		if (!loop)
+			continue;
+		for (U32 j = 0; j < dominators->count; ++j)
+			loop->blocks_count += loop->body[dominators->order[j]];
+		loop->blocks = (Block_Id *)reserve_from_arena(arena, loop->blocks_count * sizeof(Block_Id), alignof(Block_Id));
+		for (U32 j = 0, k = 0; j < dominators->count; ++j)
+		{
+			if (loop->body[dominators->order[j]])
+				loop->blocks[k++] = dominators->order[j];
+		}
+	}
+
+	// an inner loop has fewer blocks than the loops around it
+	for (U32 i = 1; i < count; ++i)
+	{
+		Loop loop = items[i];
+		U32 j = i;
+		for (; j && items[j - 1].blocks_count > loop.blocks_count; --j)
+			items[j] = items[j - 1];
+		items[j] = loop;
+	}
+	*loops_count = count;
+	return items;
+}
+
+static U32 get_loop_blocks_count(const Loop *loop)
+{
+	return loop->blocks_count;
+}
+
+static Block_Id get_loop_block(const Loop *loop, U32 index)
+{
+	return loop->blocks[index];
+}
+
+// the preheader is where what's invariant in the loop goes. if the header is entered from outside of the loop by
+// more than one block, or by one that can also go elsewhere, a block is put in between. returns whether it was.
+static bool make_preheader(Procedure *procedure, Loop *loop)
+{
+	Block_Id header = loop->header;
+	U32 outside_count = 0;
+	Block_Id outside = 0;
+	const Block *information = get_block(procedure, header);
+	for (U32 i = 0; i < get_predecessors_count(information); ++i)
+	{
+		Block_Id predecessor = get_predecessors(information)[i];
+		if (!loop->body[predecessor])
+		{
+			++outside_count;
+			outside = predecessor;
+		}
+	}
+	if (outside_count == 1 && get_terminator(procedure, outside)->operation == Operation_JUMP)
+	{
+		loop->preheader = outside;
+		return false;
+	}
+	if (!outside_count)
+		return false;
+
+	// the phis of the header take what comes from outside of the loop from phis in the preheader
+	Block_Id preheader = add_block(procedure);
+	U32 count = get_predecessors_count(get_block(procedure, header));
+	Scratch scratch;
+	Block_Id *predecessors = (Block_Id *)reserve_from_arena(scratch.arena, count * sizeof(Block_Id), alignof(Block_Id));
+	copy_memory(predecessors, get_predecessors(get_block(procedure, header)), count * sizeof(Block_Id));
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (loop->body[predecessors[i]])
+			continue;
+		retarget(procedure, predecessors[i], header, preheader);
+		add_predecessor(procedure, preheader, predecessors[i]);
+	}
+	for (U32 i = 0; i < get_block_instructions_count(get_block(procedure, header)); ++i)
+	{
+		Instruction_Id id = get_block_instructions(get_block(procedure, header))[i];
+		if (get_instruction(procedure, id)->operation != Operation_PHI)
+			continue;
+		Instruction_Id phi = insert_instruction(procedure, preheader, ~(U32)0, Operation_PHI, get_instruction(procedure, id)->type, outside_count);
+		Instruction *outer = get_instruction(procedure, phi);
+		Instruction *inner = get_instruction(procedure, id);
+		U32 inside = 0;
+		U32 outside_index = 0;
+		for (U32 j = 0; j < count; ++j)
+		{
+			if (loop->body[predecessors[j]])
+				inner->operands[inside++] = inner->operands[j];
+			else
+				outer->operands[outside_index++] = inner->operands[j];
+		}
+		inner->operands[inside++] = phi;
+		inner->operands_count = inside;
+	}
+	Block *header_information = get_block(procedure, header);
+	header_information->predecessors.mass = 0;
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (loop->body[predecessors[i]])
+			add_predecessor(procedure, header, predecessors[i]);
+	}
+	add_predecessor(procedure, header, preheader);
+	Instruction_Id jump = insert_instruction(procedure, preheader, ~(U32)0, Operation_JUMP, Type_Id_VOID, 0);
+	get_instruction(procedure, jump)->targets[0] = header;
+	return true;
+}
+
+static Instruction_Id find_copied_value(const Procedure *procedure, Instruction_Id id)
+{
+	while (get_instruction(procedure, id)->operation == Operation_COPY)
+		id = get_instruction(procedure, id)->operands[0];
+	return id;
+}
+
+static bool check_invariance(const Procedure *procedure, const Loop *loop, Instruction_Id id)
+{
+	return !loop->body[get_instruction(procedure, id)->block];
+}
+
+// moves the instruction to the position in the block.
+static void move_instruction(Procedure *procedure, Instruction_Id id, Block_Id block, U32 position)
+{
+	Block *source = get_block(procedure, get_instruction(procedure, id)->block);
+	Instruction_Id *instructions = get_block_instructions(source);
+	U32 count = get_block_instructions_count(source);
+	U32 index = 0;
+	while (instructions[index] != id)
+		++index;
+	move_memory(&instructions[index], &instructions[index + 1], (count - index - 1) * sizeof(Instruction_Id));
+	source->instructions.mass -= sizeof(Instruction_Id);
+
+	Buffer *destination = &get_block(procedure, block)->instructions;
+	count = (U32)(destination->mass / sizeof(Instruction_Id));
+	reserve_from_buffer(destination, sizeof(Instruction_Id), alignof(Instruction_Id));
+	instructions = (Instruction_Id *)destination->pointer;
+	move_memory(&instructions[position + 1], &instructions[position], (count - position) * sizeof(Instruction_Id));
+	instructions[position] = id;
+	get_instruction(procedure, id)->block = block;
+}
+
+// whether the instruction can run even when the loop doesn't, or more often than it would have: it has no side
+// effects, and it can't trap. loads only qualify from stack slots and globals, which are always there.
+static bool check_speculability(const Procedure *procedure, const Instruction *instruction)
+{
+	switch (instruction->operation)
+	{
+	case Operation_CONSTANT:
+	case Operation_ADDRESS:
+	case Operation_COPY:
+	case Operation_NEGATE:
+	case Operation_NOT:
+	case Operation_COMPLEMENT:
+	case Operation_CONVERT:
+	case Operation_ADD:
+	case Operation_SUBTRACT:
+	case Operation_MULTIPLY:
+	case Operation_AND:
+	case Operation_OR:
+	case Operation_XOR:
+	case Operation_SHIFT_LEFT:
+	case Operation_SHIFT_RIGHT:
+	case Operation_EQUAL:
+	case Operation_NOT_EQUAL:
+	case Operation_LESS:
+	case Operation_LESS_EQUAL:
+	case Operation_GREATER:
+	case Operation_GREATER_EQUAL:
+		return true;
+	case Operation_DIVIDE:
+	case Operation_MODULO:
+		{
+			const Instruction *divisor = get_instruction(procedure, instruction->operands[1]);
+			return get_underlying_type(instruction->type)->kind == Type_Kind_FLOAT ||
+			       (divisor->operation == Operation_CONSTANT && divisor->constant && divisor->constant != ~(U64)0);
+		}
+	case Operation_LOAD:
+		{
+			Operation address = get_instruction(procedure, instruction->operands[0])->operation;
+			return address == Operation_LOCAL || address == Operation_ADDRESS;
+		}
+	default:
+		return false;
+	}
+}
+
+static bool check_memory_writes(const Procedure *procedure, const Loop *loop)
+{
+	for (U32 i = 0; i < get_loop_blocks_count(loop); ++i)
+	{
+		const Block *block = get_block(procedure, get_loop_block(loop, i));
+		for (U32 j = 0; j < get_block_instructions_count(block); ++j)
+		{
+			switch (get_instruction(procedure, get_block_instructions(block)[j])->operation)
+			{
+			case Operation_STORE:
+			case Operation_COPY_MEMORY:
+			case Operation_ZERO_MEMORY:
+			case Operation_CALL:
+				return true;
+			default:
+				break;
+			}
+		}
+	}
+	return false;
+}
+
+// what only depends on values from outside of the loop is computed once, before it. the blocks are in reverse
+// postorder, so what an instruction depends on is hoisted before it.
+static bool hoist_invariants(Procedure *procedure, const Loop *loop)
+{
+	bool writes = check_memory_writes(procedure, loop);
+	bool changed = false;
+	for (U32 i = 0; i < get_loop_blocks_count(loop); ++i)
+	{
+		Block_Id block = get_loop_block(loop, i);
+		for (U32 j = 0; j < get_block_instructions_count(get_block(procedure, block));)
+		{
+			Instruction_Id id = get_block_instructions(get_block(procedure, block))[j];
+			const Instruction *instruction = get_instruction(procedure, id);
+			bool invariant = check_speculability(procedure, instruction) && !(writes && instruction->operation == Operation_LOAD);
+			for (U32 k = 0; k < instruction->operands_count && invariant; ++k)
+				invariant = check_invariance(procedure, loop, instruction->operands[k]);
+			if (!invariant)
+			{
+				++j;
+				continue;
+			}
+			U32 position = get_block_instructions_count(get_block(procedure, loop->preheader)) - 1;
+			move_instruction(procedure, id, loop->preheader, position);
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+// a basic induction variable: a phi of the header that steps by a constant on each iteration
+struct Induction
+{
+	Instruction_Id phi;
+	Instruction_Id update; // the phi plus the step
+	U64 step;
+	U32 entry;             // the index of the operand that comes from the preheader
+};
+
+static bool find_induction(const Procedure *procedure, const Loop *loop, Instruction_Id id, Induction *induction)
+{
+	const Instruction *phi = get_instruction(procedure, id);
+	const Block *header = get_block(procedure, loop->header);
+	if (phi->operation != Operation_PHI || phi->block != loop->header || loop->latches_count != 1 ||
+	    get_predecessors_count(header) != 2 || phi->operands_count != 2)
+		return false;
+	Type_Kind kind = get_underlying_type(phi->type)->kind;
+	if (kind != Type_Kind_INTEGER && kind != Type_Kind_POINTER)
+		return false;
+	U32 entry = get_predecessors(header)[0] == loop->preheader ? 0 : 1;
+	Instruction_Id update = phi->operands[1 - entry];
+	const Instruction *instruction = get_instruction(procedure, update);
+	if (!loop->body[instruction->block] || instruction->operands_count != 2)
+		return false;
+	const Instruction *a = get_instruction(procedure, instruction->operands[0]);
+	const Instruction *b = get_instruction(procedure, instruction->operands[1]);
+	if (instruction->operation == Operation_ADD && instruction->operands[0] == id && b->operation == Operation_CONSTANT)
+		induction->step = b->constant;
+	else if (instruction->operation == Operation_ADD && instruction->operands[1] == id && a->operation == Operation_CONSTANT)
+		induction->step = a->constant;
+	else if (instruction->operation == Operation_SUBTRACT && instruction->operands[0] == id && b->operation == Operation_CONSTANT)
+		induction->step = -b->constant;
+	else
+		return false;
+	induction->phi = id;
+	induction->update = update;
+	induction->entry = entry;
+	return true;
+}
+
+static U32 find_instruction_position(const Procedure *procedure, Instruction_Id id)
+{
+	const Block *block = get_block(procedure, get_instruction(procedure, id)->block);
+	U32 position = 0;
+	while (get_block_instructions(block)[position] != id)
+		++position;
+	return position;
+}
+
+// inserts the instruction before the terminator of the block.
+static Instruction_Id insert_before_terminator(Procedure *procedure, Block_Id block, Operation operation, Type_Id type, U32 operands_count)
+{
+	return insert_instruction(procedure, block, get_block_instructions_count(get_block(procedure, block)) - 1, operation, type, operands_count);
+}
+
+// multiplying an induction variable by a constant becomes another induction variable, which steps by the product
+// instead, and so does adding something invariant to one that was made like that, so indexing with the loop's
+// counter steps a pointer instead.
+static bool reduce_strength(Procedure *procedure, const Loop *loop)
+{
+	Instruction_Id original_count = get_instructions_count(procedure);
+	Buffer reduced = {}; // of the phis made here
+	bool changed = false;
+	for (U32 i = 0; i < get_loop_blocks_count(loop); ++i)
+	{
+		Block_Id block = get_loop_block(loop, i);
+		for (U32 j = 0; j < get_block_instructions_count(get_block(procedure, block)); ++j)
+		{
+			Instruction_Id id = get_block_instructions(get_block(procedure, block))[j];
+			if (id >= original_count)
+				continue;
+			const Instruction *instruction = get_instruction(procedure, id);
+			Operation operation = instruction->operation;
+			if ((operation != Operation_MULTIPLY && operation != Operation_SHIFT_LEFT && operation != Operation_ADD) ||
+			    get_underlying_type(instruction->type)->kind == Type_Kind_FLOAT)
+				continue;
+
+			// which operand is the induction variable
+			Induction induction;
+			U32 variable = 0;
+			Instruction_Id operands[2] = {find_copied_value(procedure, instruction->operands[0]), find_copied_value(procedure, instruction->operands[1])};
+			for (; variable < 2; ++variable)
+			{
+				if (operation == Operation_SHIFT_LEFT && variable == 1)
+					continue;
+				// adding to a pointer steps it by what's added
+				if (find_induction(procedure, loop, operands[variable], &induction) &&
+				    (operation == Operation_ADD || get_instruction(procedure, operands[variable])->type == instruction->type))
+					break;
+			}
+			if (variable == 2)
+				continue;
+			const Instruction *other = get_instruction(procedure, operands[1 - variable]);
+			U64 step;
+			if (operation == Operation_ADD)
+			{
+				bool made_here = false;
+				for (Size k = 0; k < reduced.mass / sizeof(Instruction_Id); ++k)
+					made_here = made_here || ((Instruction_Id *)reduced.pointer)[k] == induction.phi;
+				if (!made_here || !check_invariance(procedure, loop, operands[1 - variable]))
+					continue;
+				step = induction.step;
+			}
+			else if (other->operation != Operation_CONSTANT)
+				continue;
+			else if (operation == Operation_MULTIPLY)
+				step = induction.step * other->constant;
+			else if (other->constant < get_underlying_type(instruction->type)->size * 8)
+				step = induction.step << other->constant;
+			else
+				continue;
+			Type_Id type = instruction->type;
+			bool pointer = get_underlying_type(type)->kind == Type_Kind_POINTER;
+			Type_Id step_type = pointer ? Type_Id_SIZE : type;
+			step = normalize_integer(step_type, step);
+
+			// the initial value is the operation on the induction variable's initial value
+			Instruction_Id start = insert_before_terminator(procedure, loop->preheader, operation, type, 2);
+			Instruction *start_instruction = get_instruction(procedure, start);
+			start_instruction->operands[variable] = get_instruction(procedure, induction.phi)->operands[induction.entry];
+			start_instruction->operands[1 - variable] = operands[1 - variable];
+			Instruction_Id step_constant = insert_before_terminator(procedure, loop->preheader, Operation_CONSTANT, step_type, 0);
+			get_instruction(procedure, step_constant)->constant = step;
+
+			Instruction_Id phi = insert_instruction(procedure, loop->header, 0, Operation_PHI, type, 2);
+			Instruction_Id update = insert_instruction(procedure, get_instruction(procedure, induction.update)->block,
+			                                           find_instruction_position(procedure, induction.update) + 1, Operation_ADD, type, 2);
+			Instruction *update_instruction = get_instruction(procedure, update);
+			update_instruction->operands[0] = phi;
+			update_instruction->operands[1] = step_constant;
+			Instruction *phi_instruction = get_instruction(procedure, phi);
+			phi_instruction->operands[induction.entry] = start;
+			phi_instruction->operands[1 - induction.entry] = update;
+			*(Instruction_Id *)reserve_from_buffer(&reduced, sizeof(Instruction_Id), alignof(Instruction_Id)) = phi;
+
+			make_copy(get_instruction(procedure, id), phi);
+			changed = true;
+
+			// the phi went before it
+			if (block == loop->header)
+				++j;
+		}
+	}
+	uninitialize_buffer(&reduced);
+	return changed;
+}
+
+constexpr U32 MAXIMUM_UNROLLED_ITERATIONS_COUNT = 16;
+constexpr U32 MAXIMUM_UNROLLED_INSTRUCTIONS_COUNT = 128;
+
+// how many times the body of the loop runs, if it's known: the header exits on a comparison of an induction
+// variable that starts as a constant with a constant. the loop may only exit from the header.
+static bool count_iterations(const Procedure *procedure, const Loop *loop, Block_Id *exit, U32 *count)
+{
+	if (loop->latches_count != 1 || loop->preheader == ~(Block_Id)0)
+		return false;
+	for (U32 i = 0; i < get_loop_blocks_count(loop); ++i)
+	{
+		Block_Id block = get_loop_block(loop, i);
+		const Instruction *terminator = get_terminator(procedure, block);
+		for (U32 j = 0; j < get_successors_count(terminator); ++j)
+		{
+			if (!loop->body[get_successors(terminator)[j]] && block != loop->header)
+				return false;
+		}
+	}
+	const Instruction *branch = get_terminator(procedure, loop->header);
+	if (!branch || branch->operation != Operation_BRANCH || loop->body[branch->targets[0]] == loop->body[branch->targets[1]])
+		return false;
+	*exit = loop->body[branch->targets[0]] ? branch->targets[1] : branch->targets[0];
+
+	const Instruction *condition = get_instruction(procedure, branch->operands[0]);
+	if (condition->operation < Operation_EQUAL || condition->operation > Operation_GREATER_EQUAL)
+		return false;
+	Induction induction;
+	U32 variable = 0;
+	for (; variable < 2; ++variable)
+	{
+		if (find_induction(procedure, loop, condition->operands[variable], &induction))
+			break;
+	}
+	if (variable == 2)
+		return false;
+	const Instruction *bound = get_instruction(procedure, condition->operands[1 - variable]);
+	if (bound->operation != Operation_CONSTANT)
+		return false;
+	const Instruction *phi = get_instruction(procedure, induction.phi);
+	const Instruction *start = get_instruction(procedure, phi->operands[induction.entry]);
+	if (start->operation != Operation_CONSTANT || get_underlying_type(phi->type)->kind != Type_Kind_INTEGER)
+		return false;
+
+	U64 value = start->constant;
+	for (U32 i = 0; i <= MAXIMUM_UNROLLED_ITERATIONS_COUNT; ++i)
+	{
+		U64 result;
+		if (!fold_operation(condition->operation, Type_Id_BOOL, phi->type, phi->type, variable ? bound->constant : value,
+		                    variable ? value : bound->constant, &result))
+			return false;
+		if (branch->targets[result ? 0 : 1] == *exit)
+		{
+			*count = i;
+			return true;
+		}
+		if (!fold_operation(Operation_ADD, phi->type, phi->type, phi->type, value, induction.step, &value))
+			return false;
+	}
+	return false;
+}
+
+static Instruction_Id map_value(const Instruction_Id *map, Instruction_Id count, Instruction_Id id)
+{
+	return id < count && map[id] ? map[id] : id;
+}
+
+// a loop that runs a few times, known at compile time, is replaced by that many copies of its body, each of which
+// goes on to the next instead of back. the header is copied once more, for the test that exits. the copies' tests
+// are known to go on, and the loop they replace isn't reached anymore.
+static bool unroll_loop(Procedure *procedure, const Loop *loop)
+{
+	Block_Id exit = 0;
+	U32 iterations = 0;
+	if (!count_iterations(procedure, loop, &exit, &iterations))
+		return false;
+	U32 size = 0;
+	for (U32 i = 0; i < get_loop_blocks_count(loop); ++i)
+		size += get_block_instructions_count(get_block(procedure, get_loop_block(loop, i)));
+	if (iterations * size > MAXIMUM_UNROLLED_INSTRUCTIONS_COUNT)
+		return false;
+
+	Block_Id header = loop->header;
+	U32 entry = get_predecessors(get_block(procedure, header))[0] == loop->preheader ? 0 : 1;
+	U32 blocks_count = get_blocks_count(procedure);
+	Instruction_Id instructions_count = get_instructions_count(procedure);
+	U32 loop_blocks_count = get_loop_blocks_count(loop);
+	Scratch scratch;
+	Block_Id *blocks = (Block_Id *)reserve_from_arena(scratch.arena, blocks_count * sizeof(Block_Id), alignof(Block_Id));
+	Instruction_Id *previous = (Instruction_Id *)reserve_from_arena(scratch.arena, 2 * instructions_count * sizeof(Instruction_Id), alignof(Instruction_Id));
+	Instruction_Id *current = previous + instructions_count;
+	set_memory(previous, 2 * instructions_count * sizeof(Instruction_Id), 0);
+
+	Block_Id last = loop->preheader; // the block that goes on to the next copy
+	Block_Id first_header = 0;
+	for (U32 iteration = 0; iteration <= iterations; ++iteration)
+	{
+		// the last copy is only of the header, which exits
+		bool final = iteration == iterations;
+		U32 copied_count = final ? 1 : loop_blocks_count;
+		for (U32 i = 0; i < copied_count; ++i)
+			blocks[get_loop_block(loop, i)] = add_block(procedure);
+		Block_Id copied_header = blocks[header];
+		if (!iteration)
+			first_header = copied_header;
+		else
+			retarget(procedure, last, header, copied_header);
+		add_predecessor(procedure, copied_header, last);
+
+		for (U32 i = 0; i < copied_count; ++i)
+		{
+			Block_Id block = get_loop_block(loop, i);
+			if (block != header)
+			{
+				const Block *information = get_block(procedure, block);
+				for (U32 j = 0; j < get_predecessors_count(information); ++j)
+					add_predecessor(procedure, blocks[block], blocks[get_predecessors(get_block(procedure, block))[j]]);
+			}
+			for (U32 j = 0; j < get_block_instructions_count(get_block(procedure, block)); ++j)
+			{
+				Instruction_Id id = get_block_instructions(get_block(procedure, block))[j];
+				Instruction original = *get_instruction(procedure, id);
+
+				// the header's phis take what the previous copy ends with
+				bool phi = block == header && original.operation == Operation_PHI;
+				Instruction_Id copy = insert_instruction(procedure, blocks[block], ~(U32)0, phi ? Operation_COPY : original.operation,
+				                                         original.type, phi ? 1 : original.operands_count);
+				Instruction *instruction = get_instruction(procedure, copy);
+				Instruction_Id *operands = instruction->operands;
+				U32 operands_count = instruction->operands_count;
+				*instruction = original;
+				instruction->operation = phi ? Operation_COPY : original.operation;
+				instruction->block = blocks[block];
+				instruction->operands = operands;
+				instruction->operands_count = operands_count;
+				if (phi)
+					operands[0] = iteration ? map_value(previous, instructions_count, original.operands[1 - entry]) : original.operands[entry];
+				else if (operands_count)
+					copy_memory(operands, original.operands, operands_count * sizeof(Instruction_Id));
+				current[id] = copy;
+
+				if (original.operation == Operation_BRANCH && block == header)
+				{
+					Block_Id next = loop->body[original.targets[0]] ? original.targets[0] : original.targets[1];
+					instruction->operation = Operation_JUMP;
+					instruction->operands_count = 0;
+					// a loop of one block goes back to its header, which is the next copy's
+					instruction->targets[0] = final ? exit : next == header ? header : blocks[next];
+					if (final)
+						replace_predecessor(procedure, exit, header, blocks[header]);
+				}
+				else if (original.operation == Operation_JUMP || original.operation == Operation_BRANCH || original.operation == Operation_SWITCH)
+				{
+					if (original.operation == Operation_SWITCH)
+						copy_switch_targets(procedure, instruction);
+					for (U32 k = 0; k < get_successors_count(&original); ++k)
+					{
+						// the jump back goes on to the next copy, which retargets it
+						if (get_successors(&original)[k] != header)
+							get_successors(instruction)[k] = blocks[get_successors(&original)[k]];
+					}
+				}
+			}
+		}
+
+		// the operands are mapped once every value of the copy has its own, since phis can use later ones
+		for (U32 i = 0; i < copied_count; ++i)
+		{
+			Block_Id block = get_loop_block(loop, i);
+			const Block *information = get_block(procedure, blocks[block]);
+			for (U32 j = 0; j < get_block_instructions_count(information); ++j)
+			{
+				Instruction *instruction = get_instruction(procedure, get_block_instructions(information)[j]);
+				if (block == header && j < get_block_instructions_count(get_block(procedure, header)) &&
+				    get_instruction(procedure, get_block_instructions(get_block(procedure, header))[j])->operation == Operation_PHI)
+					continue;
+				for (U32 k = 0; k < instruction->operands_count; ++k)
+					instruction->operands[k] = map_value(current, instructions_count, instruction->operands[k]);
+			}
+		}
+		last = blocks[loop->latch];
+		Instruction_Id *swap = previous;
+		previous = current;
+		current = swap;
+		set_memory(current, instructions_count * sizeof(Instruction_Id), 0);
+	}
+
+	// what comes after the loop uses the values of the last copy of the header
+	retarget(procedure, loop->preheader, header, first_header);
+	remove_predecessor(procedure, header, loop->preheader);
+	for (Block_Id block = 0; block < blocks_count; ++block)
+	{
+		if (loop->body[block])
+			continue;
+		const Block *information = get_block(procedure, block);
+		for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+		{
+			Instruction *instruction = get_instruction(procedure, get_block_instructions(information)[i]);
+			for (U32 j = 0; j < instruction->operands_count; ++j)
+				instruction->operands[j] = map_value(previous, instructions_count, instruction->operands[j]);
+		}
+	}
+
+	return true;
+}
+
+// the loops are made to have preheaders first, since that may add blocks. then invariants are hoisted out of them
+// and induction variables are strength-reduced, inner loops first, and at most one loop is unrolled, since that
+// changes the control flow that the analysis is of.
+static bool optimize_loops(Optimization *optimization)
+{
+	Procedure *procedure = optimization->procedure;
+	Scratch scratch;
+	Arena_Pointer analysis;
+	get_arena_pointer(scratch.arena, &analysis);
+	Dominators dominators;
+	U32 count = 0;
+	find_dominators(procedure, &dominators, scratch.arena);
+	Loop *items = find_loops(procedure, &dominators, scratch.arena, &count);
+
+	bool changed = false;
+	for (U32 i = 0; i < count; ++i)
+		changed = make_preheader(procedure, &items[i]) || changed;
+	if (changed)
+	{
+		set_arena(&analysis);
+		find_dominators(procedure, &dominators, scratch.arena);
+		items = find_loops(procedure, &dominators, scratch.arena, &count);
+		for (U32 i = 0; i < count; ++i)
+			make_preheader(procedure, &items[i]);
+	}
+
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (items[i].preheader == ~(Block_Id)0)
+			continue;
+		changed = hoist_invariants(procedure, &items[i]) || changed;
+		changed = reduce_strength(procedure, &items[i]) || changed;
+	}
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (items[i].preheader != ~(Block_Id)0 && unroll_loop(procedure, &items[i]))
+		{
+			changed = true;
+			break;
+		}
+	}
+	return changed;
+}
+
+struct Pass
+{
+	const char *name;
+	bool (*run)(Optimization *optimization);
+};
+
+static const Pass passes[] =
+{
+	{"inlining",                inline_calls},
+	{"constant propagation",    propagate_constants},
+	{"copy propagation",        propagate_copies},
+	{"dead code elimination",   eliminate_dead_code},
+	{"control flow simplification", simplify_control_flow},
+	{"loop optimization",       optimize_loops},
+};
+
+// passes make work for each other, so they're run until none of them changes anything. the rounds are capped in
+// case some of them keep undoing each other.
+constexpr U32 MAXIMUM_OPTIMIZATION_ROUNDS_COUNT = 16;
+
+static void optimize_procedure(Optimization *optimization)
+{
+	for (U32 round = 0; round < MAXIMUM_OPTIMIZATION_ROUNDS_COUNT; ++round)
+	{
+		bool changed = false;
+		for (const Pass &pass : passes)
+			changed = pass.run(optimization) || changed;
+		if (!changed)
+			break;
+	}
+}
+
+// callees are optimized before their callers (in post-order of the call graph), so they are as small as they get
+// by the time they may be inlined.
+void optimize_program(Program *program)
+{
+	Size count = get_list_count(&program->procedures);
+	U8 *optimized = (U8 *)allocate(count);
+	U8 *visited = (U8 *)allocate(count);
+	set_memory(optimized, count, 0);
+	set_memory(visited, count, 0);
+	Optimization optimization = {program, 0, optimized};
+
+	// each entry of the stack is a procedure and the next of its instructions to look at for calls
+	struct Visit
+	{
+		Procedure *procedure;
+		Instruction_Id next;
+	};
+	Buffer stack = {};
+	for (Size i = 0; i < count; ++i)
+	{
+		Procedure *root = get_list_item(&program->procedures, i);
+		if (visited[i])
+			continue;
+		visited[i] = true;
+		*(Visit *)reserve_from_buffer(&stack, sizeof(Visit), alignof(Visit)) = {root, 1};
+		while (stack.mass)
+		{
+			Visit *visit = (Visit *)((U8 *)stack.pointer + stack.mass - sizeof(Visit));
+			Procedure *procedure = visit->procedure;
+			Procedure *callee = 0;
+			while (!callee && visit->next < get_instructions_count(procedure))
+			{
+				const Instruction *instruction = get_instruction(procedure, visit->next++);
+				if (instruction->operation == Operation_ADDRESS && get_type(instruction->type)->kind == Type_Kind_PROCEDURE &&
+				    !visited[instruction->address.procedure->index])
+					callee = instruction->address.procedure;
+			}
+			if (callee)
+			{
+				visited[callee->index] = true;
+				*(Visit *)reserve_from_buffer(&stack, sizeof(Visit), alignof(Visit)) = {callee, 1};
+				continue;
+			}
+			release_from_buffer(&stack, sizeof(Visit), alignof(Visit));
+			if (!procedure->external && get_instructions_count(procedure))
+			{
+				optimization.procedure = procedure;
+				optimize_procedure(&optimization);
+			}
+			optimized[procedure->index] = true;
+		}
+	}
+	uninitialize_buffer(&stack);
+	deallocate(visited);
+	deallocate(optimized);
+}
+
+// profiles
+
+// a profile is the header, the record of each procedure that was instrumented, and then the counters of all their
+// blocks
+struct Profile_Header
+{
+	U32 magic;
+	U32 version;
+	U32 procedures_count;
+	U32 counters_count;
+};
+
+struct Profile_Procedure
+{
+	U64 key;
+	U32 blocks_count;       // as it was lowered, which is how it's matched
+	U32 instructions_count;
+	U32 first_counter;      // of its blocks, in order
+	U32 unused;
+};
+
+constexpr U32 PROFILE_MAGIC = 'W' | 'P' << 8 | 'R' << 16 | 'F' << 24;
+constexpr U32 PROFILE_VERSION = 1;
+
+// top-level procedures are known by their names. others may share theirs, so their place in the program counts too.
+static U64 get_profile_key(const Procedure *procedure)
+{
+	String name = procedure->artifact ? get_identifier_string(procedure->artifact->name) : String{(const Utf8 *)"proc", 4};
+	U64 key = hash_memory(name.pointer, name.size);
+	if (!procedure->artifact || procedure->artifact->scope)
+		key ^= (procedure->index + 1) * 0x9e3779b97f4a7c15;
+	return key | 1;
+}
+
+static bool check_profiled(const Procedure *procedure)
+{
+	return !procedure->external && get_instructions_count(procedure);
+}
+
+// every block is counted, rather than only entries and the edges into the targets of jumps and labels. a block with
+// one predecessor counts that edge exactly, and what a profile decides only needs the counts of blocks, or of edges
+// into such targets: which blocks are cold or hot, and which case target of a switch is hot. the counter of the block
+// is incremented after its phis, which come first.
+static void count_block(Procedure *procedure, Block_Id block, Artifact *counters, U32 counter)
+{
+	const Block *information = get_block(procedure, block);
+	U32 position = 0;
+	while (position < get_block_instructions_count(information) &&
+	       get_instruction(procedure, get_block_instructions(information)[position])->operation == Operation_PHI)
+		++position;
+	Instruction_Id base = insert_instruction(procedure, block, position++, Operation_ADDRESS, get_pointer_type(counters->type), 0);
+	get_instruction(procedure, base)->address.artifact = counters;
+	Instruction_Id offset = insert_instruction(procedure, block, position++, Operation_CONSTANT, Type_Id_SIZE, 0);
+	get_instruction(procedure, offset)->constant = (U64)counter * 8;
+	Instruction_Id address = insert_instruction(procedure, block, position++, Operation_ADD, get_pointer_type(Type_Id_U64), 2);
+	get_instruction(procedure, address)->operands[0] = base;
+	get_instruction(procedure, address)->operands[1] = offset;
+	Instruction_Id count = insert_instruction(procedure, block, position++, Operation_LOAD, Type_Id_U64, 1);
+	get_instruction(procedure, count)->operands[0] = address;
+	Instruction_Id one = insert_instruction(procedure, block, position++, Operation_CONSTANT, Type_Id_U64, 0);
+	get_instruction(procedure, one)->constant = 1;
+	Instruction_Id sum = insert_instruction(procedure, block, position++, Operation_ADD, Type_Id_U64, 2);
+	get_instruction(procedure, sum)->operands[0] = count;
+	get_instruction(procedure, sum)->operands[1] = one;
+	Instruction_Id store = insert_instruction(procedure, block, position++, Operation_STORE, Type_Id_VOID, 2);
+	get_instruction(procedure, store)->operands[0] = address;
+	get_instruction(procedure, store)->operands[1] = sum;
+}
+
+void instrument_program(Program *program, const char *path)
+{
+	Buffer header = {};
+	reserve_from_buffer(&header, sizeof(Profile_Header), alignof(Profile_Header));
+	U32 procedures_count = 0;
+	U32 counters_count = 0;
+	for (Size i = 0; i < get_list_count(&program->procedures); ++i)
+	{
+		const Procedure *procedure = get_list_item(&program->procedures, i);
+		if (!check_profiled(procedure))
+			continue;
+		Profile_Procedure *record = (Profile_Procedure *)reserve_from_buffer(&header, sizeof(Profile_Procedure), alignof(Profile_Procedure));
+		*record = {};
+		record->key = get_profile_key(procedure);
+		record->blocks_count = get_blocks_count(procedure);
+		record->instructions_count = get_instructions_count(procedure);
+		record->first_counter = counters_count;
+		counters_count += get_blocks_count(procedure);
+		++procedures_count;
+	}
+	if (!counters_count)
+	{
+		uninitialize_buffer(&header);
+		return;
+	}
+	Profile_Header *information = (Profile_Header *)header.pointer;
+	information->magic = PROFILE_MAGIC;
+	information->version = PROFILE_VERSION;
+	information->procedures_count = procedures_count;
+	information->counters_count = counters_count;
+
+	// the counters are a global array, which starts as zeros
+	Artifact *counters = (Artifact *)reserve_from_arena(&program->arena, sizeof(Artifact), alignof(Artifact));
+	set_memory(counters, sizeof(Artifact), 0);
+	const char *name = "wika_profile_counters";
+	counters->name = intern_identifier((const Utf8 *)name, get_length_of_string(name));
+	counters->type = get_array_type(Type_Id_U64, counters_count);
+	for (Size i = 0, counter = 0; i < get_list_count(&program->procedures); ++i)
+	{
+		Procedure *procedure = get_list_item(&program->procedures, i);
+		if (!check_profiled(procedure))
+			continue;
+		for (Block_Id block = 0; block < get_blocks_count(procedure); ++block, ++counter)
+		{
+			if (get_block_instructions_count(get_block(procedure, block)))
+				count_block(procedure, block, counters, (U32)counter);
+		}
+	}
+
+	U8 *contents = (U8 *)reserve_from_arena(&program->arena, header.mass, 8);
+	copy_memory(contents, header.pointer, header.mass);
+	Size path_size = get_length_of_string(path);
+	char *path_copy = (char *)reserve_from_arena(&program->arena, path_size + 1, 1);
+	copy_memory(path_copy, path, path_size + 1);
+	program->profile_counters = counters;
+	program->profile_header = {contents, header.mass};
+	program->profile_path = path_copy;
+	uninitialize_buffer(&header);
+}
+
+void apply_profile(Program *program, const char *path)
+{
+	Handle handle;
+	if (!open_file(&handle, path))
+		return;
+	Scratch scratch;
+	Size size = 0;
+	bool valid = get_file_size(handle, &size);
+	U8 *data = (U8 *)reserve_from_arena(scratch.arena, max(size, 1), alignof(U64));
+	Size loaded = 0;
+	while (valid && loaded < size)
+	{
+		Size chunk = size - loaded;
+		valid = read_file(handle, data + loaded, &chunk) && chunk;
+		loaded += chunk;
+	}
+	close_file(handle);
+
+	const Profile_Header *header = (const Profile_Header *)data;
+	valid = valid && size >= sizeof(Profile_Header) && header->magic == PROFILE_MAGIC && header->version == PROFILE_VERSION &&
+	        size == sizeof(Profile_Header) + header->procedures_count * sizeof(Profile_Procedure) + header->counters_count * sizeof(U64);
+	const Profile_Procedure *procedures = (const Profile_Procedure *)(data + sizeof(Profile_Header));
+	for (U32 i = 0; valid && i < header->procedures_count; ++i)
+		valid = (U64)procedures[i].first_counter + procedures[i].blocks_count <= header->counters_count;
+	if (!valid)
+	{
+		report_error("this isn't a profile that an instrumented build wrote: %s.", path);
+		return;
+	}
+
+	const U64 *counters = (const U64 *)(procedures + header->procedures_count);
+	Index_Map keys = {}; // from the keys of the procedures to their index, plus one
+	for (U32 i = 0; i < header->procedures_count; ++i)
+		*insert_into_map(&keys, procedures[i].key) = i + 1;
+
+	Size stale_count = 0;
+	for (Size i = 0; i < get_list_count(&program->procedures); ++i)
+	{
+		Procedure *procedure = get_list_item(&program->procedures, i);
+		if (!check_profiled(procedure))
+			continue;
+		const U64 *index = find_in_map(&keys, get_profile_key(procedure));
+		const Profile_Procedure *record = index ? &procedures[*index - 1] : 0;
+		if (!record || record->blocks_count != get_blocks_count(procedure) || record->instructions_count != get_instructions_count(procedure))
+		{
+			++stale_count;
+			continue;
+		}
+		for (Block_Id block = 0; block < get_blocks_count(procedure); ++block)
+			get_block(procedure, block)->frequency = counters[record->first_counter + block] + 1;
+	}
+	uninitialize_map(&keys);
+	if (stale_count)
+		report_warning("%lu procedures aren't in the profile or changed since it was written, so they're optimized without it.", stale_count);
+}
+
+static const char *const operation_names[] =
+{
+	"none", "constant", "address", "parameter", "local", "phi", "copy",
+	"negate", "not", "complement", "convert", "load",
+	"add", "subtract", "multiply", "divide", "modulo", "and", "or", "xor", "shift_left", "shift_right",
+	"equal", "not_equal", "less", "less_equal", "greater", "greater_equal",
+	"store", "copy_memory", "zero_memory", "call", "result",
+	"jump", "branch", "switch", "return",
+};
+
+static void print_procedure_name(const Procedure *procedure)
+{
+	if (procedure->artifact)
+	{
+		String name = get_identifier_string(procedure->artifact->name);
+		print("%.*s", (int)name.size, name.pointer);
+	}
+	else
+		print("proc#%lu", procedure->index);
+}
+
+void print_program(const Program *program)
+{
+	for (Size i = 0; i < get_list_count(&program->procedures); ++i)
+	{
+		const Procedure *procedure = get_list_item(&program->procedures, i);
+		print(procedure->external ? "external " : "");
+		print_procedure_name(procedure);
+		print(" : %s\n", name_type(procedure->type).string);
+		for (Block_Id block = 0; block < get_blocks_count(procedure); ++block)
+		{
+			const Block *information = get_block(procedure, block);
+			if (!get_block_instructions_count(information))
+				continue;
+			print("b%u", block);
+			for (U32 j = 0; j < get_predecessors_count(information); ++j)
+				print(j ? ", b%u" : " (b%u", get_predecessors(information)[j]);
+			print(get_predecessors_count(information) ? "):\n" : ":\n");
+			for (U32 j = 0; j < get_block_instructions_count(information); ++j)
+			{
+				Instruction_Id id = get_block_instructions(information)[j];
+				const Instruction *instruction = get_instruction(procedure, id);
+				print("\t");
+				if (instruction->type != Type_Id_VOID)
+					print("%%%u = ", id);
+				print("%s", operation_names[instruction->operation]);
+				if (instruction->type != Type_Id_VOID)
+					print(" %s", name_type(instruction->type).string);
+				for (U32 k = 0; k < instruction->operands_count; ++k)
+					print(k ? ", %%%u" : " %%%u", instruction->operands[k]);
+				switch (instruction->operation)
+				{
+				case Operation_CONSTANT:
+					print(" %lu", instruction->constant);
+					break;
+				case Operation_PARAMETER:
+				case Operation_RESULT:
+					print(" %u", instruction->index);
+					break;
+				case Operation_LOCAL:
+				case Operation_COPY_MEMORY:
+				case Operation_ZERO_MEMORY:
+					print(" [%u, %u]", instruction->slot.size, instruction->slot.alignment);
+					break;
+				case Operation_ADDRESS:
+					if (const Artifact *artifact = instruction->address.artifact)
+					{
+						String name = get_identifier_string(artifact->name);
+						print(" %.*s", (int)name.size, name.pointer);
+					}
+					else if (instruction->address.procedure)
+					{
+						print(" ");
+						print_procedure_name(instruction->address.procedure);
+					}
+					else
+						print(" data[%lu]", instruction->address.data->data.size);
+					break;
+				case Operation_JUMP:
+					print(" b%u", instruction->targets[0]);
+					break;
+				case Operation_BRANCH:
+					print(", b%u, b%u", instruction->targets[0], instruction->targets[1]);
+					break;
+				case Operation_SWITCH:
+					{
+						bool is_signed = get_underlying_type(get_instruction(procedure, instruction->operands[0])->type)->is_signed;
+						print(", b%u [", instruction->table.targets[0]);
+						for (U32 k = 0; k < instruction->table.cases_count; ++k)
+						{
+							const Switch_Case *switch_case = &instruction->table.cases[k];
+							print(is_signed ? "%s%ld: b%u" : "%s%lu: b%u", k ? ", " : "", switch_case->value,
+							      instruction->table.targets[switch_case->target]);
+						}
+						print("]");
+					}
+					break;
+				default:
+					break;
+				}
+				print("\n");
+			}
+		}
+	}
+}
+
+// x86-64 code generation
+
+// procedures are compiled straight to machine code: instructions are selected from the SSA form, values get
+// registers by a linear scan over their live intervals, and the code is encoded while it's selected. the result is
+// an ELF image that's laid out in one reservation from an arena and written with a single `write`.
+
+enum Register : U8
+{
+	Register_RAX,
+	Register_RCX,
+	Register_RDX,
+	Register_RBX,
+	Register_RSP,
+	Register_RBP,
+	Register_RSI,
+	Register_RDI,
+	Register_R8,
+	Register_R9,
+	Register_R10,
+	Register_R11,
+	Register_R12,
+	Register_R13,
+	Register_R14,
+	Register_R15,
+	Register_XMM0,
+	Register_XMM1,
+	Register_XMM2,
+	Register_XMM3,
+	Register_XMM4,
+	Register_XMM5,
+	Register_XMM6,
+	Register_XMM7,
+	Register_XMM8,
+	Register_XMM9,
+	Register_XMM10,
+	Register_XMM11,
+	Register_XMM12,
+	Register_XMM13,
+	Register_XMM14,
+	Register_XMM15,
+
+	Register_NONE,
+};
+
+// rax, rcx, rdx and r11 (and xmm14 and xmm15) are never allocated, so instructions with fixed operands (division,
+// shifts) and moves that need a temporary can use them. r10 holds the target of indirect calls.
+static const Register general_registers[] = {Register_RSI, Register_RDI, Register_R8, Register_R9, Register_RBX,
+                                              Register_R12, Register_R13, Register_R14, Register_R15};
+static const Register vector_registers[] = {Register_XMM0, Register_XMM1, Register_XMM2, Register_XMM3, Register_XMM4,
+                                             Register_XMM5, Register_XMM6, Register_XMM7, Register_XMM8, Register_XMM9,
+                                             Register_XMM10, Register_XMM11, Register_XMM12, Register_XMM13};
+static const Register general_argument_registers[] = {Register_RDI, Register_RSI, Register_RDX, Register_RCX, Register_R8, Register_R9};
+constexpr U32 VECTOR_ARGUMENT_REGISTERS_COUNT = 8;
+
+static bool check_callee_saved(Register reg)
+{
+	return reg == Register_RBX || (reg >= Register_R12 && reg <= Register_R15);
+}
+
+static bool check_vector_register(Register reg)
+{
+	return reg >= Register_XMM0 && reg < Register_NONE;
+}
+
+enum Section : U8
+{
+	Section_NONE, // of symbols that are defined elsewhere
+	Section_TEXT,
+	Section_RODATA,
+	Section_DATA,
+	Section_BSS,
+
+	Section_COUNT,
+};
+
+// the first symbols are those of the sections, and then come those of the procedures, in order
+struct Object_Symbol
+{
+	String name;
+	Section section;
+	bool global;
+	bool function;
+	U64 offset; // in the section
+	U64 size;
+};
+
+enum Fixup_Kind : U8
+{
+	Fixup_Kind_RELATIVE, // 32 bits, relative to the field
+	Fixup_Kind_CALL,     // likewise, but of a call, which a linker may route through a stub
+	Fixup_Kind_ABSOLUTE, // 64 bits
+};
+
+// a field that holds the address of a symbol, plus the addend
+struct Fixup
+{
+	Section section;
+	Fixup_Kind kind;
+	U32 symbol;
+	U64 offset;
+	S64 addend;
+};
+
+struct Generation
+{
+	const Program *program;
+	Buffer sections[Section_COUNT]; // the bss has no contents, so only its mass counts
+	Buffer symbols;                 // of `Object_Symbol`
+	Buffer fixups;                  // of `Fixup`
+	Index_Map globals;              // from artifacts to their symbols, plus one
+	Index_Map datas;                // from read-only data to its offset, plus one
+	Index_Map images;               // from the hashes of read-only data to the first that was emitted with it
+	Index_Map floats;               // from the bits of float constants to their offset in the read-only data, plus one
+	Arena names;                    // of the symbols that are made up
+};
+
+static U32 get_section_symbol(Section section)
+{
+	return section - 1;
+}
+
+static U32 get_procedure_symbol(const Procedure *procedure)
+{
+	return Section_COUNT - 1 + (U32)procedure->index;
+}
+
+static Object_Symbol *get_object_symbol(const Generation *generation, U32 symbol)
+{
+	return &((Object_Symbol *)generation->symbols.pointer)[symbol];
+}
+
+static U32 add_object_symbol(Generation *generation, String name, Section section, bool global)
+{
+	U32 symbol = (U32)(generation->symbols.mass / sizeof(Object_Symbol));
+	Object_Symbol *information = (Object_Symbol *)reserve_from_buffer(&generation->symbols, sizeof(Object_Symbol), alignof(Object_Symbol));
+	*information = {};
+	information->name = name;
+	information->section = section;
+	information->global = global;
+	return symbol;
+}
+
+// top-level artifacts keep their names. what's declared in a procedure gets its index appended, since its name
+// may be taken.
+static String name_object_symbol(Generation *generation, const Artifact *artifact, Size index)
+{
+	if (artifact && !artifact->scope)
+		return get_identifier_string(artifact->name);
+	String name = artifact ? get_identifier_string(artifact->name) : String{(const Utf8 *)"proc", 4};
+	char *buffer = (char *)reserve_from_arena(&generation->names, name.size + 24, 1);
+	Size size = format(buffer, name.size + 24, "%.*s.%lu", (int)name.size, name.pointer, index);
+	return {(const Utf8 *)buffer, size};
+}
+
+static void add_fixup(Generation *generation, Section section, Fixup_Kind kind, U64 offset, U32 symbol, S64 addend)
+{
+	Fixup *fixup = (Fixup *)reserve_from_buffer(&generation->fixups, sizeof(Fixup), alignof(Fixup));
+	fixup->section = section;
+	fixup->kind = kind;
+	fixup->symbol = symbol;
+	fixup->offset = offset;
+	fixup->addend = addend;
+}
+
+static U64 reserve_from_section(Generation *generation, Section section, Size size, Size alignment)
+{
+	Buffer *buffer = &generation->sections[section];
+	Size padding = get_alignment_addition(buffer->mass, alignment);
+	if (section == Section_BSS)
+	{
+		buffer->mass += padding + size;
+		return buffer->mass - size;
+	}
+	U8 *pointer = (U8 *)reserve_from_buffer(buffer, padding + size, 1);
+	set_memory(pointer, padding + size, 0);
+	return buffer->mass - size;
+}
+
+static U32 get_global_symbol(Generation *generation, Artifact *artifact);
+static U64 get_data_offset(Generation *generation, const Relocation *data);
+
+// the addresses in an image are fixed up once the image is where it goes.
+static void add_image_fixups(Generation *generation, Section section, U64 offset, const Relocation *relocations)
+{
+	for (const Relocation *relocation = relocations; relocation; relocation = relocation->next)
+	{
+		if (relocation->artifact)
+			add_fixup(generation, section, Fixup_Kind_ABSOLUTE, offset + relocation->offset, get_global_symbol(generation, relocation->artifact), 0);
+		else if (relocation->procedure)
+		{
+			const U64 *procedure = find_in_map(&generation->program->procedures_by_node, (U64)(Address)relocation->procedure);
+			if (procedure)
+				add_fixup(generation, section, Fixup_Kind_ABSOLUTE, offset + relocation->offset,
+				          get_procedure_symbol((const Procedure *)(Address)*procedure), 0);
+		}
+		else
+			add_fixup(generation, section, Fixup_Kind_ABSOLUTE, offset + relocation->offset, get_section_symbol(Section_RODATA),
+			          (S64)get_data_offset(generation, relocation));
+	}
+}
+
+// whether the addresses in two images are of the same things
+static bool check_same_addresses(Generation *generation, const Relocation *a, const Relocation *b)
+{
+	for (; a && b; a = a->next, b = b->next)
+	{
+		if (a->offset != b->offset || a->artifact != b->artifact || a->procedure != b->procedure)
+			return false;
+		if (!a->artifact && !a->procedure && get_data_offset(generation, a) != get_data_offset(generation, b))
+			return false;
+	}
+	return !a && !b;
+}
+
+// the read-only data of constants, which may point to more of it. what was pooled is already there, and the rest
+// is emitted once for each image that has different bytes or addresses in it.
+static U64 get_data_offset(Generation *generation, const Relocation *data)
+{
+	if (const U64 *offset = find_in_map(&generation->datas, (U64)(Address)data))
+		return *offset - 1;
+	U64 hash = hash_memory(data->data.pointer, data->data.size) | 1;
+	if (const U64 *first = find_in_map(&generation->images, hash))
+	{
+		const Relocation *other = (const Relocation *)(Address)*first;
+		if (other->data.size == data->data.size && compare_memory(other->data.pointer, data->data.pointer, data->data.size) == 0 &&
+		    check_same_addresses(generation, data->relocations, other->relocations))
+		{
+			U64 offset = get_data_offset(generation, other);
+			*insert_into_map(&generation->datas, (U64)(Address)data) = offset + 1;
+			return offset;
+		}
+	}
+	else
+		*insert_into_map(&generation->images, hash) = (U64)(Address)data;
+	U64 offset = reserve_from_section(generation, Section_RODATA, data->data.size, 8);
+	*insert_into_map(&generation->datas, (U64)(Address)data) = offset + 1;
+	copy_memory((U8 *)generation->sections[Section_RODATA].pointer + offset, data->data.pointer, data->data.size);
+	add_image_fixups(generation, Section_RODATA, offset, data->relocations);
+	return offset;
+}
+
+// read-only data that holds no addresses is pooled before anything is generated: equal data is emitted once, and
+// data that ends other data is placed at the other's end, if that's aligned as its type needs. what's emitted is
+// aligned as much as its size allows as well, which is at least as much as its type needs.
+static Size get_pooled_data_alignment(const Relocation *data)
+{
+	Size alignment = 8;
+	while (data->data.size % alignment)
+		alignment /= 2;
+	return max(alignment, max(data->alignment, 1));
+}
+
+static void gather_pooled_datas(Buffer *datas, Index_Map *reached, const Relocation *relocations);
+
+static void gather_pooled_artifact(Buffer *datas, Index_Map *reached, const Artifact *artifact)
+{
+	U64 *slot = insert_into_map(reached, (U64)(Address)artifact);
+	if (*slot)
+		return;
+	*slot = 1;
+	gather_pooled_datas(datas, reached, artifact->value.relocations);
+}
+
+static void gather_pooled_data(Buffer *datas, Index_Map *reached, const Relocation *data)
+{
+	U64 *slot = insert_into_map(reached, (U64)(Address)data);
+	if (*slot)
+		return;
+	*slot = 1;
+	if (data->relocations)
+		gather_pooled_datas(datas, reached, data->relocations);
+	else
+		*(const Relocation **)reserve_from_buffer(datas, sizeof(const Relocation *), alignof(const Relocation *)) = data;
+}
+
+static void gather_pooled_datas(Buffer *datas, Index_Map *reached, const Relocation *relocations)
+{
+	for (const Relocation *relocation = relocations; relocation; relocation = relocation->next)
+	{
+		if (relocation->artifact)
+			gather_pooled_artifact(datas, reached, relocation->artifact);
+		else if (!relocation->procedure)
+			gather_pooled_data(datas, reached, relocation);
+	}
+}
+
+// the order of the data read backwards, so data that ends other data comes right before it, or before data that
+// ends the same way
+static int compare_pooled_datas(const void *a, const void *b)
+{
+	String first = (*(const Relocation *const *)a)->data;
+	String second = (*(const Relocation *const *)b)->data;
+	for (Size i = 1; i <= first.size && i <= second.size; ++i)
+	{
+		U8 x = first.pointer[first.size - i];
+		U8 y = second.pointer[second.size - i];
+		if (x != y)
+			return x < y ? -1 : 1;
+	}
+	return first.size < second.size ? -1 : first.size > second.size;
+}
+
+static void pool_read_only_data(Generation *generation)
+{
+	Buffer datas = {};
+	Index_Map reached = {};
+	const Program *program = generation->program;
+	for (Size i = 0; i < get_list_count(&program->procedures); ++i)
+	{
+		const Procedure *procedure = get_list_item(&program->procedures, i);
+		if (procedure->external)
+			continue;
+		for (U32 j = 0; j < get_instructions_count(procedure); ++j)
+		{
+			const Instruction *instruction = get_instruction(procedure, j);
+			if (instruction->operation != Operation_ADDRESS)
+				continue;
+			if (instruction->address.artifact)
+				gather_pooled_artifact(&datas, &reached, instruction->address.artifact);
+			else if (!instruction->address.procedure && instruction->address.data)
+				gather_pooled_data(&datas, &reached, instruction->address.data);
+		}
+	}
+
+	// going from the last, each is either within the last one that was emitted or emitted itself
+	const Relocation **order = (const Relocation **)datas.pointer;
+	Size count = datas.mass / sizeof(const Relocation *);
+	if (count)
+		qsort(order, count, sizeof(const Relocation *), compare_pooled_datas);
+	String host = {};
+	U64 host_offset = 0;
+	for (Size i = count; i--;)
+	{
+		String data = order[i]->data;
+		U64 offset = host_offset + host.size - data.size;
+		bool within = host.pointer && data.size <= host.size && offset % max(order[i]->alignment, 1) == 0 &&
+		              compare_memory(host.pointer + host.size - data.size, data.pointer, data.size) == 0;
+		if (!within)
+		{
+			offset = reserve_from_section(generation, Section_RODATA, data.size, get_pooled_data_alignment(order[i]));
+			copy_memory((U8 *)generation->sections[Section_RODATA].pointer + offset, data.pointer, data.size);
+			host = data;
+			host_offset = offset;
+		}
+		*insert_into_map(&generation->datas, (U64)(Address)order[i]) = offset + 1;
+	}
+
+	uninitialize_buffer(&datas);
+	uninitialize_map(&reached);
+}
+
+// global and static variables, with their initial values. those that start as zeros go into the bss.
+static U32 get_global_symbol(Generation *generation, Artifact *artifact)
+{
+	if (const U64 *symbol = find_in_map(&generation->globals, (U64)(Address)artifact))
+		return (U32)*symbol - 1;
+	U64 *slot = insert_into_map(&generation->globals, (U64)(Address)artifact);
+	const Type *type = get_type(artifact->type);
+	const Value *value = &artifact->value;
+	U64 integer = 0;
+	const U8 *image = 0;
+	if (value->type != Type_Id_NONE && check_image(value->type))
+		image = value->image;
+	else if (value->type != Type_Id_NONE && type->kind == Type_Kind_FLOAT)
+	{
+		float floating = (float)value->floating;
+		if (type->size == 4)
+			copy_memory(&integer, &floating, 4);
+		else
+			copy_memory(&integer, &value->floating, 8);
+	}
+	else if (value->type != Type_Id_NONE && type->kind != Type_Kind_PROCEDURE)
+		integer = value->integer;
+	const U64 *procedure = 0;
+	if (value->type != Type_Id_NONE && type->kind == Type_Kind_PROCEDURE && value->procedure)
+		procedure = find_in_map(&generation->program->procedures_by_node, (U64)(Address)value->procedure);
+	bool zero = !image && !integer && !procedure && !value->relocations;
+
+	Section section = zero ? Section_BSS : Section_DATA;
+	U32 symbol = add_object_symbol(generation, name_object_symbol(generation, artifact, generation->symbols.mass / sizeof(Object_Symbol)), section, !artifact->scope);
+	*slot = symbol + 1;
+	U64 offset = reserve_from_section(generation, section, max(type->size, 1), max(type->alignment, 1));
+	Object_Symbol *information = get_object_symbol(generation, symbol);
+	information->offset = offset;
+	information->size = type->size;
+	if (zero)
+		return symbol;
+	U8 *pointer = (U8 *)generation->sections[Section_DATA].pointer + offset;
+	if (image)
+		copy_memory(pointer, image, type->size);
+	else
+		copy_memory(pointer, &integer, min(type->size, 8));
+	if (procedure)
+		add_fixup(generation, Section_DATA, Fixup_Kind_ABSOLUTE, offset, get_procedure_symbol((const Procedure *)(Address)*procedure), 0);
+	add_image_fixups(generation, Section_DATA, offset, value->relocations);
+	return symbol;
+}
+
+// float constants are loaded from the read-only data, where each is once
+static U64 get_float_offset(Generation *generation, U64 bits)
+{
+	if (const U64 *offset = find_in_map(&generation->floats, bits))
+		return *offset - 1;
+	U64 *slot = insert_into_map(&generation->floats, bits);
+	U64 offset = reserve_from_section(generation, Section_RODATA, 8, 8);
+	copy_memory((U8 *)generation->sections[Section_RODATA].pointer + offset, &bits, 8);
+	*slot = offset + 1;
+	return offset;
+}
+
+// where a value is. constants, addresses of symbols and addresses of stack slots have no place of their own:
+// they're made again wherever they're used.
+enum Place_Kind : U8
+{
+	Place_Kind_NONE,
+	Place_Kind_REGISTER,
+	Place_Kind_STACK,    // in memory at `base + offset`
+	Place_Kind_CONSTANT,
+	Place_Kind_SYMBOL,   // the address `symbol + offset`
+	Place_Kind_FRAME,    // the address `base + offset`
+};
+
+struct Place
+{
+	Place_Kind kind;
+	Register reg;  // registers, or the base of stack and frame places
+	bool vector;   // whether it's a float, which goes in vector registers
+	U32 symbol;
+	S64 offset;
+	U64 constant;
+};
+
+static bool check_places_equality(const Place *a, const Place *b)
+{
+	if (a->kind != b->kind)
+		return false;
+	switch (a->kind)
+	{
+	case Place_Kind_REGISTER: return a->reg == b->reg;
+	case Place_Kind_STACK:    return a->reg == b->reg && a->offset == b->offset;
+	default:                     return false;
+	}
+}
+
+// a memory operand: `base + displacement`, or if there's no base, `symbol + displacement` relative to the next
+// instruction
+struct Memory
+{
+	Register base;
+	U32 symbol;
+	int32_t displacement;
+};
+
+struct Coding
+{
+	Generation *generation;
+	const Procedure *procedure;
+	Buffer *code;
+	Buffer *fixups;          // of `Fixup`, at offsets in `code`
+	Place *places;     // of each value
+	Block_Id *order;         // the blocks, in the order they're emitted
+	U32 order_count;
+	U32 *block_orders;       // the index of each block in `order`
+	U32 *block_offsets;      // in the code
+	Buffer jumps;            // of `Jump_Fixup`, to blocks that weren't emitted yet
+	U32 saved_count;         // of callee-saved registers that are pushed
+	Register saved[5];
+	U32 frame_size;          // below the saved registers
+};
+
+// a 32-bit field that holds where a block is, relative to `base`
+struct Jump_Fixup
+{
+	U64 offset; // of the field
+	U64 base;
+	Block_Id target;
+};
+
+static void emit_byte(Coding *coding, U8 byte)
+{
+	*(U8 *)reserve_from_buffer(coding->code, 1, 1) = byte;
+}
+
+static void emit_bytes(Coding *coding, const void *bytes, Size size)
+{
+	copy_memory(reserve_from_buffer(coding->code, size, 1), bytes, size);
+}
+
+static void emit_u32(Coding *coding, U32 value)
+{
+	emit_bytes(coding, &value, 4);
+}
+
+static U64 get_code_offset(const Coding *coding)
+{
+	return coding->code->mass;
+}
+
+static void add_code_fixup(Coding *coding, Fixup_Kind kind, U64 offset, U32 symbol, S64 addend)
+{
+	Fixup *fixup = (Fixup *)reserve_from_buffer(coding->fixups, sizeof(Fixup), alignof(Fixup));
+	fixup->section = Section_TEXT;
+	fixup->kind = kind;
+	fixup->symbol = symbol;
+	fixup->offset = offset;
+	fixup->addend = addend;
+}
+
+static void patch_u32(Coding *coding, U64 offset, U32 value)
+{
+	copy_memory((U8 *)coding->code->pointer + offset, &value, 4);
+}
+
+static bool check_s32(S64 value)
+{
+	return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+// `opcode` is one to three bytes, after the mandatory prefix (0x66, 0xf2 or 0xf3), if any. `bytes` tells that a
+// register operand is a byte register, which needs a REX prefix to be sil/dil rather than dh/bh.
+struct Encoding
+{
+	U8 prefix;
+	bool wide;
+	U8 opcode[3];
+	U8 opcode_size;
+	bool bytes;
+};
+
+static Encoding encoding(U8 prefix, bool wide, U32 opcode, bool bytes = false)
+{
+	Encoding result = {};
+	result.prefix = prefix;
+	result.wide = wide;
+	result.bytes = bytes;
+	if (opcode > 0xffff)
+	{
+		result.opcode[result.opcode_size++] = (U8)(opcode >> 16);
+		result.opcode[result.opcode_size++] = (U8)(opcode >> 8);
+	}
+	else if (opcode > 0xff)
+		result.opcode[result.opcode_size++] = (U8)(opcode >> 8);
+	result.opcode[result.opcode_size++] = (U8)opcode;
+	return result;
+}
+
+static void emit_prefixes(Coding *coding, const Encoding *encoding, U8 reg, U8 base, bool byte_registers)
+{
+	if (encoding->prefix)
+		emit_byte(coding, encoding->prefix);
+	U8 rex = 0x40 | (encoding->wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((base & 8) ? 1 : 0);
+	if (rex != 0x40 || byte_registers)
+		emit_byte(coding, rex);
+	emit_bytes(coding, encoding->opcode, encoding->opcode_size);
+}
+
+// `reg` is either a register or an opcode extension
+static void encode_register(Coding *coding, Encoding encoding, U8 reg, U8 rm)
+{
+	reg &= 15;
+	rm &= 15;
+	emit_prefixes(coding, &encoding, reg, rm, encoding.bytes && ((reg >= 4 && reg < 8) || (rm >= 4 && rm < 8)));
+	emit_byte(coding, 0xc0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+// `immediate_size` is of what follows the memory operand, which a relative displacement has to skip.
+static void encode_memory(Coding *coding, Encoding encoding, U8 reg, const Memory *memory, U32 immediate_size = 0)
+{
+	reg &= 15;
+	if (memory->base == Register_NONE)
+	{
+		emit_prefixes(coding, &encoding, reg, 0, encoding.bytes && reg >= 4 && reg < 8);
+		emit_byte(coding, ((reg & 7) << 3) | 5);
+		add_code_fixup(coding, Fixup_Kind_RELATIVE, get_code_offset(coding), memory->symbol, (S64)memory->displacement - 4 - immediate_size);
+		emit_u32(coding, 0);
+		return;
+	}
+	U8 base = memory->base & 15;
+	emit_prefixes(coding, &encoding, reg, base, encoding.bytes && reg >= 4 && reg < 8);
+	int32_t displacement = memory->displacement;
+	U8 mode = !displacement && (base & 7) != 5 ? 0 : displacement >= -128 && displacement <= 127 ? 1 : 2;
+	emit_byte(coding, (mode << 6) | ((reg & 7) << 3) | (base & 7));
+	if ((base & 7) == 4)
+		emit_byte(coding, 0x24);
+	if (mode == 1)
+		emit_byte(coding, (U8)(int8_t)displacement);
+	else if (mode == 2)
+		emit_u32(coding, (U32)displacement);
+}
+
+static Memory memory_at(Register base, S64 displacement)
+{
+	Memory memory = {};
+	memory.base = base;
+	memory.displacement = (int32_t)displacement;
+	return memory;
+}
+
+static void emit_move(Coding *coding, Register destination, Register source)
+{
+	if (destination == source)
+		return;
+	if (check_vector_register(destination))
+		encode_register(coding, encoding(0, false, 0x0f28), destination, source); // movaps
+	else
+		encode_register(coding, encoding(0, true, 0x89), source, destination);
+}
+
+static void emit_move_immediate(Coding *coding, Register destination, U64 value)
+{
+	if (value <= 0xffffffff)
+	{
+		// mov r32, imm32 zero-extends
+		if (destination & 8)
+			emit_byte(coding, 0x41);
+		emit_byte(coding, 0xb8 + (destination & 7));
+		emit_u32(coding, (U32)value);
+	}
+	else if (check_s32((S64)value))
+	{
+		encode_register(coding, encoding(0, true, 0xc7), 0, destination);
+		emit_u32(coding, (U32)value);
+	}
+	else
+	{
+		emit_byte(coding, 0x48 | ((destination & 8) ? 1 : 0));
+		emit_byte(coding, 0xb8 + (destination & 7));
+		emit_bytes(coding, &value, 8);
+	}
+}
+
+// loads a value of `size` bytes, extended to 64 bits, or a float
+static void emit_load(Coding *coding, Register destination, const Memory *memory, U32 size, bool is_signed)
+{
+	if (check_vector_register(destination))
+	{
+		encode_memory(coding, size == 4 ? encoding(0xf3, false, 0x0f10) : encoding(0xf3, false, 0x0f7e), destination, memory);
+		return;
+	}
+	switch (size)
+	{
+	case 1:  encode_memory(coding, encoding(0, is_signed, is_signed ? 0x0fbe : 0x0fb6), destination, memory); break;
+	case 2:  encode_memory(coding, encoding(0, is_signed, is_signed ? 0x0fbf : 0x0fb7), destination, memory); break;
+	case 4:  encode_memory(coding, is_signed ? encoding(0, true, 0x63) : encoding(0, false, 0x8b), destination, memory); break;
+	default: encode_memory(coding, encoding(0, true, 0x8b), destination, memory); break;
+	}
+}
+
+static void emit_store(Coding *coding, const Memory *memory, Register source, U32 size)
+{
+	if (check_vector_register(source))
+	{
+		encode_memory(coding, size == 4 ? encoding(0xf3, false, 0x0f11) : encoding(0x66, false, 0x0fd6), source, memory);
+		return;
+	}
+	switch (size)
+	{
+	case 1:  encode_memory(coding, encoding(0, false, 0x88, true), source, memory); break;
+	case 2:  encode_memory(coding, encoding(0x66, false, 0x89), source, memory); break;
+	case 4:  encode_memory(coding, encoding(0, false, 0x89), source, memory); break;
+	default: encode_memory(coding, encoding(0, true, 0x89), source, memory); break;
+	}
+}
+
+static void emit_lea(Coding *coding, Register destination, const Memory *memory)
+{
+	encode_memory(coding, encoding(0, true, 0x8d), destination, memory);
+}
+
+// the opcode extensions of the immediate forms of `add`, `or`, `and`, `sub`, `xor` and `cmp`. the register forms
+// are `extension * 8 + 1`.
+enum Arithmetic : U8
+{
+	Arithmetic_ADD = 0,
+	Arithmetic_OR  = 1,
+	Arithmetic_AND = 4,
+	Arithmetic_SUB = 5,
+	Arithmetic_XOR = 6,
+	Arithmetic_CMP = 7,
+};
+
+static void emit_arithmetic(Coding *coding, Arithmetic arithmetic, Register destination, Register source)
+{
+	encode_register(coding, encoding(0, true, arithmetic * 8 + 1), source, destination);
+}
+
+static void emit_arithmetic_memory(Coding *coding, Arithmetic arithmetic, Register destination, const Memory *memory)
+{
+	encode_memory(coding, encoding(0, true, arithmetic * 8 + 3), destination, memory);
+}
+
+static void emit_arithmetic_immediate(Coding *coding, Arithmetic arithmetic, Register destination, int32_t immediate)
+{
+	if (immediate >= -128 && immediate <= 127)
+	{
+		encode_register(coding, encoding(0, true, 0x83), arithmetic, destination);
+		emit_byte(coding, (U8)(int8_t)immediate);
+	}
+	else
+	{
+		encode_register(coding, encoding(0, true, 0x81), arithmetic, destination);
+		emit_u32(coding, (U32)immediate);
+	}
+}
+
+// extends the low `size` bytes of the register to 64 bits
+static void emit_extension(Coding *coding, Register reg, U32 size, bool is_signed)
+{
+	switch (size)
+	{
+	case 1: encode_register(coding, encoding(0, is_signed, is_signed ? 0x0fbe : 0x0fb6, true), reg, reg); break;
+	case 2: encode_register(coding, encoding(0, is_signed, is_signed ? 0x0fbf : 0x0fb7), reg, reg); break;
+	case 4:
+		if (is_signed)
+			encode_register(coding, encoding(0, true, 0x63), reg, reg);
+		else
+			encode_register(coding, encoding(0, false, 0x89), reg, reg);
+		break;
+	default: break;
+	}
+}
+
+// integers are kept like the compile-time evaluation keeps them: truncated to their size, and sign-extended if
+// they're signed. booleans are zero or one.
+static void emit_normalization(Coding *coding, Register reg, Type_Id type)
+{
+	const Type *information = get_underlying_type(type);
+	if (information->kind == Type_Kind_INTEGER)
+		emit_extension(coding, reg, information->size, information->is_signed);
+}
+
+// condition codes, for `setcc` and `jcc`
+enum Condition_Code : U8
+{
+	Condition_Code_BELOW         = 0x2,
+	Condition_Code_ABOVE_EQUAL   = 0x3,
+	Condition_Code_EQUAL         = 0x4,
+	Condition_Code_NOT_EQUAL     = 0x5,
+	Condition_Code_BELOW_EQUAL   = 0x6,
+	Condition_Code_ABOVE         = 0x7,
+	Condition_Code_SIGN          = 0x8,
+	Condition_Code_PARITY        = 0xa,
+	Condition_Code_NOT_PARITY    = 0xb,
+	Condition_Code_LESS          = 0xc,
+	Condition_Code_GREATER_EQUAL = 0xd,
+	Condition_Code_LESS_EQUAL    = 0xe,
+	Condition_Code_GREATER       = 0xf,
+};
+
+static void emit_set(Coding *coding, Condition_Code condition, Register destination)
+{
+	encode_register(coding, encoding(0, false, 0x0f90 + condition, true), 0, destination);
+}
+
+// returns where the displacement is, which is patched once the target is known
+static U64 emit_jump_instruction(Coding *coding, int condition)
+{
+	if (condition < 0)
+		emit_byte(coding, 0xe9);
+	else
+	{
+		emit_byte(coding, 0x0f);
+		emit_byte(coding, 0x80 + condition);
+	}
+	U64 offset = get_code_offset(coding);
+	emit_u32(coding, 0);
+	return offset;
+}
+
+static void patch_jump(Coding *coding, U64 offset, U64 target)
+{
+	patch_u32(coding, offset, (U32)(int32_t)(target - (offset + 4)));
+}
+
+static void add_jump_fixup(Coding *coding, U64 offset, U64 base, Block_Id target)
+{
+	Jump_Fixup *jump = (Jump_Fixup *)reserve_from_buffer(&coding->jumps, sizeof(Jump_Fixup), alignof(Jump_Fixup));
+	jump->offset = offset;
+	jump->base = base;
+	jump->target = target;
+}
+
+// jumps to a block; `condition` is negative for unconditional jumps
+static void emit_block_jump(Coding *coding, int condition, Block_Id target)
+{
+	U64 offset = emit_jump_instruction(coding, condition);
+	add_jump_fixup(coding, offset, offset + 4, target);
+}
+
+static void emit_push(Coding *coding, Register reg)
+{
+	if (reg & 8)
+		emit_byte(coding, 0x41);
+	emit_byte(coding, 0x50 + (reg & 7));
+}
+
+static void emit_pop(Coding *coding, Register reg)
+{
+	if (reg & 8)
+		emit_byte(coding, 0x41);
+	emit_byte(coding, 0x58 + (reg & 7));
+}
+
+static Memory get_symbol_memory(U32 symbol, S64 displacement)
+{
+	Memory memory = {};
+	memory.base = Register_NONE;
+	memory.symbol = symbol;
+	memory.displacement = (int32_t)displacement;
+	return memory;
+}
+
+// loads what's at the place into the register, which is of the same class
+static void emit_place_load(Coding *coding, Register destination, const Place *place)
+{
+	switch (place->kind)
+	{
+	case Place_Kind_REGISTER:
+		emit_move(coding, destination, place->reg);
+		break;
+	case Place_Kind_STACK:
+		{
+			Memory memory = memory_at(place->reg, place->offset);
+			emit_load(coding, destination, &memory, 8, false);
+		}
+		break;
+	case Place_Kind_CONSTANT:
+		if (!check_vector_register(destination))
+			emit_move_immediate(coding, destination, place->constant);
+		else if (!place->constant)
+			encode_register(coding, encoding(0, false, 0x0f57), destination, destination); // xorps
+		else
+		{
+			Memory memory = get_symbol_memory(get_section_symbol(Section_RODATA), (S64)get_float_offset(coding->generation, place->constant));
+			emit_load(coding, destination, &memory, 8, false);
+		}
+		break;
+	case Place_Kind_SYMBOL:
+		{
+			Memory memory = get_symbol_memory(place->symbol, place->offset);
+			emit_lea(coding, destination, &memory);
+		}
+		break;
+	case Place_Kind_FRAME:
+		{
+			Memory memory = memory_at(place->reg, place->offset);
+			emit_lea(coding, destination, &memory);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void emit_place_move(Coding *coding, const Place *destination, const Place *source)
+{
+	if (destination->kind == Place_Kind_REGISTER)
+	{
+		emit_place_load(coding, destination->reg, source);
+		return;
+	}
+	Memory memory = memory_at(destination->reg, destination->offset);
+	if (source->kind == Place_Kind_REGISTER)
+	{
+		emit_store(coding, &memory, source->reg, 8);
+		return;
+	}
+	if (!source->vector && source->kind == Place_Kind_CONSTANT && check_s32((S64)source->constant))
+	{
+		encode_memory(coding, encoding(0, true, 0xc7), 0, &memory, 4);
+		emit_u32(coding, (U32)source->constant);
+		return;
+	}
+	Register temporary = source->vector ? Register_XMM14 : Register_RAX;
+	emit_place_load(coding, temporary, source);
+	emit_store(coding, &memory, temporary, 8);
+}
+
+// the register that holds the value; it's loaded into `scratch` if it isn't in one
+static Register get_value_register(Coding *coding, Instruction_Id value, Register scratch)
+{
+	const Place *place = &coding->places[value];
+	if (place->kind == Place_Kind_REGISTER)
+		return place->reg;
+	emit_place_load(coding, scratch, place);
+	return scratch;
+}
+
+// stores what the register holds into where the value goes
+static void set_value(Coding *coding, Instruction_Id value, Register source)
+{
+	const Place *place = &coding->places[value];
+	if (place->kind == Place_Kind_REGISTER)
+		emit_move(coding, place->reg, source);
+	else if (place->kind == Place_Kind_STACK)
+	{
+		Memory memory = memory_at(place->reg, place->offset);
+		emit_store(coding, &memory, source, 8);
+	}
+}
+
+// the register that the value is computed in: its own, if it has one
+static Register get_result_register(Coding *coding, Instruction_Id value, Register scratch)
+{
+	const Place *place = &coding->places[value];
+	return place->kind == Place_Kind_REGISTER ? place->reg : scratch;
+}
+
+// a memory operand at the address that the value holds
+static Memory get_address_memory(Coding *coding, Instruction_Id address, Register scratch)
+{
+	const Place *place = &coding->places[address];
+	switch (place->kind)
+	{
+	case Place_Kind_FRAME:
+		return memory_at(place->reg, place->offset);
+	case Place_Kind_SYMBOL:
+		return get_symbol_memory(place->symbol, place->offset);
+	default:
+		return memory_at(get_value_register(coding, address, scratch), 0);
+	}
+}
+
+struct Move
+{
+	Place destination;
+	Place source;
+};
+
+// the moves happen at once: none of them reads what another one writes. so they're ordered, and cycles are broken
+// through a temporary. sources that are made again rather than read go last, since they don't read anything.
+static void emit_parallel_moves(Coding *coding, Move *moves, U32 count)
+{
+	U32 read_count = 0;
+	for (U32 i = 0; i < count; ++i)
+	{
+		Place_Kind kind = moves[i].source.kind;
+		if (kind == Place_Kind_NONE || moves[i].destination.kind == Place_Kind_NONE ||
+		    check_places_equality(&moves[i].destination, &moves[i].source))
+			continue;
+		if (kind == Place_Kind_REGISTER || kind == Place_Kind_STACK)
+		{
+			Move move = moves[i];
+			moves[i] = moves[read_count];
+			moves[read_count++] = move;
+		}
+	}
+	U32 remaining = read_count;
+	while (remaining)
+	{
+		U32 ready = 0;
+		for (; ready < remaining; ++ready)
+		{
+			U32 j = 0;
+			while (j < remaining && (j == ready || !check_places_equality(&moves[j].source, &moves[ready].destination)))
+				++j;
+			if (j == remaining)
+				break;
+		}
+		if (ready < remaining)
+		{
+			emit_place_move(coding, &moves[ready].destination, &moves[ready].source);
+			moves[ready] = moves[--remaining];
+			continue;
+		}
+
+		// every destination is still to be read: it's a cycle
+		Place temporary = {};
+		temporary.kind = Place_Kind_REGISTER;
+		temporary.vector = moves[0].source.vector;
+		temporary.reg = temporary.vector ? Register_XMM15 : Register_R11;
+		Place source = moves[0].source;
+		emit_place_move(coding, &temporary, &source);
+		for (U32 j = 0; j < remaining; ++j)
+		{
+			if (check_places_equality(&moves[j].source, &source))
+				moves[j].source = temporary;
+		}
+	}
+	for (U32 i = read_count; i < count; ++i)
+	{
+		Place_Kind kind = moves[i].source.kind;
+		if (kind != Place_Kind_NONE && moves[i].destination.kind != Place_Kind_NONE &&
+		    kind != Place_Kind_REGISTER && kind != Place_Kind_STACK)
+			emit_place_move(coding, &moves[i].destination, &moves[i].source);
+	}
+}
+
+static bool check_vector_type(Type_Id type)
+{
+	return get_underlying_type(type)->kind == Type_Kind_FLOAT;
+}
+
+// whether the value needs a place of its own
+static bool check_allocated(const Instruction *instruction)
+{
+	switch (instruction->operation)
+	{
+	case Operation_NONE:
+	case Operation_CONSTANT:
+	case Operation_ADDRESS:
+	case Operation_LOCAL:
+		return false;
+	default:
+		return instruction->type != Type_Id_VOID;
+	}
+}
+
+// the live range of a value, from where it's defined to where it's last needed, in the order of the code. a value
+// that's live through a loop is live through all of it.
+struct Interval
+{
+	Instruction_Id value;
+	U32 start;
+	U32 end;
+};
+
+static void extend_interval(Interval *interval, U32 position)
+{
+	if (position < interval->start)
+		interval->start = position;
+	if (position > interval->end)
+		interval->end = position;
+}
+
+struct Liveness
+{
+	U32 words_count;  // of each set
+	U64 *live_outs;   // a set of values for each block
+	U64 *live_ins;
+	U32 *positions;   // of each instruction. phis are where their block starts, and parameters are before everything
+	U32 *block_ends;  // the position of each block's terminator
+	U32 *calls;       // the positions of the calls, in order
+	U32 calls_count;
+};
+
+static void add_to_set(U64 *set, U32 index)
+{
+	set[index / 64] |= (U64)1 << (index % 64);
+}
+
+static void remove_from_set(U64 *set, U32 index)
+{
+	set[index / 64] &= ~((U64)1 << (index % 64));
+}
+
+// the phis of the successor take the operands that come from the block
+static void add_phi_operands(const Procedure *procedure, Block_Id block, Block_Id successor, U64 *set)
+{
+	const Block *information = get_block(procedure, successor);
+	for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+	{
+		const Instruction *phi = get_instruction(procedure, get_block_instructions(information)[i]);
+		if (phi->operation != Operation_PHI)
+			break;
+		for (U32 j = 0; j < phi->operands_count && j < get_predecessors_count(information); ++j)
+		{
+			Instruction_Id operand = phi->operands[j];
+			if (get_predecessors(information)[j] == block && check_allocated(get_instruction(procedure, operand)))
+				add_to_set(set, operand);
+		}
+	}
+}
+
+// what's found is reserved from the arena
+static void analyze_liveness(Coding *coding, Liveness *liveness, Arena *arena)
+{
+	const Procedure *procedure = coding->procedure;
+	U32 blocks_count = get_blocks_count(procedure);
+	U32 instructions_count = get_instructions_count(procedure);
+	U32 words_count = (instructions_count + 63) / 64;
+	liveness->words_count = words_count;
+	liveness->live_outs = (U64 *)reserve_from_arena(arena, 2 * (Size)blocks_count * words_count * sizeof(U64), alignof(U64));
+	liveness->live_ins = liveness->live_outs + (Size)blocks_count * words_count;
+	set_memory(liveness->live_outs, 2 * (Size)blocks_count * words_count * sizeof(U64), 0);
+
+	// positions are even, and zero is where the parameters arrive
+	liveness->positions = (U32 *)reserve_from_arena(arena, instructions_count * sizeof(U32), alignof(U32));
+	liveness->block_ends = (U32 *)reserve_from_arena(arena, blocks_count * sizeof(U32), alignof(U32));
+	liveness->calls = (U32 *)reserve_from_arena(arena, instructions_count * sizeof(U32), alignof(U32));
+	liveness->calls_count = 0;
+	U32 position = 2;
+	for (U32 i = 0; i < coding->order_count; ++i)
+	{
+		Block_Id block = coding->order[i];
+		const Block *information = get_block(procedure, block);
+		U32 start = position;
+		for (U32 j = 0; j < get_block_instructions_count(information); ++j)
+		{
+			Instruction_Id id = get_block_instructions(information)[j];
+			const Instruction *instruction = get_instruction(procedure, id);
+			liveness->positions[id] = instruction->operation == Operation_PHI ? start :
+			                          instruction->operation == Operation_PARAMETER ? 0 : position;
+			if (instruction->operation == Operation_CALL)
+				liveness->calls[liveness->calls_count++] = position;
+			position += 2;
+		}
+		liveness->block_ends[block] = position - 2;
+	}
+
+	U64 *live = (U64 *)reserve_from_arena(arena, words_count * sizeof(U64), alignof(U64));
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (U32 i = coding->order_count; i--;)
+		{
+			Block_Id block = coding->order[i];
+			const Block *information = get_block(procedure, block);
+			set_memory(live, words_count * sizeof(U64), 0);
+			const Instruction *terminator = get_terminator(procedure, block);
+			for (U32 j = 0; j < get_successors_count(terminator); ++j)
+			{
+				Block_Id successor = get_successors(terminator)[j];
+				const U64 *successor_live_in = &liveness->live_ins[(Size)successor * words_count];
+				for (U32 k = 0; k < words_count; ++k)
+					live[k] |= successor_live_in[k];
+				add_phi_operands(procedure, block, successor, live);
+			}
+			copy_memory(&liveness->live_outs[(Size)block * words_count], live, words_count * sizeof(U64));
+			for (U32 j = get_block_instructions_count(information); j--;)
+			{
+				Instruction_Id id = get_block_instructions(information)[j];
+				const Instruction *instruction = get_instruction(procedure, id);
+				remove_from_set(live, id);
+				if (instruction->operation == Operation_PHI)
+					continue;
+				for (U32 k = 0; k < instruction->operands_count; ++k)
+				{
+					if (check_allocated(get_instruction(procedure, instruction->operands[k])))
+						add_to_set(live, instruction->operands[k]);
+				}
+			}
+			U64 *live_in = &liveness->live_ins[(Size)block * words_count];
+			if (compare_memory(live, live_in, words_count * sizeof(U64)))
+			{
+				copy_memory(live_in, live, words_count * sizeof(U64));
+				changed = true;
+			}
+		}
+	}
+}
+
+// whether a call happens while the value is live, so it can't be in a register that calls overwrite
+static bool check_crossing_call(const Liveness *liveness, const Interval *interval)
+{
+	const U32 *calls = liveness->calls;
+	U32 low = 0;
+	U32 high = liveness->calls_count;
+	while (low < high)
+	{
+		U32 middle = (low + high) / 2;
+		if (calls[middle] <= interval->start)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	return low < liveness->calls_count && calls[low] < interval->end;
+}
+
+// the values that are live at once get different registers. when there aren't enough, the value that's needed the
+// furthest away goes to the stack. values that are live across a call only get registers that calls preserve.
+static void allocate_registers(Coding *coding, const Liveness *liveness)
+{
+	const Procedure *procedure = coding->procedure;
+	U32 instructions_count = get_instructions_count(procedure);
+	Scratch scratch;
+	Interval *intervals = (Interval *)reserve_from_arena(scratch.arena, instructions_count * sizeof(Interval), alignof(Interval));
+	U32 intervals_count = 0;
+	U32 *interval_indices = (U32 *)reserve_from_arena(scratch.arena, instructions_count * sizeof(U32), alignof(U32));
+
+	// the values are met in the order of their definitions, so the intervals mostly come sorted by where they start
+	for (U32 i = 0; i < coding->order_count; ++i)
+	{
+		const Block *information = get_block(procedure, coding->order[i]);
+		for (U32 j = 0; j < get_block_instructions_count(information); ++j)
+		{
+			Instruction_Id id = get_block_instructions(information)[j];
+			if (!check_allocated(get_instruction(procedure, id)))
+				continue;
+			interval_indices[id] = intervals_count;
+			Interval *interval = &intervals[intervals_count++];
+			interval->value = id;
+			interval->start = liveness->positions[id];
+			interval->end = liveness->positions[id];
+		}
+	}
+	for (U32 i = 0; i < coding->order_count; ++i)
+	{
+		Block_Id block = coding->order[i];
+		const Block *information = get_block(procedure, block);
+		U32 block_end = liveness->block_ends[block];
+		const U64 *live_out = &liveness->live_outs[(Size)block * liveness->words_count];
+		for (U32 j = 0; j < liveness->words_count; ++j)
+		{
+			for (U64 word = live_out[j]; word; word &= word - 1)
+			{
+				Instruction_Id value = j * 64 + __builtin_ctzll(word);
+				extend_interval(&intervals[interval_indices[value]], block_end);
+			}
+		}
+		for (U32 j = 0; j < get_block_instructions_count(information); ++j)
+		{
+			Instruction_Id id = get_block_instructions(information)[j];
+			const Instruction *instruction = get_instruction(procedure, id);
+			if (instruction->operation == Operation_PHI)
+				continue;
+			for (U32 k = 0; k < instruction->operands_count; ++k)
+			{
+				if (check_allocated(get_instruction(procedure, instruction->operands[k])))
+					extend_interval(&intervals[interval_indices[instruction->operands[k]]], liveness->positions[id]);
+			}
+		}
+	}
+	for (U32 i = 1; i < intervals_count; ++i)
+	{
+		Interval interval = intervals[i];
+		U32 j = i;
+		for (; j && intervals[j - 1].start > interval.start; --j)
+			intervals[j] = intervals[j - 1];
+		intervals[j] = interval;
+	}
+
+	// the active intervals are sorted by where they end. an interval that ends where another starts is still
+	// active then, so an instruction's result never shares a register with its operands.
+	U32 *active = (U32 *)reserve_from_arena(scratch.arena, intervals_count * sizeof(U32), alignof(U32));
+	U32 active_count = 0;
+	U32 free_registers = 0;
+	for (Register reg : general_registers)
+		free_registers |= 1u << reg;
+	for (Register reg : vector_registers)
+		free_registers |= 1u << reg;
+	U32 used_registers = 0;
+	for (U32 i = 0; i < intervals_count; ++i)
+	{
+		Interval *interval = &intervals[i];
+		while (active_count && intervals[active[0]].end < interval->start)
+		{
+			free_registers |= 1u << coding->places[intervals[active[0]].value].reg;
+			move_memory(&active[0], &active[1], (active_count - 1) * sizeof(U32));
+			--active_count;
+		}
+
+		Place *place = &coding->places[interval->value];
+		bool vector = check_vector_type(get_instruction(procedure, interval->value)->type);
+		bool crossing = check_crossing_call(liveness, interval);
+		const Register *candidates = vector ? vector_registers : general_registers;
+		U32 candidates_count = vector ? sizeof(vector_registers) / sizeof(Register) : sizeof(general_registers) / sizeof(Register);
+		if (crossing && vector)
+			candidates_count = 0;
+
+		Register chosen = Register_NONE;
+		for (U32 j = 0; j < candidates_count && chosen == Register_NONE; ++j)
+		{
+			if ((free_registers >> candidates[j]) & 1 && (!crossing || check_callee_saved(candidates[j])))
+				chosen = candidates[j];
+		}
+		place->vector = vector;
+		if (chosen == Register_NONE)
+		{
+			// the active interval of the same class that ends last gives its register up if it ends later
+			U32 victim = active_count;
+			for (U32 j = active_count; j--;)
+			{
+				const Place *other = &coding->places[intervals[active[j]].value];
+				if (candidates_count && other->vector == vector && (!crossing || check_callee_saved(other->reg)))
+				{
+					victim = j;
+					break;
+				}
+			}
+			if (victim == active_count || intervals[active[victim]].end <= interval->end)
+			{
+				place->kind = Place_Kind_STACK;
+				continue;
+			}
+			Place *spilled = &coding->places[intervals[active[victim]].value];
+			chosen = spilled->reg;
+			spilled->kind = Place_Kind_STACK;
+			move_memory(&active[victim], &active[victim + 1], (active_count - victim - 1) * sizeof(U32));
+			--active_count;
+		}
+		else
+			free_registers &= ~(1u << chosen);
+		place->kind = Place_Kind_REGISTER;
+		place->reg = chosen;
+		used_registers |= 1u << chosen;
+		U32 j = active_count++;
+		for (; j && intervals[active[j - 1]].end > interval->end; --j)
+			active[j] = active[j - 1];
+		active[j] = i;
+	}
+
+	coding->saved_count = 0;
+	for (Register reg : general_registers)
+	{
+		if (check_callee_saved(reg) && ((used_registers >> reg) & 1))
+			coding->saved[coding->saved_count++] = reg;
+	}
+}
+
+// where the arguments of a call go: integers and addresses in the first six argument registers, floats in the first
+// eight vector registers, and the rest on the stack, eight bytes each, in order
+struct Argument_Assignment
+{
+	U32 generals_count;
+	U32 vectors_count;
+	U32 stack_count;
+};
+
+static Place assign_argument(Argument_Assignment *assignment, bool vector, Register stack_base, S64 stack_offset)
+{
+	Place place = {};
+	place.vector = vector;
+	if (vector && assignment->vectors_count < VECTOR_ARGUMENT_REGISTERS_COUNT)
+	{
+		place.kind = Place_Kind_REGISTER;
+		place.reg = (Register)(Register_XMM0 + assignment->vectors_count++);
+	}
+	else if (!vector && assignment->generals_count < sizeof(general_argument_registers) / sizeof(Register))
+	{
+		place.kind = Place_Kind_REGISTER;
+		place.reg = general_argument_registers[assignment->generals_count++];
+	}
+	else
+	{
+		place.kind = Place_Kind_STACK;
+		place.reg = stack_base;
+		place.offset = stack_offset + 8 * assignment->stack_count++;
+	}
+	return place;
+}
+
+// parameters that are passed in memory are passed by address
+static bool check_vector_parameter(const Procedure *procedure, U32 index)
+{
+	const Type *type = get_type(procedure->type);
+	return index < type->elements_count && !check_image(type->elements[index]) && check_vector_type(type->elements[index]);
+}
+
+// constants, addresses and stack slots are made where they're used, and the values that are left get registers or
+// stack slots. the frame has the callee-saved registers that are used on top, then the stack slots, and then the
+// arguments of calls that don't fit in registers.
+static void lay_out_frame(Coding *coding)
+{
+	const Procedure *procedure = coding->procedure;
+	Generation *generation = coding->generation;
+	U32 size = 8 * coding->saved_count;
+	U32 stack_arguments_count = 0;
+	for (U32 i = 0; i < coding->order_count; ++i)
+	{
+		const Block *information = get_block(procedure, coding->order[i]);
+		for (U32 j = 0; j < get_block_instructions_count(information); ++j)
+		{
+			Instruction_Id id = get_block_instructions(information)[j];
+			const Instruction *instruction = get_instruction(procedure, id);
+			Place *place = &coding->places[id];
+			switch (instruction->operation)
+			{
+			case Operation_CONSTANT:
+				place->kind = Place_Kind_CONSTANT;
+				place->vector = check_vector_type(instruction->type);
+				place->constant = instruction->constant;
+				break;
+			case Operation_ADDRESS:
+				place->kind = Place_Kind_SYMBOL;
+				if (instruction->address.artifact)
+					place->symbol = get_global_symbol(generation, instruction->address.artifact);
+				else if (instruction->address.procedure)
+					place->symbol = get_procedure_symbol(instruction->address.procedure);
+				else
+				{
+					place->symbol = get_section_symbol(Section_RODATA);
+					place->offset = (S64)get_data_offset(generation, instruction->address.data);
+				}
+				break;
+			case Operation_LOCAL:
+				size = (U32)align(size + instruction->slot.size, max(instruction->slot.alignment, 1));
+				place->kind = Place_Kind_FRAME;
+				place->reg = Register_RBP;
+				place->offset = -(S64)size;
+				break;
+			case Operation_CALL:
+				{
+					Argument_Assignment assignment = {};
+					for (U32 k = 1; k < instruction->operands_count; ++k)
+						assign_argument(&assignment, check_vector_type(get_instruction(procedure, instruction->operands[k])->type), Register_RSP, 0);
+					stack_arguments_count = (U32)max(stack_arguments_count, assignment.stack_count);
+				}
+				// fallthrough
+			default:
+				if (place->kind == Place_Kind_STACK)
+				{
+					size = (U32)align(size + 8, 8);
+					place->reg = Register_RBP;
+					place->offset = -(S64)size;
+				}
+				break;
+			}
+		}
+	}
+	U32 total = (U32)align(size + 8 * stack_arguments_count, 16);
+	coding->frame_size = total - 8 * coding->saved_count;
+}
+
+static void emit_epilogue(Coding *coding)
+{
+	if (coding->saved_count)
+	{
+		Memory saved = memory_at(Register_RBP, -8 * (S64)coding->saved_count);
+		emit_lea(coding, Register_RSP, &saved);
+		for (U32 i = coding->saved_count; i--;)
+			emit_pop(coding, coding->saved[i]);
+		emit_pop(coding, Register_RBP);
+	}
+	else
+		emit_byte(coding, 0xc9); // leave
+	emit_byte(coding, 0xc3);
+}
+
+// the phis of the successor get what they take from the block
+static void emit_edge_moves(Coding *coding, Block_Id block, Block_Id successor)
+{
+	const Procedure *procedure = coding->procedure;
+	const Block *information = get_block(procedure, successor);
+	Buffer moves = {};
+	for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+	{
+		Instruction_Id id = get_block_instructions(information)[i];
+		const Instruction *phi = get_instruction(procedure, id);
+		if (phi->operation != Operation_PHI)
+			break;
+		for (U32 j = 0; j < phi->operands_count && j < get_predecessors_count(information); ++j)
+		{
+			if (get_predecessors(information)[j] != block)
+				continue;
+			Move *move = (Move *)reserve_from_buffer(&moves, sizeof(Move), alignof(Move));
+			move->destination = coding->places[id];
+			move->source = coding->places[phi->operands[j]];
+			break;
+		}
+	}
+	emit_parallel_moves(coding, (Move *)moves.pointer, (U32)(moves.mass / sizeof(Move)));
+	uninitialize_buffer(&moves);
+}
+
+static bool check_edge_moves(const Coding *coding, Block_Id successor)
+{
+	const Block *information = get_block(coding->procedure, successor);
+	for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+	{
+		Instruction_Id id = get_block_instructions(information)[i];
+		if (get_instruction(coding->procedure, id)->operation != Operation_PHI)
+			break;
+		if (coding->places[id].kind != Place_Kind_NONE)
+			return true;
+	}
+	return false;
+}
+
+static Block_Id get_next_block(const Coding *coding, Block_Id block)
+{
+	U32 index = coding->block_orders[block] + 1;
+	return index < coding->order_count ? coding->order[index] : ~(Block_Id)0;
+}
+
+static void emit_edge(Coding *coding, Block_Id block, Block_Id successor)
+{
+	emit_edge_moves(coding, block, successor);
+	if (successor != get_next_block(coding, block))
+		emit_block_jump(coding, -1, successor);
+}
+
+static Memory offset_memory(Memory memory, S64 offset)
+{
+	memory.displacement += (int32_t)offset;
+	return memory;
+}
+
+// integers go from the low bytes of the register. what's converted to a boolean is whether it isn't zero.
+static void emit_conversion_normalization(Coding *coding, Register reg, Type_Id type)
+{
+	if (get_underlying_type(type)->kind == Type_Kind_BOOL)
+	{
+		encode_register(coding, encoding(0, true, 0x85), reg, reg); // test
+		emit_set(coding, Condition_Code_NOT_EQUAL, reg);
+		emit_extension(coding, reg, 1, false);
+	}
+	else
+		emit_normalization(coding, reg, type);
+}
+
+// the second operand of an arithmetic instruction on integers
+static void emit_arithmetic_operand(Coding *coding, Arithmetic arithmetic, Register destination, Instruction_Id value)
+{
+	const Place *place = &coding->places[value];
+	if (place->kind == Place_Kind_REGISTER)
+		emit_arithmetic(coding, arithmetic, destination, place->reg);
+	else if (place->kind == Place_Kind_STACK)
+	{
+		Memory memory = memory_at(place->reg, place->offset);
+		emit_arithmetic_memory(coding, arithmetic, destination, &memory);
+	}
+	else if (place->kind == Place_Kind_CONSTANT && check_s32((S64)place->constant))
+		emit_arithmetic_immediate(coding, arithmetic, destination, (int32_t)place->constant);
+	else
+	{
+		emit_place_load(coding, Register_RAX, place);
+		emit_arithmetic(coding, arithmetic, destination, Register_RAX);
+	}
+}
+
+// an instruction with an operand in a register (or an opcode extension), and one that's a register or in memory.
+// `scratch` holds the second if it's neither.
+static void emit_register_or_memory(Coding *coding, Encoding encoding, U8 reg, Instruction_Id value, Register scratch)
+{
+	const Place *place = &coding->places[value];
+	if (place->kind == Place_Kind_STACK)
+	{
+		Memory memory = memory_at(place->reg, place->offset);
+		encode_memory(coding, encoding, reg, &memory);
+	}
+	else
+		encode_register(coding, encoding, reg, get_value_register(coding, value, scratch));
+}
+
+static void emit_unary(Coding *coding, Instruction_Id id)
+{
+	const Instruction *instruction = get_instruction(coding->procedure, id);
+	Instruction_Id operand = instruction->operands[0];
+	if (check_vector_type(instruction->type))
+	{
+		// the sign bit is flipped in a general register
+		Register result = get_result_register(coding, id, Register_XMM15);
+		Register source = get_value_register(coding, operand, Register_XMM15);
+		encode_register(coding, encoding(0x66, true, 0x0f7e), source, Register_RAX); // movq rax, xmm
+		encode_register(coding, encoding(0, true, 0x0fba), 7, Register_RAX);       // btc rax, imm8
+		emit_byte(coding, get_underlying_type(instruction->type)->size == 4 ? 31 : 63);
+		encode_register(coding, encoding(0x66, true, 0x0f6e), result, Register_RAX); // movq xmm, rax
+		set_value(coding, id, result);
+		return;
+	}
+	Register result = get_result_register(coding, id, Register_R11);
+	emit_place_load(coding, result, &coding->places[operand]);
+	switch (instruction->operation)
+	{
+	case Operation_NEGATE:     encode_register(coding, encoding(0, true, 0xf7), 3, result); break;
+	case Operation_COMPLEMENT: encode_register(coding, encoding(0, true, 0xf7), 2, result); break;
+	default:                   emit_arithmetic_immediate(coding, Arithmetic_XOR, result, 1); break;
+	}
+	emit_normalization(coding, result, instruction->type);
+	set_value(coding, id, result);
+}
+
+static U64 emit_short_jump(Coding *coding, U8 opcode)
+{
+	emit_byte(coding, opcode);
+	emit_byte(coding, 0);
+	return get_code_offset(coding);
+}
+
+static void patch_short_jump(Coding *coding, U64 end)
+{
+	((U8 *)coding->code->pointer)[end - 1] = (U8)(get_code_offset(coding) - end);
+}
+
+
+static void emit_conversion(Coding *coding, Instruction_Id id)
+{
+	const Instruction *instruction = get_instruction(coding->procedure, id);
+	Instruction_Id operand = instruction->operands[0];
+	const Type *source_type = get_underlying_type(get_instruction(coding->procedure, operand)->type);
+	const Type *type = get_underlying_type(instruction->type);
+	bool from_float = source_type->kind == Type_Kind_FLOAT;
+	bool to_float = type->kind == Type_Kind_FLOAT;
+	U8 prefix = type->size == 4 ? 0xf3 : 0xf2;
+	if (from_float && to_float)
+	{
+		Register result = get_result_register(coding, id, Register_XMM15);
+		if (source_type->size == type->size)
+			emit_place_load(coding, result, &coding->places[operand]);
+		else
+			emit_register_or_memory(coding, encoding(source_type->size == 4 ? 0xf3 : 0xf2, false, 0x0f5a), result, operand, Register_XMM14); // cvtss2sd, cvtsd2ss
+		set_value(coding, id, result);
+	}
+	else if (to_float)
+	{
+		Register result = get_result_register(coding, id, Register_XMM15);
+		if (source_type->size == 8 && !source_type->is_signed)
+		{
+			// unsigned integers with the top bit set are halved, keeping the lowest bit for rounding, and doubled
+			emit_place_load(coding, Register_R11, &coding->places[operand]);
+			encode_register(coding, encoding(0, true, 0x85), Register_R11, Register_R11);
+			U64 large = emit_short_jump(coding, 0x78); // js
+			encode_register(coding, encoding(prefix, true, 0x0f2a), result, Register_R11);
+			U64 done = emit_short_jump(coding, 0xeb);
+			patch_short_jump(coding, large);
+			emit_move(coding, Register_RAX, Register_R11);
+			encode_register(coding, encoding(0, true, 0xd1), 5, Register_RAX); // shr rax, 1
+			emit_arithmetic_immediate(coding, Arithmetic_AND, Register_R11, 1);
+			emit_arithmetic(coding, Arithmetic_OR, Register_RAX, Register_R11);
+			encode_register(coding, encoding(prefix, true, 0x0f2a), result, Register_RAX);
+			encode_register(coding, encoding(prefix, false, 0x0f58), result, result);
+			patch_short_jump(coding, done);
+		}
+		else
+			emit_register_or_memory(coding, encoding(prefix, true, 0x0f2a), result, operand, Register_R11); // cvtsi2sd, cvtsi2ss
+		set_value(coding, id, result);
+	}
+	else if (from_float)
+	{
+		Register result = get_result_register(coding, id, Register_R11);
+		emit_register_or_memory(coding, encoding(source_type->size == 4 ? 0xf3 : 0xf2, true, 0x0f2c), result, operand, Register_XMM15); // cvttsd2si
+		emit_conversion_normalization(coding, result, instruction->type);
+		set_value(coding, id, result);
+	}
+	else
+	{
+		Register result = get_result_register(coding, id, Register_R11);
+		emit_place_load(coding, result, &coding->places[operand]);
+		emit_conversion_normalization(coding, result, instruction->type);
+		set_value(coding, id, result);
+	}
+}
+
+static void emit_binary(Coding *coding, Instruction_Id id)
+{
+	const Instruction *instruction = get_instruction(coding->procedure, id);
+	Instruction_Id a = instruction->operands[0];
+	Instruction_Id b = instruction->operands[1];
+	const Type *type = get_underlying_type(instruction->type);
+	if (type->kind == Type_Kind_FLOAT)
+	{
+		U32 opcode;
+		switch (instruction->operation)
+		{
+		case Operation_ADD:      opcode = 0x0f58; break;
+		case Operation_SUBTRACT: opcode = 0x0f5c; break;
+		case Operation_MULTIPLY: opcode = 0x0f59; break;
+		default:                 opcode = 0x0f5e; break;
+		}
+		Register result = get_result_register(coding, id, Register_XMM15);
+		emit_place_load(coding, result, &coding->places[a]);
+		emit_register_or_memory(coding, encoding(type->size == 4 ? 0xf3 : 0xf2, false, opcode), result, b, Register_XMM14);
+		set_value(coding, id, result);
+		return;
+	}
+
+	Register result;
+	switch (instruction->operation)
+	{
+	case Operation_DIVIDE:
+	case Operation_MODULO:
+		emit_place_load(coding, Register_RAX, &coding->places[a]);
+		if (type->is_signed)
+		{
+			emit_byte(coding, 0x48);
+			emit_byte(coding, 0x99); // cqo
+		}
+		else
+			encode_register(coding, encoding(0, false, 0x31), Register_RDX, Register_RDX);
+		emit_register_or_memory(coding, encoding(0, true, 0xf7), type->is_signed ? 7 : 6, b, Register_R11);
+		result = instruction->operation == Operation_DIVIDE ? Register_RAX : Register_RDX;
+		break;
+	case Operation_SHIFT_LEFT:
+	case Operation_SHIFT_RIGHT:
+		{
+			U8 extension = instruction->operation == Operation_SHIFT_LEFT ? 4 : type->is_signed ? 7 : 5;
+			result = get_result_register(coding, id, Register_R11);
+			const Place *amount = &coding->places[b];
+			if (amount->kind == Place_Kind_CONSTANT)
+			{
+				emit_place_load(coding, result, &coding->places[a]);
+				encode_register(coding, encoding(0, true, 0xc1), extension, result);
+				emit_byte(coding, (U8)(amount->constant & 63));
+			}
+			else
+			{
+				emit_place_load(coding, Register_RCX, amount);
+				emit_place_load(coding, result, &coding->places[a]);
+				encode_register(coding, encoding(0, true, 0xd3), extension, result);
+			}
+		}
+		break;
+	case Operation_MULTIPLY:
+		{
+			result = get_result_register(coding, id, Register_R11);
+			const Place *place = &coding->places[b];
+			if (place->kind == Place_Kind_CONSTANT && check_s32((S64)place->constant))
+			{
+				Register source = get_value_register(coding, a, result);
+				encode_register(coding, encoding(0, true, 0x69), result, source);
+				emit_u32(coding, (U32)place->constant);
+			}
+			else
+			{
+				emit_place_load(coding, result, &coding->places[a]);
+				emit_register_or_memory(coding, encoding(0, true, 0x0faf), result, b, Register_RAX);
+			}
+		}
+		break;
+	default:
+		{
+			Arithmetic arithmetic;
+			switch (instruction->operation)
+			{
+			case Operation_ADD:      arithmetic = Arithmetic_ADD; break;
+			case Operation_SUBTRACT: arithmetic = Arithmetic_SUB; break;
+			case Operation_AND:      arithmetic = Arithmetic_AND; break;
+			case Operation_OR:       arithmetic = Arithmetic_OR; break;
+			default:                 arithmetic = Arithmetic_XOR; break;
+			}
+			result = get_result_register(coding, id, Register_R11);
+			emit_place_load(coding, result, &coding->places[a]);
+			emit_arithmetic_operand(coding, arithmetic, result, b);
+		}
+		break;
+	}
+	emit_normalization(coding, result, instruction->type);
+	set_value(coding, id, result);
+}
+
+// comparisons of floats are unordered when either is a NaN, and then only `!=` holds
+static void emit_comparison(Coding *coding, Instruction_Id id)
+{
+	const Instruction *instruction = get_instruction(coding->procedure, id);
+	Instruction_Id a = instruction->operands[0];
+	Instruction_Id b = instruction->operands[1];
+	const Type *type = get_underlying_type(get_instruction(coding->procedure, a)->type);
+	Register result = get_result_register(coding, id, Register_R11);
+	Condition_Code condition;
+	if (type->kind == Type_Kind_FLOAT)
+	{
+		// `a < b` is `b > a`, which is false when they're unordered
+		bool swapped = instruction->operation == Operation_LESS || instruction->operation == Operation_LESS_EQUAL;
+		Register left = get_value_register(coding, swapped ? b : a, Register_XMM15);
+		emit_register_or_memory(coding, encoding(type->size == 4 ? 0 : 0x66, false, 0x0f2e), left, swapped ? a : b, Register_XMM14); // ucomis
+		switch (instruction->operation)
+		{
+		case Operation_EQUAL:
+		case Operation_NOT_EQUAL:
+			{
+				bool equal = instruction->operation == Operation_EQUAL;
+				emit_set(coding, equal ? Condition_Code_EQUAL : Condition_Code_NOT_EQUAL, result);
+				emit_set(coding, equal ? Condition_Code_NOT_PARITY : Condition_Code_PARITY, Register_RAX);
+				emit_extension(coding, result, 1, false);
+				emit_extension(coding, Register_RAX, 1, false);
+				emit_arithmetic(coding, equal ? Arithmetic_AND : Arithmetic_OR, result, Register_RAX);
+				set_value(coding, id, result);
+			}
+			return;
+		case Operation_LESS:
+		case Operation_GREATER:
+			condition = Condition_Code_ABOVE;
+			break;
+		default:
+			condition = Condition_Code_ABOVE_EQUAL;
+			break;
+		}
+	}
+	else
+	{
+		bool is_signed = type->is_signed;
+		switch (instruction->operation)
+		{
+		case Operation_EQUAL:         condition = Condition_Code_EQUAL; break;
+		case Operation_NOT_EQUAL:     condition = Condition_Code_NOT_EQUAL; break;
+		case Operation_LESS:          condition = is_signed ? Condition_Code_LESS : Condition_Code_BELOW; break;
+		case Operation_LESS_EQUAL:    condition = is_signed ? Condition_Code_LESS_EQUAL : Condition_Code_BELOW_EQUAL; break;
+		case Operation_GREATER:       condition = is_signed ? Condition_Code_GREATER : Condition_Code_ABOVE; break;
+		default:                      condition = is_signed ? Condition_Code_GREATER_EQUAL : Condition_Code_ABOVE_EQUAL; break;
+		}
+		Register left = get_value_register(coding, a, Register_R11);
+		emit_arithmetic_operand(coding, Arithmetic_CMP, left, b);
+	}
+	emit_set(coding, condition, result);
+	emit_extension(coding, result, 1, false);
+	set_value(coding, id, result);
+}
+
+static void emit_store_instruction(Coding *coding, Instruction_Id id)
+{
+	const Instruction *instruction = get_instruction(coding->procedure, id);
+	Instruction_Id value = instruction->operands[1];
+	const Type *type = get_underlying_type(get_instruction(coding->procedure, value)->type);
+	Memory memory = get_address_memory(coding, instruction->operands[0], Register_R11);
+	const Place *place = &coding->places[value];
+	if (type->kind != Type_Kind_FLOAT && place->kind == Place_Kind_CONSTANT && check_s32((S64)place->constant))
+	{
+		switch (type->size)
+		{
+		case 1:
+			encode_memory(coding, encoding(0, false, 0xc6), 0, &memory, 1);
+			emit_byte(coding, (U8)place->constant);
+			break;
+		case 2:
+			{
+				encode_memory(coding, encoding(0x66, false, 0xc7), 0, &memory, 2);
+				U8 bytes[2] = {(U8)place->constant, (U8)(place->constant >> 8)};
+				emit_bytes(coding, bytes, 2);
+			}
+			break;
+		default:
+			encode_memory(coding, encoding(0, type->size == 8, 0xc7), 0, &memory, 4);
+			emit_u32(coding, (U32)place->constant);
+			break;
+		}
+		return;
+	}
+	Register source = get_value_register(coding, value, type->kind == Type_Kind_FLOAT ? Register_XMM15 : Register_RAX);
+	emit_store(coding, &memory, source, type->size);
+}
+
+// small blocks of memory are copied eight bytes at a time and then the rest, and larger ones in a loop
+constexpr U32 MAXIMUM_UNROLLED_COPY_SIZE = 128;
+
+static void emit_memory_chunks(Coding *coding, Memory destination, const Memory *source, U32 size)
+{
+	for (U32 offset = 0, width = 8; offset < size; width /= 2)
+	{
+		for (; size - offset >= width; offset += width)
+		{
+			Memory to = offset_memory(destination, offset);
+			if (source)
+			{
+				Memory from = offset_memory(*source, offset);
+				emit_load(coding, Register_R11, &from, width, false);
+			}
+			emit_store(coding, &to, Register_R11, width);
+		}
+	}
+}
+
+static void emit_memory_operation(Coding *coding, Instruction_Id id)
+{
+	const Instruction *instruction = get_instruction(coding->procedure, id);
+	bool copy = instruction->operation == Operation_COPY_MEMORY;
+	U32 size = instruction->slot.size;
+	Memory destination = get_address_memory(coding, instruction->operands[0], Register_RDX);
+	Memory source = copy ? get_address_memory(coding, instruction->operands[1], Register_RCX) : Memory{};
+	if (!copy)
+		encode_register(coding, encoding(0, false, 0x31), Register_R11, Register_R11);
+	if (size <= MAXIMUM_UNROLLED_COPY_SIZE)
+	{
+		emit_memory_chunks(coding, destination, copy ? &source : 0, size);
+		return;
+	}
+	emit_lea(coding, Register_RDX, &destination);
+	if (copy)
+		emit_lea(coding, Register_RCX, &source);
+	emit_move_immediate(coding, Register_RAX, size / 8);
+	U64 loop = get_code_offset(coding);
+	Memory to = memory_at(Register_RDX, 0);
+	Memory from = memory_at(Register_RCX, 0);
+	if (copy)
+	{
+		emit_load(coding, Register_R11, &from, 8, false);
+		emit_arithmetic_immediate(coding, Arithmetic_ADD, Register_RCX, 8);
+	}
+	emit_store(coding, &to, Register_R11, 8);
+	emit_arithmetic_immediate(coding, Arithmetic_ADD, Register_RDX, 8);
+	emit_arithmetic_immediate(coding, Arithmetic_SUB, Register_RAX, 1);
+	patch_jump(coding, emit_jump_instruction(coding, Condition_Code_NOT_EQUAL), loop);
+	emit_memory_chunks(coding, to, copy ? &from : 0, size % 8);
+}
+
+// results that are returned in registers go in rax and then rdx, or in xmm0 and then xmm1 if they're floats
+static Register get_returned_register(const Type *results, U32 index)
+{
+	U32 vectors_count = 0;
+	for (U32 i = 0; i < index; ++i)
+		vectors_count += check_vector_type(results->elements[i]);
+	if (check_vector_type(results->elements[index]))
+		return (Register)(Register_XMM0 + vectors_count);
+	return index - vectors_count ? Register_RDX : Register_RAX;
+}
+
+// calls follow the System V convention, so external procedures can be written in C. the number of vector
+// registers that are used goes in al for variadic ones.
+static void emit_call(Coding *coding, Instruction_Id id)
+{
+	const Procedure *procedure = coding->procedure;
+	const Instruction *instruction = get_instruction(procedure, id);
+	const Instruction *callee = get_instruction(procedure, instruction->operands[0]);
+	const Procedure *target = callee->operation == Operation_ADDRESS ? callee->address.procedure : 0;
+
+	Scratch scratch;
+	Move *moves = (Move *)reserve_from_arena(scratch.arena, instruction->operands_count * sizeof(Move), alignof(Move));
+	Argument_Assignment assignment = {};
+	for (U32 i = 1; i < instruction->operands_count; ++i)
+	{
+		Instruction_Id argument = instruction->operands[i];
+		moves[i - 1].destination = assign_argument(&assignment, check_vector_type(get_instruction(procedure, argument)->type), Register_RSP, 0);
+		moves[i - 1].source = coding->places[argument];
+	}
+	U32 count = instruction->operands_count - 1;
+	if (!target)
+	{
+		moves[count].destination = {};
+		moves[count].destination.kind = Place_Kind_REGISTER;
+		moves[count].destination.reg = Register_R10;
+		moves[count].source = coding->places[instruction->operands[0]];
+		++count;
+	}
+	emit_parallel_moves(coding, moves, count);
+
+	if (!target || target->external)
+		emit_move_immediate(coding, Register_RAX, assignment.vectors_count);
+	if (target)
+	{
+		emit_byte(coding, 0xe8);
+		add_code_fixup(coding, Fixup_Kind_CALL, get_code_offset(coding), get_procedure_symbol(target), -4);
+		emit_u32(coding, 0);
+	}
+	else
+		encode_register(coding, encoding(0, false, 0xff), 2, Register_R10);
+
+	if (instruction->type == Type_Id_VOID)
+		return;
+
+	// the other results come right after the call, and they're all set at once
+	const Type *results = get_type(get_type(callee->type)->base);
+	Instruction_Id values[MAXIMUM_REGISTER_RESULTS_COUNT] = {id};
+	U32 values_count = 1;
+	if (results->elements_count > 1)
+	{
+		const Block *information = get_block(procedure, instruction->block);
+		const Instruction_Id *ids = get_block_instructions(information);
+		U32 position = 0;
+		while (ids[position] != id)
+			++position;
+		for (++position; position < get_block_instructions_count(information) && values_count < MAXIMUM_REGISTER_RESULTS_COUNT; ++position)
+		{
+			const Instruction *result = get_instruction(procedure, ids[position]);
+			if (result->operation != Operation_RESULT || result->operands[0] != id)
+				break;
+			values[values_count++] = ids[position];
+		}
+	}
+	Move result_moves[MAXIMUM_REGISTER_RESULTS_COUNT];
+	for (U32 i = 0; i < values_count; ++i)
+	{
+		const Instruction *value = get_instruction(procedure, values[i]);
+		Register reg = get_returned_register(results, i ? value->index : 0);
+		// C doesn't extend small results
+		if (!check_vector_register(reg))
+			emit_conversion_normalization(coding, reg, value->type);
+		result_moves[i].destination = coding->places[values[i]];
+		result_moves[i].source = {};
+		result_moves[i].source.kind = Place_Kind_REGISTER;
+		result_moves[i].source.reg = reg;
+		result_moves[i].source.vector = check_vector_register(reg);
+	}
+	emit_parallel_moves(coding, result_moves, values_count);
+}
+
+// the results go where the caller takes them from
+static void emit_return(Coding *coding, const Instruction *instruction)
+{
+	const Type *results = get_type(get_type(coding->procedure->type)->base);
+	Move moves[MAXIMUM_REGISTER_RESULTS_COUNT];
+	for (U32 i = 0; i < instruction->operands_count; ++i)
+	{
+		Register reg = get_returned_register(results, i);
+		moves[i].destination = {};
+		moves[i].destination.kind = Place_Kind_REGISTER;
+		moves[i].destination.reg = reg;
+		moves[i].destination.vector = check_vector_register(reg);
+		moves[i].source = coding->places[instruction->operands[i]];
+	}
+	emit_parallel_moves(coding, moves, instruction->operands_count);
+	emit_epilogue(coding);
+}
+
+static void emit_branch_instruction(Coding *coding, Block_Id block, const Instruction *instruction)
+{
+	Block_Id then_block = instruction->targets[0];
+	Block_Id else_block = instruction->targets[1];
+	const Place *condition = &coding->places[instruction->operands[0]];
+	if (condition->kind == Place_Kind_CONSTANT)
+	{
+		emit_edge(coding, block, condition->constant ? then_block : else_block);
+		return;
+	}
+	if (condition->kind == Place_Kind_REGISTER)
+		encode_register(coding, encoding(0, true, 0x85), condition->reg, condition->reg);
+	else
+	{
+		Memory memory = memory_at(condition->reg, condition->offset);
+		encode_memory(coding, encoding(0, false, 0x80), Arithmetic_CMP, &memory, 1);
+		emit_byte(coding, 0);
+	}
+
+	Block_Id next = get_next_block(coding, block);
+	if (!check_edge_moves(coding, then_block) && !check_edge_moves(coding, else_block))
+	{
+		if (then_block == next)
+			emit_block_jump(coding, Condition_Code_EQUAL, else_block);
+		else
+		{
+			emit_block_jump(coding, Condition_Code_NOT_EQUAL, then_block);
+			if (else_block != next)
+				emit_block_jump(coding, -1, else_block);
+		}
+		return;
+	}
+
+	// the moves of each edge are on their own path
+	U64 otherwise = emit_jump_instruction(coding, Condition_Code_EQUAL);
+	emit_edge_moves(coding, block, then_block);
+	emit_block_jump(coding, -1, then_block);
+	patch_jump(coding, otherwise, get_code_offset(coding));
+	emit_edge(coding, block, else_block);
+}
+
+// switches try the values of their cases in a binary search, whose ranges that are dense enough jump through a table
+// of where their targets are, relative to the table
+constexpr U32 MAXIMUM_LINEAR_CASES_COUNT = 3;
+
+// a field that holds where one of the targets of a switch is
+struct Switch_Landing
+{
+	U64 offset;
+	U64 base;
+	U32 target;
+};
+
+struct Switch_Coding
+{
+	Register subject;
+	bool is_signed;
+	Buffer landings;
+};
+
+static void add_switch_landing(Switch_Coding *switching, U64 offset, U64 base, U32 target)
+{
+	Switch_Landing *landing = (Switch_Landing *)reserve_from_buffer(&switching->landings, sizeof(Switch_Landing), alignof(Switch_Landing));
+	landing->offset = offset;
+	landing->base = base;
+	landing->target = target;
+}
+
+static void emit_switch_jump(Coding *coding, Switch_Coding *switching, int condition, U32 target)
+{
+	U64 offset = emit_jump_instruction(coding, condition);
+	add_switch_landing(switching, offset, offset + 4, target);
+}
+
+static void emit_case_comparison(Coding *coding, Register subject, U64 value)
+{
+	if (check_s32((S64)value))
+		emit_arithmetic_immediate(coding, Arithmetic_CMP, subject, (int32_t)value);
+	else
+	{
+		emit_move_immediate(coding, Register_RAX, value);
+		emit_arithmetic(coding, Arithmetic_CMP, subject, Register_RAX);
+	}
+}
+
+static void emit_switch_table(Coding *coding, Switch_Coding *switching, const Switch_Case *cases, U32 count)
+{
+	// the subject goes from the first value, so values below it wrap around to above the range
+	U64 range = get_cases_range(cases, count);
+	emit_move(coding, Register_RAX, switching->subject);
+	if (check_s32((S64)cases[0].value))
+	{
+		if (cases[0].value)
+			emit_arithmetic_immediate(coding, Arithmetic_SUB, Register_RAX, (int32_t)cases[0].value);
+	}
+	else
+	{
+		emit_move_immediate(coding, Register_RDX, cases[0].value);
+		emit_arithmetic(coding, Arithmetic_SUB, Register_RAX, Register_RDX);
+	}
+	emit_case_comparison(coding, Register_RAX, range);
+	emit_switch_jump(coding, switching, Condition_Code_ABOVE_EQUAL, 0);
+
+	static const U8 load_table[] = {0x48, 0x8d, 0x15};          // lea rdx, [rip + table]
+	static const U8 load_entry[] = {0x48, 0x63, 0x04, 0x82};    // movsxd rax, dword [rdx + rax * 4]
+	static const U8 jump[] = {0xff, 0xe0};                      // jmp rax
+	emit_bytes(coding, load_table, sizeof(load_table));
+	U64 table_field = get_code_offset(coding);
+	emit_u32(coding, 0);
+	emit_bytes(coding, load_entry, sizeof(load_entry));
+	emit_arithmetic(coding, Arithmetic_ADD, Register_RAX, Register_RDX);
+	emit_bytes(coding, jump, sizeof(jump));
+	while (get_code_offset(coding) % 4)
+		emit_byte(coding, 0xcc);
+
+	U64 table = get_code_offset(coding);
+	patch_jump(coding, table_field, table);
+	for (U32 i = 0; i < count; ++i)
+	{
+		// the values that no case has go to the default
+		for (U64 value = cases[0].value + (get_code_offset(coding) - table) / 4; value != cases[i].value; ++value)
+		{
+			add_switch_landing(switching, get_code_offset(coding), table, 0);
+			emit_u32(coding, 0);
+		}
+		add_switch_landing(switching, get_code_offset(coding), table, cases[i].target);
+		emit_u32(coding, 0);
+	}
+}
+
+static void emit_case_dispatch(Coding *coding, Switch_Coding *switching, const Switch_Case *cases, U32 count)
+{
+	if (check_table_density(cases, count))
+	{
+		emit_switch_table(coding, switching, cases, count);
+		return;
+	}
+	if (count <= MAXIMUM_LINEAR_CASES_COUNT)
+	{
+		for (U32 i = 0; i < count; ++i)
+		{
+			emit_case_comparison(coding, switching->subject, cases[i].value);
+			emit_switch_jump(coding, switching, Condition_Code_EQUAL, cases[i].target);
+		}
+		emit_switch_jump(coding, switching, -1, 0);
+		return;
+	}
+	U32 middle = count / 2;
+	emit_case_comparison(coding, switching->subject, cases[middle].value);
+	U64 below = emit_jump_instruction(coding, switching->is_signed ? Condition_Code_LESS : Condition_Code_BELOW);
+	emit_case_dispatch(coding, switching, cases + middle, count - middle);
+	patch_jump(coding, below, get_code_offset(coding));
+	emit_case_dispatch(coding, switching, cases, middle);
+}
+
+// with a profile, the case target that took most of the runs of the switch, if there's one, or else zero
+static U32 find_hot_switch_target(const Coding *coding, Block_Id block, const Instruction *instruction)
+{
+	const Procedure *procedure = coding->procedure;
+	U64 frequency = get_block(procedure, block)->frequency;
+	for (U32 i = 1; frequency > 1 && i < instruction->table.targets_count; ++i)
+	{
+		const Block *target = get_block(procedure, instruction->table.targets[i]);
+		if (get_predecessors_count(target) == 1 && target->frequency && (target->frequency - 1) * 2 > frequency - 1)
+			return i;
+	}
+	return 0;
+}
+
+static void emit_switch(Coding *coding, Block_Id block, const Instruction *instruction)
+{
+	Instruction_Id subject = instruction->operands[0];
+	Switch_Coding switching = {};
+	switching.subject = get_value_register(coding, subject, Register_R11);
+	switching.is_signed = get_underlying_type(get_instruction(coding->procedure, subject)->type)->is_signed;
+
+	// the values of the hot target are compared first, and the rest are dispatched as if it had none
+	const Switch_Case *cases = instruction->table.cases;
+	U32 cases_count = instruction->table.cases_count;
+	Scratch scratch;
+	U32 hot = find_hot_switch_target(coding, block, instruction);
+	U32 hot_count = 0;
+	for (U32 i = 0; hot && i < instruction->table.cases_count; ++i)
+		hot_count += instruction->table.cases[i].target == hot;
+	if (hot_count && hot_count <= MAXIMUM_LINEAR_CASES_COUNT)
+	{
+		Switch_Case *rest = (Switch_Case *)reserve_from_arena(scratch.arena, cases_count * sizeof(Switch_Case), alignof(Switch_Case));
+		cases_count = 0;
+		for (U32 i = 0; i < instruction->table.cases_count; ++i)
+		{
+			const Switch_Case *item = &instruction->table.cases[i];
+			if (item->target != hot)
+				rest[cases_count++] = *item;
+			else
+			{
+				emit_case_comparison(coding, switching.subject, item->value);
+				emit_switch_jump(coding, &switching, Condition_Code_EQUAL, hot);
+			}
+		}
+		cases = rest;
+	}
+	emit_case_dispatch(coding, &switching, cases, cases_count);
+
+	// the moves of each edge are on their own path
+	const Block_Id *targets = instruction->table.targets;
+	U64 *paths = (U64 *)reserve_from_arena(scratch.arena, instruction->table.targets_count * sizeof(U64), alignof(U64));
+	for (U32 i = 0; i < instruction->table.targets_count; ++i)
+	{
+		paths[i] = ~(U64)0;
+		if (!check_edge_moves(coding, targets[i]))
+			continue;
+		paths[i] = get_code_offset(coding);
+		emit_edge_moves(coding, block, targets[i]);
+		emit_block_jump(coding, -1, targets[i]);
+	}
+	const Switch_Landing *landings = (const Switch_Landing *)switching.landings.pointer;
+	for (U32 i = 0; i < switching.landings.mass / sizeof(Switch_Landing); ++i)
+	{
+		const Switch_Landing *landing = &landings[i];
+		if (paths[landing->target] != ~(U64)0)
+			patch_u32(coding, landing->offset, (U32)(int32_t)(paths[landing->target] - landing->base));
+		else
+			add_jump_fixup(coding, landing->offset, landing->base, targets[landing->target]);
+	}
+	uninitialize_buffer(&switching.landings);
+}
+
+static void emit_instruction(Coding *coding, Block_Id block, Instruction_Id id)
+{
+	const Instruction *instruction = get_instruction(coding->procedure, id);
+	switch (instruction->operation)
+	{
+	case Operation_COPY:
+		emit_place_move(coding, &coding->places[id], &coding->places[instruction->operands[0]]);
+		break;
+	case Operation_NEGATE:
+	case Operation_NOT:
+	case Operation_COMPLEMENT:
+		emit_unary(coding, id);
+		break;
+	case Operation_CONVERT:
+		emit_conversion(coding, id);
+		break;
+	case Operation_LOAD:
+		{
+			const Type *type = get_underlying_type(instruction->type);
+			Register result = get_result_register(coding, id, type->kind == Type_Kind_FLOAT ? Register_XMM15 : Register_R11);
+			Memory memory = get_address_memory(coding, instruction->operands[0], Register_R11);
+			emit_load(coding, result, &memory, type->size, type->is_signed);
+			set_value(coding, id, result);
+		}
+		break;
+	case Operation_ADD:
+	case Operation_SUBTRACT:
+	case Operation_MULTIPLY:
+	case Operation_DIVIDE:
+	case Operation_MODULO:
+	case Operation_AND:
+	case Operation_OR:
+	case Operation_XOR:
+	case Operation_SHIFT_LEFT:
+	case Operation_SHIFT_RIGHT:
+		emit_binary(coding, id);
+		break;
+	case Operation_EQUAL:
+	case Operation_NOT_EQUAL:
+	case Operation_LESS:
+	case Operation_LESS_EQUAL:
+	case Operation_GREATER:
+	case Operation_GREATER_EQUAL:
+		emit_comparison(coding, id);
+		break;
+	case Operation_STORE:
+		emit_store_instruction(coding, id);
+		break;
+	case Operation_COPY_MEMORY:
+	case Operation_ZERO_MEMORY:
+		emit_memory_operation(coding, id);
+		break;
+	case Operation_CALL:
+		emit_call(coding, id);
+		break;
+	case Operation_JUMP:
+		emit_edge(coding, block, instruction->targets[0]);
+		break;
+	case Operation_BRANCH:
+		emit_branch_instruction(coding, block, instruction);
+		break;
+	case Operation_SWITCH:
+		emit_switch(coding, block, instruction);
+		break;
+	case Operation_RETURN:
+		emit_return(coding, instruction);
+		break;
+	default:
+		// constants, addresses, stack slots, parameters and phis are where they're used, and calls set their results
+		break;
+	}
+}
+
+// `_start` is entered with the stack aligned to 16 bytes rather than to 8, since nothing calls it
+static bool check_entry(const Procedure *procedure)
+{
+	if (!procedure->artifact || procedure->artifact->scope)
+		return false;
+	String name = get_identifier_string(procedure->artifact->name);
+	return name.size == 6 && !compare_memory(name.pointer, "_start", 6);
+}
+
+// procedures are generated on all processors, each into code and fixups of its own, which are put together in the
+// order of the procedures once they're all done. what procedures share is made beforehand, in that order too: the
+// symbols of the globals they use, and the read-only data of their constants. nothing is added to it while they're
+// generated, so they only look it up, and the output is the same however many threads there are.
+struct Procedure_Code
+{
+	Buffer code;
+	Buffer fixups; // of `Fixup`, at offsets in `code`
+};
+
+struct Generation_Work
+{
+	Generation *generation;
+	Procedure_Code *codes; // of each procedure
+	Size next_procedure_index;
+};
+
+static void prepare_procedure_generation(Generation *generation, const Procedure *procedure)
+{
+	for (Instruction_Id id = 1; id < get_instructions_count(procedure); ++id)
+	{
+		const Instruction *instruction = get_instruction(procedure, id);
+		if (instruction->operation == Operation_ADDRESS && instruction->address.artifact)
+			get_global_symbol(generation, instruction->address.artifact);
+		else if (instruction->operation == Operation_ADDRESS && !instruction->address.procedure && instruction->address.data)
+			get_data_offset(generation, instruction->address.data);
+		else if (instruction->operation == Operation_CONSTANT && check_vector_type(instruction->type) && instruction->constant)
+			get_float_offset(generation, instruction->constant);
+	}
+}
+
+// with a profile, the blocks that never ran go after those that did, in the same order, so the code that runs is
+// together. every value still comes after what it's made from, since a block that ran can't depend on one that didn't.
+// the places of the values don't depend on the order, which only decides what falls through to what.
+static void place_cold_blocks_last(Coding *coding)
+{
+	const Procedure *procedure = coding->procedure;
+	if (check_cold_block(procedure, 0) || !get_block(procedure, 0)->frequency)
+		return;
+	Scratch scratch;
+	Block_Id *order = (Block_Id *)reserve_from_arena(scratch.arena, coding->order_count * sizeof(Block_Id), alignof(Block_Id));
+	U32 count = 0;
+	for (U32 pass = 0; pass < 2; ++pass)
+	{
+		for (U32 i = 0; i < coding->order_count; ++i)
+		{
+			if (check_cold_block(procedure, coding->order[i]) == (pass == 1))
+				order[count++] = coding->order[i];
+		}
+	}
+	for (U32 i = 0; i < count; ++i)
+	{
+		coding->order[i] = order[i];
+		coding->block_orders[order[i]] = i;
+	}
+}
+
+static void generate_procedure(Generation *generation, const Procedure *procedure, Procedure_Code *result)
+{
+	Coding coding = {};
+	coding.generation = generation;
+	coding.procedure = procedure;
+	coding.code = &result->code;
+	coding.fixups = &result->fixups;
+
+	Scratch scratch;
+	Dominators dominators;
+	find_dominators(procedure, &dominators, scratch.arena);
+	coding.order = dominators.order;
+	coding.order_count = dominators.count;
+	coding.block_orders = dominators.indices;
+	U32 instructions_count = get_instructions_count(procedure);
+	coding.places = (Place *)reserve_from_arena(scratch.arena, instructions_count * sizeof(Place), alignof(Place));
+	set_memory(coding.places, instructions_count * sizeof(Place), 0);
+	coding.block_offsets = (U32 *)reserve_from_arena(scratch.arena, get_blocks_count(procedure) * sizeof(U32), alignof(U32));
+
+	// the liveness is only needed until the registers are allocated
+	{
+		Scratch analysis(scratch.arena);
+		Liveness liveness = {};
+		analyze_liveness(&coding, &liveness, analysis.arena);
+		allocate_registers(&coding, &liveness);
+	}
+	lay_out_frame(&coding);
+	place_cold_blocks_last(&coding);
+
+	emit_push(&coding, Register_RBP);
+	emit_move(&coding, Register_RBP, Register_RSP);
+	for (U32 i = 0; i < coding.saved_count; ++i)
+		emit_push(&coding, coding.saved[i]);
+	if (coding.frame_size)
+		emit_arithmetic_immediate(&coding, Arithmetic_SUB, Register_RSP, (int32_t)coding.frame_size);
+	if (check_entry(procedure))
+		emit_arithmetic_immediate(&coding, Arithmetic_AND, Register_RSP, -16);
+
+	// the parameters go from where they arrive to where they're kept
+	Argument_Assignment assignment = {};
+	Place *arrivals = (Place *)reserve_from_arena(scratch.arena, procedure->parameters_count * sizeof(Place), alignof(Place));
+	for (U32 i = 0; i < procedure->parameters_count; ++i)
+		arrivals[i] = assign_argument(&assignment, check_vector_parameter(procedure, i), Register_RBP, 16);
+	U32 moves_count = 0;
+	for (Instruction_Id id = 1; id < instructions_count; ++id)
+	{
+		const Instruction *instruction = get_instruction(procedure, id);
+		moves_count += instruction->operation == Operation_PARAMETER && instruction->index < procedure->parameters_count;
+	}
+	Move *moves = (Move *)reserve_from_arena(scratch.arena, moves_count * sizeof(Move), alignof(Move));
+	moves_count = 0;
+	for (Instruction_Id id = 1; id < instructions_count; ++id)
+	{
+		const Instruction *instruction = get_instruction(procedure, id);
+		if (instruction->operation != Operation_PARAMETER || instruction->index >= procedure->parameters_count)
+			continue;
+		Move *move = &moves[moves_count++];
+		move->destination = coding.places[id];
+		move->source = arrivals[instruction->index];
+	}
+	emit_parallel_moves(&coding, moves, moves_count);
+
+	for (U32 i = 0; i < coding.order_count; ++i)
+	{
+		Block_Id block = coding.order[i];
+		coding.block_offsets[block] = (U32)get_code_offset(&coding);
+		const Block *information = get_block(procedure, block);
+		for (U32 j = 0; j < get_block_instructions_count(information); ++j)
+			emit_instruction(&coding, block, get_block_instructions(information)[j]);
+	}
+	const Jump_Fixup *jumps = (const Jump_Fixup *)coding.jumps.pointer;
+	for (Size i = 0; i < coding.jumps.mass / sizeof(Jump_Fixup); ++i)
+		patch_u32(&coding, jumps[i].offset, (U32)(int32_t)(coding.block_offsets[jumps[i].target] - jumps[i].base));
+
+	uninitialize_buffer(&coding.jumps);
+}
+
+static bool check_generated(const Procedure *procedure)
+{
+	return !procedure->external && get_instructions_count(procedure);
+}
+
+static void *generate_procedures(void *input)
+{
+	Generation_Work *work = (Generation_Work *)input;
+	const Program *program = work->generation->program;
+	for (;;)
+	{
+		Size index = __atomic_fetch_add(&work->next_procedure_index, 1, __ATOMIC_RELAXED);
+		if (index >= get_list_count(&program->procedures))
+			break;
+		const Procedure *procedure = get_list_item(&program->procedures, index);
+		if (check_generated(procedure))
+			generate_procedure(work->generation, procedure, &work->codes[index]);
+	}
+	return 0;
+}
+
+static void generate_program_code(Generation *generation)
+{
+	const Program *program = generation->program;
+	Size count = get_list_count(&program->procedures);
+	for (Size i = 0; i < count; ++i)
+	{
+		const Procedure *procedure = get_list_item(&program->procedures, i);
+		if (check_generated(procedure))
+			prepare_procedure_generation(generation, procedure);
+	}
+
+	Generation_Work work = {};
+	work.generation = generation;
+	work.codes = (Procedure_Code *)allocate(max(count, 1) * sizeof(Procedure_Code));
+	set_memory(work.codes, count * sizeof(Procedure_Code), 0);
+	Size threads_count = min(get_processors_count(), count);
+	Thread *threads = (Thread *)allocate(max(threads_count, 1) * sizeof(Thread));
+	Size created_threads_count = 0;
+	for (Size i = 1; i < threads_count; ++i)
+	{
+		if (!create_thread(&threads[created_threads_count], generate_procedures, &work))
+			break;
+		++created_threads_count;
+	}
+	generate_procedures(&work);
+	for (Size i = 0; i < created_threads_count; ++i)
+		join_thread(threads[i]);
+	deallocate(threads);
+
+	// each procedure starts on 16 bytes, and its fixups move with it. with a profile, those that never ran go last.
+	Buffer *text = &generation->sections[Section_TEXT];
+	for (Size i = 0; i < 2 * count; ++i)
+	{
+		const Procedure *procedure = get_list_item(&program->procedures, i % count);
+		Procedure_Code *code = &work.codes[i % count];
+		if (check_generated(procedure) && check_cold_block(procedure, 0) == (i >= count))
+		{
+			if (Size padding = get_alignment_addition(text->mass, 16))
+				set_memory(reserve_from_buffer(text, padding, 1), padding, 0xcc);
+			Object_Symbol *symbol = get_object_symbol(generation, get_procedure_symbol(procedure));
+			symbol->offset = text->mass;
+			symbol->size = code->code.mass;
+			copy_memory(reserve_from_buffer(text, code->code.mass, 1), code->code.pointer, code->code.mass);
+			for (Size j = 0; j < code->fixups.mass / sizeof(Fixup); ++j)
+			{
+				Fixup *fixup = (Fixup *)reserve_from_buffer(&generation->fixups, sizeof(Fixup), alignof(Fixup));
+				*fixup = ((const Fixup *)code->fixups.pointer)[j];
+				fixup->offset += symbol->offset;
+			}
+		}
+	}
+	for (Size i = 0; i < count; ++i)
+	{
+		uninitialize_buffer(&work.codes[i].code);
+		uninitialize_buffer(&work.codes[i].fixups);
+	}
+	deallocate(work.codes);
+}
+
+
+static void add_to_string_table(Buffer *table, String string)
+{
+	U8 *pointer = (U8 *)reserve_from_buffer(table, string.size + 1, 1);
+	copy_memory(pointer, string.pointer, string.size);
+	pointer[string.size] = 0;
+}
+
+static const char *const section_names[Section_COUNT] = {"", ".text", ".rodata", ".data", ".bss"};
+
+// a static executable: the headers and the code are in one segment, then the read-only data gets its own, and the
+// data and the bss the last. each starts on a page, where its addresses are.
+constexpr U64 EXECUTABLE_BASE_ADDRESS = 0x400000;
+constexpr U64 SEGMENT_ALIGNMENT = 0x1000;
+
+static bool write_executable(Generation *generation, Handle handle)
+{
+	const Buffer *sections = generation->sections;
+	U64 offsets[Section_COUNT] = {};
+	U32 headers_count = 2 + (sections[Section_RODATA].mass != 0) + (sections[Section_DATA].mass || sections[Section_BSS].mass);
+	offsets[Section_TEXT] = align(sizeof(Elf64_Ehdr) + headers_count * sizeof(Elf64_Phdr), 16);
+	offsets[Section_RODATA] = align(offsets[Section_TEXT] + sections[Section_TEXT].mass, SEGMENT_ALIGNMENT);
+	offsets[Section_DATA] = align(offsets[Section_RODATA] + sections[Section_RODATA].mass, SEGMENT_ALIGNMENT);
+	offsets[Section_BSS] = align(offsets[Section_DATA] + sections[Section_DATA].mass, 16);
+	Size size = offsets[Section_DATA] + sections[Section_DATA].mass;
+
+	Arena arena;
+	initialize_arena(&arena, size);
+	U8 *image = (U8 *)reserve_from_arena(&arena, size, 16);
+	for (U32 section = Section_TEXT; section < Section_BSS; ++section)
+	{
+		if (sections[section].mass)
+			copy_memory(image + offsets[section], sections[section].pointer, sections[section].mass);
+	}
+
+	const Object_Symbol *symbols = (const Object_Symbol *)generation->symbols.pointer;
+	const Fixup *fixups = (const Fixup *)generation->fixups.pointer;
+	for (Size i = 0; i < generation->fixups.mass / sizeof(Fixup); ++i)
+	{
+		const Fixup *fixup = &fixups[i];
+		const Object_Symbol *symbol = &symbols[fixup->symbol];
+		U64 target = EXECUTABLE_BASE_ADDRESS + offsets[symbol->section] + symbol->offset + fixup->addend;
+		U64 field = EXECUTABLE_BASE_ADDRESS + offsets[fixup->section] + fixup->offset;
+		if (fixup->kind == Fixup_Kind_ABSOLUTE)
+			copy_memory(image + offsets[fixup->section] + fixup->offset, &target, 8);
+		else
+		{
+			U32 relative = (U32)(int32_t)(target - field);
+			copy_memory(image + offsets[fixup->section] + fixup->offset, &relative, 4);
+		}
+	}
+
+	Elf64_Ehdr *header = (Elf64_Ehdr *)image;
+	copy_memory(header->e_ident, ELFMAG, SELFMAG);
+	header->e_ident[EI_CLASS] = ELFCLASS64;
+	header->e_ident[EI_DATA] = ELFDATA2LSB;
+	header->e_ident[EI_VERSION] = EV_CURRENT;
+	header->e_ident[EI_OSABI] = ELFOSABI_SYSV;
+	header->e_type = ET_EXEC;
+	header->e_machine = EM_X86_64;
+	header->e_version = EV_CURRENT;
+	header->e_entry = EXECUTABLE_BASE_ADDRESS + offsets[Section_TEXT];
+	header->e_phoff = sizeof(Elf64_Ehdr);
+	header->e_ehsize = sizeof(Elf64_Ehdr);
+	header->e_phentsize = sizeof(Elf64_Phdr);
+	header->e_phnum = headers_count;
+	header->e_shentsize = sizeof(Elf64_Shdr);
+
+	Elf64_Phdr *segment = (Elf64_Phdr *)(image + sizeof(Elf64_Ehdr));
+	segment->p_type = PT_LOAD;
+	segment->p_flags = PF_R | PF_X;
+	segment->p_vaddr = segment->p_paddr = EXECUTABLE_BASE_ADDRESS;
+	segment->p_filesz = segment->p_memsz = offsets[Section_TEXT] + sections[Section_TEXT].mass;
+	segment->p_align = SEGMENT_ALIGNMENT;
+	++segment;
+	if (sections[Section_RODATA].mass)
+	{
+		segment->p_type = PT_LOAD;
+		segment->p_flags = PF_R;
+		segment->p_offset = offsets[Section_RODATA];
+		segment->p_vaddr = segment->p_paddr = EXECUTABLE_BASE_ADDRESS + offsets[Section_RODATA];
+		segment->p_filesz = segment->p_memsz = sections[Section_RODATA].mass;
+		segment->p_align = SEGMENT_ALIGNMENT;
+		++segment;
+	}
+	if (sections[Section_DATA].mass || sections[Section_BSS].mass)
+	{
+		segment->p_type = PT_LOAD;
+		segment->p_flags = PF_R | PF_W;
+		segment->p_offset = offsets[Section_DATA];
+		segment->p_vaddr = segment->p_paddr = EXECUTABLE_BASE_ADDRESS + offsets[Section_DATA];
+		segment->p_filesz = sections[Section_DATA].mass;
+		segment->p_memsz = offsets[Section_BSS] + sections[Section_BSS].mass - offsets[Section_DATA];
+		segment->p_align = SEGMENT_ALIGNMENT;
+		++segment;
+	}
+	segment->p_type = PT_GNU_STACK;
+	segment->p_flags = PF_R | PF_W;
+
+	bool written = write_file(handle, image, size);
+	uninitialize_arena(&arena);
+	return written;
+}
+
+// sections of a relocatable object, after the null one and those of `Section`
+enum : U32
+{
+	OBJECT_SECTION_SYMBOLS = Section_COUNT,
+	OBJECT_SECTION_STRINGS,
+	OBJECT_SECTION_TEXT_RELOCATIONS,
+	OBJECT_SECTION_RODATA_RELOCATIONS,
+	OBJECT_SECTION_DATA_RELOCATIONS,
+	OBJECT_SECTION_SECTION_NAMES,
+	OBJECT_SECTION_STACK_NOTE,
+
+	OBJECT_SECTIONS_COUNT,
+};
+
+// a relocatable object for a linker. local symbols come before global ones, as the format wants.
+static bool write_object(Generation *generation, Handle handle)
+{
+	const Buffer *sections = generation->sections;
+	const Object_Symbol *symbols = (const Object_Symbol *)generation->symbols.pointer;
+	U32 symbols_count = (U32)(generation->symbols.mass / sizeof(Object_Symbol));
+
+	U32 *indices = (U32 *)allocate(max(symbols_count, 1) * sizeof(U32));
+	U32 index = 1;
+	for (int global = 0; global < 2; ++global)
+	{
+		for (U32 i = 0; i < symbols_count; ++i)
+		{
+			if (symbols[i].global == (bool)global)
+				indices[i] = index++;
+		}
+	}
+	U32 first_global = 1;
+	for (U32 i = 0; i < symbols_count; ++i)
+		first_global += !symbols[i].global;
+
+	Buffer strings = {};
+	add_to_string_table(&strings, {(const Utf8 *)"", 0});
+	Buffer symbol_table = {};
+	set_memory(reserve_from_buffer(&symbol_table, sizeof(Elf64_Sym), 8), sizeof(Elf64_Sym), 0);
+	set_memory(reserve_from_buffer(&symbol_table, symbols_count * sizeof(Elf64_Sym), 8), symbols_count * sizeof(Elf64_Sym), 0);
+	for (U32 i = 0; i < symbols_count; ++i)
+	{
+		const Object_Symbol *symbol = &symbols[i];
+		Elf64_Sym *entry = &((Elf64_Sym *)symbol_table.pointer)[indices[i]];
+		if (i < Section_COUNT - 1)
+		{
+			entry->st_info = ELF64_ST_INFO(STB_LOCAL, STT_SECTION);
+			entry->st_shndx = symbol->section;
+			continue;
+		}
+		entry->st_name = (U32)strings.mass;
+		add_to_string_table(&strings, symbol->name);
+		entry->st_info = ELF64_ST_INFO(symbol->global ? STB_GLOBAL : STB_LOCAL,
+		                               symbol->section == Section_NONE ? STT_NOTYPE : symbol->function ? STT_FUNC : STT_OBJECT);
+		entry->st_shndx = symbol->section == Section_NONE ? SHN_UNDEF : symbol->section;
+		entry->st_value = symbol->offset;
+		entry->st_size = symbol->size;
+	}
+
+	Buffer relocations[Section_COUNT] = {};
+	const Fixup *fixups = (const Fixup *)generation->fixups.pointer;
+	for (Size i = 0; i < generation->fixups.mass / sizeof(Fixup); ++i)
+	{
+		const Fixup *fixup = &fixups[i];
+		Elf64_Rela *relocation = (Elf64_Rela *)reserve_from_buffer(&relocations[fixup->section], sizeof(Elf64_Rela), 8);
+		U32 type = fixup->kind == Fixup_Kind_ABSOLUTE ? R_X86_64_64 : fixup->kind == Fixup_Kind_CALL ? R_X86_64_PLT32 : R_X86_64_PC32;
+		relocation->r_offset = fixup->offset;
+		relocation->r_info = ELF64_R_INFO(indices[fixup->symbol], type);
+		relocation->r_addend = fixup->addend;
+	}
+
+	Buffer section_names_table = {};
+	U32 name_offsets[OBJECT_SECTIONS_COUNT] = {};
+	const char *names[OBJECT_SECTIONS_COUNT] = {"", ".text", ".rodata", ".data", ".bss", ".symtab", ".strtab", ".rela.text",
+	                                            ".rela.rodata", ".rela.data", ".shstrtab", ".note.GNU-stack"};
+	for (U32 i = 0; i < OBJECT_SECTIONS_COUNT; ++i)
+	{
+		name_offsets[i] = (U32)section_names_table.mass;
+		add_to_string_table(&section_names_table, {(const Utf8 *)names[i], get_length_of_string(names[i])});
+	}
+
+	// the contents, in the order of the sections
+	const Buffer *contents[OBJECT_SECTIONS_COUNT] = {0, &sections[Section_TEXT], &sections[Section_RODATA], &sections[Section_DATA], 0,
+	                                                 &symbol_table, &strings, &relocations[Section_TEXT],
+	                                                 &relocations[Section_RODATA], &relocations[Section_DATA], &section_names_table, 0};
+	U64 offsets[OBJECT_SECTIONS_COUNT] = {};
+	U64 size = sizeof(Elf64_Ehdr);
+	for (U32 i = 0; i < OBJECT_SECTIONS_COUNT; ++i)
+	{
+		offsets[i] = size = align(size, 16);
+		if (contents[i])
+			size += contents[i]->mass;
+	}
+	U64 headers_offset = align(size, 8);
+	size = headers_offset + OBJECT_SECTIONS_COUNT * sizeof(Elf64_Shdr);
+
+	Arena arena;
+	initialize_arena(&arena, size);
+	U8 *image = (U8 *)reserve_from_arena(&arena, size, 16);
+	for (U32 i = 0; i < OBJECT_SECTIONS_COUNT; ++i)
+	{
+		if (contents[i] && contents[i]->mass)
+			copy_memory(image + offsets[i], contents[i]->pointer, contents[i]->mass);
+	}
+
+	Elf64_Ehdr *header = (Elf64_Ehdr *)image;
+	copy_memory(header->e_ident, ELFMAG, SELFMAG);
+	header->e_ident[EI_CLASS] = ELFCLASS64;
+	header->e_ident[EI_DATA] = ELFDATA2LSB;
+	header->e_ident[EI_VERSION] = EV_CURRENT;
+	header->e_ident[EI_OSABI] = ELFOSABI_SYSV;
+	header->e_type = ET_REL;
+	header->e_machine = EM_X86_64;
+	header->e_version = EV_CURRENT;
+	header->e_shoff = headers_offset;
+	header->e_ehsize = sizeof(Elf64_Ehdr);
+	header->e_shentsize = sizeof(Elf64_Shdr);
+	header->e_shnum = OBJECT_SECTIONS_COUNT;
+	header->e_shstrndx = OBJECT_SECTION_SECTION_NAMES;
+
+	Elf64_Shdr *headers = (Elf64_Shdr *)(image + headers_offset);
+	for (U32 i = 1; i < OBJECT_SECTIONS_COUNT; ++i)
+	{
+		Elf64_Shdr *section = &headers[i];
+		section->sh_name = name_offsets[i];
+		section->sh_offset = offsets[i];
+		section->sh_size = contents[i] ? contents[i]->mass : 0;
+		section->sh_addralign = 1;
+		switch (i)
+		{
+		case Section_TEXT:
+			section->sh_type = SHT_PROGBITS;
+			section->sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+			section->sh_addralign = 16;
+			break;
+		case Section_RODATA:
+		case Section_DATA:
+			section->sh_type = SHT_PROGBITS;
+			section->sh_flags = SHF_ALLOC | (i == Section_DATA ? SHF_WRITE : 0);
+			section->sh_addralign = 16;
+			break;
+		case Section_BSS:
+			section->sh_type = SHT_NOBITS;
+			section->sh_flags = SHF_ALLOC | SHF_WRITE;
+			section->sh_size = sections[Section_BSS].mass;
+			section->sh_addralign = 16;
+			break;
+		case OBJECT_SECTION_SYMBOLS:
+			section->sh_type = SHT_SYMTAB;
+			section->sh_link = OBJECT_SECTION_STRINGS;
+			section->sh_info = first_global;
+			section->sh_entsize = sizeof(Elf64_Sym);
+			section->sh_addralign = 8;
+			break;
+		case OBJECT_SECTION_STRINGS:
+		case OBJECT_SECTION_SECTION_NAMES:
+			section->sh_type = SHT_STRTAB;
+			break;
+		case OBJECT_SECTION_TEXT_RELOCATIONS:
+		case OBJECT_SECTION_RODATA_RELOCATIONS:
+		case OBJECT_SECTION_DATA_RELOCATIONS:
+			section->sh_type = SHT_RELA;
+			section->sh_flags = SHF_INFO_LINK;
+			section->sh_link = OBJECT_SECTION_SYMBOLS;
+			section->sh_info = Section_TEXT + (i - OBJECT_SECTION_TEXT_RELOCATIONS);
+			section->sh_entsize = sizeof(Elf64_Rela);
+			section->sh_addralign = 8;
+			break;
+		default:
+			section->sh_type = SHT_PROGBITS;
+			break;
+		}
+	}
+
+	bool written = write_file(handle, image, size);
+	uninitialize_arena(&arena);
+	for (Buffer &buffer : relocations)
+		uninitialize_buffer(&buffer);
+	uninitialize_buffer(&section_names_table);
+	uninitialize_buffer(&symbol_table);
+	uninitialize_buffer(&strings);
+	deallocate(indices);
+	return written;
+}
+
+// `wika_write_profile` writes the profile of an instrumented program: the header, and then the counters. it only
+// makes system calls, and nothing is reported if the file can't be opened.
+static void emit_profile_writer(Generation *generation, U32 symbol)
+{
+	const Program *program = generation->program;
+	Coding coding = {};
+	coding.generation = generation;
+	coding.code = &generation->sections[Section_TEXT];
+	coding.fixups = &generation->fixups;
+	while (get_code_offset(&coding) % 16)
+		emit_byte(&coding, 0xcc);
+	Object_Symbol *information = get_object_symbol(generation, symbol);
+	information->offset = get_code_offset(&coding);
+
+	Size path_size = get_length_of_string(program->profile_path) + 1;
+	U64 path_offset = reserve_from_section(generation, Section_RODATA, path_size, 1);
+	copy_memory((U8 *)generation->sections[Section_RODATA].pointer + path_offset, program->profile_path, path_size);
+	U64 header_offset = reserve_from_section(generation, Section_RODATA, program->profile_header.size, 8);
+	copy_memory((U8 *)generation->sections[Section_RODATA].pointer + header_offset, program->profile_header.pointer, program->profile_header.size);
+
+	Memory path = get_symbol_memory(get_section_symbol(Section_RODATA), (S64)path_offset);
+	emit_move_immediate(&coding, Register_RAX, 2); // open
+	emit_lea(&coding, Register_RDI, &path);
+	emit_move_immediate(&coding, Register_RSI, O_WRONLY | O_CREAT | O_TRUNC);
+	emit_move_immediate(&coding, Register_RDX, 0644);
+	emit_byte(&coding, 0x0f);
+	emit_byte(&coding, 0x05);
+	encode_register(&coding, encoding(0, true, 0x85), Register_RAX, Register_RAX); // test
+	U64 failed = emit_short_jump(&coding, 0x78); // js
+	emit_move(&coding, Register_RDI, Register_RAX);
+
+	Memory header = get_symbol_memory(get_section_symbol(Section_RODATA), (S64)header_offset);
+	Memory counters = get_symbol_memory(get_global_symbol(generation, program->profile_counters), 0);
+	const Memory *parts[] = {&header, &counters};
+	U64 sizes[] = {program->profile_header.size, get_type(program->profile_counters->type)->size};
+	for (U32 i = 0; i < 2; ++i)
+	{
+		emit_move_immediate(&coding, Register_RAX, 1); // write
+		emit_lea(&coding, Register_RSI, parts[i]);
+		emit_move_immediate(&coding, Register_RDX, sizes[i]);
+		emit_byte(&coding, 0x0f);
+		emit_byte(&coding, 0x05);
+	}
+	emit_move_immediate(&coding, Register_RAX, 3); // close
+	emit_byte(&coding, 0x0f);
+	emit_byte(&coding, 0x05);
+	patch_short_jump(&coding, failed);
+	emit_byte(&coding, 0xc3);
+	information->size = get_code_offset(&coding) - information->offset;
+}
+
+bool generate_program(const Program *program, const char *path, bool object)
+{
+	Generation generation = {};
+	generation.program = program;
+	initialize_arena(&generation.names, 64);
+
+	// the symbols of the procedures come first, so they're where `get_procedure_symbol` says
+	for (Section section = Section_TEXT; section < Section_COUNT; section = (Section)(section + 1))
+		add_object_symbol(&generation, {(const Utf8 *)section_names[section], get_length_of_string(section_names[section])}, section, false);
+	const Procedure *entry = 0;
+	bool external = false;
+	for (Size i = 0; i < get_list_count(&program->procedures); ++i)
+	{
+		const Procedure *procedure = get_list_item(&program->procedures, i);
+		assert(get_procedure_symbol(procedure) == generation.symbols.mass / sizeof(Object_Symbol));
+		bool global = procedure->external || (procedure->artifact && !procedure->artifact->scope);
+		U32 symbol = add_object_symbol(&generation, name_object_symbol(&generation, procedure->artifact, get_procedure_symbol(procedure)),
+		                               procedure->external ? Section_NONE : Section_TEXT, global);
+		get_object_symbol(&generation, symbol)->function = true;
+		if (check_entry(procedure))
+			entry = procedure;
+		if (procedure->external)
+			external = true;
+	}
+	U32 profile_writer = 0;
+	if (program->profile_counters)
+	{
+		profile_writer = add_object_symbol(&generation, {(const Utf8 *)"wika_write_profile", 18}, Section_TEXT, true);
+		get_object_symbol(&generation, profile_writer)->function = true;
+	}
+
+	bool result = true;
+	if (!object && external)
+	{
+		report_error("a program with external procedures can only be compiled into an object (--object): %s.", path);
+		result = false;
+	}
+	else if (!object && !entry)
+	{
+		report_error("an executable needs a `_start` procedure to enter: %s.", path);
+		result = false;
+	}
+	else
+	{
+		// the executable is entered at a stub that calls `_start` and exits with what it returns, if it's an integer
+		if (!object)
+		{
+			Coding coding = {};
+			coding.generation = &generation;
+			coding.code = &generation.sections[Section_TEXT];
+			coding.fixups = &generation.fixups;
+			emit_byte(&coding, 0xe8);
+			add_code_fixup(&coding, Fixup_Kind_CALL, get_code_offset(&coding), get_procedure_symbol(entry), -4);
+			emit_u32(&coding, 0);
+			const Type *results = get_type(get_type(entry->type)->base);
+			if (results->elements_count && check_register_results(get_type(entry->type)->base) && !check_vector_type(results->elements[0]))
+				encode_register(&coding, encoding(0, false, 0x89), Register_RAX, Register_RDI);
+			else
+				encode_register(&coding, encoding(0, false, 0x31), Register_RDI, Register_RDI);
+			if (profile_writer)
+			{
+				// the exit code is kept on the stack across the call
+				emit_push(&coding, Register_RDI);
+				emit_byte(&coding, 0xe8);
+				add_code_fixup(&coding, Fixup_Kind_CALL, get_code_offset(&coding), profile_writer, -4);
+				emit_u32(&coding, 0);
+				emit_pop(&coding, Register_RDI);
+			}
+			emit_move_immediate(&coding, Register_RAX, 231); // exit_group
+			emit_byte(&coding, 0x0f);
+			emit_byte(&coding, 0x05);
+		}
+		pool_read_only_data(&generation);
+		generate_program_code(&generation);
+		if (profile_writer)
+			emit_profile_writer(&generation, profile_writer);
+
+		Handle handle;
+		result = create_file(&handle, path, !object);
+		if (result)
+		{
+			result = object ? write_object(&generation, handle) : write_executable(&generation, handle);
+			close_file(handle);
+		}
+	}
+
+	for (Buffer &section : generation.sections)
+		uninitialize_buffer(&section);
+	uninitialize_buffer(&generation.symbols);
+	uninitialize_buffer(&generation.fixups);
+	uninitialize_map(&generation.globals);
+	uninitialize_map(&generation.datas);
+	uninitialize_map(&generation.images);
+	uninitialize_map(&generation.floats);
+	uninitialize_arena(&generation.names);
+	return result;
+}
+
+// C generation
+
+// the program can also be written as C, one translation unit for each source, so that a C compiler can optimize it
+// further or compile it for another target. values are variables, blocks are labels that are gone to, and memory is
+// bytes that are read and written with `memcpy`. an image is a structure of its bytes and of the addresses in it.
+
+static const char c_prelude[] =
+	"#include <stdint.h>\n"
+	"#include <string.h>\n"
+	"\n"
+	"typedef void (*w_procedure)(void);\n"
+	"\n"
+	"#if defined(__GNUC__)\n"
+	"#define W_ALIGNED(pointer, alignment) __builtin_assume_aligned(pointer, alignment)\n"
+	"#else\n"
+	"#define W_ALIGNED(pointer, alignment) (pointer)\n"
+	"#endif\n"
+	"\n"
+	"static inline float w_f32(uint32_t bits) { float value; memcpy(&value, &bits, 4); return value; }\n"
+	"static inline double w_f64(uint64_t bits) { double value; memcpy(&value, &bits, 8); return value; }\n"
+	"\n";
+
+// the C types of scalars, and what they're called in the names of the structures of results
+static const struct
+{
+	const char *name;
+	const char *abbreviation;
+}
+c_scalars[] =
+{
+	{"uint8_t", "u8"}, {"uint16_t", "u16"}, {"uint32_t", "u32"}, {"uint64_t", "u64"},
+	{"int8_t", "s8"}, {"int16_t", "s16"}, {"int32_t", "s32"}, {"int64_t", "s64"},
+	{"float", "f32"}, {"double", "f64"}, {"uint8_t *", "p"}, {"w_procedure", "f"},
+};
+
+constexpr U32 C_SCALARS_COUNT = sizeof(c_scalars) / sizeof(c_scalars[0]);
+
+static U32 get_c_scalar(Type_Id type)
+{
+	const Type *information = get_underlying_type(type);
+	switch (information->kind)
+	{
+	case Type_Kind_INTEGER:   return (information->is_signed ? 4 : 0) + __builtin_ctz(information->size);
+	case Type_Kind_FLOAT:     return information->size == 4 ? 8 : 9;
+	case Type_Kind_POINTER:   return 10;
+	case Type_Kind_PROCEDURE: return 11;
+	case Type_Kind_TYPE:      return 2;
+	default:                  return check_image(type) ? 10 : 0;
+	}
+}
+
+static const char *get_c_type(Type_Id type)
+{
+	return c_scalars[get_c_scalar(type)].name;
+}
+
+[[gnu::format(printf, 2, 3)]]
+static void write_c(Buffer *buffer, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	va_list measuring;
+	va_copy(measuring, args);
+	Size size = (Size)vsnprintf(0, 0, format, measuring);
+	va_end(measuring);
+	char *pointer = (char *)reserve_from_buffer(buffer, size + 1, 1);
+	vsnprintf(pointer, size + 1, format, args);
+	va_end(args);
+	buffer->mass -= 1;
+}
+
+// globals keep their names, with `g_` before them so they don't take those of C. what's declared in a procedure gets
+// its index appended, since its name may be taken.
+struct C_Global
+{
+	Artifact *artifact;
+	const Source *source; // it's defined in
+	String name;
+};
+
+struct C_Generation
+{
+	const Program *program;
+	Buffer globals;      // of `C_Global`
+	Index_Map artifacts; // to their indices in `globals`
+	Arena names;
+};
+
+// a translation unit, which is written in parts, since what's used is declared before it
+struct C_Unit
+{
+	C_Generation *generation;
+	const Source *source;
+	Buffer declarations;
+	Buffer data;
+	Buffer code;
+	Index_Map declared; // procedures, globals and read-only data, to the numbers of the read-only data
+	U32 datas_count;
+	bool pairs[C_SCALARS_COUNT][C_SCALARS_COUNT]; // the structures of two results that are returned
+	const U8 *values; // how each value of the procedure that's being written is used, as `C_Value` flags
+};
+
+// only what's used is written, so the C compiles without warnings about what's set but not used
+enum C_Value : U8
+{
+	C_Value_WRITTEN = 1,      // something with side effects depends on it
+	C_Value_READ = 2,         // its variable is read
+	C_Value_RESULTS_READ = 4, // a call's other results are read
+};
+
+// an address in an image
+struct C_Address
+{
+	U32 offset;
+	Artifact *artifact;
+	const Procedure *procedure;
+	const Relocation *data; // if neither of the others is set; the address is null if this isn't either
+};
+
+static C_Global *get_c_global(C_Generation *generation, const Artifact *artifact)
+{
+	const U64 *index = find_in_map(&generation->artifacts, (U64)(Address)artifact);
+	assert(index);
+	return &((C_Global *)generation->globals.pointer)[*index - 1];
+}
+
+static void add_c_global(C_Generation *generation, Artifact *artifact);
+
+static void add_c_relocation_globals(C_Generation *generation, const Relocation *relocations)
+{
+	for (const Relocation *relocation = relocations; relocation; relocation = relocation->next)
+	{
+		if (relocation->artifact)
+			add_c_global(generation, relocation->artifact);
+		else if (!relocation->procedure)
+			add_c_relocation_globals(generation, relocation->relocations);
+	}
+}
+
+static void add_c_global(C_Generation *generation, Artifact *artifact)
+{
+	U64 *slot = insert_into_map(&generation->artifacts, (U64)(Address)artifact);
+	if (*slot)
+		return;
+	Size index = generation->globals.mass / sizeof(C_Global);
+	*slot = index + 1;
+	C_Global *global = (C_Global *)reserve_from_buffer(&generation->globals, sizeof(C_Global), alignof(C_Global));
+	global->artifact = artifact;
+	global->source = find_source(artifact->span.beginning);
+	String name = get_identifier_string(artifact->name);
+	char *buffer = (char *)reserve_from_arena(&generation->names, name.size + 32, 1);
+	Size size = artifact->scope ? format(buffer, name.size + 32, "g_%.*s_%lu", (int)name.size, name.pointer, index)
+	                            : format(buffer, name.size + 32, "g_%.*s", (int)name.size, name.pointer);
+	global->name = {(const Utf8 *)buffer, size};
+	if (artifact->value.type != Type_Id_NONE)
+		add_c_relocation_globals(generation, artifact->value.relocations);
+}
+
+static void gather_c_addresses(const Program *program, Buffer *addresses, const Relocation *relocations)
+{
+	for (const Relocation *relocation = relocations; relocation; relocation = relocation->next)
+	{
+		C_Address *address = (C_Address *)reserve_from_buffer(addresses, sizeof(C_Address), alignof(C_Address));
+		*address = {};
+		address->offset = relocation->offset;
+		if (relocation->artifact)
+			address->artifact = relocation->artifact;
+		else if (relocation->procedure)
+		{
+			const U64 *procedure = find_in_map(&program->procedures_by_node, (U64)(Address)relocation->procedure);
+			if (procedure)
+				address->procedure = (const Procedure *)(Address)*procedure;
+		}
+		else
+			address->data = relocation;
+	}
+
+	// they're placed in order
+	C_Address *items = (C_Address *)addresses->pointer;
+	U32 count = (U32)(addresses->mass / sizeof(C_Address));
+	for (U32 i = 1; i < count; ++i)
+	{
+		C_Address key = items[i];
+		U32 j = i;
+		for (; j && items[j - 1].offset > key.offset; --j)
+			items[j] = items[j - 1];
+		items[j] = key;
+	}
+}
+
+static void write_c_procedure_name(Buffer *buffer, const Procedure *procedure)
+{
+	String name = procedure->artifact ? get_identifier_string(procedure->artifact->name) : String{(const Utf8 *)"proc", 4};
+	if (procedure->external)
+		write_c(buffer, "%.*s", (int)name.size, name.pointer);
+	else if (procedure->artifact && !procedure->artifact->scope)
+		write_c(buffer, "w_%.*s", (int)name.size, name.pointer);
+	else
+		write_c(buffer, "w_%.*s_%lu", (int)name.size, name.pointer, procedure->index);
+}
+
+// the C type of what a procedure of the type returns. two results are returned in a structure.
+static void write_c_results(C_Unit *unit, Buffer *buffer, Type_Id procedure_type)
+{
+	Type_Id results = get_type(procedure_type)->base;
+	const Type *type = get_type(results);
+	if (!check_register_results(results) || !type->elements_count)
+		write_c(buffer, "void");
+	else if (type->elements_count == 1)
+		write_c(buffer, "%s", get_c_type(type->elements[0]));
+	else
+	{
+		U32 first = get_c_scalar(type->elements[0]);
+		U32 second = get_c_scalar(type->elements[1]);
+		unit->pairs[first][second] = true;
+		write_c(buffer, "struct w_results_%s_%s", c_scalars[first].abbreviation, c_scalars[second].abbreviation);
+	}
+}
+
+// what's in memory is passed by the address of a copy, and so is where the results go if they aren't returned, so
+// nothing else points into them
+static void write_c_parameters(Buffer *buffer, Type_Id procedure_type, bool named)
+{
+	const Type *type = get_type(procedure_type);
+	U32 count = type->elements_count + !check_register_results(type->base);
+	write_c(buffer, "(");
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (i)
+			write_c(buffer, ", ");
+		if (i == type->elements_count || check_image(type->elements[i]))
+			write_c(buffer, "uint8_t *restrict");
+		else
+			write_c(buffer, "%s", get_c_type(type->elements[i]));
+		if (named)
+			write_c(buffer, " a%u", i);
+	}
+	write_c(buffer, count ? ")" : "void)");
+}
+
+static void declare_c_procedure(C_Unit *unit, const Procedure *procedure)
+{
+	U64 *slot = insert_into_map(&unit->declared, (U64)(Address)procedure);
+	if (*slot)
+		return;
+	*slot = 1;
+	write_c_results(unit, &unit->declarations, procedure->type);
+	write_c(&unit->declarations, " ");
+	write_c_procedure_name(&unit->declarations, procedure);
+	write_c_parameters(&unit->declarations, procedure->type, false);
+	write_c(&unit->declarations, ";\n");
+}
+
+static void write_c_image_type(Buffer *buffer, String name, Size size, const C_Address *addresses, U32 count)
+{
+	write_c(buffer, "struct %.*s_image\n{\n", (int)name.size, name.pointer);
+	Size offset = 0;
+	for (U32 i = 0; i <= count; ++i)
+	{
+		Size end = i < count ? addresses[i].offset : size;
+		if (end > offset)
+			write_c(buffer, "\tuint8_t b%lu[%lu];\n", offset, end - offset);
+		if (i == count)
+			break;
+		write_c(buffer, "\tvoid *r%lu;\n", end);
+		offset = end + 8;
+	}
+	if (!size)
+		write_c(buffer, "\tuint8_t b0[1];\n");
+	write_c(buffer, "};\n");
+}
+
+static U32 declare_c_data(C_Unit *unit, const Relocation *data);
+static const C_Global *declare_c_global(C_Unit *unit, Artifact *artifact);
+
+// what the addresses in an image point to is declared before the image is written
+static void declare_c_addresses(C_Unit *unit, const C_Address *addresses, U32 count)
+{
+	for (U32 i = 0; i < count; ++i)
+	{
+		if (addresses[i].artifact)
+			declare_c_global(unit, addresses[i].artifact);
+		else if (addresses[i].procedure)
+			declare_c_procedure(unit, addresses[i].procedure);
+		else if (addresses[i].data)
+			declare_c_data(unit, addresses[i].data);
+	}
+}
+
+// `bytes` is null if they're all zeros
+static void write_c_image_value(C_Unit *unit, Buffer *buffer, const U8 *bytes, Size size, const C_Address *addresses, U32 count)
+{
+	write_c(buffer, " =\n{");
+	Size offset = 0;
+	for (U32 i = 0; i <= count; ++i)
+	{
+		Size end = i < count ? addresses[i].offset : size;
+		if (end > offset)
+		{
+			bool zero = true;
+			for (Size j = offset; bytes && j < end; ++j)
+				zero &= !bytes[j];
+			if (zero)
+				write_c(buffer, "\n\t{0},");
+			else
+			{
+				write_c(buffer, "\n\t{");
+				for (Size j = offset; j < end; ++j)
+					write_c(buffer, "%s%s%u", j == offset ? "" : ",", (j - offset) % 16 ? " " : "\n\t\t", bytes[j]);
+				write_c(buffer, "\n\t},");
+			}
+		}
+		if (i == count)
+			break;
+		const C_Address *address = &addresses[i];
+		if (address->artifact)
+		{
+			String name = get_c_global(unit->generation, address->artifact)->name;
+			write_c(buffer, "\n\t(void *)&%.*s,", (int)name.size, name.pointer);
+		}
+		else if (address->procedure)
+		{
+			write_c(buffer, "\n\t(void *)");
+			write_c_procedure_name(buffer, address->procedure);
+			write_c(buffer, ",");
+		}
+		else if (address->data)
+			write_c(buffer, "\n\t(void *)&d%u,", declare_c_data(unit, address->data));
+		else
+			write_c(buffer, "\n\t0,");
+		offset = end + 8;
+	}
+	write_c(buffer, "\n}");
+}
+
+// read-only data is written into each unit that uses it
+static U32 declare_c_data(C_Unit *unit, const Relocation *data)
+{
+	U64 *slot = insert_into_map(&unit->declared, (U64)(Address)data);
+	if (*slot)
+		return (U32)*slot - 1;
+	U32 number = unit->datas_count++;
+	*slot = number + 1;
+
+	Buffer addresses = {};
+	gather_c_addresses(unit->generation->program, &addresses, data->relocations);
+	const C_Address *items = (const C_Address *)addresses.pointer;
+	U32 count = (U32)(addresses.mass / sizeof(C_Address));
+	declare_c_addresses(unit, items, count);
+	char name[16];
+	Size size = format(name, sizeof(name), "d%u", number);
+	write_c_image_type(&unit->declarations, {(const Utf8 *)name, size}, data->data.size, items, count);
+	write_c(&unit->data, "static _Alignas(8) const struct d%u_image d%u", number, number);
+	write_c_image_value(unit, &unit->data, data->data.pointer, data->data.size, items, count);
+	write_c(&unit->data, ";\n\n");
+	uninitialize_buffer(&addresses);
+	return number;
+}
+
+// the bytes that a global starts as, and the addresses in them
+static const U8 *get_c_global_image(C_Unit *unit, const Artifact *artifact, U64 *scalar, Buffer *addresses)
+{
+	const Type *type = get_type(artifact->type);
+	const Value *value = &artifact->value;
+	if (value->type == Type_Id_NONE)
+		return 0;
+	gather_c_addresses(unit->generation->program, addresses, value->relocations);
+	if (check_image(value->type))
+		return value->image;
+	*scalar = 0;
+	if (type->kind == Type_Kind_FLOAT)
+	{
+		float floating = (float)value->floating;
+		if (type->size == 4)
+			copy_memory(scalar, &floating, 4);
+		else
+			copy_memory(scalar, &value->floating, 8);
+	}
+	else if (type->kind == Type_Kind_PROCEDURE)
+	{
+		const U64 *procedure = value->procedure ? find_in_map(&unit->generation->program->procedures_by_node, (U64)(Address)value->procedure) : 0;
+		C_Address *address = (C_Address *)reserve_from_buffer(addresses, sizeof(C_Address), alignof(C_Address));
+		*address = {};
+		address->procedure = procedure ? (const Procedure *)(Address)*procedure : 0;
+	}
+	else
+		*scalar = value->integer;
+	return (const U8 *)scalar;
+}
+
+// globals are defined in the unit of their source, and declared in the others
+static const C_Global *declare_c_global(C_Unit *unit, Artifact *artifact)
+{
+	const C_Global *global = get_c_global(unit->generation, artifact);
+	U64 *slot = insert_into_map(&unit->declared, (U64)(Address)artifact);
+	if (*slot)
+		return global;
+	*slot = 1;
+
+	const Type *type = get_type(artifact->type);
+	U64 scalar;
+	Buffer addresses = {};
+	const U8 *bytes = get_c_global_image(unit, artifact, &scalar, &addresses);
+	const C_Address *items = (const C_Address *)addresses.pointer;
+	U32 count = (U32)(addresses.mass / sizeof(C_Address));
+	String name = global->name;
+	write_c_image_type(&unit->declarations, name, type->size, items, count);
+	write_c(&unit->declarations, "extern struct %.*s_image %.*s;\n", (int)name.size, name.pointer, (int)name.size, name.pointer);
+	if (global->source == unit->source)
+	{
+		declare_c_addresses(unit, items, count);
+		write_c(&unit->data, "_Alignas(%lu) struct %.*s_image %.*s", max(type->alignment, 1), (int)name.size, name.pointer,
+		        (int)name.size, name.pointer);
+		if (bytes || count)
+			write_c_image_value(unit, &unit->data, bytes, type->size, items, count);
+		write_c(&unit->data, ";\n\n");
+	}
+	uninitialize_buffer(&addresses);
+	return global;
+}
+
+// the phis of the successor take what comes from the block before it's gone to
+static void write_c_edge(C_Unit *unit, const Procedure *procedure, Block_Id block, Block_Id successor, const char *indentation)
+{
+	const Block *information = get_block(procedure, successor);
+	for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+	{
+		Instruction_Id id = get_block_instructions(information)[i];
+		const Instruction *phi = get_instruction(procedure, id);
+		if (phi->operation != Operation_PHI)
+			break;
+		if (!(unit->values[id] & C_Value_WRITTEN))
+			continue;
+		for (U32 j = 0; j < phi->operands_count && j < get_predecessors_count(information); ++j)
+		{
+			if (get_predecessors(information)[j] == block)
+			{
+				write_c(&unit->code, "%sp%u = v%u;\n", indentation, id, phi->operands[j]);
+				break;
+			}
+		}
+	}
+	write_c(&unit->code, "%sgoto b%u;\n", indentation, successor);
+}
+
+static const char *get_c_operator(Operation operation)
+{
+	switch (operation)
+	{
+	case Operation_ADD:           return "+";
+	case Operation_SUBTRACT:      return "-";
+	case Operation_MULTIPLY:      return "*";
+	case Operation_DIVIDE:        return "/";
+	case Operation_MODULO:        return "%";
+	case Operation_AND:           return "&";
+	case Operation_OR:            return "|";
+	case Operation_XOR:           return "^";
+	case Operation_SHIFT_LEFT:    return "<<";
+	case Operation_SHIFT_RIGHT:   return ">>";
+	case Operation_EQUAL:         return "==";
+	case Operation_NOT_EQUAL:     return "!=";
+	case Operation_LESS:          return "<";
+	case Operation_LESS_EQUAL:    return "<=";
+	case Operation_GREATER:       return ">";
+	case Operation_GREATER_EQUAL: return ">=";
+	default:                      return "?";
+	}
+}
+
+static void write_c_instruction(C_Unit *unit, const Procedure *procedure, Block_Id block, Instruction_Id id)
+{
+	Buffer *code = &unit->code;
+	const Instruction *instruction = get_instruction(procedure, id);
+	const Instruction_Id *operands = instruction->operands;
+	const char *type = instruction->type == Type_Id_VOID ? "" : get_c_type(instruction->type);
+	if (!(unit->values[id] & C_Value_WRITTEN))
+		return;
+	switch (instruction->operation)
+	{
+	case Operation_CONSTANT:
+		{
+			const Type *information = get_underlying_type(instruction->type);
+			if (information->kind == Type_Kind_FLOAT && information->size == 4)
+				write_c(code, "\tv%u = w_f32(0x%xu);\n", id, (U32)instruction->constant);
+			else if (information->kind == Type_Kind_FLOAT)
+				write_c(code, "\tv%u = w_f64(0x%lxull);\n", id, instruction->constant);
+			else if (information->kind == Type_Kind_POINTER || information->kind == Type_Kind_PROCEDURE)
+				write_c(code, "\tv%u = (%s)(uintptr_t)0x%lxull;\n", id, type, instruction->constant);
+			else
+				write_c(code, "\tv%u = (%s)0x%lxull;\n", id, type, instruction->constant);
+		}
+		break;
+	case Operation_ADDRESS:
+		if (instruction->address.artifact)
+		{
+			String name = declare_c_global(unit, instruction->address.artifact)->name;
+			write_c(code, "\tv%u = (uint8_t *)&%.*s;\n", id, (int)name.size, name.pointer);
+		}
+		else if (instruction->address.procedure)
+		{
+			declare_c_procedure(unit, instruction->address.procedure);
+			write_c(code, "\tv%u = (w_procedure)", id);
+			write_c_procedure_name(code, instruction->address.procedure);
+			write_c(code, ";\n");
+		}
+		else
+			write_c(code, "\tv%u = (uint8_t *)&d%u;\n", id, declare_c_data(unit, instruction->address.data));
+		break;
+	case Operation_PARAMETER:
+		write_c(code, "\tv%u = a%u;\n", id, instruction->index);
+		break;
+	case Operation_LOCAL:
+		write_c(code, "\tv%u = l%u;\n", id, id);
+		break;
+	case Operation_PHI:
+		write_c(code, "\tv%u = p%u;\n", id, id);
+		break;
+	case Operation_COPY:
+		write_c(code, "\tv%u = v%u;\n", id, operands[0]);
+		break;
+	case Operation_NEGATE:
+		if (check_vector_type(instruction->type))
+			write_c(code, "\tv%u = -v%u;\n", id, operands[0]);
+		else
+			write_c(code, "\tv%u = (%s)(0 - (uint64_t)v%u);\n", id, type, operands[0]);
+		break;
+	case Operation_NOT:
+		write_c(code, "\tv%u = !v%u;\n", id, operands[0]);
+		break;
+	case Operation_COMPLEMENT:
+		write_c(code, "\tv%u = (%s)~v%u;\n", id, type, operands[0]);
+		break;
+	case Operation_CONVERT:
+		{
+			const Type *from = get_underlying_type(get_instruction(procedure, operands[0])->type);
+			const Type *to = get_underlying_type(instruction->type);
+			if (to->kind == Type_Kind_BOOL)
+				write_c(code, "\tv%u = v%u != 0;\n", id, operands[0]);
+			else if (from->kind == Type_Kind_POINTER || from->kind == Type_Kind_PROCEDURE || to->kind == Type_Kind_POINTER ||
+			         to->kind == Type_Kind_PROCEDURE)
+				write_c(code, "\tv%u = (%s)(uintptr_t)v%u;\n", id, type, operands[0]);
+			else
+				write_c(code, "\tv%u = (%s)v%u;\n", id, type, operands[0]);
+		}
+		break;
+	case Operation_LOAD:
+		write_c(code, "\tmemcpy(&v%u, v%u, sizeof(v%u));\n", id, operands[0], id);
+		break;
+	case Operation_ADD:
+	case Operation_SUBTRACT:
+	case Operation_MULTIPLY:
+	case Operation_DIVIDE:
+	case Operation_MODULO:
+	case Operation_AND:
+	case Operation_OR:
+	case Operation_XOR:
+		{
+			const char *symbol = get_c_operator(instruction->operation);
+			bool first_pointer = get_c_scalar(get_instruction(procedure, operands[0])->type) == 10;
+			bool second_pointer = get_c_scalar(get_instruction(procedure, operands[1])->type) == 10;
+			// offsets from addresses stay pointer arithmetic, so what they point to is still known
+			if (get_c_scalar(instruction->type) == 10 && first_pointer != second_pointer &&
+			    (instruction->operation == Operation_ADD || (instruction->operation == Operation_SUBTRACT && first_pointer)))
+			{
+				Instruction_Id address = first_pointer ? operands[0] : operands[1];
+				Instruction_Id offset = first_pointer ? operands[1] : operands[0];
+				write_c(code, "\tv%u = v%u %s (int64_t)v%u;\n", id, address, symbol, offset);
+			}
+			else if (first_pointer || second_pointer)
+				write_c(code, "\tv%u = (%s)((uintptr_t)v%u %s (uintptr_t)v%u);\n", id, type, operands[0], symbol, operands[1]);
+			else if (check_vector_type(instruction->type))
+				write_c(code, "\tv%u = v%u %s v%u;\n", id, operands[0], symbol, operands[1]);
+			// integers wrap around
+			else if (instruction->operation <= Operation_MULTIPLY)
+				write_c(code, "\tv%u = (%s)((uint64_t)v%u %s (uint64_t)v%u);\n", id, type, operands[0], symbol, operands[1]);
+			else
+				write_c(code, "\tv%u = (%s)(v%u %s v%u);\n", id, type, operands[0], symbol, operands[1]);
+		}
+		break;
+	case Operation_SHIFT_LEFT:
+		write_c(code, "\tv%u = (%s)((uint64_t)v%u << (v%u & 63));\n", id, type, operands[0], operands[1]);
+		break;
+	case Operation_SHIFT_RIGHT:
+		write_c(code, "\tv%u = (%s)(v%u >> (v%u & 63));\n", id, type, operands[0], operands[1]);
+		break;
+	case Operation_EQUAL:
+	case Operation_NOT_EQUAL:
+	case Operation_LESS:
+	case Operation_LESS_EQUAL:
+	case Operation_GREATER:
+	case Operation_GREATER_EQUAL:
+		write_c(code, "\tv%u = v%u %s v%u;\n", id, operands[0], get_c_operator(instruction->operation), operands[1]);
+		break;
+	case Operation_STORE:
+		write_c(code, "\tmemcpy(v%u, &v%u, sizeof(v%u));\n", operands[0], operands[1], operands[1]);
+		break;
+	case Operation_COPY_MEMORY:
+		write_c(code, "\tmemcpy(v%u, v%u, %u);\n", operands[0], operands[1], instruction->slot.size);
+		break;
+	case Operation_ZERO_MEMORY:
+		write_c(code, "\tmemset(v%u, 0, %u);\n", operands[0], instruction->slot.size);
+		break;
+	case Operation_CALL:
+		{
+			const Instruction *callee = get_instruction(procedure, operands[0]);
+			Type_Id procedure_type = callee->type;
+			bool pair = instruction->type != Type_Id_VOID && get_type(get_type(procedure_type)->base)->elements_count > 1;
+			bool read = unit->values[id] & C_Value_READ;
+			write_c(code, "\t");
+			if (pair && (read || unit->values[id] & C_Value_RESULTS_READ))
+				write_c(code, "c%u = ", id);
+			else if (!pair && read && instruction->type != Type_Id_VOID)
+				write_c(code, "v%u = ", id);
+			// calls that are known go straight to the procedure, and the others through a pointer of its type
+			if (callee->operation == Operation_ADDRESS && callee->address.procedure)
+			{
+				declare_c_procedure(unit, callee->address.procedure);
+				write_c_procedure_name(code, callee->address.procedure);
+			}
+			else
+			{
+				write_c(code, "((");
+				write_c_results(unit, code, procedure_type);
+				write_c(code, " (*)");
+				write_c_parameters(code, procedure_type, false);
+				write_c(code, ")v%u)", operands[0]);
+			}
+			write_c(code, "(");
+			for (U32 i = 1; i < instruction->operands_count; ++i)
+				write_c(code, "%sv%u", i == 1 ? "" : ", ", operands[i]);
+			write_c(code, ");\n");
+			if (pair && read)
+				write_c(code, "\tv%u = c%u.e0;\n", id, id);
+		}
+		break;
+	case Operation_RESULT:
+		write_c(code, "\tv%u = c%u.e%u;\n", id, operands[0], instruction->index);
+		break;
+	case Operation_JUMP:
+		write_c_edge(unit, procedure, block, instruction->targets[0], "\t");
+		break;
+	case Operation_BRANCH:
+		write_c(code, "\tif (v%u)\n\t{\n", operands[0]);
+		write_c_edge(unit, procedure, block, instruction->targets[0], "\t\t");
+		write_c(code, "\t}\n");
+		write_c_edge(unit, procedure, block, instruction->targets[1], "\t");
+		break;
+	case Operation_SWITCH:
+		{
+			// the values of the cases are normalized like the operand, which is extended to 64 bits
+			bool is_signed = get_underlying_type(get_instruction(procedure, operands[0])->type)->is_signed;
+			write_c(code, "\tswitch (%sv%u)\n\t{\n", is_signed ? "(uint64_t)(int64_t)" : "(uint64_t)", operands[0]);
+			for (U32 i = 0; i < instruction->table.cases_count; ++i)
+			{
+				const Switch_Case *item = &instruction->table.cases[i];
+				write_c(code, "\tcase 0x%lxull:\n", item->value);
+				write_c_edge(unit, procedure, block, instruction->table.targets[item->target], "\t\t");
+			}
+			write_c(code, "\tdefault:\n");
+			write_c_edge(unit, procedure, block, instruction->table.targets[0], "\t\t");
+			write_c(code, "\t}\n");
+		}
+		break;
+	case Operation_RETURN:
+		if (!instruction->operands_count)
+			write_c(code, "\treturn;\n");
+		else if (instruction->operands_count == 1)
+			write_c(code, "\treturn v%u;\n", operands[0]);
+		else
+		{
+			write_c(code, "\treturn (");
+			write_c_results(unit, code, procedure->type);
+			write_c(code, "){v%u, v%u};\n", operands[0], operands[1]);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+// what's read by something with side effects, and which blocks are gone to. a procedure that's called directly is
+// named by the call, so its address isn't read.
+static void find_c_values(const Procedure *procedure, U8 *values, bool *targets)
+{
+	Scratch scratch;
+	Instruction_Id *stack = (Instruction_Id *)reserve_from_arena(scratch.arena, get_instructions_count(procedure) * sizeof(Instruction_Id), alignof(Instruction_Id));
+	U32 stack_count = 0;
+	for (Block_Id block = 0; block < get_blocks_count(procedure); ++block)
+	{
+		const Block *information = get_block(procedure, block);
+		for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+		{
+			Instruction_Id id = get_block_instructions(information)[i];
+			if (check_side_effects(get_instruction(procedure, id)->operation))
+			{
+				values[id] = C_Value_WRITTEN;
+				stack[stack_count++] = id;
+			}
+		}
+		const Instruction *terminator = get_terminator(procedure, block);
+		for (U32 i = 0; i < get_successors_count(terminator); ++i)
+			targets[get_successors(terminator)[i]] = true;
+	}
+	while (stack_count)
+	{
+		const Instruction *instruction = get_instruction(procedure, stack[--stack_count]);
+		for (U32 i = 0; i < instruction->operands_count; ++i)
+		{
+			Instruction_Id operand = instruction->operands[i];
+			const Instruction *value = get_instruction(procedure, operand);
+			if (instruction->operation == Operation_CALL && i == 0 && value->operation == Operation_ADDRESS && value->address.procedure)
+				continue;
+			values[operand] |= instruction->operation == Operation_RESULT ? C_Value_RESULTS_READ : C_Value_READ;
+			if (!(values[operand] & C_Value_WRITTEN))
+			{
+				values[operand] |= C_Value_WRITTEN;
+				stack[stack_count++] = operand;
+			}
+		}
+	}
+}
+
+static void write_c_procedure(C_Unit *unit, const Procedure *procedure)
+{
+	Buffer *code = &unit->code;
+	declare_c_procedure(unit, procedure);
+	write_c_results(unit, code, procedure->type);
+	write_c(code, "\n");
+	write_c_procedure_name(code, procedure);
+	write_c_parameters(code, procedure->type, true);
+	write_c(code, "\n{\n");
+
+	// what's passed in memory is as aligned as its type
+	const Type *type = get_type(procedure->type);
+	for (U32 i = 0; i < type->elements_count; ++i)
+	{
+		if (check_image(type->elements[i]))
+			write_c(code, "\ta%u = W_ALIGNED(a%u, %lu);\n", i, i, max(get_type(type->elements[i])->alignment, 1));
+	}
+
+	Scratch scratch;
+	U8 *values = (U8 *)reserve_from_arena(scratch.arena, get_instructions_count(procedure), 1);
+	bool *targets = (bool *)reserve_from_arena(scratch.arena, get_blocks_count(procedure) * sizeof(bool), alignof(bool));
+	set_memory(values, get_instructions_count(procedure), 0);
+	set_memory(targets, get_blocks_count(procedure) * sizeof(bool), 0);
+	find_c_values(procedure, values, targets);
+	unit->values = values;
+
+	// every value is declared first, since the labels may be gone to from anywhere
+	for (Instruction_Id id = 1; id < get_instructions_count(procedure); ++id)
+	{
+		const Instruction *instruction = get_instruction(procedure, id);
+		if (instruction->operation == Operation_NONE || instruction->type == Type_Id_VOID || !(values[id] & C_Value_WRITTEN))
+			continue;
+		const char *name = get_c_type(instruction->type);
+		if (values[id] & C_Value_READ)
+			write_c(code, "\t%s v%u;\n", name, id);
+		if (instruction->operation == Operation_PHI)
+			write_c(code, "\t%s p%u;\n", name, id);
+		else if (instruction->operation == Operation_LOCAL)
+			write_c(code, "\t_Alignas(%lu) uint8_t l%u[%lu];\n", max(instruction->slot.alignment, 1), id, max(instruction->slot.size, 1));
+		else if (instruction->operation == Operation_CALL && values[id] & (C_Value_READ | C_Value_RESULTS_READ))
+		{
+			Type_Id callee = get_instruction(procedure, instruction->operands[0])->type;
+			if (get_type(get_type(callee)->base)->elements_count > 1)
+			{
+				write_c(code, "\t");
+				write_c_results(unit, code, callee);
+				write_c(code, " c%u;\n", id);
+			}
+		}
+	}
+
+	for (Block_Id block = 0; block < get_blocks_count(procedure); ++block)
+	{
+		const Block *information = get_block(procedure, block);
+		if (!get_block_instructions_count(information))
+			continue;
+		if (targets[block])
+			write_c(code, "b%u:;\n", block);
+		for (U32 i = 0; i < get_block_instructions_count(information); ++i)
+			write_c_instruction(unit, procedure, block, get_block_instructions(information)[i]);
+	}
+	write_c(code, "}\n\n");
+}
+
+// the path of the source with its extension replaced
+static void make_c_path(const Source *source, char *path)
+{
+	Size size = source->path_size;
+	for (Size i = source->path_size; i-- && source->path[i] != '/' && source->path[i] != '\\';)
+	{
+		if (source->path[i] == '.')
+		{
+			size = i;
+			break;
+		}
+	}
+	copy_memory(path, source->path, size);
+	copy_memory(&path[size], ".c", 3);
+}
+
+static bool write_c_unit(C_Generation *generation, const Source *source)
+{
+	const Program *program = generation->program;
+	C_Unit unit = {};
+	unit.generation = generation;
+	unit.source = source;
+
+	for (Size i = 0; i < generation->globals.mass / sizeof(C_Global); ++i)
+	{
+		const C_Global *global = &((const C_Global *)generation->globals.pointer)[i];
+		if (global->source == source)
+			declare_c_global(&unit, global->artifact);
+	}
+	const Procedure *entry = 0;
+	for (Size i = 0; i < get_list_count(&program->procedures); ++i)
+	{
+		const Procedure *procedure = get_list_item(&program->procedures, i);
+		if (procedure->external || !get_instructions_count(procedure) || find_source(procedure->node->span.beginning) != source)
+			continue;
+		write_c_procedure(&unit, procedure);
+		if (check_entry(procedure))
+			entry = procedure;
+	}
+
+	// the program is entered at `main`, which exits with what `_start` returns, if it's an integer
+	if (entry)
+	{
+		write_c(&unit.code, "int main(void)\n{\n");
+		const Type *results = get_type(get_type(entry->type)->base);
+		if (results->elements_count && check_register_results(get_type(entry->type)->base) && !check_vector_type(results->elements[0]))
+		{
+			write_c(&unit.code, "\treturn (int)");
+			write_c_procedure_name(&unit.code, entry);
+			write_c(&unit.code, results->elements_count > 1 ? "().e0;\n" : "();\n");
+		}
+		else if (check_register_results(get_type(entry->type)->base))
+		{
+			write_c(&unit.code, "\t");
+			write_c_procedure_name(&unit.code, entry);
+			write_c(&unit.code, "();\n\treturn 0;\n");
+		}
+		else
+		{
+			write_c(&unit.code, "\tstatic _Alignas(%lu) uint8_t results[%lu];\n\t", max(results->alignment, 1), max(results->size, 1));
+			write_c_procedure_name(&unit.code, entry);
+			write_c(&unit.code, "(results);\n\treturn 0;\n");
+		}
+		write_c(&unit.code, "}\n");
+	}
+
+	Buffer pairs = {};
+	for (U32 i = 0; i < C_SCALARS_COUNT; ++i)
+	{
+		for (U32 j = 0; j < C_SCALARS_COUNT; ++j)
+		{
+			if (unit.pairs[i][j])
+				write_c(&pairs, "struct w_results_%s_%s { %s e0; %s e1; };\n", c_scalars[i].abbreviation, c_scalars[j].abbreviation,
+				        c_scalars[i].name, c_scalars[j].name);
+		}
+	}
+
+	char path[MAX_FILE_PATH_SIZE + 4];
+	make_c_path(source, path);
+	Handle handle;
+	bool result = create_file(&handle, path);
+	if (result)
+	{
+		const Buffer *parts[] = {&pairs, &unit.declarations, &unit.data, &unit.code};
+		result = write_file(handle, c_prelude, sizeof(c_prelude) - 1);
+		for (const Buffer *part : parts)
+		{
+			if (result && part->mass)
+				result = write_file(handle, part->pointer, part->mass) && write_file(handle, "\n", 1);
+		}
+		close_file(handle);
+	}
+	if (!result)
+		report_error("failed to write %s.", path);
+
+	uninitialize_buffer(&pairs);
+	uninitialize_buffer(&unit.declarations);
+	uninitialize_buffer(&unit.data);
+	uninitialize_buffer(&unit.code);
+	uninitialize_map(&unit.declared);
+	return result;
+}
+
+bool generate_c_program(const Program *program)
+{
+	C_Generation generation = {};
+	generation.program = program;
+	initialize_arena(&generation.names, 64);
+
+	// the globals are numbered once for every unit
+	for (Size i = 0; i < get_list_count(&program->procedures); ++i)
+	{
+		const Procedure *procedure = get_list_item(&program->procedures, i);
+		for (Instruction_Id id = 1; id < get_instructions_count(procedure); ++id)
+		{
+			const Instruction *instruction = get_instruction(procedure, id);
+			if (instruction->operation != Operation_ADDRESS)
+				continue;
+			if (instruction->address.artifact)
+				add_c_global(&generation, instruction->address.artifact);
+			else if (!instruction->address.procedure)
+				add_c_relocation_globals(&generation, instruction->address.data->relocations);
+		}
 	}
-	char *line = &data[line_offset];
-	Size line_size = find_character(line, '\n') - line;
 
+	bool result = true;
+	for (Size i = 0; i < get_sources_count(); ++i)
+		result &= write_c_unit(&generation, get_source(i));
+
+	uninitialize_buffer(&generation.globals);
+	uninitialize_map(&generation.artifacts);
+	uninitialize_arena(&generation.names);
+	return result;
+}
+
+// `color` is the SGR parameter of the label and the highlighting.
+static void v_report_span(Span span, const char *label, const char *color, const char *message, va_list args)
+{
+	const Source *source = find_source(span.beginning);
+	const char *data = (const char *)source->data;
+	Size beginning = span.beginning - source->base;
+	Size ending = min(beginning + span.size, source->data_size);
+
+	// find the line that the span begins in
+	Size line_offset = beginning;
+	while (line_offset && data[line_offset - 1] != '\n')
+		--line_offset;
+	Size line_number = 1;
+	for (const char *newline = data; (newline = (const char *)memchr(newline, '\n', &data[line_offset] - newline)); ++newline)
+		++line_number;
+	const char *line = &data[line_offset];
+	Size line_size = 0;
+	while (line[line_size] && line[line_size] != '\n')
+		++line_size;
+
+	beginning -= line_offset;
+	ending = min(ending - line_offset, line_size);
+	if (ending < beginning)
+		ending = beginning;
+
+	flockfile(stderr);
+	fprintf(stderr, "\e[1m%s:%lu:%lu: \e[%sm%s:\e[0m ", source->path, line_number, beginning + 1, color, label);
+	vfprintf(stderr, message, args);
+	putc('\n', stderr);
+
+	fprintf(stderr, "\t| ");
 	for (Size i = 0; i < beginning; ++i)
 		putc(line[i], stderr);
-	fprintf(stderr, "\e[1;31m");
+	fprintf(stderr, "\e[1;%sm", color);
 	for (Size i = beginning; i < ending; ++i)
 		putc(line[i], stderr);
 	fprintf(stderr, "\e[0m");
 	for (Size i = ending; i < line_size; ++i)
 		putc(line[i], stderr);
-	
+
 	fprintf(stderr, "\n\t  ");
 	for (Size i = 0; i < beginning; ++i)
-		putc(' ', stderr);
+		putc(line[i] == '\t' ? '\t' : ' ', stderr);
 
-	fprintf(stderr, "\e[1;31m");
+	fprintf(stderr, "\e[1;%sm", color);
 	Size error_length = ending - beginning;
 	for (Size i = 0; i < error_length; ++i)
 		putc('^', stderr);
 	fprintf(stderr, "\e[0m\n");
+	funlockfile(stderr);
+}
+
+// whether the last error of this thread went past the limit, in which case its notes aren't reported either
+static thread_local bool error_dropped = false;
+
+// compiling stops as soon as the errors reach the limit. workers that are still running may report more, which are
+// dropped and not counted. returns whether to report the error.
+static bool count_error(void)
+{
+	Size errors_count = __atomic_add_fetch(&compilation_errors_count, 1, __ATOMIC_RELAXED);
+	Size limit = compilation_options.errors_limit;
+	error_dropped = false;
+	if (!limit || errors_count < limit)
+		return true;
+	__atomic_store_n(&compilation_stopped, true, __ATOMIC_RELAXED);
+	if (errors_count == limit)
+		return true;
+	__atomic_sub_fetch(&compilation_errors_count, 1, __ATOMIC_RELAXED);
+	error_dropped = true;
+	return false;
+}
+
+void v_report_span_error(Span span, const char *message, va_list args)
+{
+	if (count_error())
+		v_report_span(span, "error", "31", message, args);
+}
+
+void v_report_span_note(Span span, const char *message, va_list args)
+{
+	if (!error_dropped)
+		v_report_span(span, "note", "36", message, args);
 }
 
 Size get_alignment_addition(Address address, Size alignment)
 {
-	assert(alignment % 2 == 0);
+	assert((alignment & (alignment - 1)) == 0);
 	Size addition = 0;
 	if (Size mod = address & (alignment - 1); mod != 0)
 		addition = alignment - mod;
@@ -420,7 +13507,7 @@ Size get_alignment_addition(Address address, Size alignment)
 
 Size get_alignment_subtraction(Address address, Size alignment)
 {
-	assert(alignment % 2 == 0);
+	assert((alignment & (alignment - 1)) == 0);
 	Size subtraction = 0;
 	if (Size mod = address & (alignment - 1); mod != 0)
 		subtraction = mod;
@@ -438,124 +13525,576 @@ void print(const char *message, ...)
 
 void report_error(const char *message, ...)
 {
-	++compilation_errors_count;
+	if (!count_error())
+		return;
 
+	flockfile(stderr);
 	fprintf(stderr, "error: ");
 	va_list args;
 	va_start(args, message);
 	vfprintf(stderr, message, args);
 	va_end(args);
 	fprintf(stderr, "\n");
+	funlockfile(stderr);
+}
+
+void report_warning(const char *message, ...)
+{
+	flockfile(stderr);
+	fprintf(stderr, "warning: ");
+	va_list args;
+	va_start(args, message);
+	vfprintf(stderr, message, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+	funlockfile(stderr);
+}
+
+void debug(const char *message, ...)
+{
+	fprintf(stderr, "debug: ");
+	va_list args;
+	va_start(args, message);
+	vfprintf(stderr, message, args);
+	va_end(args);
+	fprintf(stderr, "\n");
+}
+
+Size get_memory_page_size(void)
+{
+	return getpagesize();
+}
+
+static Size total_program_memory_allocation_size = 0;
+
+void *allocate(Size size)
+{
+	void *result = malloc(size);
+	if (result)
+		__atomic_fetch_add(&total_program_memory_allocation_size, size, __ATOMIC_RELAXED);
+	return result;
+}
+
+void deallocate(void *pointer)
+{
+	free(pointer);
+}
+
+void *reallocate(void *pointer, Size size)
+{
+	return realloc(pointer, size);
+}
+
+void *allocate_virtual_memory(void *address, Size size)
+{
+	void *result = mmap(address, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	if (result == MAP_FAILED)
+		result = 0;
+	else
+		__atomic_fetch_add(&total_program_memory_allocation_size, align(size, get_memory_page_size()), __ATOMIC_RELAXED);
+	return result;
+}
+
+void deallocate_virtual_memory(void *pointer, Size size)
+{
+	if (munmap(pointer, size) == -1)
+	{
+		// idek
+	}
+}
+
+const char *get_system_error_message(void)
+{
+	return strerror(errno);
+}
+
+bool open_file(Handle *handle, const char *path, bool writable)
+{
+	int oflags = writable ? O_RDWR : O_RDONLY;
+	int fd = open(path, oflags);
+	if (fd == -1)
+	{
+		report_error("system: failed to open file: %s.", get_system_error_message());
+		return 0;
+	}
+	*handle = fd;
+	return 1;
+}
+
+void close_file(Handle handle)
+{
+	(void)close(handle);
+}
+
+bool get_file_size(Handle handle, Size *size)
+{
+	struct stat st;
+	if (fstat(handle, &st) == -1)
+	{
+		report_error("system: failed to get file size: %s.", get_system_error_message());
+		return 0;
+	}
+	*size = st.st_size;
+	return 1;
+}
+
+bool read_file(Handle handle, void *buffer, Size *size)
+{
+	ssize_t r = read(handle, buffer, *size);
+	if (r == -1)
+	{
+		*size = 0;
+		report_error("system: failed to read file: %s.", get_system_error_message());
+		return 0;
+	}
+	*size = r;
+	return 1;
+}
+
+// loading many files is bound by waiting on the disk, so a window of files is waited on at once. io_uring takes batches
+// of opens, statx calls and reads with one system call, and where it's missing, a pool of threads does the same with
+// blocking calls.
+
+struct Ring
+{
+	int fd;
+	U32 entries;
+	U32 *submission_tail;
+	U32 submission_mask;
+	U32 *submission_array;
+	io_uring_sqe *submissions;
+	U32 *completion_head;
+	U32 *completion_tail;
+	U32 completion_mask;
+	io_uring_cqe *completions;
+	void *rings[2];
+	Size rings_sizes[2];
+	Size submissions_size;
+};
+
+constexpr U32 LOADING_RING_ENTRIES_COUNT = 256;
+
+// the threads mostly wait, so there are at least this many
+constexpr Size LOADING_THREADS_COUNT = 16;
+
+// how many files are open at once, which is as many as the ring has entries for
+constexpr Size LOADING_WINDOW_SIZE = LOADING_RING_ENTRIES_COUNT / 2;
+
+static bool initialize_ring(Ring *ring, U32 entries)
+{
+	*ring = {};
+	io_uring_params parameters = {};
+	ring->fd = (int)syscall(__NR_io_uring_setup, entries, &parameters);
+	if (ring->fd < 0)
+		return false;
+
+	// openat, statx, read and close with links have all been taken since the kernel first had `IORING_FEAT_FAST_POLL`
+	if (!(parameters.features & IORING_FEAT_FAST_POLL))
+	{
+		close(ring->fd);
+		return false;
+	}
+	ring->entries = parameters.sq_entries;
+	ring->rings_sizes[0] = parameters.sq_off.array + parameters.sq_entries * sizeof(U32);
+	ring->rings_sizes[1] = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+	ring->submissions_size = parameters.sq_entries * sizeof(io_uring_sqe);
+	ring->rings[0] = mmap(0, ring->rings_sizes[0], PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	ring->rings[1] = mmap(0, ring->rings_sizes[1], PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+	void *submissions = mmap(0, ring->submissions_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->rings[0] == MAP_FAILED || ring->rings[1] == MAP_FAILED || submissions == MAP_FAILED)
+	{
+		for (Size i = 0; i < 2; ++i)
+		{
+			if (ring->rings[i] != MAP_FAILED)
+				munmap(ring->rings[i], ring->rings_sizes[i]);
+		}
+		if (submissions != MAP_FAILED)
+			munmap(submissions, ring->submissions_size);
+		close(ring->fd);
+		return false;
+	}
+	U8 *submission_ring = (U8 *)ring->rings[0];
+	U8 *completion_ring = (U8 *)ring->rings[1];
+	ring->submission_tail = (U32 *)(submission_ring + parameters.sq_off.tail);
+	ring->submission_mask = *(U32 *)(submission_ring + parameters.sq_off.ring_mask);
+	ring->submission_array = (U32 *)(submission_ring + parameters.sq_off.array);
+	ring->submissions = (io_uring_sqe *)submissions;
+	ring->completion_head = (U32 *)(completion_ring + parameters.cq_off.head);
+	ring->completion_tail = (U32 *)(completion_ring + parameters.cq_off.tail);
+	ring->completion_mask = *(U32 *)(completion_ring + parameters.cq_off.ring_mask);
+	ring->completions = (io_uring_cqe *)(completion_ring + parameters.cq_off.cqes);
+	return true;
+}
+
+static void uninitialize_ring(Ring *ring)
+{
+	munmap(ring->submissions, ring->submissions_size);
+	munmap(ring->rings[0], ring->rings_sizes[0]);
+	munmap(ring->rings[1], ring->rings_sizes[1]);
+	close(ring->fd);
+}
+
+// returns how many completions were taken
+static U32 reap_ring(Ring *ring, void (*complete)(void *input, U64 data, S64 result), void *input)
+{
+	U32 head = *ring->completion_head;
+	U32 completion_tail = __atomic_load_n(ring->completion_tail, __ATOMIC_ACQUIRE);
+	U32 count = completion_tail - head;
+	for (; head != completion_tail; ++head)
+	{
+		const io_uring_cqe *completion = &ring->completions[head & ring->completion_mask];
+		complete(input, completion->user_data, completion->res);
+	}
+	__atomic_store_n(ring->completion_head, head, __ATOMIC_RELEASE);
+	return count;
+}
+
+// `prepare` fills up to two entries for each of the items, which may be linked, and `complete` takes what each
+// entry completes with. no more are in flight than the ring holds, so the completions can't overflow. if the ring
+// fails, what the kernel took is waited for and completed before it returns, so that nothing is left that touches
+// the files or their memory.
+static bool run_ring(Ring *ring, Size count, U32 (*prepare)(void *input, Size index, io_uring_sqe *entries),
+                     void (*complete)(void *input, U64 data, S64 result), void *input)
+{
+	Size next = 0;
+	U32 in_flight = 0;
+	U32 pending = 0; // filled, but not taken by the kernel
+	U32 tail = *ring->submission_tail;
+	while (next < count || in_flight || pending)
+	{
+		while (next < count && in_flight + pending + 2 <= ring->entries)
+		{
+			io_uring_sqe entries[2] = {};
+			U32 filled = prepare(input, next++, entries);
+			for (U32 i = 0; i < filled; ++i)
+			{
+				U32 slot = tail++ & ring->submission_mask;
+				ring->submissions[slot] = entries[i];
+				ring->submission_array[slot] = slot;
+			}
+			pending += filled;
+		}
+		__atomic_store_n(ring->submission_tail, tail, __ATOMIC_RELEASE);
+
+		bool waiting = in_flight + pending != 0;
+		long entered = syscall(__NR_io_uring_enter, ring->fd, pending, waiting ? 1 : 0, waiting ? IORING_ENTER_GETEVENTS : 0, 0, 0);
+		if (entered < 0)
+		{
+			if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			{
+				// what the kernel didn't take is taken back. the completions are still posted if waiting fails,
+				// once the kernel gets to them.
+				tail -= pending;
+				__atomic_store_n(ring->submission_tail, tail, __ATOMIC_RELEASE);
+				while (in_flight)
+				{
+					if (syscall(__NR_io_uring_enter, ring->fd, 0, 1, IORING_ENTER_GETEVENTS, 0, 0) < 0 && errno != EINTR)
+						sched_yield();
+					in_flight -= reap_ring(ring, complete, input);
+				}
+				return false;
+			}
+			entered = 0;
+		}
+		pending -= (U32)entered;
+		in_flight += (U32)entered;
+		in_flight -= reap_ring(ring, complete, input);
+	}
+	return true;
 }
 
-void report_warning(const char *message, ...)
+// the low bit of what an entry carries tells which of the file's two entries it is
+struct File_Loading
+{
+	File_Load *loads;
+	Size count;
+	int *handles;   // -1 once closed
+	int *errors;    // of opening, getting the size and reading, for each file
+	struct statx *statuses;
+	Size *read_sizes;
+	Size next;      // for the threads
+};
+
+static int *get_load_errors(File_Loading *loading, Size index)
 {
-	fprintf(stderr, "warning: ");
-	va_list args;
-	va_start(args, message);
-	vfprintf(stderr, message, args);
-	va_end(args);
-	fprintf(stderr, "\n");
+	return &loading->errors[3 * index];
 }
 
-void debug(const char *message, ...)
+static U32 prepare_opening(void *input, Size index, io_uring_sqe *entries)
 {
-	fprintf(stderr, "debug: ");
-	va_list args;
-	va_start(args, message);
-	vfprintf(stderr, message, args);
-	va_end(args);
-	fprintf(stderr, "\n");
+	File_Loading *loading = (File_Loading *)input;
+	entries[0].opcode = IORING_OP_OPENAT;
+	entries[0].fd = AT_FDCWD;
+	entries[0].addr = (U64)(Address)loading->loads[index].path;
+	entries[0].open_flags = O_RDONLY | O_CLOEXEC;
+	entries[0].user_data = 2 * index;
+	entries[1].opcode = IORING_OP_STATX;
+	entries[1].fd = AT_FDCWD;
+	entries[1].addr = (U64)(Address)loading->loads[index].path;
+	entries[1].len = STATX_SIZE;
+	entries[1].off = (U64)(Address)&loading->statuses[index];
+	entries[1].user_data = 2 * index + 1;
+	return 2;
 }
 
-Size get_memory_page_size(void)
+static void complete_opening(void *input, U64 data, S64 result)
 {
-	return getpagesize();
+	File_Loading *loading = (File_Loading *)input;
+	Size index = data / 2;
+	if (result < 0)
+		get_load_errors(loading, index)[data % 2] = (int)-result;
+	else if (data % 2 == 0)
+		loading->handles[index] = (int)result;
+	else
+		loading->loads[index].size = loading->statuses[index].stx_size;
 }
 
-static Size total_program_memory_allocation_size = 0;
+// the file is closed right after it's read, unless the read comes up short, which breaks the link
+static U32 prepare_reading(void *input, Size index, io_uring_sqe *entries)
+{
+	File_Loading *loading = (File_Loading *)input;
+	int handle = loading->handles[index];
+	if (handle < 0)
+		return 0;
+	U32 count = 0;
+	const File_Load *load = &loading->loads[index];
+	if (load->data && load->size)
+	{
+		entries[0].opcode = IORING_OP_READ;
+		entries[0].fd = handle;
+		entries[0].addr = (U64)(Address)load->data;
+		entries[0].len = (U32)min(load->size, LMASK31);
+		entries[0].flags = IOSQE_IO_LINK;
+		entries[0].user_data = 2 * index;
+		count = 1;
+	}
+	entries[count].opcode = IORING_OP_CLOSE;
+	entries[count].fd = handle;
+	entries[count].user_data = 2 * index + 1;
+	return count + 1;
+}
 
-void *allocate(Size size)
+static void complete_reading(void *input, U64 data, S64 result)
 {
-	void *result = malloc(size);
-	if (result)
-		total_program_memory_allocation_size += size;
-	return result;
+	File_Loading *loading = (File_Loading *)input;
+	Size index = data / 2;
+	if (data % 2)
+	{
+		if (!result)
+			loading->handles[index] = -1;
+	}
+	else if (result < 0)
+		get_load_errors(loading, index)[2] = (int)-result;
+	else
+		loading->read_sizes[index] = (Size)result;
 }
 
-void deallocate(void *pointer)
+static void open_file_for_loading(File_Loading *loading, Size index)
 {
-	free(pointer);
+	int handle = open(loading->loads[index].path, O_RDONLY | O_CLOEXEC);
+	struct stat status;
+	if (handle == -1)
+		get_load_errors(loading, index)[0] = errno;
+	else if (fstat(handle, &status) == -1)
+		get_load_errors(loading, index)[1] = errno;
+	else
+		loading->loads[index].size = status.st_size;
+	loading->handles[index] = handle;
 }
 
-void *reallocate(void *pointer, Size size)
+// what wasn't read goes on with `pread`, and the file is closed
+static void finish_loading_file(File_Loading *loading, Size index)
 {
-	return realloc(pointer, size);
+	int handle = loading->handles[index];
+	if (handle < 0)
+		return;
+	File_Load *load = &loading->loads[index];
+	int *errors = get_load_errors(loading, index);
+	while (load->data && !errors[2] && loading->read_sizes[index] < load->size)
+	{
+		ssize_t read_size = pread(handle, load->data + loading->read_sizes[index], load->size - loading->read_sizes[index], loading->read_sizes[index]);
+		if (read_size > 0)
+			loading->read_sizes[index] += read_size;
+		else if (!read_size)
+			break;
+		else if (errno != EINTR)
+			errors[2] = errno;
+	}
+	close(handle);
+	loading->handles[index] = -1;
 }
 
-void *allocate_virtual_memory(void *address, Size size)
+static void *open_files_for_loading(void *input)
 {
-	void *result = mmap(address, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
-	if (result == MAP_FAILED)
-		result = 0;
-	else
-		total_program_memory_allocation_size += align(size, get_memory_page_size());
-	return result;
+	File_Loading *loading = (File_Loading *)input;
+	for (;;)
+	{
+		Size index = __atomic_fetch_add(&loading->next, 1, __ATOMIC_RELAXED);
+		if (index >= loading->count)
+			return 0;
+		open_file_for_loading(loading, index);
+	}
 }
 
-void deallocate_virtual_memory(void *pointer, Size size)
+static void *finish_loading_files(void *input)
 {
-	if (munmap(pointer, size) == -1)
+	File_Loading *loading = (File_Loading *)input;
+	for (;;)
 	{
-		// idek
+		Size index = __atomic_fetch_add(&loading->next, 1, __ATOMIC_RELAXED);
+		if (index >= loading->count)
+			return 0;
+		finish_loading_file(loading, index);
 	}
 }
 
-const char *get_system_error_message(void)
+// runs the procedure on this thread and on more, which take the next file until there are none left
+static void run_loading_threads(File_Loading *loading, void *(*procedure)(void *input))
 {
-	return strerror(errno);
+	loading->next = 0;
+	Size threads_count = min(max(get_processors_count(), LOADING_THREADS_COUNT), loading->count);
+	Thread *threads = (Thread *)allocate(threads_count * sizeof(Thread));
+	Size created_threads_count = 0;
+	for (Size i = 1; i < threads_count; ++i)
+	{
+		if (!create_thread(&threads[created_threads_count], procedure, loading))
+			break;
+		++created_threads_count;
+	}
+	procedure(loading);
+	for (Size i = 0; i < created_threads_count; ++i)
+		join_thread(threads[i]);
+	deallocate(threads);
 }
 
-bool open_file(Handle *handle, const char *path, bool writable)
+// the files of a window are opened, their data is reserved, and they're read and closed before the next window's are
+// opened. if the ring fails to open them, it's given up on, and the threads do this window and the rest.
+static void load_file_window(File_Loading *loading, Ring *ring, bool *ringing, U8 *(*reserve)(void *input, Size size), void *input)
 {
-	int oflags = writable ? O_RDWR : O_RDONLY;
-	int fd = open(path, oflags);
-	if (fd == -1)
+	File_Load *loads = loading->loads;
+	Size count = loading->count;
+	for (Size i = 0; i < count; ++i)
 	{
-		report_error("system: failed to open file: %s.", get_system_error_message());
-		return 0;
+		loading->handles[i] = -1;
+		loads[i].data = 0;
+		loads[i].size = 0;
+		loads[i].failure = 0;
+		loads[i].message = 0;
+		loading->read_sizes[i] = 0;
+	}
+	set_memory(loading->errors, 3 * count * sizeof(int), 0);
+
+	if (*ringing && !run_ring(ring, count, prepare_opening, complete_opening, loading))
+	{
+		// what was opened is closed, and it's all done again without the ring
+		uninitialize_ring(ring);
+		*ringing = false;
+		for (Size i = 0; i < count; ++i)
+		{
+			if (loading->handles[i] >= 0)
+				close(loading->handles[i]);
+			loading->handles[i] = -1;
+			loads[i].size = 0;
+		}
+		set_memory(loading->errors, 3 * count * sizeof(int), 0);
+	}
+	if (!*ringing)
+		run_loading_threads(loading, open_files_for_loading);
+
+	for (Size i = 0; i < count; ++i)
+	{
+		const int *errors = get_load_errors(loading, i);
+		if (!errors[0] && !errors[1])
+			loads[i].data = reserve(input, loads[i].size);
+	}
+
+	if (*ringing)
+	{
+		// what the ring didn't read is read with `pread`, and the windows after this one don't use it
+		if (!run_ring(ring, count, prepare_reading, complete_reading, loading))
+		{
+			uninitialize_ring(ring);
+			*ringing = false;
+		}
+		for (Size i = 0; i < count; ++i)
+			finish_loading_file(loading, i);
+	}
+	else
+		run_loading_threads(loading, finish_loading_files);
+
+	for (Size i = 0; i < count; ++i)
+	{
+		File_Load *load = &loads[i];
+		const int *errors = get_load_errors(loading, i);
+		static const char *const failures[] = {"open", "get the size of", "read"};
+		for (Size j = 0; j < 3; ++j)
+		{
+			if (errors[j])
+			{
+				load->failure = failures[j];
+				load->message = strerror(errors[j]);
+				break;
+			}
+		}
+		if (!load->failure && load->data && loading->read_sizes[i] != load->size)
+		{
+			load->failure = "read all of";
+			load->message = "it changed while it was read";
+		}
+		if (load->failure)
+			load->data = 0;
 	}
-	*handle = fd;
-	return 1;
 }
 
-void close_file(Handle handle)
+void load_files(File_Load *loads, Size count, U8 *(*reserve)(void *input, Size size), void *input)
 {
-	(void)close(handle);
+	Size window_size = min(count, LOADING_WINDOW_SIZE);
+	Scratch scratch;
+	File_Loading loading = {};
+	loading.handles = (int *)reserve_from_arena(scratch.arena, window_size * sizeof(int), alignof(int));
+	loading.errors = (int *)reserve_from_arena(scratch.arena, 3 * window_size * sizeof(int), alignof(int));
+	loading.statuses = (struct statx *)reserve_from_arena(scratch.arena, window_size * sizeof(struct statx), alignof(struct statx));
+	loading.read_sizes = (Size *)reserve_from_arena(scratch.arena, window_size * sizeof(Size), alignof(Size));
+
+	Ring ring;
+	bool ringing = count && initialize_ring(&ring, LOADING_RING_ENTRIES_COUNT);
+	for (Size first = 0; first < count; first += window_size)
+	{
+		loading.loads = &loads[first];
+		loading.count = min(window_size, count - first);
+		load_file_window(&loading, &ring, &ringing, reserve, input);
+	}
+	if (ringing)
+		uninitialize_ring(&ring);
 }
 
-bool get_file_size(Handle handle, Size *size)
+bool create_file(Handle *handle, const char *path, bool executable)
 {
-	struct stat st;
-	if (fstat(handle, &st) == -1)
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, executable ? 0755 : 0644);
+	if (fd == -1)
 	{
-		report_error("system: failed to get file size: %s.", get_system_error_message());
+		report_error("system: failed to create file: %s.", get_system_error_message());
 		return 0;
 	}
-	*size = st.st_size;
+	*handle = fd;
 	return 1;
 }
 
-bool read_file(Handle handle, void *buffer, Size *size)
+bool write_file(Handle handle, const void *buffer, Size size)
 {
-	ssize_t r = read(handle, buffer, *size);
-	if (r == -1)
+	while (size)
 	{
-		*size = 0;
-		report_error("system: failed to read file: %s.", get_system_error_message());
-		return 0;
+		ssize_t w = write(handle, buffer, size);
+		if (w == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			report_error("system: failed to write file: %s.", get_system_error_message());
+			return 0;
+		}
+		buffer = (const U8 *)buffer + w;
+		size -= w;
 	}
-	*size = r;
 	return 1;
 }
 
@@ -573,6 +14112,58 @@ Size get_full_file_path(const char *path, char *buffer)
 	return length;
 }
 
+Size get_processors_count(void)
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? count : 1;
+}
+
+bool create_thread(Thread *thread, void *(*procedure)(void *input), void *input)
+{
+	int error = pthread_create(thread, 0, procedure, input);
+	if (error)
+	{
+		report_error("system: failed to create thread: %s.", strerror(error));
+		return 0;
+	}
+	return 1;
+}
+
+void join_thread(Thread thread)
+{
+	(void)pthread_join(thread, 0);
+}
+
+void initialize_mutex(Mutex *mutex)
+{
+	pthread_mutex_init(mutex, 0);
+}
+
+void lock_mutex(Mutex *mutex)
+{
+	pthread_mutex_lock(mutex);
+}
+
+void unlock_mutex(Mutex *mutex)
+{
+	pthread_mutex_unlock(mutex);
+}
+
+void initialize_condition(Condition *condition)
+{
+	pthread_cond_init(condition, 0);
+}
+
+void wait_condition(Condition *condition, Mutex *mutex)
+{
+	pthread_cond_wait(condition, mutex);
+}
+
+void broadcast_condition(Condition *condition)
+{
+	pthread_cond_broadcast(condition);
+}
+
 void initialize_array(Array *array, Size size, void *pointer)
 {
 	if (pointer)
@@ -632,10 +14223,10 @@ void *ensure_buffer(Buffer *buffer, Size size)
 
 void *reserve_from_buffer(Buffer *buffer, Size size, Size alignment)
 {
+	ensure_buffer(buffer, alignment + size);
 	Size addition = get_alignment_addition((Address)buffer->pointer + buffer->mass, alignment);
-	U8 *end = (U8 *)ensure_buffer(buffer, alignment + size);
 	buffer->mass += addition;
-	void *result = end + buffer->mass;
+	void *result = (U8 *)buffer->pointer + buffer->mass;
 	buffer->mass += size;
 	return result;
 }
@@ -656,6 +14247,25 @@ void attach_singly(Singly<T> *singly, Singly<T> *other)
 	singly->other = other;
 }
 
+template<typename T>
+void add_to_list(List<T> *list, T *item)
+{
+	T **slot = (T **)reserve_from_buffer(&list->items, sizeof(T *), alignof(T *));
+	*slot = item;
+}
+
+template<typename T>
+Size get_list_count(const List<T> *list)
+{
+	return list->items.mass / sizeof(T *);
+}
+
+template<typename T>
+T *get_list_item(const List<T> *list, Size index)
+{
+	return ((T **)list->items.pointer)[index];
+}
+
 static void initialize_arena_buffer(Arena_Buffer *buffer, Size size)
 {
 	buffer->pointer = buffer;
@@ -666,7 +14276,7 @@ static void initialize_arena_buffer(Arena_Buffer *buffer, Size size)
 
 void initialize_arena(Arena *arena, Size size)
 {
-	size = align(sizeof(Buffer) + size, get_memory_page_size());
+	size = align(sizeof(Arena_Buffer) + size, get_memory_page_size());
 	arena->first = (Arena_Buffer *)allocate_virtual_memory(0, size);
 	initialize_arena_buffer(arena->first, size);
 	arena->last = arena->first;
@@ -674,13 +14284,15 @@ void initialize_arena(Arena *arena, Size size)
 
 void uninitialize_arena(Arena *arena)
 {
-	Arena_Pointer pointer =
+	Arena_Buffer *buffer = arena->first;
+	while (buffer)
 	{
-		.arena = arena,
-		.buffer = arena->first,
-		.offset = 0,
-	};
-	set_arena(&pointer);
+		Arena_Buffer *other = buffer->other;
+		deallocate_virtual_memory(buffer, buffer->size);
+		buffer = other;
+	}
+	arena->first = 0;
+	arena->last = 0;
 }
 
 void *reserve_from_arena(Arena *arena, Size size, Size alignment)
@@ -690,11 +14302,10 @@ void *reserve_from_arena(Arena *arena, Size size, Size alignment)
 	Size space = buffer->size - buffer->mass;
 	if (space < addition + size)
 	{
-
-		addition = get_alignment_addition(get_memory_page_size(), alignment);
-		Size buffer_size = align(addition + size, get_memory_page_size());
+		addition = get_alignment_addition(sizeof(Arena_Buffer), alignment);
+		Size buffer_size = align(sizeof(Arena_Buffer) + addition + size, get_memory_page_size());
 		buffer = (Arena_Buffer *)allocate_virtual_memory(0, buffer_size);
-		initialize_arena_buffer(buffer, size);
+		initialize_arena_buffer(buffer, buffer_size);
 		attach_singly(arena->last, buffer);
 		arena->last = buffer;
 	}
@@ -745,10 +14356,47 @@ void set_arena(Arena_Pointer *pointer)
 		deallocate_virtual_memory(buffer, buffer->size);
 		buffer = other;
 	}
+	pointer->buffer->other = 0;
 	pointer->arena->last = pointer->buffer;
 	pointer->buffer->mass = pointer->offset;
 }
 
+constexpr Size SCRATCH_ARENA_SIZE = MIB;
+
+// they're made when they're first used, and given back when their thread ends
+struct Scratch_Arenas
+{
+	Arena arenas[2];
+	Size depth; // of the scratches
+
+	~Scratch_Arenas()
+	{
+		for (Arena &arena : arenas)
+		{
+			if (arena.first)
+				uninitialize_arena(&arena);
+		}
+	}
+};
+
+static thread_local Scratch_Arenas scratch_arenas;
+
+Scratch::Scratch(const Arena *conflict)
+{
+	Scratch_Arenas *arenas = &scratch_arenas;
+	arena = &arenas->arenas[conflict ? conflict == &arenas->arenas[0] : arenas->depth % 2];
+	if (!arena->first)
+		initialize_arena(arena, SCRATCH_ARENA_SIZE);
+	get_arena_pointer(arena, &pointer);
+	++arenas->depth;
+}
+
+Scratch::~Scratch()
+{
+	set_arena(&pointer);
+	--scratch_arenas.depth;
+}
+
 constexpr U8 utf8_class_table[32] =
 {
 	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
@@ -812,6 +14460,201 @@ Size get_utf8_size(U32 codepoint)
 	return size;
 }
 
+// floating-point numbers
+
+constexpr int SMALLEST_POWER_OF_FIVE = -342;
+constexpr int LARGEST_POWER_OF_FIVE  = 308;
+
+// the most significant 128 bits of 5^q for each q, rounded up for negative powers
+// (as in Lemire's "Number Parsing at a Gigabyte per Second").
+static U64 power_of_five_table[2 * (LARGEST_POWER_OF_FIVE - SMALLEST_POWER_OF_FIVE + 1)];
+
+constexpr Size BIG_NUMBER_LIMBS_COUNT = 72;
+constexpr Size BIG_NUMBER_SHIFT = 2048;
+
+static void multiply_big_number(U32 *limbs, U32 factor)
+{
+	U64 carry = 0;
+	for (Size i = 0; i < BIG_NUMBER_LIMBS_COUNT; ++i)
+	{
+		U64 product = (U64)limbs[i] * factor + carry;
+		limbs[i] = (U32)product;
+		carry = product >> 32;
+	}
+}
+
+static void divide_big_number(U32 *limbs, U32 divisor)
+{
+	U64 remainder = 0;
+	for (Size i = BIG_NUMBER_LIMBS_COUNT; i--;)
+	{
+		U64 dividend = remainder << 32 | limbs[i];
+		limbs[i] = (U32)(dividend / divisor);
+		remainder = dividend % divisor;
+	}
+}
+
+static Size get_big_number_bit_length(const U32 *limbs)
+{
+	for (Size i = BIG_NUMBER_LIMBS_COUNT; i--;)
+	{
+		if (limbs[i])
+			return i * 32 + 32 - __builtin_clz(limbs[i]);
+	}
+	return 0;
+}
+
+static bool get_big_number_bit(const U32 *limbs, Size index)
+{
+	return limbs[index / 32] >> (index % 32) & 1;
+}
+
+// extracts the 128 bits below `length`, padded with zeros.
+static void get_big_number_high_bits(const U32 *limbs, Size length, U64 *high_bits)
+{
+	high_bits[0] = 0;
+	high_bits[1] = 0;
+	for (Size i = 0; i < 128 && i < length; ++i)
+	{
+		if (get_big_number_bit(limbs, length - 1 - i))
+			high_bits[i / 64] |= 1ull << (63 - i % 64);
+	}
+}
+
+void initialize_power_of_five_table(void)
+{
+	U32 power[BIG_NUMBER_LIMBS_COUNT] = {1};
+
+	// positive powers: 5^q, truncated.
+	for (int q = 0; q <= LARGEST_POWER_OF_FIVE; ++q)
+	{
+		get_big_number_high_bits(power, get_big_number_bit_length(power), &power_of_five_table[2 * (q - SMALLEST_POWER_OF_FIVE)]);
+		multiply_big_number(power, 5);
+	}
+
+	// negative powers: 2^b / 5^n + 1 for a b that keeps enough bits. 2^SHIFT / 5^n is built up
+	// by dividing by 5 repeatedly, which is exact because floor(floor(x / a) / b) = floor(x / ab).
+	set_memory(power, sizeof(power), 0);
+	power[0] = 1;
+	U32 quotient[BIG_NUMBER_LIMBS_COUNT] = {};
+	quotient[BIG_NUMBER_SHIFT / 32] = 1;
+	for (int n = 1; n <= -SMALLEST_POWER_OF_FIVE; ++n)
+	{
+		multiply_big_number(power, 5);
+		divide_big_number(quotient, 5);
+
+		Size z = get_big_number_bit_length(power);
+		Size b = n <= 27 ? z + 127 : 2 * z + 128;
+		Size shift = BIG_NUMBER_SHIFT - b;
+
+		U32 result[BIG_NUMBER_LIMBS_COUNT] = {};
+		for (Size i = 0; i + shift < BIG_NUMBER_LIMBS_COUNT * 32; ++i)
+			result[i / 32] |= (U32)get_big_number_bit(quotient, i + shift) << (i % 32);
+		for (Size i = 0; i < BIG_NUMBER_LIMBS_COUNT && ++result[i] == 0; ++i)
+		{
+		}
+
+		get_big_number_high_bits(result, get_big_number_bit_length(result), &power_of_five_table[2 * (-n - SMALLEST_POWER_OF_FIVE)]);
+	}
+}
+
+bool compute_float(U64 digits, int exponent, F64 *result)
+{
+	constexpr int MANTISSA_BITS_COUNT = 52;
+	constexpr int MINIMUM_EXPONENT = -1023;
+	constexpr int INFINITE_POWER = 0x7ff;
+	constexpr F64 exact_powers_of_ten[] =
+	{
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	if (digits == 0 || exponent < SMALLEST_POWER_OF_FIVE)
+	{
+		*result = 0;
+		return true;
+	}
+	if (exponent > LARGEST_POWER_OF_FIVE)
+	{
+		*result = __builtin_inf();
+		return true;
+	}
+
+	// Clinger's fast path: both operands are exact, so a single IEEE operation rounds correctly.
+	if (exponent >= -22 && exponent <= 22 && digits <= 1ull << 53)
+	{
+		F64 value = (F64)digits;
+		if (exponent < 0)
+			value /= exact_powers_of_ten[-exponent];
+		else
+			value *= exact_powers_of_ten[exponent];
+		*result = value;
+		return true;
+	}
+
+	// Eisel-Lemire
+	int leading_zeros = __builtin_clzll(digits);
+	digits <<= leading_zeros;
+
+	Size index = 2 * (exponent - SMALLEST_POWER_OF_FIVE);
+	unsigned __int128 product = (unsigned __int128)digits * power_of_five_table[index];
+	U64 high = (U64)(product >> 64);
+	U64 low = (U64)product;
+	constexpr U64 precision_mask = 0xffffffffffffffff >> (MANTISSA_BITS_COUNT + 3);
+	if ((high & precision_mask) == precision_mask)
+	{
+		// the truncated product might be off in the bits that decide the rounding; use the lower half too.
+		U64 second_high = (U64)(((unsigned __int128)digits * power_of_five_table[index + 1]) >> 64);
+		low += second_high;
+		if (second_high > low)
+			++high;
+		if (low == 0xffffffffffffffff && (exponent < -27 || exponent > 55))
+			return false;
+	}
+
+	int upper_bit = (int)(high >> 63);
+	int shift = upper_bit + 64 - MANTISSA_BITS_COUNT - 3;
+	U64 mantissa = high >> shift;
+	int power2 = (((152170 + 65536) * exponent) >> 16) + 63 + upper_bit - leading_zeros - MINIMUM_EXPONENT;
+
+	if (power2 <= 0)
+	{
+		// subnormal
+		if (-power2 + 1 >= 64)
+		{
+			*result = 0;
+			return true;
+		}
+		mantissa >>= -power2 + 1;
+		mantissa += mantissa & 1;
+		mantissa >>= 1;
+		power2 = mantissa < 1ull << MANTISSA_BITS_COUNT ? 0 : 1;
+	}
+	else
+	{
+		// exactly halfway between two floats; round to even instead of up.
+		if (low <= 1 && exponent >= -4 && exponent <= 23 && (mantissa & 3) == 1 && mantissa << shift == high)
+			mantissa &= ~1ull;
+		mantissa += mantissa & 1;
+		mantissa >>= 1;
+		if (mantissa >= 2ull << MANTISSA_BITS_COUNT)
+		{
+			mantissa = 1ull << MANTISSA_BITS_COUNT;
+			++power2;
+		}
+		mantissa &= ~(1ull << MANTISSA_BITS_COUNT);
+		if (power2 >= INFINITE_POWER)
+		{
+			*result = __builtin_inf();
+			return true;
+		}
+	}
+
+	U64 bits = mantissa | (U64)power2 << MANTISSA_BITS_COUNT;
+	copy_memory(result, &bits, sizeof(bits));
+	return true;
+}
+
 // end of file stuff
 
 // initialize any global objects/states
@@ -819,6 +14662,12 @@ void initialize(void)
 {
 	setbuf(stdout, 0);
 	setbuf(stderr, 0);
+
+	initialize_power_of_five_table();
+	initialize_identifiers();
+	initialize_literals();
+	initialize_symbol_table();
+	initialize_types();
 }
 
 void terminate(void)
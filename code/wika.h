@@ -18,9 +18,19 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <pthread.h>
+#include <sched.h>
+#include <elf.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
 
 using U8  = uint8_t;
 using U32 = uint32_t;
+using U64 = uint64_t;
+
+using S64 = int64_t;
+
+using F64 = double;
 
 using Address    = uintptr_t;
 using Size       = size_t;
@@ -71,6 +81,11 @@ inline Size min(Size a, Size b)
 	return a < b ? a : b;
 }
 
+inline Size max(Size a, Size b)
+{
+	return a > b ? a : b;
+}
+
 inline Size format(char *output, Size size, const char *format, ...)
 {
 	va_list args;
@@ -182,8 +197,52 @@ bool get_file_size(Handle handle, Size *size);
 
 bool read_file(Handle handle, void *buffer, Size *size);
 
+// a file that `load_files` reads whole
+struct File_Load
+{
+	const char *path;
+	U8 *data;            // null if it couldn't be loaded
+	Size size;
+	const char *failure; // what couldn't be done to it, as in "failed to %s"
+	const char *message; // and why
+};
+
+// loads the files a window at a time. they're opened, their sizes are gotten and they're read in batches through
+// io_uring, or by a pool of threads if it isn't there. `reserve` gives where the data of each file goes once its size
+// is known, on this thread and in order. each file is closed as soon as it's read, so only a window's are open at once.
+void load_files(File_Load *loads, Size count, U8 *(*reserve)(void *input, Size size), void *input);
+
+// creates the file, or empties it if it exists, to be written.
+bool create_file(Handle *handle, const char *path, bool executable = 0);
+
+bool write_file(Handle handle, const void *buffer, Size size);
+
 Size get_full_file_path(const char *path, char *buffer);
 
+Size get_processors_count(void);
+
+using Thread = pthread_t;
+
+bool create_thread(Thread *thread, void *(*procedure)(void *input), void *input);
+
+void join_thread(Thread thread);
+
+using Mutex = pthread_mutex_t;
+
+void initialize_mutex(Mutex *mutex);
+
+void lock_mutex(Mutex *mutex);
+
+void unlock_mutex(Mutex *mutex);
+
+using Condition = pthread_cond_t;
+
+void initialize_condition(Condition *condition);
+
+void wait_condition(Condition *condition, Mutex *mutex);
+
+void broadcast_condition(Condition *condition);
+
 // containers
 
 struct Array
@@ -254,6 +313,20 @@ void get_arena_pointer(Arena *arena, Arena_Pointer *pointer);
 
 void set_arena(Arena_Pointer *pointer);
 
+// temporaries go into scratch arenas, of which each thread has two. a scratch takes the one that isn't `conflict`,
+// where its caller wants what's reserved for it, or else the other one from the scratch it's nested in, and rewinds
+// it when it goes out of scope.
+struct Scratch
+{
+	Arena *arena;
+	Arena_Pointer pointer;
+
+	explicit Scratch(const Arena *conflict = 0);
+	~Scratch();
+	Scratch(const Scratch &) = delete;
+	Scratch &operator=(const Scratch &) = delete;
+};
+
 // Unicode
 
 using Utf8 = U8;
@@ -264,106 +337,831 @@ Size get_utf8_size(U32 codepoint);
 
 // language-specific artifacts
 
+// all sources are mapped into one global address space, so a 32-bit location identifies both a source and a
+// position within it.
+using Location = U32;
+
+constexpr U64 MAXIMUM_SOURCE_SPACE_SIZE = (U64)1 << 32;
+
+struct Span
+{
+	Location beginning;
+	U32 size;
+};
+
 struct Source
 {
 	Size path_size;
 	const char *path;
-	Handle handle;
 	Size data_size;
 	U8 *data;
+	Location base; // location of `data[0]`
 };
 
+// the lexer may read this many bytes past the end of the source data at once (see `lex_number`).
+// they are all zeroed, so the source data is also null-terminated.
+constexpr Size SOURCE_DATA_PADDING_SIZE = 8;
+
+// assigns the source its base. fails if the address space is exhausted.
+bool register_source(Source *source);
+
+const Source *find_source(Location location);
+
+Size get_sources_count(void);
+
+// in order of registration, which is also the order of their bases.
+Source *get_source(Size index);
+
+inline const U8 *get_source_pointer(const Source *source, Location location)
+{
+	return &source->data[location - source->base];
+}
+
+inline Location get_source_location(const Source *source, const U8 *pointer)
+{
+	return source->base + (Location)(pointer - source->data);
+}
+
 enum Token_Type
 {
 	Token_Type_UNKNOWN           = -1,
 	Token_Type_NONE              = 0,
 	Token_Type_IDENTIFIER        = 2,
 	Token_Type_PROC              = 3,
+	Token_Type_INTEGER           = 4,
+	Token_Type_FLOAT             = 5,
+	Token_Type_STRING            = 6,
+	Token_Type_JUMP_TO           = 7,
+	Token_Type_STRUCT            = 8,
+	Token_Type_UNION             = 9,
+	Token_Type_ENUM              = 10,
+	Token_Type_RETURN            = 11,
+	Token_Type_TRUE              = 12,
+	Token_Type_FALSE             = 13,
+	Token_Type_EQUAL_EQUAL       = 14, // `==`
+	Token_Type_EXCLAMATION_EQUAL = 15, // `!=`
+	Token_Type_LESS_EQUAL        = 16, // `<=`
+	Token_Type_GREATER_EQUAL     = 17, // `>=`
+	Token_Type_LESS_LESS         = 18, // `<<`
+	Token_Type_GREATER_GREATER   = 19, // `>>`
+	Token_Type_AND               = 20, // `&&`
+	Token_Type_OR                = 21, // `||`
+	Token_Type_ARROW             = 22, // `->`
+	Token_Type_PIPE              = 23, // `|>`
+	Token_Type_PLUS_EQUAL        = 24, // `+=`
+	Token_Type_MINUS_EQUAL       = 25, // `-=`
+	Token_Type_ASTERISK_EQUAL    = 26, // `*=`
+	Token_Type_SLASH_EQUAL       = 27, // `/=`
 	Token_Type_COLON             = ':',
 	Token_Type_SEMICOLON         = ';',
 	Token_Type_LEFT_PARENTHESIS  = '(',
 	Token_Type_RIGHT_PARENTHESIS = ')',
 	Token_Type_LEFT_BRACE        = '{',
 	Token_Type_RIGHT_BRACE       = '}',
+	Token_Type_MINUS             = '-',
+	Token_Type_EQUAL             = '=',
+	Token_Type_COMMA             = ',',
+	Token_Type_DOT               = '.',
+	Token_Type_LEFT_BRACKET      = '[',
+	Token_Type_RIGHT_BRACKET     = ']',
+	Token_Type_QUESTION_MARK     = '?',
+	Token_Type_AT                = '@',
+	Token_Type_HASH              = '#',
+	Token_Type_EXCLAMATION_MARK  = '!',
+	Token_Type_LESS              = '<',
+	Token_Type_GREATER           = '>',
+	Token_Type_PLUS              = '+',
+	Token_Type_ASTERISK          = '*',
+	Token_Type_SLASH             = '/',
+	Token_Type_PERCENT           = '%',
+	Token_Type_AMPERSAND         = '&',
+	Token_Type_BAR               = '|',
+	Token_Type_CARET             = '^',
+	Token_Type_TILDE             = '~',
+	Token_Type_APOSTROPHE        = '\'',
 };
 
 struct Token
 {
 	Token_Type type;
-	Size position;
+	Span span;
+	U32 value; // identifiers: `Identifier`; literals: index into `Parser::literals`
+};
+
+struct Scope;
+
+struct String
+{
+	const Utf8 *pointer;
 	Size size;
 };
 
-Size format_token(char *buffer, Size size, const Token *token);
+U64 hash_memory(const void *pointer, Size size);
+
+// identifiers are interned once into a global table that every parser thread shares, so they can be compared,
+// hashed and stored as 32-bit values. the table is sharded by hash, each shard under its own lock.
+// zero is never a valid identifier.
+using Identifier = U32;
 
-struct Location
+constexpr Size IDENTIFIER_SHARDS_COUNT_LOG2 = 6;
+constexpr Size IDENTIFIER_SHARDS_COUNT = 1 << IDENTIFIER_SHARDS_COUNT_LOG2;
+constexpr Size MAXIMUM_IDENTIFIERS_COUNT_PER_SHARD = 1 << 18;
+
+void initialize_identifiers(void);
+
+Identifier intern_identifier(const Utf8 *pointer, Size size);
+
+String get_identifier_string(Identifier identifier);
+
+// returns `Token_Type_IDENTIFIER` if it isn't a keyword.
+Token_Type get_identifier_keyword(Identifier identifier);
+
+// string literals are pooled the same way, so a literal that's repeated in any source is kept once and every use of
+// it shares the same bytes, which can then be emitted once.
+void initialize_literals(void);
+
+// returns the pooled string with these bytes, which is `string` itself if it's the first. the bytes have to stay
+// where they are until the compilation ends.
+String intern_literal(String string);
+
+// literals are decoded while lexing, so nothing after the lexer has to look at their digits/escapes again.
+
+enum Literal_Type
 {
-	const Source *source;
-	Size position;
+	Literal_Type_INTEGER,
+	Literal_Type_FLOAT,
+	Literal_Type_STRING,
 };
 
-struct Scope;
+struct Literal
+{
+	Literal_Type type;
+	union
+	{
+		U64 integer;
+		F64 floating;
+		String string; // pooled; it points into the source data if its first occurrence has no escape sequences
+	};
+};
+
+void initialize_power_of_five_table(void);
+
+// `digits` is the decimal mantissa (at most 19 digits) and `exponent` its power of ten.
+// returns false if the result can't be computed quickly and correctly; the caller has to fall back.
+bool compute_float(U64 digits, int exponent, F64 *result);
 
-enum Node_Type
+struct Node;
+struct Artifact;
+struct Reference;
+struct Label;
+struct Jump;
+struct Task;
+
+// types are hash-consed: every distinct type is built once and named by its 32-bit ID, so comparing types is
+// comparing IDs, and the ID is all a cache needs to hash. structures, unions and enumerations that are declared
+// with a name are nominal: their artifact is their identity, so they get their ID before their fields are known
+// and are completed afterwards. anonymous ones are structural.
+
+using Type_Id = U32;
+
+// the built-in types are made first, in this order
+enum : Type_Id
+{
+	Type_Id_NONE,
+	Type_Id_VOID,
+	Type_Id_BOOL,
+	Type_Id_U8,
+	Type_Id_U16,
+	Type_Id_U32,
+	Type_Id_U64,
+	Type_Id_S8,
+	Type_Id_S16,
+	Type_Id_S32,
+	Type_Id_S64,
+	Type_Id_F32,
+	Type_Id_F64,
+	Type_Id_EMPTY_TUPLE,
+	Type_Id_STRING, // []U8
+	Type_Id_TYPE,   // the type of types
+
+	Type_Id_SIZE = Type_Id_U64,
+};
+
+constexpr Size MAXIMUM_TYPES_COUNT = 1 << 20;
+
+enum Type_Kind : U8
 {
+	Type_Kind_VOID,
+	Type_Kind_BOOL,
+	Type_Kind_INTEGER,
+	Type_Kind_FLOAT,
+	Type_Kind_POINTER,   // `@T`
+	Type_Kind_SLICE,     // `[]T`
+	Type_Kind_ARRAY,     // `[N]T`
+	Type_Kind_TUPLE,     // `(T, U)`
+	Type_Kind_STRUCT,
+	Type_Kind_UNION,
+	Type_Kind_ENUM,      // `enum -> T`
+	Type_Kind_PROCEDURE,
+	Type_Kind_TYPE,
+};
+
+struct Type
+{
+	Type_Kind kind;
+	bool is_signed;  // integers
+	bool complete;   // nominal types are incomplete until their fields are known; every other type is complete
+	U32 size;        // in bytes
+	U32 alignment;
+	Type_Id base;    // the pointee/element type, the type of an enumeration, or the results (a tuple) of a procedure
+	U32 elements_count;
+	const Type_Id *elements;     // tuple elements, structure/union fields, or the parameters of a procedure
+	const Identifier *names;     // structure/union field names; zero for anonymous fields
+	const U32 *offsets;          // of tuple elements and structure fields
+	U64 count;                   // arrays
+	const Artifact *declaration; // nominal types only
+	U64 hash;
+};
+
+void initialize_types(void);
+
+const Type *get_type(Type_Id type);
+
+U64 get_type_hash(Type_Id type);
+
+// returns `Type_Id_NONE` if it isn't the name of a built-in type.
+Type_Id find_builtin_type(Identifier name);
+
+Type_Id get_pointer_type(Type_Id base);
+
+Type_Id get_slice_type(Type_Id element);
+
+Type_Id get_array_type(Type_Id element, U64 count);
+
+Type_Id get_tuple_type(const Type_Id *elements, U32 count);
+
+// an anonymous structure or union. `kind` is either `Type_Kind_STRUCT` or `Type_Kind_UNION`.
+Type_Id get_record_type(Type_Kind kind, const Type_Id *fields, const Identifier *names, U32 count);
+
+// the (possibly still incomplete) structure, union or enumeration that `declaration` declares.
+Type_Id get_nominal_type(Type_Kind kind, const Artifact *declaration);
+
+// completing a type is left to the one thread that analyzes its declaration. the fields have to be complete.
+void complete_record_type(Type_Id type, const Type_Id *fields, const Identifier *names, U32 count);
+
+void complete_enum_type(Type_Id type, Type_Id base);
+
+bool check_type_completeness(Type_Id type);
+
+// structures are laid out in the order their fields are declared, so they can be passed to C. unless this is called
+// before they're laid out: then their fields go from the most aligned to the least, which leaves the least padding.
+void enable_field_reordering(void);
+
+// the bytes of a tuple, structure or union that none of its elements take up
+U32 get_padding_size(Type_Id type);
+
+// prints the size and padding of each structure and union that has padding, once they're analyzed
+void report_padding(void);
+
+Type_Id get_procedure_type(const Type_Id *parameters, U32 count, Type_Id results);
+
+// whether a value of type `source` can be stored as type `destination` without an explicit conversion
+bool check_assignability(Type_Id destination, Type_Id source);
+
+Size format_type(char *buffer, Size size, Type_Id type);
+
+// compile-time values are kept the way they would be in memory, so constants can be emitted as they are.
+// scalars are kept in the value itself; anything else is an image of the type's size. pointers in an image
+// (to strings, to other images, or to global artifacts) are relocations, since they have no address yet.
+
+struct Relocation
+{
+	U32 offset;         // in the image
+	Artifact *artifact; // the address of a global artifact, or if null, of a procedure or of `data`
+	Node *procedure;
+	String data;
+	Size alignment;          // that `data`'s type needs
+	Relocation *relocations; // within `data`
+	Relocation *next;
+};
+
+struct Value
+{
+	Type_Id type;
+	union
+	{
+		U64 integer;     // integers, booleans, and enumeration elements whose base is one of these
+		F64 floating;
+		Type_Id type_value;
+		Node *procedure;
+		const U8 *image; // anything else
+	};
+	Relocation *relocations;
+};
+
+// whether the value is an image rather than a scalar
+bool check_image(Type_Id type);
+
+
+enum Node_Type : U8
+{
+	Node_Type_NONE,
+
+	// expressions
+	Node_Type_NAME,        // `name`, `..name`, etc.
+	Node_Type_LITERAL,
+	Node_Type_BOOLEAN,     // `true`, `false`
+	Node_Type_ELEMENT,     // `'NAME` or `.NAME`: an element of the enumeration the context expects
+	Node_Type_UNARY,       // `-a`, `!a`, `~a`, `@a`
+	Node_Type_BINARY,      // `a + b`, etc., and `a |> b`
+	Node_Type_CONDITIONAL, // `a ? b : c`, where `: c` is optional
+	Node_Type_SWITCH,      // `a == {cases} : c`, where `: c` is optional
+	Node_Type_CASE,        // `values ? b`
+	Node_Type_CALL,        // `a(arguments)` or `a arguments`. calling a type converts to it
+	Node_Type_MEMBER,      // `a.name`, or in a compound, `name = b`
+	Node_Type_INDEX,       // `a[b]`
+	Node_Type_COMPOUND,    // `{elements}`, or `a {elements}`, which is of type `a`
+	Node_Type_TUPLE,       // `(elements)`, of values or of types
+	Node_Type_SIZE_OF,     // `#size_of a`
+	Node_Type_SLICE_TYPE,  // `[]a`
+	Node_Type_ARRAY_TYPE,  // `[b]a`
+	Node_Type_PROCEDURE,   // `proc(parameters) -> results {b}`
+	Node_Type_STRUCT,      // `struct {fields}`
+	Node_Type_UNION,       // `union {fields}`
+	Node_Type_ENUM,        // `enum -> a {elements}`
+
+	// statements
+	Node_Type_BLOCK,       // `{statements}`; also a named scope
+	Node_Type_DECLARATION, // `artifacts: a = b`, `artifacts :: b`, etc.; fields and parameters may have no names
+	Node_Type_ASSIGNMENT,  // `a = b`, `a += b`, etc.
+	Node_Type_RETURN,      // `return a`
+	Node_Type_JUMP,        // `jump_to name`
+	Node_Type_LABEL,       // `[name]`
 };
 
 struct Node
 {
 	Node_Type type;
+	Token_Type operation; // of operations and assignments; `:` for constant declarations, `=` for variables with a
+	                      // value; `,` for tuples without parentheses
+	bool is_static;       // `#static` declarations
+	Span span;
+	Node *left;  // `a` above
+	Node *right; // `b` above
+	Node *other; // `c` above
+	U32 count;   // of the nodes or artifacts
+	U32 parameters_count; // procedures; the nodes after the parameters are the results
+	union
+	{
+		Node **nodes;
+		Artifact **artifacts; // declarations
+	};
+	union
+	{
+		Literal literal;
+		bool boolean;
+		Identifier name;      // elements and members
+		Reference *reference; // names
+		Scope *scope;         // blocks, procedures, structures, unions and enumerations
+		Label *label;         // null if it's a redeclaration
+		Jump *jump;           // null if it has nowhere to go
+	};
 };
 
 struct Parser;
 
 Node *allocate_node(Parser *parser, Node_Type type);
 
-struct String
+// a growable list of pointers
+template<typename T>
+struct List
 {
-	const Utf8 *pointer;
-	Size size;
+	Buffer items;
+};
+
+template<typename T>
+void add_to_list(List<T> *list, T *item);
+
+template<typename T>
+Size get_list_count(const List<T> *list);
+
+template<typename T>
+T *get_list_item(const List<T> *list, Size index);
+
+enum Evaluation_State : U8
+{
+	Evaluation_State_NONE,
+	Evaluation_State_RUNNING,
+	Evaluation_State_DONE,
+	Evaluation_State_FAILED,
 };
 
 struct Artifact
 {
-	String name;
-	Node *node;
+	Identifier name;
+	Span span; // of the name
+	Node *node;   // its declaration
+	U32 index;    // among the names of its declaration
+	Scope *scope; // where it's declared; null at the top level
+	Scope *body;  // the scope its initializer opens, if any (the body of a procedure, structure, etc.)
+
+	Evaluation_State evaluation;
+	Type_Id type;
+	Value value; // of constants, and the initial value of variables outside of procedures; zero if there's no image
+
+	// top-level artifacts only
+	bool exported;         // `#export`: a root of the analysis, like `_start`
+	Reference *references; // every name used in the declaration, in order
+	List<Scope> scopes;    // the outermost scopes in the declaration
+	Task *task;
 };
 
-template<typename T>
-struct List
+struct Scope_Entry;
+
+// a hash index from identifiers to what they name in a scope
+struct Scope_Table
 {
+	Scope_Entry *entries;
+	U32 count;
+	U32 capacity;
+};
+
+// `[name]`
+struct Label
+{
+	Identifier name;
+	Span span;
+	Scope *scope;
+};
+
+// `jump_to name`, `jump_to ..name`, etc.
+struct Jump
+{
+	Identifier name;
+	Span span;
+	Size levels;   // the number of scopes the search skips: one for `..name`
+	Scope *scope;  // where the jump is
+	Label *target; // null until it's resolved
+	Jump *next;    // in the list of jumps pending on a scope
+};
+
+// a use of a name. they are only recorded while parsing, since resolving them has to wait until every source is
+// parsed.
+struct Reference
+{
+	Identifier name;
+	Span span;
+	Scope *scope; // where it's used
+	Size levels;  // the number of scopes the search skips: one for `..name`
+	bool weak;    // what it names doesn't have to be analyzed first: it's in a procedure's body, or behind `@`
+	Artifact *artifact; // what it names, once it's resolved; null for built-in names
+	Reference *next;
 };
 
 struct Scope
 {
 	Scope *parent;
 	Size index; // index from parent->children
+	Size depth; // the number of enclosing scopes; zero for the scopes of top-level artifacts
+	Scope **ancestors; // `ancestors[i]` is the enclosing scope at depth `i`; `ancestors[depth]` is this scope
 	List<Scope> children;
 	List<Artifact> artifacts;
+
+	Scope_Table names; // the artifacts declared here, plus every resolution made from here
+	Scope_Table labels;
+
+	// jumps to labels that weren't declared yet. a jump goes to the label in the nearest scope that has it, so
+	// the ones still unresolved when the scope closes move on to the parent.
+	Jump *pending_jumps;
+	bool procedure; // labels aren't visible past the scope of a procedure
+	Artifact *owner; // the artifact whose body it is, if any
+	Artifact *top;   // the top-level artifact it's in
 };
 
+// name resolution goes through the hash index of each scope and memoizes its result in every scope along the
+// way, so each (scope, name) pair is resolved once. because of that, resolution may only start once parsing is
+// done, and a scope must only be resolved from one thread at a time.
+
+Artifact *resolve_name(Scope *scope, Identifier name);
+
+// returns the scope `levels` levels up, or null for the global scope.
+Scope *get_ancestor(Scope *scope, Size levels);
+
+// resolves `..name`, `...name`, etc. starting from the scope `levels` levels up (one for `..name`).
+Artifact *resolve_backwards_name(Scope *scope, Size levels, Identifier name);
+
+// resolves `artifact.name`, which has to be declared directly in the artifact's body.
+Artifact *find_member(const Artifact *artifact, Identifier name);
+
 struct Parser
 {
+	const Source *source;
 	Location location;
 	Token token;
-	Buffer identifiers;
-
-	Scope global_scope;
-	Scope *current_scope;
+	Buffer literals;
+	Arena strings; // decoded string literals with escape sequences
+	Arena artifacts;
+	Arena scopes;
+	Arena labels; // and jumps
+	Arena references;
+	Arena nodes;
+	Buffer node_stack; // nodes (or artifacts) that go into the list that is being parsed
+	List<Artifact> declarations; // the top-level artifacts
+
+	Scope *current_scope; // null at the top level, whose artifacts are in the global symbol table
+	Token_Type previous_token_type;
+	Location previous_token_ending;
+	Artifact *current_declaration; // the top-level artifact that is being parsed
+	Reference **next_reference;    // the tail of its references
+	Size procedure_bodies_depth;
+	Size braces_depth;             // of the current token, which counts if it's a brace itself
+	bool braces_end_types;         // in the results of a procedure or the type of an enumeration, which a body follows
+	Size skipped_statements_count; // that failed, whose declarations failed too, though the rest was parsed
 };
 
 void initialize_parser(Parser *parser, const Source *source);
 
+Size format_token(char *buffer, Size size, const Parser *parser, const Token *token);
+
+// after an error in a statement, what's left of it is skipped and parsing goes on from the next one in its block.
+// after any other error, what's left of the top-level declaration is skipped and parsing goes on from the next one,
+// so independent errors are all reported. returns the number of declarations that failed.
 Size parse(Parser *parser);
 
 Artifact *reserve_artifact(Parser *parser);
 
-void v_report_parsing_error(Parser *parser, Size beginning, Size ending, const char *message, va_list args);
+// top-level artifacts of all sources share one symbol table, which parser threads insert into concurrently.
+// like identifiers, it is sharded, each shard under its own lock.
+
+void initialize_symbol_table(void);
+
+// returns the artifact that already has the same name, if there is one. the earliest declaration (by location)
+// is the one that stays in the table, so the outcome doesn't depend on which thread got there first.
+Artifact *insert_global_artifact(Artifact *artifact);
+
+Artifact *find_global_artifact(Identifier name);
+
+// semantic analysis runs a task per top-level artifact on every processor. a task resolves the names its
+// artifact uses, and when it needs another artifact that isn't analyzed yet, it parks on that artifact's task
+// and resumes where it stopped once that task is done. so artifacts get analyzed in dependency order without
+// sweeping over them more than once, whatever order they're declared in.
+
+enum Task_State : U8
+{
+	Task_State_IDLE, // not reached (yet) by a lazy analysis
+	Task_State_QUEUED,
+	Task_State_RUNNING,
+	Task_State_PARKED,
+	Task_State_DONE,
+};
+
+struct Task
+{
+	Artifact *artifact;
+	Task_State state;
+	Reference *next_reference;   // where the analysis resumes
+	List<Artifact> dependencies; // the top-level artifacts it refers to (possibly repeated), in order
+	Size reached_count;          // how many of the dependencies were reached
+
+	Task *blocker;               // the task it's parked on
+	Span blocking_span;          // where it needs the blocker
+	Task *waiters;               // the tasks parked on it
+	Task *next_waiter;
+	Size mark;                   // for finding cycles
+};
+
+// tasks that are still parked once nothing else can run are waiting on a cycle, which gets reported.
+// a lazy analysis starts from `_start` and the exported artifacts only, and a task starts once an artifact that
+// runs refers to its artifact. what nothing reaches stays parsed, but isn't analyzed.
+void analyze(Parser *parsers, Size parsers_count, bool lazy);
+
+// constants, enumeration elements, the types of declarations, the initial values of global variables and
+// `#size_of`s are evaluated at compile time, each once: an artifact keeps its value after it's evaluated.
+// a task evaluates what it declares outside of procedures before it's done. evaluating a name from another
+// task's artifact needs that task to be done, so the evaluation stops and the task parks on it, and starts
+// over when it resumes; whatever was evaluated until then is kept.
+
+struct Evaluation
+{
+	Task *task;        // the task that is evaluating; null once every task is done
+	Arena *arena;      // where the images go
+	Task *blocker;     // set if it stopped for a task that isn't done
+	Span blocking_span;
+};
+
+// false if it failed or stopped; `evaluation->blocker` tells which.
+bool evaluate_artifact(Evaluation *evaluation, Artifact *artifact);
+
+// `expected` is the type that the context expects, or `Type_Id_NONE`. literals take it if they can, and
+// enumeration elements and compounds need it.
+bool evaluate(Evaluation *evaluation, Node *node, Type_Id expected, Value *value);
+
+// procedures are lowered into SSA form: every instruction defines at most one value, which is named by the
+// instruction's index in its procedure. instructions are grouped into basic blocks that each end with one
+// terminator, and labels begin blocks, so the blocks follow the control flow of `jump_to`. only scalars (integers,
+// floats, booleans, pointers and procedures) are values; anything else lives in memory and is used by address.
+
+using Instruction_Id = U32; // zero is none
+using Block_Id = U32;       // the entry is zero
+
+enum Operation : U8
+{
+	Operation_NONE,        // removed
+
+	Operation_CONSTANT,    // `constant`: the bits of an integer, a boolean or a float
+	Operation_ADDRESS,     // of `address.artifact`, of `address.procedure`, or of `address.data`
+	Operation_PARAMETER,   // the `index`th. unless a procedure returns its results in registers, the address that
+	                       // its results go to is passed after the parameters
+	Operation_LOCAL,       // the address of a stack slot of `slot.size` bytes, aligned to `slot.alignment`
+	Operation_PHI,         // an operand for each predecessor of the block, in the same order
+	Operation_COPY,
+
+	// one operand
+	Operation_NEGATE,
+	Operation_NOT,         // of booleans
+	Operation_COMPLEMENT,
+	Operation_CONVERT,     // to its type
+	Operation_LOAD,        // from the address
+
+	// two operands
+	Operation_ADD,
+	Operation_SUBTRACT,
+	Operation_MULTIPLY,
+	Operation_DIVIDE,
+	Operation_MODULO,
+	Operation_AND,
+	Operation_OR,
+	Operation_XOR,
+	Operation_SHIFT_LEFT,
+	Operation_SHIFT_RIGHT,
+	Operation_EQUAL,       // comparisons define a `Bool`
+	Operation_NOT_EQUAL,
+	Operation_LESS,
+	Operation_LESS_EQUAL,
+	Operation_GREATER,
+	Operation_GREATER_EQUAL,
+	Operation_STORE,       // the second operand to the address in the first
+	Operation_COPY_MEMORY, // `slot.size` bytes from the address in the second operand to the one in the first
+	Operation_ZERO_MEMORY, // `slot.size` bytes at the address
+	Operation_CALL,        // of the first operand, with the others as arguments. it defines the first result if
+	                       // the results are returned in registers
+	Operation_RESULT,      // the `index`th result of the call in the operand, which it comes right after
+
+	// terminators
+	Operation_JUMP,        // to `targets[0]`
+	Operation_BRANCH,      // to `targets[0]` if the operand is true, or else to `targets[1]`
+	Operation_SWITCH,      // to the target of the case whose value the integer operand is, or else to the first
+	Operation_RETURN,      // the results, if they're returned in registers
+};
+
+struct Procedure;
+
+// a value of a switch, and the index of the target it goes to
+struct Switch_Case
+{
+	U64 value;
+	U32 target;
+};
+
+struct Instruction
+{
+	Operation operation;
+	Type_Id type; // of the value it defines, or `Type_Id_VOID`
+	Block_Id block;
+	U32 operands_count;
+	Instruction_Id *operands;
+	union
+	{
+		U64 constant;
+		U32 index;
+		struct
+		{
+			Artifact *artifact;     // a global artifact, if it isn't null
+			Procedure *procedure;
+			const Relocation *data; // or else read-only data, with its own relocations
+		}
+		address;
+		struct
+		{
+			U32 size;
+			U32 alignment;
+		}
+		slot;
+		Block_Id targets[2];
+		struct
+		{
+			Block_Id *targets;        // the default first, and then each case's
+			const Switch_Case *cases; // sorted by value, which is normalized like the operand
+			U32 targets_count;
+			U32 cases_count;
+		}
+		table;
+	};
+};
+
+struct Block
+{
+	Buffer instructions; // of `Instruction_Id`, in order. the terminator is last
+	Buffer predecessors; // of `Block_Id`
+	U64 frequency;       // one more than how many times it ran in the profile, or zero if that isn't known
+};
+
+struct Procedure
+{
+	Node *node;
+	Artifact *artifact; // the constant it's the value of, if any
+	Type_Id type;
+	Size index;         // in the program
+	bool external;      // it has no body, so it's defined elsewhere
+	U32 parameters_count; // including the address of the results, if it's passed
+
+	Buffer instructions; // of `Instruction`
+	Buffer blocks;       // of `Block`
+	Arena operands;
+};
+
+struct Index_Map
+{
+	U64 *keys; // zero is empty
+	U64 *values;
+	U32 count;
+	U32 capacity;
+};
+
+struct Program
+{
+	List<Procedure> procedures;
+	Index_Map procedures_by_node;
+	Arena arena; // procedures, and data that is only read
+
+	// what an instrumented program counts into, and what it writes to its profile before the counters
+	Artifact *profile_counters;
+	String profile_header;
+	const char *profile_path;
+};
+
+Instruction *get_instruction(const Procedure *procedure, Instruction_Id id);
+
+U32 get_instructions_count(const Procedure *procedure);
+
+Block *get_block(const Procedure *procedure, Block_Id id);
+
+U32 get_blocks_count(const Procedure *procedure);
+
+// every procedure that the top-level artifacts which were analyzed can reach is lowered.
+void lower_program(Program *program, const Parser *parsers, Size parsers_count);
+
+// the passes are run on every procedure until they don't change anything.
+void optimize_program(Program *program);
+
+// a profile counts how many times each block of each procedure ran. an instrumented program counts them and writes
+// them to `path` when `_start` returns, or when an object's `wika_write_profile` is called. procedures are matched
+// with those of the profile by name, and only if they lower the same way.
+void instrument_program(Program *program, const char *path);
+
+// reads the profile at `path` and gives the blocks of the procedures that match it their frequencies, which inlining,
+// the layout of the blocks and the dispatch of switches follow
+void apply_profile(Program *program, const char *path);
+
+void print_program(const Program *program);
+
+// writes the program's machine code to `path`, as a relocatable object if `object` is set and otherwise as a static
+// executable, which is entered at `_start`.
+bool generate_program(const Program *program, const char *path, bool object);
+
+// writes the program as C, into a translation unit for each source, at its path with the extension replaced by `.c`.
+// the unit of `_start` enters the program at `main`.
+bool generate_c_program(const Program *program);
+
+void v_report_span_error(Span span, const char *message, va_list args);
+
+void v_report_span_note(Span span, const char *message, va_list args);
+
+[[gnu::format(printf, 2, 3)]]
+inline void report_span_note(Span span, const char *message, ...)
+{
+	va_list args;
+	va_start(args, message);
+	v_report_span_note(span, message, args);
+	va_end(args);
+}
+
+[[gnu::format(printf, 2, 3)]]
+inline void report_span_error(Span span, const char *message, ...)
+{
+	va_list args;
+	va_start(args, message);
+	v_report_span_error(span, message, args);
+	va_end(args);
+}
 
+// reports an error spanning from the current token to the current location.
+[[gnu::format(printf, 2, 3)]]
 inline void report_parsing_token_error(Parser *parser, const char *message, ...)
 {
+	Span span = {parser->token.span.beginning, parser->location - parser->token.span.beginning};
 	va_list args;
 	va_start(args, message);
-	v_report_parsing_error(parser, parser->token.position, parser->location.position, message, args);
+	v_report_span_error(span, message, args);
 	va_end(args);
 }
@@ -0,0 +1,35 @@
+// a scratch that overflows its first buffer is rewound, twice, and then the arenas are given back when their thread
+// ends, which walks what the rewinds left
+
+#define main wika_main
+#include "../code/wika.cpp"
+#undef main
+
+static void overflow_scratch(void)
+{
+	Scratch scratch;
+	U8 *pointer = (U8 *)reserve_from_arena(scratch.arena, 2 * MIB, 1);
+	set_memory(pointer, 2 * MIB, 0xaa);
+	assert(scratch.arena->last != scratch.arena->first);
+}
+
+static void *overflow_scratches(void *)
+{
+	for (U32 i = 0; i < 2; ++i)
+	{
+		overflow_scratch();
+		assert(scratch_arenas.arenas[0].last == scratch_arenas.arenas[0].first);
+		assert(!scratch_arenas.arenas[0].first->other);
+	}
+	return 0;
+}
+
+int main(void)
+{
+	pthread_t thread;
+	if (pthread_create(&thread, 0, overflow_scratches, 0) || pthread_join(thread, 0))
+		return 1;
+	overflow_scratches(0);
+	printf("scratch: ok\n");
+	return 0;
+}